@@ -9,12 +9,34 @@ export type Action =
        * Ignore the command in catter, but still execute the original command.
        */
       type: "skip";
+
+      /**
+       * How much of the command output `onExecution` receives, defaults to
+       * `options.capture`.
+       */
+      capture?: CaptureMode;
+
+      /**
+       * Set by `ctx.cache`, see `options.decisionCache`.
+       */
+      cache?: CachedDecision;
+
+      /**
+       * Run the command without the hook, so its descendants never reach
+       * catter. Set by `ctx.ignoreDescendants`.
+       */
+      ignoreDescendants?: boolean;
     }
   | {
       /**
        * Skip execution of the original command.
        */
       type: "drop";
+
+      /**
+       * Set by `ctx.cache`, see `options.decisionCache`.
+       */
+      cache?: CachedDecision;
     }
   | {
       /**
@@ -32,8 +54,58 @@ export type Action =
        * Replacement command data for the modified command.
        */
       data: CommandData;
+
+      /**
+       * How much of the command output `onExecution` receives, defaults to
+       * `options.capture`.
+       */
+      capture?: CaptureMode;
+
+      /**
+       * Run the command without the hook, so its descendants never reach
+       * catter. Set by `ctx.ignoreDescendants`.
+       */
+      ignoreDescendants?: boolean;
+    }
+  | {
+      /**
+       * Do not run the compiler, write placeholders of its outputs instead.
+       *
+       * `catter-proxy` works out the object files, archives and depfiles the
+       * command writes with the option tables of clang and nvcc. Commands whose
+       * outputs it can not work out, such as `-E`, run as with `"skip"`.
+       */
+      type: "fake";
+
+      /**
+       * Set by `ctx.cache`, see `options.decisionCache`.
+       */
+      cache?: CachedDecision;
+
+      /**
+       * Run the command without the hook, so its descendants never reach
+       * catter. Set by `ctx.ignoreDescendants`.
+       */
+      ignoreDescendants?: boolean;
     };
 
+/**
+ * A decision catter keeps on disk and reuses for the same command in later
+ * runs, without calling `onCommand`.
+ */
+export type CachedDecision = {
+  /**
+   * JSON of the states handed to `service_on_merge` when the decision is
+   * reused.
+   */
+  state: string;
+
+  /**
+   * Whether the descendants of the command are skipped too.
+   */
+  ignoreDescendants: boolean;
+};
+
 /**
  * Action discriminator extracted from {@link Action}.
  */
@@ -57,6 +129,58 @@ export type ProcessResult = {
    * Captured standard error content.
    */
   stderr: string;
+
+  /**
+   * Timing and resource usage of the process.
+   */
+  stats?: ProcessStats;
+};
+
+/**
+ * Where the time of a process went.
+ *
+ * Timestamps are microseconds since the Unix epoch, so they can be compared
+ * across commands. CPU time and memory are only measured on Linux and macOS,
+ * they are `0` elsewhere.
+ */
+export type ProcessStats = {
+  /**
+   * Process id of the command.
+   */
+  pid: number;
+
+  /**
+   * When the command was intercepted, before catter decided about it.
+   */
+  spawn: number;
+
+  /**
+   * When the command itself started.
+   */
+  exec: number;
+
+  /**
+   * When the command exited.
+   */
+  exit: number;
+
+  /**
+   * CPU time spent in user mode, in microseconds, including the processes
+   * the command waited for.
+   */
+  userTime: number;
+
+  /**
+   * CPU time spent in kernel mode, in microseconds, including the processes
+   * the command waited for.
+   */
+  systemTime: number;
+
+  /**
+   * Peak resident set size of the command or of the largest process it
+   * waited for, in KiB.
+   */
+  maxRss: number;
 };
 
 /**
@@ -91,6 +215,47 @@ export type CatterRuntime = {
  */
 export type CatterStdioMode = "inherit" | "capture";
 
+/**
+ * Controls how much of the output of a command catter keeps for `onExecution`.
+ *
+ * - `"inherit"`: the command writes straight to the build output, `stdout`
+ *   and `stderr` of its result are empty.
+ * - `"tail"`: keep the last 64 KiB of each stream.
+ * - `"full"`: keep the whole output.
+ */
+export type CaptureMode = "inherit" | "tail" | "full";
+
+/**
+ * A decision catter makes natively, without calling `onCommand` or
+ * `onExecution`.
+ *
+ * Every condition that is set must hold. Commands started by a matched command
+ * are still captured; their `parent` is the nearest ancestor the script has
+ * seen.
+ */
+export type CommandRule = {
+  /**
+   * Glob (`*`, `?`) on the file name of the executable, or on its full path if
+   * it contains a path separator.
+   */
+  exe?: string;
+
+  /**
+   * Regular expression searched in the full executable path.
+   */
+  exePattern?: string;
+
+  /**
+   * Globs matched against the leading arguments after `argv[0]`.
+   */
+  args?: string[];
+
+  /**
+   * The decision, only `"skip"` and `"drop"` are supported.
+   */
+  action: "skip" | "drop";
+};
+
 /**
  * Configuration passed to the script before command capture begins.
  */
@@ -133,6 +298,84 @@ export type CatterConfig = {
      * Controls whether target stdout/stderr is printed by catter while it is captured.
      */
     stdioMode?: CatterStdioMode;
+
+    /**
+     * Lets the hook library ask catter for decisions itself instead of starting
+     * `catter-proxy` for every command. Linux and macOS only.
+     *
+     * Nothing reports the exit of a command decided this way, so it is turned off after
+     * `onStart` when a service handles `onExecution`.
+     */
+    directHook?: boolean;
+
+    /**
+     * Number of extra script runtimes, each on its own thread, that run `onCommand`
+     * and `onExecution` in parallel. `0` or unset runs everything on the main runtime.
+     *
+     * Each worker loads the script and runs `onStart` with the final config. A command
+     * is handled by one worker only, so state spanning commands must be returned by
+     * `service_on_collect` on the workers and is passed to `service_on_merge` on the
+     * main runtime before `onFinish`.
+     */
+    decisionWorkers?: number;
+
+    /**
+     * Rules checked before `onCommand`, in order. The first match decides the
+     * command without calling into the script.
+     */
+    rules?: CommandRule[];
+
+    /**
+     * How much output is kept for commands whose action does not set
+     * `capture`. Defaults to `"tail"`.
+     */
+    capture?: CaptureMode;
+
+    /**
+     * Keeps the decisions `onCommand` marked with `ctx.cache` on disk, in the
+     * data directory of catter. In later runs of the same script in the same
+     * build directory, a command with the same working directory, executable,
+     * arguments, content of its `@file` response files and environment, see
+     * `decisionCacheEnv`, is answered from there without calling `onCommand`,
+     * and its state goes to `service_on_merge` instead. `onExecution` still
+     * receives its result.
+     *
+     * Changing the script, its arguments or catter drops the cache.
+     */
+    decisionCache?: boolean;
+
+    /**
+     * Environment variables whose values are part of the cache key, for
+     * scripts that read them. Those compilers read, such as `CC`, `CPATH` or
+     * `CFLAGS`, always are.
+     */
+    decisionCacheEnv?: string[];
+
+    /**
+     * Write every intercepted command, its environment and its result to this
+     * file, for `--replay` to feed the build to a script again without running
+     * it. Defaults to `--record`.
+     */
+    record?: string;
+
+    /**
+     * Connections the socket of catter queues before a starting `catter-proxy`
+     * has to wait. Raise it for builds running very many commands at once.
+     * Defaults to `--ipc-backlog`, which is 1024.
+     */
+    ipcBacklog?: number;
+
+    /**
+     * For scripts which only watch the build. Every command is skipped at
+     * once, and `onCommand` runs while it already runs. The action it returns
+     * is not applied; only `ctx.ignoreDescendants()` and `ctx.cache` take
+     * effect, for the commands the command starts afterwards and for later
+     * runs, which answer it as skipped. Those commands still run with the
+     * hook, so catter keeps hearing of the descendants of an ignored command,
+     * it only skips them at once. `onExecution` still follows `onCommand` for
+     * each command, and every `onCommand` has returned before `onFinish`.
+     */
+    observeOnly?: boolean;
   };
 
   /**
@@ -188,8 +431,37 @@ export type CommandData = {
 
   /**
    * Parent command identifier when the runtime supports parent tracking.
+   *
+   * This is the running command whose process asked to run this one, or forked
+   * the process which did, so tools spawning through processes catter does not
+   * see still get the right parent.
    */
   parent?: number;
+
+  /**
+   * The process which asked to run the command, when the hook reported it.
+   */
+  origin?: ProcessOrigin;
+};
+
+/**
+ * The process which called `exec`, `posix_spawn` or `CreateProcess`.
+ */
+export type ProcessOrigin = {
+  /**
+   * Process id of the caller.
+   */
+  pid: number;
+
+  /**
+   * Process id of the parent of the caller, `0` on Windows.
+   */
+  ppid: number;
+
+  /**
+   * Id of the thread which made the call.
+   */
+  tid: number;
 };
 
 /**
@@ -231,6 +503,15 @@ export function service_on_command(
 export function service_on_execution(
   cb: (id: number, result: ProcessResult) => Promise<void>,
 ): void;
+/**
+ * Serializes the state of a worker runtime, called once before it stops.
+ */
+export function service_on_collect(cb: () => Promise<string>): void;
+/**
+ * Receives the states collected from the worker runtimes and those of the
+ * commands answered from the decision cache, before `onFinish`.
+ */
+export function service_on_merge(cb: (states: string[]) => Promise<void>): void;
 // io
 export function stdout_print(content: string): void;
 export function stdout_print_red(content: string): void;
@@ -241,6 +522,17 @@ export function stdout_print_green(content: string): void;
 // os
 export function os_name(): "linux" | "windows" | "macos";
 export function os_arch(): "x86" | "x64" | "arm" | "arm64";
+/**
+ * Runs `file` with the full argument vector `args` in `cwd` and the environment `env`,
+ * or the one of catter if `env` is empty. The output is kept up to the same limit as for
+ * captured commands, `stats` is left out.
+ */
+export function os_run(
+  file: string,
+  args: string[],
+  cwd: string,
+  env: string[],
+): Promise<ProcessResult>;
 
 // time
 export function time_unix_ms(): number;
@@ -249,6 +541,24 @@ export function time_unix_seconds(): number;
 export function time_monotonic_ms(): number;
 export function time_monotonic_us(): number;
 
+// debug
+/**
+ * Calls of one CAPI since catter started.
+ */
+export type CapiStats = {
+  name: string;
+  calls: number;
+  /**
+   * Time spent in the calls, in microseconds.
+   */
+  totalUs: number;
+};
+
+/**
+ * The CAPIs called so far. Asynchronous CAPIs are not counted.
+ */
+export function debug_capi_stats(): CapiStats[];
+
 // http
 export type RawHttpResponse = {
   status: number;
@@ -355,6 +665,23 @@ export function file_write_n(
   buf: ArrayBuffer,
 ): void;
 
+// compile_commands.json streaming writer
+export function cdb_writer_open(path: string): number;
+export function cdb_writer_append(writer: number, entry: string): void;
+export function cdb_writer_close(writer: number): void;
+export function cdb_writer_abort(writer: number): void;
+
+// compile_commands.json entries kept natively
+export function cdb_store_load(path: string): number;
+export function cdb_store_size(store: number, excluded: string[]): number;
+export function cdb_store_items(store: number, excluded: string[]): string;
+export function cdb_store_write(
+  store: number,
+  writer: number,
+  excluded: string[],
+): number;
+export function cdb_store_close(store: number): void;
+
 // option
 export type OptionItem = {
   values: string[];
@@ -1,5 +1,6 @@
+import * as capi from "catter-c";
 import * as fs from "../fs.js";
-import * as io from "../io.js";
+import { CDBWriter } from "./cdb-writer.js";
 
 export class CDBError extends Error {
   constructor(message: string) {
@@ -55,14 +56,6 @@ function cloneItem(item: CDBItem): CDBItem {
   };
 }
 
-function readEntireText(path: string): string {
-  let content = "";
-  io.TextFileStream.with(path, "utf-8", (stream) => {
-    content = stream.readEntireFile();
-  });
-  return content;
-}
-
 function asItem(value: unknown, context: string): CDBItem {
   if (!isRecord(value)) {
     throw new CDBValidationError(`${context}: expected object item`);
@@ -148,36 +141,43 @@ function addTo(store: Map<string, Map<string, CDBItem>>, item: CDBItem): void {
   items.set(itemKey(item), cloneItem(item));
 }
 
-function readItemsFromPath(path: string): CDBItem[] {
+/**
+ * Loads an existing database on the native side, which validates and groups
+ * its entries like `addTo` without turning them into JS objects.
+ */
+function loadInheritedStore(path: string): number | undefined {
   if (!fs.exists(path)) {
-    return [];
+    return undefined;
   }
   if (!fs.isFile(path)) {
     throw new CDBFileError(`CDB path is not a file: ${path}`);
   }
 
-  const raw = readEntireText(path).trim();
-  if (raw.length === 0) {
-    return [];
+  try {
+    return capi.cdb_store_load(path);
+  } catch (e) {
+    throw new CDBValidationError(e instanceof Error ? e.message : String(e));
   }
-
-  const parsed: unknown = JSON.parse(raw);
-  if (!Array.isArray(parsed)) {
-    throw new CDBValidationError(`CDB file must contain a JSON array: ${path}`);
-  }
-
-  return parsed.map((item, index) => asItem(item, `${path}[${index}]`));
 }
 
-function writeItemsToPath(path: string, items: CDBItem[]): void {
-  if (fs.exists(path)) {
-    fs.removeAll(path);
+function writeItemsToPath(
+  path: string,
+  inherited: ((writer: number) => number) | undefined,
+  items: Iterable<CDBItem>,
+): void {
+  const writer = new CDBWriter(path);
+  try {
+    if (inherited !== undefined) {
+      writer.appendNative(inherited);
+    }
+    for (const item of items) {
+      writer.append(item);
+    }
+    writer.close();
+  } catch (e) {
+    writer.abort();
+    throw e;
   }
-  fs.createFile(path, true);
-
-  io.TextFileStream.with(path, "utf-8", (stream) => {
-    stream.write(JSON.stringify(items, null, 2));
-  });
 }
 
 /**
@@ -186,11 +186,16 @@ function writeItemsToPath(path: string, items: CDBItem[]): void {
  * When constructed with an existing `compile_commands.json` path, previous
  * entries are inherited. New items override existing entries that resolve to
  * the same source file; untouched inherited entries are preserved on save.
+ *
+ * Inherited entries are kept natively and only become JS objects when
+ * `items()` is called, `save()` and `size()` never convert them. Call
+ * `dispose()` to release them early. Items added with `addItem` are held
+ * until saved, `write()` saves items as they are produced instead.
  */
 export class CDBManager {
   readonly savePath: string;
 
-  private readonly inheritedItems = new Map<string, Map<string, CDBItem>>();
+  private inheritedStore: number | undefined;
   private readonly pendingItems = new Map<string, Map<string, CDBItem>>();
 
   constructor(
@@ -200,30 +205,12 @@ export class CDBManager {
     this.savePath = savePath;
 
     if (options.inherit ?? true) {
-      for (const item of readItemsFromPath(savePath)) {
-        addTo(this.inheritedItems, item);
-      }
+      this.inheritedStore = loadInheritedStore(savePath);
     }
   }
 
-  private mergedItems(): CDBItem[] {
-    const items: CDBItem[] = [];
-
-    for (const [file, group] of this.inheritedItems) {
-      if (!this.pendingItems.has(file)) {
-        for (const item of group.values()) {
-          items.push(cloneItem(item));
-        }
-      }
-    }
-
-    for (const group of this.pendingItems.values()) {
-      for (const item of group.values()) {
-        items.push(cloneItem(item));
-      }
-    }
-
-    return items;
+  private pendingFiles(): string[] {
+    return [...this.pendingItems.keys()];
   }
 
   /**
@@ -256,7 +243,31 @@ export class CDBManager {
    * Returns the current merged view of the database.
    */
   items(): CDBItem[] {
-    return this.mergedItems();
+    // inherited entries were validated when they were loaded
+    const items: CDBItem[] =
+      this.inheritedStore === undefined
+        ? []
+        : JSON.parse(
+            capi.cdb_store_items(this.inheritedStore, this.pendingFiles()),
+          );
+    for (const item of this.pendingValues()) {
+      items.push(cloneItem(item));
+    }
+    return items;
+  }
+
+  /**
+   * Returns the number of entries in the merged view.
+   */
+  size(): number {
+    let size = 0;
+    for (const group of this.pendingItems.values()) {
+      size += group.size;
+    }
+    if (this.inheritedStore !== undefined) {
+      size += capi.cdb_store_size(this.inheritedStore, this.pendingFiles());
+    }
+    return size;
   }
 
   /**
@@ -269,11 +280,83 @@ export class CDBManager {
   /**
    * Saves the merged compilation database to disk.
    *
-   * If `path` is omitted, the constructor path is used.
+   * Entries are streamed to a temporary file which then replaces the target,
+   * so the whole database is never serialized at once and a failed save keeps
+   * the previous file. If `path` is omitted, the constructor path is used.
    */
   save(path?: string): string {
     const targetPath = path ?? this.savePath;
-    writeItemsToPath(targetPath, this.mergedItems());
+    const store = this.inheritedStore;
+    const pendingFiles = this.pendingFiles();
+    writeItemsToPath(
+      targetPath,
+      store === undefined
+        ? undefined
+        : (writer) => capi.cdb_store_write(store, writer, pendingFiles),
+      this.pendingValues(),
+    );
     return targetPath;
   }
+
+  /**
+   * Saves the database like `save()`, with `items` added to it, and returns
+   * the number of entries saved.
+   *
+   * Each item is validated and appended as soon as `items` yields it, only
+   * the keys of the items written so far are kept to drop duplicates and to
+   * leave out the inherited entries of their files, which are written last.
+   * Unlike `addItem`, the first of two items with the same key is kept.
+   */
+  write(items: Iterable<CDBItem>, path?: string): number {
+    const written = new Map<string, Set<string>>();
+    const writer = new CDBWriter(path ?? this.savePath);
+    try {
+      for (const source of [this.pendingValues(), items]) {
+        for (const value of source) {
+          const item = asItem(value, "CDBManager.write");
+          const file = fileKey(item);
+          let keys = written.get(file);
+          if (keys === undefined) {
+            keys = new Set();
+            written.set(file, keys);
+          }
+          const key = itemKey(item);
+          if (!keys.has(key)) {
+            keys.add(key);
+            writer.append(item);
+          }
+        }
+      }
+
+      const store = this.inheritedStore;
+      if (store !== undefined) {
+        const files = [...written.keys()];
+        writer.appendNative((native) =>
+          capi.cdb_store_write(store, native, files),
+        );
+      }
+      writer.close();
+    } catch (e) {
+      writer.abort();
+      throw e;
+    }
+    return writer.entries;
+  }
+
+  /**
+   * Releases the inherited entries, which are then dropped from the merged
+   * view.
+   */
+  dispose(): void {
+    if (this.inheritedStore !== undefined) {
+      capi.cdb_store_close(this.inheritedStore);
+      this.inheritedStore = undefined;
+    }
+  }
+
+  private *pendingValues(): Generator<CDBItem> {
+    for (const group of this.pendingItems.values()) {
+      yield* group.values();
+    }
+  }
 }
@@ -0,0 +1,90 @@
+import * as capi from "catter-c";
+
+/**
+ * Streams a compile_commands.json array to disk one entry at a time.
+ *
+ * Entries are written to a temporary file next to `path` as they are
+ * appended, so only one serialized entry is held in memory at a time. The
+ * temporary file replaces `path` on `close()`; until then, and after
+ * `abort()`, an existing database at `path` is left untouched.
+ *
+ * @example
+ * ```ts
+ * const writer = new CDBWriter("build/compile_commands.json");
+ * try {
+ *   for (const item of items) {
+ *     writer.append(item);
+ *   }
+ *   writer.close();
+ * } catch (e) {
+ *   writer.abort();
+ *   throw e;
+ * }
+ * ```
+ */
+export class CDBWriter {
+  readonly path: string;
+
+  private handle: number | undefined;
+  private count = 0;
+
+  constructor(path: string) {
+    this.path = path;
+    this.handle = capi.cdb_writer_open(path);
+  }
+
+  /**
+   * Number of entries appended so far.
+   */
+  get entries(): number {
+    return this.count;
+  }
+
+  /**
+   * Serializes and appends one entry.
+   */
+  append(entry: unknown): this {
+    capi.cdb_writer_append(this.open(), JSON.stringify(entry, null, 2));
+    ++this.count;
+    return this;
+  }
+
+  /**
+   * Lets native code append entries directly, `write` receives the native
+   * writer and returns how many entries it appended.
+   *
+   * @internal
+   */
+  appendNative(write: (writer: number) => number): this {
+    this.count += write(this.open());
+    return this;
+  }
+
+  /**
+   * Finishes the array and moves it in place of `path`.
+   */
+  close(): void {
+    const handle = this.open();
+    this.handle = undefined;
+    capi.cdb_writer_close(handle);
+  }
+
+  /**
+   * Discards everything written so far. Does nothing once closed.
+   */
+  abort(): void {
+    if (this.handle === undefined) {
+      return;
+    }
+    const handle = this.handle;
+    this.handle = undefined;
+    capi.cdb_writer_abort(handle);
+  }
+
+  private open(): number {
+    if (this.handle === undefined) {
+      throw new Error(`CDB writer for ${this.path} is already closed`);
+    }
+    return this.handle;
+  }
+}
@@ -1,2 +1,3 @@
 export * from "./cdb.js";
 export * from "./cdb-manager.js";
+export * from "./cdb-writer.js";
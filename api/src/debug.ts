@@ -2,7 +2,10 @@
  * Debug helpers for assertions inside catter scripts and tests.
  */
 
-import { stdout_print } from "catter-c";
+import { debug_capi_stats, stdout_print } from "catter-c";
+import type { CapiStats } from "catter-c";
+
+export type { CapiStats };
 
 /**
  * Runs a fallback callback when a condition is false.
@@ -62,3 +65,23 @@ export function assertThrow(cond: boolean) {
     throw new Error("assertion failed!");
   });
 }
+
+/**
+ * Returns how often each native API was called so far and the time spent in
+ * it, sorted by time. Asynchronous APIs are not counted.
+ *
+ * The counters are kept whether logging is enabled or not, so a script can
+ * find what it spends its time on at the end of a build.
+ *
+ * @example
+ * ```typescript
+ * service.onFinish(() => {
+ *   for (const { name, calls, totalUs } of debug.capiStats()) {
+ *     io.println(`${name}: ${calls} calls, ${totalUs} us`);
+ *   }
+ * });
+ * ```
+ */
+export function capiStats(): CapiStats[] {
+  return debug_capi_stats().sort((a, b) => b.totalUs - a.totalUs);
+}
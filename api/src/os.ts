@@ -1,4 +1,6 @@
-import { os_arch, os_name } from "catter-c";
+import { os_arch, os_name, os_run } from "catter-c";
+import type { ProcessResult } from "catter-c";
+import { pwd } from "./fs.js";
 
 export {};
 
@@ -31,3 +33,34 @@ export function platform(): "linux" | "windows" | "macos" {
 export function arch(): "x86" | "x64" | "arm" | "arm64" {
   return os_arch();
 }
+
+/**
+ * Runs a program and waits for it to exit.
+ *
+ * The program runs with `env`, or with the environment catter was started
+ * with if it is not given. Either way catter does not capture it, such as the
+ * `env` of a captured command, which is already free of the hook. Its output
+ * is returned instead of printed.
+ *
+ * @param exe - Path of the program.
+ * @param argv - Full argument vector, including the program name.
+ * @param cwd - Working directory, the current one by default.
+ * @param env - Environment in `KEY=VALUE` form.
+ * @returns The exit code and output of the program.
+ *
+ * @example
+ * ```typescript
+ * const result = await run("/usr/bin/cc", ["cc", "-c", "main.c"], "build");
+ * if (result.code !== 0) {
+ *   println(result.stderr);
+ * }
+ * ```
+ */
+export async function run(
+  exe: string,
+  argv: readonly string[],
+  cwd: string = pwd(),
+  env?: readonly string[],
+): Promise<ProcessResult> {
+  return await os_run(exe, [...argv], cwd, env === undefined ? [] : [...env]);
+}
@@ -21,6 +21,18 @@ import {
 
 type Producer = CDBCommand;
 
+/**
+ * What the script keeps of one compiler command, with absolute paths. It is
+ * also the state handed between runtimes and kept by the decision cache.
+ */
+type CompilerRecord = {
+  cwd: string;
+  argv: string[];
+  /** Pairs of the absolute path and the path as written in the command. */
+  sources: [string, string][];
+  edges: { output: string; inputs: string[] }[];
+};
+
 type CDBScriptOptions = {
   outputPath: string;
   append: boolean;
@@ -31,6 +43,38 @@ type CDBScriptOptions = {
   verbose: boolean;
 };
 
+/**
+ * Tools which never compile anything themselves. When their exit code does not
+ * matter, catter skips them natively instead of asking `onCommand`; commands
+ * they start are still seen.
+ */
+const NON_COMPILER_RULES: service.CommandRule[] = [
+  ...[
+    "sh",
+    "bash",
+    "dash",
+    "zsh",
+    "env",
+    "make",
+    "gmake",
+    "ninja",
+    "mkdir",
+    "rm",
+    "cp",
+    "mv",
+    "ln",
+    "touch",
+    "install",
+    "chmod",
+    "cat",
+    "echo",
+    "sed",
+    "awk",
+    "grep",
+  ].map((exe): service.CommandRule => ({ exe, action: "skip" })),
+  { exe: "cmake", args: ["-E"], action: "skip" },
+];
+
 const cdbCLI = cli.command({
   name: "cdb",
   description:
@@ -56,6 +100,10 @@ const cdbCLI = cli.command({
       description:
         "Abort when any captured command exits with a non-zero code.",
     }),
+    cli.flag("decision-cache", {
+      description:
+        "Reuse the analysis of compiler commands which did not change since the last run.",
+    }),
     cli.flag("abort-on-capture-error", {
       description: "Abort when catter reports a command capture error.",
     }),
@@ -268,11 +316,68 @@ export function cdb(
   const producers = new Map<string, Producer[]>();
   const srcFiles = new Map<string, string>();
   const capturedCompilerCommandIds = new Set<number>();
+  const records: CompilerRecord[] = [];
+
+  function compilerRecord(
+    command: service.CommandData,
+    analysis: CompilerAnalysis,
+  ): CompilerRecord {
+    const sources: [string, string][] = [];
+    for (const source of analysis.sourceFiles) {
+      const full = pathOf(command.cwd, source);
+      if (full !== undefined) {
+        sources.push([full, source]);
+      }
+    }
+
+    const edges: CompilerRecord["edges"] = [];
+    for (const edge of analysis.edges) {
+      const output = pathOf(command.cwd, edge.output);
+      if (output !== undefined) {
+        edges.push({
+          output,
+          inputs: edge.inputs
+            .map((input) => pathOf(command.cwd, input))
+            .filter(isSet),
+        });
+      }
+    }
+
+    return { cwd: command.cwd, argv: [...command.argv], sources, edges };
+  }
+
+  function record(compiler: CompilerRecord): void {
+    records.push(compiler);
+    for (const [full, source] of compiler.sources) {
+      srcFiles.set(full, source);
+    }
+
+    for (const { output, inputs } of compiler.edges) {
+      commandTree.justMergeNode({
+        id: output,
+        content: output,
+      });
+
+      for (const input of inputs) {
+        commandTree.justMergeNode({
+          id: input,
+          parent: [output],
+          content: input,
+        });
+      }
+
+      const parents = producers.get(output) ?? [];
+      parents.push({
+        cwd: compiler.cwd,
+        argv: compiler.argv,
+      });
+      producers.set(output, parents);
+    }
+  }
 
-  function generatedItems(): CDBItem[] {
+  function* generatedItems(): Generator<CDBItem> {
     commandTree.assemble();
 
-    const items: CDBItem[] = [];
     for (const node of commandTree.nodes()) {
       if (node.children.length !== 0) {
         continue;
@@ -297,31 +402,56 @@ export function cdb(
         ];
 
         for (const producer of parents) {
-          items.push(...cdbItemsOf(producer, entries));
+          yield* cdbItemsOf(producer, entries);
         }
       }
     }
-
-    return items;
   }
 
   function save(): void {
-    const items = generatedItems();
-    verboseLog(
-      options,
-      `Generated ${items.length} entries for ${new Set(items.map((item) => item.file)).size} source files; ` +
-        `${items.filter((item) => item.output !== undefined).length} entries include an output path.`,
-    );
+    let generated = 0;
+    let withOutput = 0;
+    const files = new Set<string>();
+    // each entry goes to disk as soon as it is generated
+    function* counted(): Generator<CDBItem> {
+      for (const item of generatedItems()) {
+        ++generated;
+        if (item.output !== undefined) {
+          ++withOutput;
+        }
+        files.add(item.file);
+        yield item;
+      }
+    }
 
     const manager = new CDBManager(options.outputPath, {
       inherit: options.append,
     });
-    manager.merge(items);
-
-    const savedPath = manager.save();
+    const saved = manager.write(counted());
+    verboseLog(
+      options,
+      `Generated ${generated} entries for ${files.size} source files; ` +
+        `${withOutput} entries include an output path.`,
+    );
     log(
       options,
-      `CDB saved to ${fs.path.absolute(savedPath)} with ${manager.items().length} entries.`,
+      `CDB saved to ${fs.path.absolute(options.outputPath)} with ${saved} entries.`,
+    );
+  }
+
+  function abortOnFailure(ctx: service.ExecutionContext): void {
+    if (ctx.result.code === 0) {
+      return;
+    }
+
+    const compilerPrefix = capturedCompilerCommandIds.has(ctx.id)
+      ? "compiler "
+      : "";
+    if (options.saveOnFailure) {
+      save();
+    }
+    throw new Error(
+      `CDB aborting after ${compilerPrefix}command ${ctx.id} exited with code ${ctx.result.code}.`,
     );
   }
 
@@ -359,6 +489,22 @@ export function cdb(
         ].join("\n"),
       );
 
+      // verbose runs log every rejected command, abort needs every exit code
+      if (!options.verbose && !options.abortOnCommandFailure) {
+        config.options.rules = [
+          ...(config.options.rules ?? []),
+          ...NON_COMPILER_RULES,
+        ];
+      }
+      // verbose runs log the analysis of every command, which a cached one skips
+      if (parsed["decision-cache"] && !options.verbose) {
+        config.options.decisionCache ??= true;
+      }
+      // only exit codes are read, compiler output goes straight to the build log
+      config.options.capture ??= "inherit";
+      // nothing is changed, compilers need not wait for their analysis
+      config.options.observeOnly ??= true;
+
       return config;
     },
 
@@ -395,6 +541,7 @@ export function cdb(
           options,
           compilerAnalysisErrorLog(ctx.id, command, analysisResult.error),
         );
+        ctx.cache([]);
         return;
       }
 
@@ -405,61 +552,28 @@ export function cdb(
       );
       capturedCompilerCommandIds.add(ctx.id);
 
-      for (const source of analysis.sourceFiles) {
-        const full = pathOf(command.cwd, source);
-        if (full !== undefined) {
-          srcFiles.set(full, source);
-        }
-      }
-
-      for (const edge of analysis.edges) {
-        const output = pathOf(command.cwd, edge.output);
-        if (output === undefined) {
-          continue;
-        }
-
-        const inputs = edge.inputs
-          .map((input) => pathOf(command.cwd, input))
-          .filter(isSet);
+      const compiler = compilerRecord(command, analysis);
+      record(compiler);
+      ctx.cache([compiler]);
+      ctx.ignoreDescendants();
+    },
 
-        commandTree.justMergeNode({
-          id: output,
-          content: output,
-        });
+    onCollect() {
+      return records;
+    },
 
-        for (const input of inputs) {
-          commandTree.justMergeNode({
-            id: input,
-            parent: [output],
-            content: input,
-          });
+    onMerge(states) {
+      for (const state of states as (CompilerRecord[] | null | undefined)[]) {
+        for (const compiler of state ?? []) {
+          record(compiler);
         }
-
-        const parents = producers.get(output) ?? [];
-        parents.push({
-          cwd: command.cwd,
-          argv: [...command.argv],
-        });
-        producers.set(output, parents);
       }
-
-      ctx.ignoreDescendants();
     },
 
-    onExecution(ctx) {
-      if (!options.abortOnCommandFailure || ctx.result.code === 0) {
-        return;
-      }
-
-      const compilerPrefix = capturedCompilerCommandIds.has(ctx.id)
-        ? "compiler "
-        : "";
-      if (options.saveOnFailure) {
-        save();
-      }
-      throw new Error(
-        `CDB aborting after ${compilerPrefix}command ${ctx.id} exited with code ${ctx.result.code}.`,
-      );
+    // exit codes are only read to abort, without that the direct path can
+    // decide commands
+    get onExecution() {
+      return options.abortOnCommandFailure ? abortOnFailure : undefined;
     },
   });
 }
@@ -1,3 +1,5 @@
 export * from "./cdb.js";
 export * from "./cmd-tree.js";
 export * from "./target-tree.js";
+export * from "./trace.js";
+export * from "./minimal-build.js";
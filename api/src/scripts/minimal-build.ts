@@ -0,0 +1,255 @@
+import * as cli from "../cli/index.js";
+import * as fs from "../fs.js";
+import * as io from "../io.js";
+import * as os from "../os.js";
+import * as service from "../service.js";
+import { analyze as analyzeCmd } from "../cmd/index.js";
+
+function isDefined<T>(value: T | undefined): value is T {
+  return value !== undefined;
+}
+
+function normalizePath(cwd: string, path: string): string | undefined {
+  if (path === "-") {
+    return undefined;
+  }
+
+  const base = fs.path.absolute(cwd);
+  const joined = fs.path.isAbsolute(path) ? path : fs.path.joinAll(base, path);
+  return fs.path.lexicalNormal(joined);
+}
+
+const minimalBuildCLI = cli.command({
+  name: "minimal-build",
+  description:
+    "Fake every compile and link, except those of the tools the build runs.",
+  options: [
+    cli.number("jobs", {
+      short: "j",
+      valueName: "n",
+      description: "Build at most n commands for the tools at once.",
+      integer: true,
+      min: 1,
+    }),
+  ] as const,
+  examples: ["minimal-build -j 16"],
+});
+
+/**
+ * A compile, link or archive command which was faked.
+ *
+ * `inputs` are the absolute paths the command reads, as far as its analysis
+ * knows them. `env` is the environment it was captured with, shared by the
+ * commands with the same one.
+ */
+export type FakedCommand = {
+  cwd: string;
+  exe: string;
+  argv: string[];
+  env: readonly string[];
+  inputs: string[];
+};
+
+export type MinimalBuildOptions = {
+  /**
+   * Number of commands built at once for a tool, defaults to 8.
+   * `--jobs` of the script arguments takes precedence.
+   */
+  jobs?: number;
+
+  /**
+   * Really runs a faked command, defaults to running it with `os.run` in the
+   * environment it was captured with.
+   */
+  run?: (command: FakedCommand) => Promise<service.ProcessResult>;
+};
+
+/**
+ * Run at most `jobs` of the jobs given to the returned function at once.
+ */
+function limiter(jobs: number) {
+  let running = 0;
+  const waiting: (() => void)[] = [];
+
+  return async <T>(job: () => Promise<T>): Promise<T> => {
+    if (running < jobs) {
+      running += 1;
+    } else {
+      // the slot is handed over by the job which finishes
+      await new Promise<void>((resolve) => waiting.push(resolve));
+    }
+
+    try {
+      return await job();
+    } finally {
+      const next = waiting.shift();
+      if (next !== undefined) {
+        next();
+      } else {
+        running -= 1;
+      }
+    }
+  };
+}
+
+/**
+ * Service script for a minimal build: every compile, link and archive command
+ * the command analysis recognizes is faked, except for what is needed to run
+ * the code generators of the build.
+ *
+ * The script remembers which command wrote each placeholder. When the build
+ * runs an executable that is a placeholder, such as `llvm-tblgen`, the
+ * commands that wrote it and the placeholders it was linked from are run for
+ * real first, in dependency order, and only then the tool. Everything else
+ * stays fake, so the build still writes its generated headers and a complete
+ * compilation database at a small part of its usual cost.
+ *
+ * The commands are rebuilt with the environment they were captured with, and
+ * a tool which fails to build aborts the build. Tools which load shared
+ * libraries of the build that were linked by name (`-lfoo`) instead of by
+ * path are not found, so such projects should link their tools statically.
+ * The state lives in one runtime, so `options.decisionWorkers` is turned off.
+ *
+ * @example
+ * ```ts
+ * import { scripts, service } from "catter";
+ *
+ * service.register(scripts.minimalBuild());
+ * ```
+ */
+export function minimalBuild(
+  options: MinimalBuildOptions = {},
+): service.CatterContextService {
+  const run =
+    options.run ??
+    ((command: FakedCommand) =>
+      os.run(command.exe, command.argv, command.cwd, command.env));
+  let limit = limiter(options.jobs ?? 8);
+
+  // the command which wrote each placeholder
+  const faked = new Map<string, FakedCommand>();
+  const builds = new Map<FakedCommand, Promise<boolean>>();
+  const tools = new Set<string>();
+  // a build runs most commands in few environments, they are kept once
+  const envs = new Map<string, readonly string[]>();
+  let fakedCount = 0;
+  let builtCount = 0;
+
+  function sharedEnv(env: string[]): readonly string[] {
+    const key = env.join("\0");
+    let shared = envs.get(key);
+    if (shared === undefined) {
+      shared = env;
+      envs.set(key, shared);
+    }
+    return shared;
+  }
+
+  function build(command: FakedCommand): Promise<boolean> {
+    let pending = builds.get(command);
+    if (pending !== undefined) {
+      return pending;
+    }
+
+    pending = (async () => {
+      const dependencies = command.inputs
+        .map((input) => faked.get(input))
+        .filter(isDefined)
+        .filter((dependency) => dependency !== command);
+      const built = await Promise.all(dependencies.map(build));
+      if (!built.every((ok) => ok)) {
+        return false;
+      }
+
+      const result = await limit(() => run(command));
+      if (result.code !== 0) {
+        io.coloredPrintln(
+          `Failed to build ${command.argv.join(" ")} (exit code ${result.code}):\n${result.stderr}`,
+          "red",
+        );
+        return false;
+      }
+
+      builtCount += 1;
+      return true;
+    })();
+    builds.set(command, pending);
+    return pending;
+  }
+
+  return service.create({
+    onStart(config) {
+      const parsed = cli.run(minimalBuildCLI, config.scriptArgs);
+      if (parsed === undefined) {
+        config.execute = false;
+        return config;
+      }
+
+      if (parsed.jobs !== undefined) {
+        limit = limiter(parsed.jobs);
+      }
+      config.options.decisionWorkers = 0;
+      return config;
+    },
+
+    async onCommand(ctx) {
+      if (!ctx.capture.success) {
+        return;
+      }
+
+      const { cwd, exe, argv } = ctx.capture.data;
+      const tool = normalizePath(cwd, exe);
+      const placeholder = tool === undefined ? undefined : faked.get(tool);
+      if (tool !== undefined && placeholder !== undefined) {
+        tools.add(tool);
+        if (!(await build(placeholder))) {
+          ctx.abort();
+        }
+        return;
+      }
+
+      const analysis = analyzeCmd({ exe, argv });
+      if (analysis.isErr()) {
+        return;
+      }
+
+      const { reads, writes } = analysis.value;
+      const phase =
+        analysis.value.kind === "compiler"
+          ? analysis.value.compilerMode.phase
+          : undefined;
+      if (phase === "preprocess" || phase === "syntax-only") {
+        // their output is read by the build, they are cheap anyway
+        return;
+      }
+
+      const command: FakedCommand = {
+        cwd,
+        exe,
+        argv: [...argv],
+        env: sharedEnv(ctx.capture.data.env),
+        inputs: reads
+          .map((input) => normalizePath(cwd, input))
+          .filter(isDefined),
+      };
+      for (const output of writes) {
+        const path = normalizePath(cwd, output);
+        if (path !== undefined) {
+          faked.set(path, command);
+        }
+      }
+
+      fakedCount += 1;
+      ctx.fake();
+    },
+
+    onFinish() {
+      io.println(
+        `Faked ${fakedCount} commands, built ${builtCount} of them for ${tools.size} tools.`,
+      );
+      for (const tool of tools) {
+        io.println(`  ${tool}`);
+      }
+    },
+  });
+}
@@ -0,0 +1,239 @@
+import * as cli from "../cli/index.js";
+import * as fs from "../fs.js";
+import * as io from "../io.js";
+import * as service from "../service.js";
+
+const traceCLI = cli.command({
+  name: "trace",
+  description:
+    "Record the captured commands as a Chrome Trace Event timeline, which Perfetto and chrome://tracing can open.",
+  options: [
+    cli.string("output", {
+      short: "o",
+      valueName: "path",
+      description: "Write the trace to this path.",
+    }),
+  ] as const,
+  examples: ["trace -o build-trace.json"],
+});
+
+/**
+ * A command which finished while the trace was recorded.
+ */
+export type TraceCommand = {
+  id: number;
+  parent?: number;
+  cwd: string;
+  exe: string;
+  argv: string[];
+  code: number;
+  stats: service.ProcessStats;
+};
+
+/**
+ * One event of the Chrome Trace Event format, times are in microseconds.
+ */
+export type TraceEvent = {
+  name: string;
+  cat?: string;
+  ph: "X" | "C" | "M";
+  ts: number;
+  dur?: number;
+  pid: number;
+  tid: number;
+  args?: Record<string, unknown>;
+};
+
+export type ChromeTrace = {
+  traceEvents: TraceEvent[];
+  displayTimeUnit: "ms";
+};
+
+const BUILD_PID = 1;
+
+function startOf(stats: service.ProcessStats): number {
+  return stats.spawn !== 0 ? stats.spawn : stats.exec;
+}
+
+/**
+ * Lay out finished commands as a Chrome trace.
+ *
+ * Commands are packed on as few tracks as possible, so the number of tracks
+ * in use shows how parallel the build was at any time, and a `running`
+ * counter tracks the same. The time catter spent before starting a command is
+ * a nested `catter` slice.
+ */
+export function chromeTrace(commands: readonly TraceCommand[]): ChromeTrace {
+  const sorted = commands
+    .filter((command) => command.stats.exit !== 0)
+    .sort((a, b) => startOf(a.stats) - startOf(b.stats) || a.id - b.id);
+  if (sorted.length === 0) {
+    return { traceEvents: [], displayTimeUnit: "ms" };
+  }
+
+  const origin = startOf(sorted[0].stats);
+  const traceEvents: TraceEvent[] = [
+    {
+      name: "process_name",
+      ph: "M",
+      ts: 0,
+      pid: BUILD_PID,
+      tid: 0,
+      args: { name: "build" },
+    },
+  ];
+
+  // the end of the last command on each track
+  const tracks: number[] = [];
+  const changes: { ts: number; delta: number }[] = [];
+  for (const command of sorted) {
+    const { stats } = command;
+    const start = startOf(stats) - origin;
+    const end = Math.max(stats.exit - origin, start);
+
+    let track = tracks.findIndex((busyUntil) => busyUntil <= start);
+    if (track === -1) {
+      track = tracks.length;
+      tracks.push(end);
+      traceEvents.push({
+        name: "thread_name",
+        ph: "M",
+        ts: 0,
+        pid: BUILD_PID,
+        tid: track,
+        args: { name: `track ${track}` },
+      });
+    } else {
+      tracks[track] = end;
+    }
+
+    traceEvents.push({
+      name: fs.path.filename(command.exe),
+      cat: "command",
+      ph: "X",
+      ts: start,
+      dur: end - start,
+      pid: BUILD_PID,
+      tid: track,
+      args: {
+        id: command.id,
+        parent: command.parent,
+        pid: stats.pid,
+        cwd: command.cwd,
+        argv: command.argv.join(" "),
+        code: command.code,
+        userMs: stats.userTime / 1000,
+        systemMs: stats.systemTime / 1000,
+        maxRssKiB: stats.maxRss,
+      },
+    });
+    if (stats.spawn !== 0 && stats.exec > stats.spawn) {
+      traceEvents.push({
+        name: "catter",
+        cat: "catter",
+        ph: "X",
+        ts: start,
+        dur: Math.min(stats.exec - origin, end) - start,
+        pid: BUILD_PID,
+        tid: track,
+      });
+    }
+
+    changes.push({ ts: start, delta: 1 }, { ts: end, delta: -1 });
+  }
+
+  // a command ending at the same time another one starts does not overlap it
+  changes.sort((a, b) => a.ts - b.ts || a.delta - b.delta);
+  let running = 0;
+  for (const change of changes) {
+    running += change.delta;
+    traceEvents.push({
+      name: "running",
+      ph: "C",
+      ts: change.ts,
+      pid: BUILD_PID,
+      tid: 0,
+      args: { commands: running },
+    });
+  }
+
+  return { traceEvents, displayTimeUnit: "ms" };
+}
+
+/**
+ * Service script that records when each captured command ran, how long
+ * catter held it back and what it cost, then writes the whole build as a
+ * Chrome Trace Event file.
+ *
+ * Open the file in https://ui.perfetto.dev or `chrome://tracing` to find the
+ * points where the build stops running in parallel. Commands catter does not
+ * run itself, those decided by `options.rules`, are missing from the trace.
+ *
+ * @example
+ * ```ts
+ * import { scripts, service } from "catter";
+ *
+ * service.register(scripts.trace());
+ * ```
+ */
+export function trace(): service.CatterContextService {
+  const commands = new Map<number, Omit<TraceCommand, "code" | "stats">>();
+  const finished: TraceCommand[] = [];
+  let outputPath = "catter-trace.json";
+
+  return service.create({
+    onStart(config) {
+      const parsed = cli.run(traceCLI, config.scriptArgs);
+      if (parsed === undefined) {
+        config.execute = false;
+        return config;
+      }
+
+      outputPath = parsed.output ?? outputPath;
+      return config;
+    },
+
+    onCommand(ctx) {
+      if (!ctx.capture.success) {
+        return;
+      }
+
+      const { cwd, exe, argv, parent } = ctx.capture.data;
+      commands.set(ctx.id, { id: ctx.id, parent, cwd, exe, argv });
+    },
+
+    onExecution(ctx) {
+      const command = commands.get(ctx.id);
+      if (command === undefined || ctx.result.stats === undefined) {
+        return;
+      }
+
+      commands.delete(ctx.id);
+      finished.push({
+        ...command,
+        code: ctx.result.code,
+        stats: ctx.result.stats,
+      });
+    },
+
+    onCollect() {
+      return finished;
+    },
+
+    onMerge(states) {
+      for (const state of states as (TraceCommand[] | undefined)[]) {
+        finished.push(...(state ?? []));
+      }
+    },
+
+    async onFinish() {
+      await fs.async.writeText(
+        outputPath,
+        JSON.stringify(chromeTrace(finished)),
+      );
+      io.println(
+        `Trace of ${finished.length} commands saved to ${fs.path.absolute(outputPath)}.`,
+      );
+    },
+  });
+}
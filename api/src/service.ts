@@ -1,7 +1,9 @@
 import {
+  service_on_collect,
   service_on_command,
   service_on_execution,
   service_on_finish,
+  service_on_merge,
   service_on_start,
 } from "catter-c";
 
@@ -15,7 +17,9 @@ import {
   type LegacyCommandHandler,
   type LegacyExecutionHandler,
   type RegisterableService,
+  type ServiceCollectHandler,
   type ServiceFinishHandler,
+  type ServiceMergeHandler,
   type ServiceStartHandler,
 } from "./service/runtime.js";
 
@@ -24,13 +28,16 @@ export * from "./service/runtime.js";
 export type {
   Action,
   ActionType,
+  CaptureMode,
   CatterConfig,
   CatterErr,
   CatterStdioMode,
   CatterRuntime,
   CommandCaptureResult,
   CommandData,
+  CommandRule,
   ProcessResult,
+  ProcessStats,
 } from "catter-c";
 
 import type { ActionType } from "catter-c";
@@ -45,6 +52,7 @@ export const ActionKind = [
   "drop",
   "abort",
   "modify",
+  "fake",
 ] as const satisfies readonly ActionType[];
 
 const defaultRuntime = new ServiceRuntime();
@@ -60,6 +68,12 @@ function installRuntime(): void {
   service_on_finish((result) => defaultRuntime.finish(result));
   service_on_command((id, data) => defaultRuntime.command(id, data));
   service_on_execution((id, result) => defaultRuntime.execution(id, result));
+  service_on_collect(async () =>
+    JSON.stringify(await defaultRuntime.collect()),
+  );
+  service_on_merge((states) =>
+    defaultRuntime.merge(states.map((state) => JSON.parse(state) as unknown)),
+  );
 }
 
 /**
@@ -76,6 +90,22 @@ export function onFinish(cb: ServiceFinishHandler): void {
   register({ onFinish: cb });
 }
 
+/**
+ * Registers a callback that returns the state of a worker runtime, see
+ * `options.decisionWorkers`. The value must survive `JSON.stringify`.
+ */
+export function onCollect(cb: ServiceCollectHandler): void {
+  register({ onCollect: cb });
+}
+
+/**
+ * Registers a callback that receives the states collected from every worker
+ * runtime. It runs on the main runtime, before `onFinish`.
+ */
+export function onMerge(cb: ServiceMergeHandler): void {
+  register({ onMerge: cb });
+}
+
 /**
  * Registers a callback that handles each captured command.
  */
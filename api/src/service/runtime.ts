@@ -18,6 +18,16 @@ export type ServiceFinishHandler = (
   result: ProcessResult,
 ) => MaybePromise<void>;
 
+/**
+ * Returns the state of a worker runtime, it must survive `JSON.stringify`.
+ */
+export type ServiceCollectHandler = () => MaybePromise<unknown>;
+
+/**
+ * Receives the states returned by `onCollect` on every worker runtime.
+ */
+export type ServiceMergeHandler = (states: unknown[]) => MaybePromise<void>;
+
 export type LegacyCommandHandler = (
   id: number,
   data: CommandCaptureResult,
@@ -46,9 +56,18 @@ export interface CommandContext {
   drop(): void;
   abort(): void;
   modify(data: CommandData): void;
+  fake(): void;
   setAction(action: Action): void;
   ignoreDescendants(): void;
   stopPropagation(): void;
+  /**
+   * Remember the decision for this command across runs, see
+   * `options.decisionCache`. Later runs answer the same command without
+   * calling `onCommand` and pass `state` to `onMerge` instead, so it must
+   * hold whatever the service keeps of the command and survive
+   * `JSON.stringify`. Only `skip`, `drop` and `fake` are remembered.
+   */
+  cache(state?: unknown): void;
 }
 
 export interface ExecutionContext {
@@ -64,6 +83,8 @@ export interface CatterService {
   onFinish?: ServiceFinishHandler;
   onCommand?: LegacyCommandHandler;
   onExecution?: LegacyExecutionHandler;
+  onCollect?: ServiceCollectHandler;
+  onMerge?: ServiceMergeHandler;
 }
 
 export interface CatterContextService {
@@ -71,6 +92,8 @@ export interface CatterContextService {
   onFinish?: ServiceFinishHandler;
   onCommand?: ContextCommandHandler;
   onExecution?: ContextExecutionHandler;
+  onCollect?: ServiceCollectHandler;
+  onMerge?: ServiceMergeHandler;
 }
 
 export interface CatterServiceAdapter {
@@ -87,12 +110,50 @@ type RuntimeService = {
   onFinish?: ServiceFinishHandler;
   onCommand?: ContextCommandHandler;
   onExecution?: ContextExecutionHandler;
+  onCollect?: ServiceCollectHandler;
+  onMerge?: ServiceMergeHandler;
 };
 
+const CACHEABLE_ACTIONS: readonly Action["type"][] = ["skip", "drop", "fake"];
+
+/**
+ * Actions which run the command, catter can run it without the hook when its
+ * descendants are ignored.
+ */
+const UNHOOKABLE_ACTIONS: readonly Action["type"][] = [
+  "skip",
+  "modify",
+  "fake",
+];
+
+/**
+ * Hands the cached decision and the ignored descendants of a nested runtime,
+ * such as `pipeline`, to `ctx` and returns the action without the cache.
+ */
+function takeCache(ctx: CommandContext, action: Action): Action {
+  if ("ignoreDescendants" in action && action.ignoreDescendants === true) {
+    ctx.ignoreDescendants();
+  }
+  if (!("cache" in action) || action.cache === undefined) {
+    return action;
+  }
+
+  const { cache, ...rest } = action;
+  ctx.cache(JSON.parse(cache.state) as unknown);
+  if (cache.ignoreDescendants) {
+    ctx.ignoreDescendants();
+  }
+  return rest as Action;
+}
+
 class RuntimeCommandContext implements CommandContext {
   private currentAction: Action = { type: "skip" };
   private propagationStopped = false;
   private actionSet = false;
+  /** Index of the service handling the command. */
+  service = 0;
+  /** The states passed to `cache`, by service. */
+  states: unknown[] | undefined;
 
   constructor(
     private readonly owner: ServiceRuntime,
@@ -128,9 +189,14 @@ class RuntimeCommandContext implements CommandContext {
     this.currentAction = { type: "modify", data };
   }
 
+  fake(): void {
+    this.actionSet = true;
+    this.currentAction = { type: "fake" };
+  }
+
   setAction(action: Action): void {
     this.actionSet = true;
-    this.currentAction = action;
+    this.currentAction = takeCache(this, action);
   }
 
   ignoreDescendants(): void {
@@ -141,6 +207,11 @@ class RuntimeCommandContext implements CommandContext {
     this.propagationStopped = true;
   }
 
+  cache(state?: unknown): void {
+    this.states ??= [];
+    this.states[this.service] = state ?? null;
+  }
+
   hasAction(): boolean {
     return this.actionSet;
   }
@@ -155,6 +226,8 @@ class ParallelCommandContext implements CommandContext {
     private readonly parent: CommandContext,
     readonly id: number,
     readonly capture: CommandCaptureResult,
+    private readonly service: number,
+    private readonly states: unknown[],
   ) {}
 
   get action(): Action {
@@ -185,9 +258,14 @@ class ParallelCommandContext implements CommandContext {
     this.currentAction = { type: "modify", data };
   }
 
+  fake(): void {
+    this.actionSet = true;
+    this.currentAction = { type: "fake" };
+  }
+
   setAction(action: Action): void {
     this.actionSet = true;
-    this.currentAction = action;
+    this.currentAction = takeCache(this, action);
   }
 
   ignoreDescendants(): void {
@@ -198,6 +276,12 @@ class ParallelCommandContext implements CommandContext {
     this.propagationStopped = true;
   }
 
+  cache(state?: unknown): void {
+    // the services of `parallel` share the state of the parallel service
+    this.states[this.service] = state ?? null;
+    this.parent.cache(this.states);
+  }
+
   hasAction(): boolean {
     return this.actionSet;
   }
@@ -238,9 +322,21 @@ export class ServiceRuntime {
         current = next;
       }
     }
+    if (current.options.directHook === true && this.handlesExecution()) {
+      // nothing reports the exit of a command decided on the direct path
+      current.options.directHook = false;
+    }
     return current;
   }
 
+  /**
+   * Whether a service reads the results of commands, they must then all go
+   * through `catter-proxy`.
+   */
+  handlesExecution(): boolean {
+    return this.services.some((service) => service.onExecution !== undefined);
+  }
+
   async finish(result: ProcessResult): Promise<void> {
     for (const service of this.services) {
       await service.onFinish?.(result);
@@ -252,15 +348,32 @@ export class ServiceRuntime {
 
     const ctx = new RuntimeCommandContext(this, id, data);
     if (this.hasIgnoredAncestor(id)) {
-      return ctx.action;
+      // it reached catter although its ancestor ran without the hook
+      return { type: "skip", ignoreDescendants: true };
     }
 
     await this.dispatchCommand(ctx);
-    return ctx.action;
+
+    let action = ctx.action;
+    if (this.isIgnored(id) && UNHOOKABLE_ACTIONS.includes(action.type)) {
+      // nothing below the command is dispatched, so nothing below it is hooked
+      action = { ...action, ignoreDescendants: true } as Action;
+    }
+    if (ctx.states === undefined || !CACHEABLE_ACTIONS.includes(action.type)) {
+      return action;
+    }
+    return {
+      ...action,
+      cache: {
+        state: JSON.stringify(ctx.states),
+        ignoreDescendants: this.isIgnored(id),
+      },
+    } as Action;
   }
 
-  async dispatchCommand(ctx: CommandContext): Promise<void> {
-    for (const service of this.services) {
+  async dispatchCommand(ctx: RuntimeCommandContext): Promise<void> {
+    for (const [index, service] of this.services.entries()) {
+      ctx.service = index;
       const action = await service.onCommand?.(ctx);
       if (action !== undefined) {
         ctx.setAction(action);
@@ -285,6 +398,28 @@ export class ServiceRuntime {
     }
   }
 
+  /**
+   * Collects the state of every service, in registration order.
+   */
+  async collect(): Promise<unknown[]> {
+    const states: unknown[] = [];
+    for (const service of this.services) {
+      states.push(await service.onCollect?.());
+    }
+    return states;
+  }
+
+  /**
+   * Hands each service its own entry of every state returned by `collect`.
+   */
+  async merge(states: unknown[]): Promise<void> {
+    for (const [index, service] of this.services.entries()) {
+      await service.onMerge?.(
+        states.map((state) => (state as unknown[] | null)?.[index]),
+      );
+    }
+  }
+
   rememberCommand(id: number, parentId?: number): void {
     this.commandParentIds.set(id, parentId);
   }
@@ -322,11 +457,18 @@ export class ServiceRuntime {
   }
 
   asService(): CatterService {
+    const runtime = this;
     return {
       onStart: (config) => this.start(config),
       onFinish: (result) => this.finish(result),
       onCommand: (id, data) => this.command(id, data),
-      onExecution: (id, result) => this.execution(id, result),
+      get onExecution() {
+        return runtime.handlesExecution()
+          ? (id: number, result: ProcessResult) => runtime.execution(id, result)
+          : undefined;
+      },
+      onCollect: () => this.collect(),
+      onMerge: (states) => this.merge(states),
     };
   }
 }
@@ -363,9 +505,30 @@ export function parallel(
     onCommand: async (ctx) => {
       return await dispatchParallelCommand(runtimeServices, ctx);
     },
-    onExecution: async (ctx) => {
+    get onExecution() {
+      if (
+        runtimeServices.every((service) => service.onExecution === undefined)
+      ) {
+        return undefined;
+      }
+      return async (ctx: ExecutionContext) => {
+        await Promise.all(
+          runtimeServices.map((service) => service.onExecution?.(ctx)),
+        );
+      };
+    },
+    onCollect: async () => {
+      return await Promise.all(
+        runtimeServices.map((service) => service.onCollect?.()),
+      );
+    },
+    onMerge: async (states) => {
       await Promise.all(
-        runtimeServices.map((service) => service.onExecution?.(ctx)),
+        runtimeServices.map((service, index) =>
+          service.onMerge?.(
+            states.map((state) => (state as unknown[] | null)?.[index]),
+          ),
+        ),
       );
     },
   };
@@ -385,12 +548,19 @@ function adaptService(service: RegisterableService): RuntimeService {
   return {
     onStart: service.onStart,
     onFinish: service.onFinish,
+    onCollect: service.onCollect,
+    onMerge: service.onMerge,
     onCommand: service.onCommand
       ? (ctx) => callCommandHandler(service.onCommand!, ctx)
       : undefined,
-    onExecution: service.onExecution
-      ? (ctx) => callExecutionHandler(service.onExecution!, ctx)
-      : undefined,
+    // read on every use, a service may only know after `onStart` whether it
+    // needs the results of commands
+    get onExecution() {
+      const handler = service.onExecution;
+      return handler
+        ? (ctx: ExecutionContext) => callExecutionHandler(handler, ctx)
+        : undefined;
+    },
   };
 }
 
@@ -418,13 +588,20 @@ async function dispatchParallelCommand(
   services: RuntimeService[],
   parent: CommandContext,
 ): Promise<Action | undefined> {
+  const states: unknown[] = [];
   const outputs = await Promise.all(
-    services.map(async (service) => {
+    services.map(async (service, index) => {
       if (!service.onCommand) {
         return undefined;
       }
 
-      const ctx = new ParallelCommandContext(parent, parent.id, parent.capture);
+      const ctx = new ParallelCommandContext(
+        parent,
+        parent.id,
+        parent.capture,
+        index,
+        states,
+      );
       const returned = await service.onCommand(ctx);
       if (returned !== undefined) {
         ctx.setAction(returned);
@@ -90,6 +90,7 @@ manager.merge(extra);
 
 const mergedItems = manager.items();
 expectEq(mergedItems.length, 5, "merged item count");
+expectEq(manager.size(), 5, "merged size");
 const keptItem = expectDefined(
   mergedItems.find((item) => item.file === "../src/keep.cc"),
   "kept inherited item",
@@ -178,3 +179,85 @@ expectEq(
   "-DNAME=你好",
   "reloaded unicode flag",
 );
+
+function readText(path: string): string {
+  let content = "";
+  io.TextFileStream.with(path, "utf-8", (stream) => {
+    content = stream.readEntireFile();
+  });
+  return content;
+}
+
+const streamedPath = fs.path.joinAll(testEnvPath, "streamed.json");
+const writer = new cdb.CDBWriter(streamedPath);
+for (const item of inheritedItems) {
+  writer.append(item);
+}
+expectEq(writer.entries, inheritedItems.length, "streamed entry count");
+debug.assertThrow(!fs.exists(streamedPath));
+writer.close();
+expectEq(
+  readText(streamedPath),
+  JSON.stringify(inheritedItems, null, 2),
+  "streamed text",
+);
+debug.assertThrow(!fs.exists(`${streamedPath}.tmp`));
+
+const emptyWriter = new cdb.CDBWriter(streamedPath);
+emptyWriter.close();
+expectEq(readText(streamedPath), "[]", "empty streamed text");
+
+const abortedWriter = new cdb.CDBWriter(savePath);
+abortedWriter.append(inheritedItems[0]);
+abortedWriter.abort();
+expectEq(
+  new cdb.CDBManager(savePath).items().length,
+  5,
+  "aborted writer keeps the previous file",
+);
+debug.assertThrow(!fs.exists(`${savePath}.tmp`));
+
+const writtenPath = fs.path.joinAll(testEnvPath, "written.json");
+const overrideNew = {
+  directory: buildDir,
+  file: "override.cc",
+  command: "clang++ -c override.cc -DFROM_NEW",
+};
+let appendedWhileGenerating = false;
+function* producedItems(): Generator<cdb.CDBItem> {
+  yield overrideNew;
+  appendedWhileGenerating = fs.exists(`${writtenPath}.tmp`);
+  yield { ...overrideNew };
+  yield { directory: sourceDir, file: "new.cc", command: "clang++ -c new.cc" };
+}
+const writtenCount = new cdb.CDBManager(inheritedPath).write(
+  producedItems(),
+  writtenPath,
+);
+debug.assertThrow(appendedWhileGenerating);
+expectEq(writtenCount, 4, "written entry count");
+const writtenItems = new cdb.CDBManager(writtenPath).items();
+expectEq(writtenItems.length, 4, "written item count");
+expectEq(
+  writtenItems.filter((item) => item.file === "override.cc").length,
+  1,
+  "written items replace the inherited ones of their file",
+);
+
+const invalidPath = fs.path.joinAll(testEnvPath, "invalid.json");
+debug.assertThrow(fs.createFile(invalidPath));
+io.TextFileStream.with(invalidPath, "utf-8", (stream) => {
+  stream.write(JSON.stringify([{ directory: buildDir, file: "a.cc" }]));
+});
+let invalidError: unknown;
+try {
+  new cdb.CDBManager(invalidPath);
+} catch (e) {
+  invalidError = e;
+}
+debug.assertThrow(invalidError instanceof cdb.CDBValidationError);
+debug.assertThrow(
+  String((invalidError as Error).message).includes(
+    'expected "command" or "arguments"',
+  ),
+);
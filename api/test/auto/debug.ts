@@ -0,0 +1,14 @@
+import { debug, time } from "catter";
+
+time.unixMs();
+time.unixMs();
+
+const stats = debug.capiStats();
+const unixMs = stats.find((entry) => entry.name === "time_unix_ms");
+debug.assertThrow(unixMs !== undefined);
+debug.assertThrow(unixMs!.calls >= 2);
+debug.assertThrow(unixMs!.totalUs >= 0);
+
+for (let i = 1; i < stats.length; ++i) {
+  debug.assertThrow(stats[i - 1].totalUs >= stats[i].totalUs);
+}
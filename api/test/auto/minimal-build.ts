@@ -0,0 +1,121 @@
+import {
+  debug,
+  scripts,
+  service,
+  type CatterConfig,
+  type CatterRuntime,
+  type CommandCaptureResult,
+} from "catter";
+
+const runtimeInfo: CatterRuntime = {
+  supportActions: ["skip", "drop", "abort", "modify", "fake"],
+  type: "inject",
+  supportParentId: true,
+};
+
+const config: CatterConfig = {
+  scriptPath: "minimal-build.ts",
+  scriptArgs: [],
+  buildSystemCommand: ["ninja"],
+  buildSystemCommandCwd: "/tmp",
+  runtime: runtimeInfo,
+  options: {
+    decisionWorkers: 4,
+  },
+  execute: true,
+};
+
+function command(argv: string[]): CommandCaptureResult {
+  return {
+    success: true,
+    data: {
+      cwd: "/tmp",
+      exe: argv[0],
+      argv,
+      env: ["PATH=/opt/toolchain/bin"],
+      runtime: runtimeInfo,
+    },
+  };
+}
+
+function outputOf(argv: readonly string[]): string {
+  const flag = argv.indexOf("-o");
+  // ar takes the archive first
+  return flag === -1 ? argv[2] : argv[flag + 1];
+}
+
+const built: string[] = [];
+const runtime = new service.ServiceRuntime();
+runtime.use(
+  scripts.minimalBuild({
+    jobs: 1,
+    async run(faked) {
+      // rebuilt in the environment of the build
+      debug.assertThrow(faked.env[0] === "PATH=/opt/toolchain/bin");
+      built.push(outputOf(faked.argv));
+      return {
+        code: faked.argv.includes("broken.o") ? 1 : 0,
+        stdout: "",
+        stderr: "",
+      };
+    },
+  }),
+);
+
+const started = await runtime.start(config);
+debug.assertThrow(started.execute);
+debug.assertThrow(started.options.decisionWorkers === 0);
+
+const compiles = ["support", "tblgen", "app", "broken"].map((name, id) =>
+  runtime.command(
+    id,
+    command(["/usr/bin/c++", "-c", `${name}.cc`, "-o", `${name}.o`]),
+  ),
+);
+for (const action of await Promise.all(compiles)) {
+  debug.assertThrow(action.type === "fake");
+}
+
+const archive = await runtime.command(
+  10,
+  command(["/usr/bin/ar", "rcs", "libsupport.a", "support.o"]),
+);
+debug.assertThrow(archive.type === "fake");
+
+const links = [
+  ["/usr/bin/c++", "tblgen.o", "libsupport.a", "-o", "bin/tblgen"],
+  ["/usr/bin/c++", "app.o", "libsupport.a", "-o", "bin/app"],
+  ["/usr/bin/c++", "broken.o", "-o", "bin/broken"],
+];
+for (const [id, argv] of links.entries()) {
+  const action = await runtime.command(20 + id, command(argv));
+  debug.assertThrow(action.type === "fake");
+}
+
+// preprocessing is read by the build and runs for real
+const preprocess = await runtime.command(
+  30,
+  command(["/usr/bin/c++", "-E", "app.cc"]),
+);
+debug.assertThrow(preprocess.type === "skip");
+debug.assertThrow(built.length === 0);
+
+// running the tool builds what it was linked from, dependencies first
+const tool = await runtime.command(40, command(["/tmp/bin/tblgen", "x.td"]));
+debug.assertThrow(tool.type === "skip");
+debug.assertThrow(built.length === 4);
+debug.assertThrow(built.indexOf("support.o") < built.indexOf("libsupport.a"));
+debug.assertThrow(built.includes("tblgen.o"));
+debug.assertThrow(built[3] === "bin/tblgen");
+
+// a second run builds nothing again
+await runtime.command(41, command(["bin/tblgen", "y.td"]));
+debug.assertThrow(built.length === 4);
+
+// other tools are unknown, the rest of the build stays fake
+await runtime.command(42, command(["/usr/bin/python3", "gen.py"]));
+debug.assertThrow(built.length === 4);
+
+const broken = await runtime.command(43, command(["/tmp/bin/broken"]));
+debug.assertThrow(broken.type === "abort");
+debug.assertThrow(built[built.length - 1] === "broken.o");
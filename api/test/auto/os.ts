@@ -1,4 +1,4 @@
-import { debug, io, os } from "catter";
+import { debug, fs, io, os } from "catter";
 
 debug.assertThrow(
   os.platform() == "linux" ||
@@ -15,3 +15,17 @@ debug.assertThrow(
 
 io.println(`Operating System: ${os.platform()}`);
 io.println(`Architecture: ${os.arch()}`);
+
+if (os.platform() !== "windows") {
+  const result = await os.run("/bin/sh", ["sh", "-c", "echo out; exit 3"]);
+  debug.assertThrow(result.code === 3);
+  debug.assertThrow(result.stdout === "out\n");
+
+  const withEnv = await os.run(
+    "/bin/sh",
+    ["sh", "-c", "echo $CATTER_OS_RUN"],
+    fs.pwd(),
+    ["CATTER_OS_RUN=build"],
+  );
+  debug.assertThrow(withEnv.stdout === "build\n");
+}
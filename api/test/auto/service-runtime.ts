@@ -80,6 +80,10 @@ debug.assertThrow(
 
 const rootAction = await runtime.command(1, command("gcc"));
 debug.assertThrow(rootAction.type === "modify");
+// the compiler runs without the hook, its children never reach catter
+debug.assertThrow(
+  rootAction.type === "modify" && rootAction.ignoreDescendants === true,
+);
 if (rootAction.type === "modify") {
   debug.assertThrow(
     rootAction.data.argv[rootAction.data.argv.length - 1] === "-Wall",
@@ -255,6 +259,9 @@ if (pipelineAction.type === "modify") {
 }
 debug.assertThrow(pipelineEvents.includes("seen:10"));
 debug.assertThrow(pipelineEvents.includes("action:10"));
+debug.assertThrow(
+  pipelineAction.type === "modify" && pipelineAction.ignoreDescendants === true,
+);
 
 const pipelineChildAction = await pipelineRuntime.command(
   11,
@@ -292,3 +299,84 @@ try {
   conflictSeen = String(error).includes("at most one action result");
 }
 debug.assertThrow(conflictSeen);
+
+const collectedCounts: number[][] = [];
+function countingRuntime(count: number): service.ServiceRuntime {
+  const counting = new service.ServiceRuntime();
+  counting.use(
+    service.create({
+      onCollect() {
+        return count;
+      },
+      onMerge(states) {
+        collectedCounts.push(states as number[]);
+      },
+    }),
+  );
+  counting.use(service.create({}));
+  return counting;
+}
+
+const workerStates = [
+  JSON.parse(JSON.stringify(await countingRuntime(2).collect())) as unknown,
+  JSON.parse(JSON.stringify(await countingRuntime(3).collect())) as unknown,
+];
+await countingRuntime(0).merge(workerStates);
+debug.assertThrow(collectedCounts.length === 1);
+debug.assertThrow(collectedCounts[0].join(",") === "2,3");
+
+const fakeRuntime = new service.ServiceRuntime();
+fakeRuntime.use(
+  service.create({
+    onCommand(ctx) {
+      if (ctx.capture.success && ctx.capture.data.exe === "clang") {
+        ctx.fake();
+      }
+    },
+  }),
+);
+debug.assertThrow(
+  (await fakeRuntime.command(30, command("clang"))).type === "fake",
+);
+debug.assertThrow(
+  (await fakeRuntime.command(31, command("tblgen"))).type === "skip",
+);
+
+const cacheRuntime = new service.ServiceRuntime();
+cacheRuntime.use(service.create({}));
+cacheRuntime.use(
+  service.create({
+    onCommand(ctx) {
+      if (!ctx.capture.success) {
+        return;
+      }
+      ctx.cache({ exe: ctx.capture.data.exe });
+      if (ctx.capture.data.exe === "clang") {
+        ctx.ignoreDescendants();
+        ctx.fake();
+      } else if (ctx.capture.data.exe === "sed") {
+        ctx.modify({ ...ctx.capture.data, argv: ["sed", "-n"] });
+      }
+    },
+  }),
+);
+
+const cachedFake = await cacheRuntime.command(40, command("clang"));
+debug.assertThrow(cachedFake.type === "fake");
+debug.assertThrow(
+  cachedFake.type === "fake" &&
+    cachedFake.cache?.state === '[null,{"exe":"clang"}]' &&
+    cachedFake.cache.ignoreDescendants,
+);
+
+debug.assertThrow(cachedFake.type === "fake" && cachedFake.ignoreDescendants);
+
+const cachedSkip = await cacheRuntime.command(41, command("make"));
+debug.assertThrow(
+  cachedSkip.type === "skip" && cachedSkip.cache?.ignoreDescendants === false,
+);
+debug.assertThrow(!("ignoreDescendants" in cachedSkip));
+
+// a modified command depends on more than the command line
+const uncached = await cacheRuntime.command(42, command("sed"));
+debug.assertThrow(uncached.type === "modify" && !("cache" in uncached));
@@ -0,0 +1,60 @@
+import { debug, scripts } from "catter";
+
+function command(
+  id: number,
+  exe: string,
+  spawn: number,
+  exec: number,
+  exit: number,
+  parent?: number,
+): scripts.TraceCommand {
+  return {
+    id,
+    parent,
+    cwd: "/tmp",
+    exe,
+    argv: [exe],
+    code: 0,
+    stats: {
+      pid: 100 + id,
+      spawn,
+      exec,
+      exit,
+      userTime: 1500,
+      systemTime: 500,
+      maxRss: 2048,
+    },
+  };
+}
+
+const empty = scripts.chromeTrace([]);
+debug.assertThrow(empty.traceEvents.length === 0);
+
+const trace = scripts.chromeTrace([
+  command(3, "/usr/bin/ld", 5_000_200, 5_000_300, 5_000_400, 1),
+  command(1, "/usr/bin/make", 5_000_000, 5_000_000, 5_000_500),
+  command(2, "/usr/bin/cc", 5_000_050, 5_000_060, 5_000_150, 1),
+  // never finished, catter did not run it
+  command(4, "/usr/bin/cc", 5_000_100, 0, 0, 1),
+]);
+
+const slices = trace.traceEvents.filter(
+  (event) => event.ph === "X" && event.cat === "command",
+);
+debug.assertThrow(slices.length === 3);
+debug.assertThrow(slices.map((slice) => slice.name).join() === "make,cc,ld");
+debug.assertThrow(slices[0].ts === 0 && slices[0].dur === 500);
+debug.assertThrow(slices[1].ts === 50 && slices[1].dur === 100);
+debug.assertThrow(slices[0].tid === 0 && slices[1].tid === 1);
+// cc is done by the time ld starts, so ld reuses its track
+debug.assertThrow(slices[2].tid === 1);
+debug.assertThrow(slices[2].args?.userMs === 1.5);
+
+const catter = trace.traceEvents.filter((event) => event.cat === "catter");
+debug.assertThrow(catter.length === 2);
+debug.assertThrow(catter[0].ts === 50 && catter[0].dur === 10);
+
+const running = trace.traceEvents
+  .filter((event) => event.ph === "C")
+  .map((event) => event.args?.commands);
+debug.assertThrow(running.join() === "1,2,1,2,1,0");
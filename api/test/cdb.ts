@@ -150,6 +150,28 @@ try {
   await skippedFailureRuntime.finish({ code: 1, stdout: "", stderr: "" });
   debug.assertThrow(!fs.exists(skippedFailurePath));
 
+  // the compiler runs while it is analyzed, the commands it starts meanwhile are
+  // hidden once the analysis ignores them
+  const descendantsPath = fs.path.joinAll(testEnvPath, "descendants.json");
+  const descendantsRuntime = new service.ServiceRuntime();
+  descendantsRuntime.use(scripts.cdb());
+  const descendantsConfig = await descendantsRuntime.start(
+    config(["--output", descendantsPath, "--quiet"]),
+  );
+  debug.assertThrow(descendantsConfig.options.observeOnly === true);
+  const compilerAction = await descendantsRuntime.command(
+    12,
+    command(
+      ["clang++", "-c", "src/main.cc", "-o", "obj/main.o"],
+      fs.path.absolute(testEnvPath),
+    ),
+  );
+  debug.assertThrow(
+    compilerAction.type === "skip" &&
+      compilerAction.ignoreDescendants === true,
+  );
+  await descendantsRuntime.finish({ code: 0, stdout: "", stderr: "" });
+
   const appendPath = fs.path.joinAll(testEnvPath, "append.json");
   const inherited = new cdb.CDBManager(appendPath, { inherit: false });
   inherited.addItem({
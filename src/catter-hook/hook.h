@@ -1,13 +1,31 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <string>
 #include <kota/async/runtime/task.h>
 
 #include "util/crossplat.h"
 #include "util/data.h"
 
 namespace catter::proxy::hook {
+struct Options {
+    std::string proxy_path = util::get_executable_path().string();
+    /// Socket of catter, handed to the hook library so its proxies reach the same catter.
+    std::string ipc_pipe{};
+    /// Socket of the direct path, handed to the hook library when not empty. Unix only.
+    std::string direct_pipe{};
+    /// File of the executables the hook library runs without asking catter, handed to it when not
+    /// empty. Unix only.
+    std::string exec_filter{};
+    /// How much of the output of the command is kept in the result.
+    data::CaptureMode capture = data::CaptureMode::TAIL;
+    /// Called with the pid of the command once it is spawned.
+    std::function<void(int64_t)> on_start{};
+    /// Attach the hook, so the commands it runs reach catter. See `data::action`.
+    bool inject = true;
+};
+
 /// Run the command with catter proxy hook
-kota::task<data::process_result> run(data::command command,
-                                     data::ipcid_t id,
-                                     std::string proxy_path = util::get_executable_path().string());
+kota::task<data::process_result> run(data::command command, data::ipcid_t id, Options options = {});
 }  // namespace catter::proxy::hook
@@ -12,8 +12,24 @@ constexpr static char OS_DIR_SEPARATOR = '/';
 namespace catter::config::hook {
 constexpr static char KEY_CATTER_PROXY_PATH[] = "__key_catter_proxy_path_v1";
 constexpr static char KEY_CATTER_COMMAND_ID[] = "__key_catter_command_id_v1";
-constexpr static auto KEYS_TO_INJECT =
-    std::array<std::string_view, 2>{KEY_CATTER_PROXY_PATH, KEY_CATTER_COMMAND_ID};
+/// Socket the proxies connect to, unique to the catter running the build.
+constexpr static char KEY_CATTER_IPC_PIPE[] = "__key_catter_ipc_pipe_v1";
+/// Socket of the direct path, only present when catter runs with `--direct-hook`.
+constexpr static char KEY_CATTER_DIRECT_PIPE[] = "__key_catter_direct_pipe_v1";
+/// File of the executables run without asking catter, see `util/exec_filter.h`. Optional.
+constexpr static char KEY_CATTER_EXEC_FILTER[] = "__key_catter_exec_filter_v1";
+/// Keys in which the environment the process started with differs from the environment catter
+/// knows for its command id, joined by `env_delta::key_separator`. Set when the hook runs an
+/// executable matching the exec filter, which keeps the command id of its caller. Optional.
+constexpr static char KEY_CATTER_ENV_CHANGED[] = "__key_catter_env_changed_v1";
+/// `KEY_CATTER_ENV_CHANGED` when the difference can not be described. As a key list it would be
+/// two empty keys, which no environment has.
+constexpr static char ENV_CHANGED_UNKNOWN[] = "=";
+constexpr static auto KEYS_TO_INJECT = std::array<std::string_view, 5>{KEY_CATTER_PROXY_PATH,
+                                                                       KEY_CATTER_COMMAND_ID,
+                                                                       KEY_CATTER_IPC_PIPE,
+                                                                       KEY_CATTER_DIRECT_PIPE,
+                                                                       KEY_CATTER_EXEC_FILTER};
 
 #if defined(CATTER_LINUX)
 constexpr static char KEY_PRELOAD[] = "LD_PRELOAD";
@@ -4,6 +4,8 @@
 #include <cstdlib>
 #include <filesystem>
 #include <format>
+#include <string>
+#include <vector>
 #include <dirent.h>
 #include <spawn.h>
 #include <sys/wait.h>
@@ -20,11 +22,10 @@
 
 namespace catter::proxy::hook {
 
-kota::task<data::process_result> run(data::command command,
-                                     data::ipcid_t id,
-                                     std::string proxy_path) {
-    LOG_INFO("new command id is: {}", id);
+namespace {
 
+/// Preload the hook library and hand it what it needs to reach catter.
+void inject_hook(std::vector<std::string>& env, data::ipcid_t id, const Options& options) {
     const auto lib_path =
         util::get_catter_root_path() / catter::config::hook::RELATIVE_PATH_OF_HOOK_LIB;
 
@@ -36,7 +37,7 @@ kota::task<data::process_result> run(data::command command,
 
     bool preload_injected = false;
     std::string key_preload_prefix = std::string(catter::config::hook::KEY_PRELOAD) + "=";
-    for(auto& env_item: command.env) {
+    for(auto& env_item: env) {
         if(env_item.starts_with(key_preload_prefix)) {
             env_item += catter::config::OS_PATH_SEPARATOR + lib_path.string();
             preload_injected = true;
@@ -45,12 +46,36 @@ kota::task<data::process_result> run(data::command command,
     }
 
     if(!preload_injected) {
-        command.env.push_back(
-            std::format("{}={}", catter::config::hook::KEY_PRELOAD, lib_path.string()));
+        env.push_back(std::format("{}={}", catter::config::hook::KEY_PRELOAD, lib_path.string()));
+    }
+    env.push_back(std::format("{}={}", catter::config::hook::KEY_CATTER_COMMAND_ID, id));
+    env.push_back(
+        std::format("{}={}", catter::config::hook::KEY_CATTER_PROXY_PATH, options.proxy_path));
+    if(!options.ipc_pipe.empty()) {
+        env.push_back(
+            std::format("{}={}", catter::config::hook::KEY_CATTER_IPC_PIPE, options.ipc_pipe));
+    }
+    if(!options.direct_pipe.empty()) {
+        env.push_back(std::format("{}={}",
+                                  catter::config::hook::KEY_CATTER_DIRECT_PIPE,
+                                  options.direct_pipe));
+    }
+    if(!options.exec_filter.empty()) {
+        env.push_back(std::format("{}={}",
+                                  catter::config::hook::KEY_CATTER_EXEC_FILTER,
+                                  options.exec_filter));
+    }
+}
+
+}  // namespace
+
+kota::task<data::process_result> run(data::command command, data::ipcid_t id, Options options) {
+    LOG_INFO("new command id is: {}", id);
+
+    // the environment came from the hook, which already took itself out of it
+    if(options.inject) {
+        inject_hook(command.env, id, options);
     }
-    command.env.push_back(std::format("{}={}", catter::config::hook::KEY_CATTER_COMMAND_ID, id));
-    command.env.push_back(
-        std::format("{}={}", catter::config::hook::KEY_CATTER_PROXY_PATH, proxy_path));
 
     std::string cmd_for_print = "";
     for(auto& arg: command.args) {
@@ -66,10 +91,12 @@ kota::task<data::process_result> run(data::command command,
         .env = command.env,
         .cwd = command.cwd,
         .streams = {kota::process::stdio::inherit(),
-                    kota::process::stdio::pipe(false, true),
-                    kota::process::stdio::pipe(false, true)}
+                    output_stream(options.capture),
+                    output_stream(options.capture)}
     };
-    return catter::capture_process_result(make_process_event(opts));
+    return catter::capture_process_result(
+        notify_start(make_process_event(opts), std::move(options.on_start)),
+        options.capture);
 };
 
 };  // namespace catter::proxy::hook
@@ -1,17 +1,41 @@
 #include "command.h"
 
 #include <format>
+#include <optional>
+#include <string>
+#include <unistd.h>
 
+#include "crossplat.h"
 #include "session.h"
 
 namespace {
 void push_proxy_args(std::vector<std::string>& argv,
                      const catter::Session& sess,
                      std::string_view exec_path,
+                     const std::optional<std::string>& env_changed,
                      bool error = false) {
     argv.emplace_back(sess.proxy_path);
     argv.emplace_back("-p");
     argv.emplace_back(sess.self_id);
+    // the process making the call, the proxy is handed only the command the environment is from
+    argv.emplace_back("--origin");
+    argv.emplace_back(std::format("{}:{}:{}", ::getpid(), ::getppid(), get_thread_id()));
+    if(!sess.ipc_pipe.empty()) {
+        argv.emplace_back("--ipc");
+        argv.emplace_back(sess.ipc_pipe);
+    }
+    if(!sess.direct_pipe.empty()) {
+        argv.emplace_back("--direct");
+        argv.emplace_back(sess.direct_pipe);
+    }
+    if(!sess.exec_filter_file.empty()) {
+        argv.emplace_back("--exec-filter");
+        argv.emplace_back(sess.exec_filter_file);
+    }
+    if(env_changed.has_value()) {
+        argv.emplace_back("--env-changed");
+        argv.emplace_back(*env_changed);
+    }
     argv.emplace_back("--exec");
     argv.emplace_back(exec_path);
     if(!error) {
@@ -34,10 +58,13 @@ std::vector<char*> Command::c_argv() {
     return res;
 }
 
-Command build_proxy_command(const Session& session, const fs::path& path, ArgvRef argv) {
+Command build_proxy_command(const Session& session,
+                            const fs::path& path,
+                            ArgvRef argv,
+                            const std::optional<std::string>& env_changed) {
     Command cmd;
     cmd.path = session.proxy_path;
-    push_proxy_args(cmd.argv, session, path.string());
+    push_proxy_args(cmd.argv, session, path.string(), env_changed);
     for(const auto arg: argv) {
         cmd.argv.emplace_back(arg);
     }
@@ -50,7 +77,7 @@ Command build_error_command(const Session& session,
                             ArgvRef argv) {
     Command cmd;
     cmd.path = session.proxy_path;
-    push_proxy_args(cmd.argv, session, path.string(), true);
+    push_proxy_args(cmd.argv, session, path.string(), std::nullopt, true);
     std::string res_msg = std::format("Catter Proxy Error: {}\n", message);
     if(!argv.empty()) {
         res_msg.append(std::format("in command: "));
@@ -1,5 +1,6 @@
 #pragma once
 #include <filesystem>
+#include <optional>
 #include <span>
 #include <string>
 #include <string_view>
@@ -22,17 +23,22 @@ struct Command {
 /**
  * Build the proxy command.
  *
- * @example /proxy_path -p self_id --exec /bin/cc -- cc -c main.cc
+ * @example /proxy_path -p self_id --origin pid:ppid:tid --exec /bin/cc -- cc -c main.cc
+ * @example /proxy_path -p self_id --origin pid:ppid:tid --direct /direct.sock --exec /bin/cc -- ...
+ * @example /proxy_path -p self_id --origin pid:ppid:tid --env-changed PATH=CC --exec /bin/cc -- ...
+ *
+ * @param env_changed keys changed against the environment of the session, if known.
  */
 [[nodiscard]]
 Command build_proxy_command(const Session& session,
                             const std::filesystem::path& executable,
-                            ArgvRef argv);
+                            ArgvRef argv,
+                            const std::optional<std::string>& env_changed = std::nullopt);
 
 /**
  * Build the proxy error command.
  *
- * @example /proxy_path -p self_id --exec /bin/cc "Catter Proxy Error: ..."
+ * @example /proxy_path -p self_id --origin pid:ppid:tid --exec /bin/cc "Catter Proxy Error: ..."
  */
 [[nodiscard]]
 Command build_error_command(const Session& session,
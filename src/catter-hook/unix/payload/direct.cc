@@ -0,0 +1,237 @@
+#include "direct.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <format>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "crossplat.h"
+#include "debug.h"
+#include "environment.h"
+#include "unix/config.h"
+#include "util/direct.h"
+#include "util/bincode.h"
+#include "util/env_delta.h"
+
+namespace {
+
+class Socket {
+public:
+    explicit Socket(int fd) noexcept : fd(fd) {}
+
+    Socket(const Socket&) = delete;
+    Socket& operator= (const Socket&) = delete;
+
+    ~Socket() {
+        if(fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    int get() const noexcept {
+        return fd;
+    }
+
+private:
+    int fd;
+};
+
+int open_socket() noexcept {
+#ifdef CATTER_LINUX
+    return ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+#else
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd >= 0) {
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+#endif
+}
+
+bool connect_to(int fd, std::string_view path) noexcept {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.data(), path.size());
+
+    while(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        if(errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool write_all(int fd, std::string_view data) noexcept {
+    while(!data.empty()) {
+        auto written = ::write(fd, data.data(), data.size());
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+/// Read one frame and return its body.
+std::optional<std::string> read_frame(int fd) {
+    std::string buffer;
+    char chunk[4096];
+    while(true) {
+        if(auto size = catter::bincode::frame_size(buffer)) {
+            return buffer.substr(catter::bincode::frame_header_size,
+                                 *size - catter::bincode::frame_header_size);
+        }
+        auto got = ::read(fd, chunk, sizeof(chunk));
+        if(got < 0 && errno == EINTR) {
+            continue;
+        }
+        if(got <= 0) {
+            return std::nullopt;
+        }
+        buffer.append(chunk, static_cast<size_t>(got));
+    }
+}
+
+std::string current_directory() {
+    char buf[PATH_MAX];
+    if(::getcwd(buf, sizeof(buf)) == nullptr) {
+        return {};
+    }
+    return buf;
+}
+
+}  // namespace
+
+namespace catter {
+
+std::optional<direct::reply> request_decision(const Session& session,
+                                              const char* executable,
+                                              ArgvRef argv,
+                                              char* const env[],
+                                              const std::optional<std::string>& changed) noexcept {
+    // errno is observable by the caller if we fall back, keep it untouched
+    const int saved_errno = errno;
+    try {
+        direct::request req{
+            .parent_id = std::stoi(std::string(session.self_id)),
+            .cwd = current_directory(),
+            .executable = executable,
+            .pid = ::getpid(),
+            .ppid = ::getppid(),
+            .tid = static_cast<int64_t>(get_thread_id()),
+        };
+        for(const auto* arg: argv) {
+            req.args.emplace_back(arg);
+        }
+        std::vector<std::string_view> entries;
+        for(auto it = env; it != nullptr && *it != nullptr; ++it) {
+            entries.emplace_back(*it);
+        }
+        if(changed.has_value()) {
+            req.env_delta = true;
+            env_delta::select(entries, *changed, req.env, req.env_unset);
+        } else {
+            req.env.assign(entries.begin(), entries.end());
+        }
+
+        std::optional<direct::reply> rep;
+        auto frame = direct::encode(req);
+        Socket socket(open_socket());
+        if(frame.has_value() && socket.get() >= 0 &&
+           connect_to(socket.get(), session.direct_pipe) && write_all(socket.get(), *frame)) {
+            if(auto body = read_frame(socket.get())) {
+                rep = direct::decode_reply(*body);
+            }
+        }
+
+        if(!rep.has_value()) {
+            WARN("direct request to {} failed, fallback to catter-proxy", session.direct_pipe);
+        } else if(rep->env_delta) {
+            std::vector<std::string> full_env(entries.begin(), entries.end());
+            env_delta::apply(full_env, rep->env, rep->env_unset);
+            rep->env = std::move(full_env);
+            rep->env_unset.clear();
+            rep->env_delta = false;
+        }
+        errno = saved_errno;
+        return rep;
+    } catch(const std::exception& err) {
+        WARN("direct request failed: {}, fallback to catter-proxy", err.what());
+    } catch(...) {
+        WARN("direct request failed with unknown exception, fallback to catter-proxy");
+    }
+    errno = saved_errno;
+    return std::nullopt;
+}
+
+std::string_view find_hook_library(const char* const envp[]) noexcept {
+    if(envp == nullptr) {
+        return {};
+    }
+    const char* preload = env::get_env_value(envp, config::hook::KEY_PRELOAD);
+    if(preload == nullptr) {
+        return {};
+    }
+    for(const auto& lib: std::string_view(preload) | std::views::split(config::OS_PATH_SEPARATOR)) {
+        std::string_view lib_sv(lib.begin(), lib.end());
+        if(lib_sv.ends_with(config::hook::HOOK_LIB_NAME)) {
+            return lib_sv;
+        }
+    }
+    return {};
+}
+
+SanitizedEnv attach_environment(const char* const envp[],
+                                char* const env[],
+                                std::string_view hook_library,
+                                int32_t id) {
+    SanitizedEnv result;
+    result.entries.reserve(64);
+
+    bool preload_attached = false;
+    for(auto it = env; it != nullptr && *it != nullptr; ++it) {
+        if(env::is_entry_of(*it, config::hook::KEY_PRELOAD)) {
+            result.owned_entries.push_back(
+                std::format("{}{}{}", *it, config::OS_PATH_SEPARATOR, hook_library));
+            result.entries.push_back(result.owned_entries.back().data());
+            preload_attached = true;
+            continue;
+        }
+        result.entries.push_back(*it);
+    }
+
+    if(!preload_attached) {
+        result.owned_entries.push_back(
+            std::format("{}{}", config::hook::LD_PRELOAD_INIT_ENTRY, hook_library));
+        result.entries.push_back(result.owned_entries.back().data());
+    }
+
+    for(const auto& key: config::hook::KEYS_TO_INJECT) {
+        if(key == config::hook::KEY_CATTER_COMMAND_ID) {
+            result.owned_entries.push_back(std::format("{}={}", key, id));
+            result.entries.push_back(result.owned_entries.back().data());
+        } else if(auto* entry = env::get_env_entry(envp, key)) {
+            result.entries.push_back(const_cast<char*>(entry));
+        }
+    }
+
+    result.entries.push_back(nullptr);
+    return result;
+}
+
+}  // namespace catter
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "command.h"
+#include "env_sanitizer.h"
+#include "session.h"
+#include "util/direct.h"
+
+namespace catter {
+
+/**
+ * Ask catter for a decision over the direct socket of the session.
+ *
+ * @param env the sanitized environment of the command, reported as its environment.
+ * @param changed keys of `env` changed against the session, only those are sent if known.
+ * @return nullopt if catter can not be reached, the caller then goes through catter-proxy. The
+ * environment of the reply is always complete.
+ */
+[[nodiscard]]
+std::optional<direct::reply> request_decision(const Session& session,
+                                              const char* executable,
+                                              ArgvRef argv,
+                                              char* const env[],
+                                              const std::optional<std::string>& changed) noexcept;
+
+/**
+ * @return the path of the hook library in the preload list of `envp`, empty if not found.
+ */
+[[nodiscard]]
+std::string_view find_hook_library(const char* const envp[]) noexcept;
+
+/**
+ * Build the environment of a command launched by the payload itself.
+ *
+ * The result is `env` with the hook library appended to the preload list and the session keys
+ * copied from `envp`, except the command id, which becomes `id`.
+ */
+[[nodiscard]]
+SanitizedEnv attach_environment(const char* const envp[],
+                                char* const env[],
+                                std::string_view hook_library,
+                                int32_t id);
+
+}  // namespace catter
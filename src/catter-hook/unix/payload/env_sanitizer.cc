@@ -1,80 +1,184 @@
 #include "env_sanitizer.h"
 
+#include <algorithm>
 #include <cstddef>
-#include <cstring>
 #include <list>
 #include <optional>
-#include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "unix/config.h"
 #include "unix/payload/environment.h"
+#include "util/env_delta.h"
 
 namespace {
-bool should_drop_entry(const char* entry) noexcept {
-    for(const auto& key: catter::config::hook::KEYS_TO_INJECT) {
-        if(catter::env::is_entry_of(entry, key)) {
+/// Entries of `envp` sorted by key, nullopt if some key appears twice.
+std::optional<std::vector<std::string_view>> sorted_entries(char* const envp[]) {
+    std::vector<std::string_view> entries;
+    for(auto it = envp; it != nullptr && *it != nullptr; ++it) {
+        entries.emplace_back(*it);
+    }
+    if(!catter::sort_entries(entries)) {
+        return std::nullopt;
+    }
+    return entries;
+}
+
+/// Whether the preload `entry` names a library besides the hook, so `sanitize_preload_entry`
+/// keeps it.
+bool preloads_other_libraries(std::string_view entry) noexcept {
+    auto value = entry.substr(entry.find('=') + 1);
+    while(true) {
+        auto pos = value.find(catter::config::OS_PATH_SEPARATOR);
+        auto lib = value.substr(0, pos);
+        if(!lib.empty() && !lib.ends_with(catter::config::hook::HOOK_LIB_NAME)) {
+            return true;
+        }
+        if(pos == std::string_view::npos) {
+            return false;
+        }
+        value.remove_prefix(pos + 1);
+    }
+}
+}  // namespace
+
+namespace catter {
+bool is_hook_entry(const char* entry) noexcept {
+    for(const auto& key: config::hook::KEYS_TO_INJECT) {
+        if(env::is_entry_of(entry, key)) {
             return true;
         }
     }
-    return false;
+    return env::is_entry_of(entry, config::hook::KEY_CATTER_ENV_CHANGED);
 }
 
-std::optional<std::string> sanitize_preload_entry(const char* entry) noexcept {
-    std::string_view full_entry(entry);
-    size_t eq_pos = full_entry.find('=');
+std::size_t sanitize_preload_entry(std::string_view entry, char* out) noexcept {
+    size_t eq_pos = entry.find('=');
     if(eq_pos == std::string_view::npos)
-        return std::nullopt;
+        return 0;
 
-    auto value = full_entry.substr(eq_pos + 1);
-    std::string new_value;
-    for(const auto& lib: value | std::views::split(catter::config::OS_PATH_SEPARATOR)) {
-        std::string_view lib_sv(lib.begin(), lib.end());
-        if(lib_sv.ends_with(catter::config::hook::HOOK_LIB_NAME)) {
-            continue;
+    std::string_view prefix = config::hook::LD_PRELOAD_INIT_ENTRY;
+    std::size_t size = prefix.copy(out, prefix.size());
+    auto value = entry.substr(eq_pos + 1);
+    while(true) {
+        auto pos = value.find(config::OS_PATH_SEPARATOR);
+        auto lib = value.substr(0, pos);
+        if(!lib.ends_with(config::hook::HOOK_LIB_NAME)) {
+            if(size > prefix.size()) {
+                out[size++] = config::OS_PATH_SEPARATOR;
+            }
+            size += lib.copy(out + size, lib.size());
         }
-        if(!new_value.empty()) {
-            new_value += catter::config::OS_PATH_SEPARATOR;
+        if(pos == std::string_view::npos) {
+            break;
         }
-        new_value += lib_sv;
+        value.remove_prefix(pos + 1);
     }
-    if(new_value.empty()) {
+    if(size == prefix.size()) {
         // If the new value is empty, we just skip this entry.
-        return std::nullopt;
+        return 0;
     }
-    return catter::config::hook::LD_PRELOAD_INIT_ENTRY + new_value;
+    out[size] = '\0';
+    return size;
+}
+
+bool sort_entries(std::span<std::string_view> entries) noexcept {
+    auto by_key = [](std::string_view lhs, std::string_view rhs) {
+        return env_delta::key_of(lhs) < env_delta::key_of(rhs);
+    };
+    std::ranges::sort(entries, by_key);
+    auto dup = std::ranges::adjacent_find(entries, [](std::string_view lhs, std::string_view rhs) {
+        return env_delta::key_of(lhs) == env_delta::key_of(rhs);
+    });
+    return dup == entries.end();
 }
-}  // namespace
 
-namespace catter {
 SanitizedEnv sanitize_environment(char* const envp[]) noexcept {
     SanitizedEnv env;
     env.entries.reserve(64);
+    for_each_sanitized_entry(
+        envp,
+        [&](std::size_t size) { return env.owned_entries.emplace_back(size, '\0').data(); },
+        [&](char* entry) { env.entries.push_back(entry); });
+    env.entries.push_back(nullptr);
+    return env;
+}
 
-    if(envp == nullptr) {
-        env.entries.push_back(nullptr);
-        return env;
-    }
-
-    for(size_t i = 0; envp[i] != nullptr; ++i) {
-        if(should_drop_entry(envp[i])) {
+std::optional<std::span<const std::string_view>>
+    snapshot_environment(const char* const envp[], std::span<std::string_view> storage) noexcept {
+    std::size_t size = 0;
+    for(auto it = envp; it != nullptr && *it != nullptr; ++it) {
+        if(is_hook_entry(*it) || (env::is_entry_of(*it, config::hook::KEY_PRELOAD) &&
+                                  !preloads_other_libraries(*it))) {
             continue;
         }
+        if(size == storage.size()) {
+            return std::nullopt;
+        }
+        storage[size++] = *it;
+    }
+    auto entries = storage.first(size);
+    if(!sort_entries(entries)) {
+        return std::nullopt;
+    }
+    return entries;
+}
 
-        if(catter::env::is_entry_of(envp[i], catter::config::hook::KEY_PRELOAD)) {
-            auto new_entry = sanitize_preload_entry(envp[i]);
-            if(!new_entry.has_value()) {
-                continue;
+std::size_t join_changed_keys(std::span<const std::string_view> snapshot,
+                              std::span<const std::string_view> current,
+                              std::string_view base_changes,
+                              char* out) noexcept {
+    // `base_changes` is joined already
+    std::size_t size = 0;
+    auto append = [&](std::string_view key) {
+        if(size != 0) {
+            if(out != nullptr) {
+                out[size] = env_delta::key_separator;
             }
-            env.owned_entries.push_back(std::move(*new_entry));
-            env.entries.push_back(env.owned_entries.back().data());
-            continue;
+            ++size;
+        }
+        if(out != nullptr) {
+            key.copy(out + size, key.size());
         }
-        env.entries.push_back(envp[i]);
+        size += key.size();
+    };
+    append(base_changes);
+    for_each_changed_key(snapshot, current, append);
+    return size;
+}
+
+std::optional<std::string> changed_environment_keys(std::span<const std::string_view> snapshot,
+                                                    char* const envp[],
+                                                    std::string_view base_changes) {
+    auto current = sorted_entries(envp);
+    if(!current.has_value()) {
+        return std::nullopt;
+    }
+
+    std::string joined(join_changed_keys(snapshot, *current, base_changes, nullptr), '\0');
+    join_changed_keys(snapshot, *current, base_changes, joined.data());
+    return joined;
+}
+
+SanitizedEnv
+    pass_through_environment(char* const envp[],
+                             const std::optional<std::span<const std::string_view>>& snapshot,
+                             std::string_view base_changes) {
+    std::optional<std::string> changed;
+    if(snapshot.has_value()) {
+        auto clean_env = sanitize_environment(envp);
+        changed = changed_environment_keys(*snapshot, clean_env.data(), base_changes);
     }
-    env.entries.push_back(nullptr);
 
+    SanitizedEnv env;
+    for_each_passed_entry(
+        envp,
+        changed.value_or(config::hook::ENV_CHANGED_UNKNOWN),
+        [&](std::size_t size) { return env.owned_entries.emplace_back(size, '\0').data(); },
+        [&](char* entry) { env.entries.push_back(entry); });
+    env.entries.push_back(nullptr);
     return env;
 }
 }  // namespace catter
@@ -1,9 +1,18 @@
 #pragma once
 
+#include <cstddef>
+#include <iterator>
 #include <list>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "unix/config.h"
+#include "unix/payload/environment.h"
+#include "util/env_delta.h"
+
 namespace catter {
 
 struct SanitizedEnv {
@@ -19,4 +28,160 @@ struct SanitizedEnv {
 /// Remove envs used by hook so the target process is not affected by them.
 [[nodiscard]]
 SanitizedEnv sanitize_environment(char* const envp[]) noexcept;
+
+/// Whether `entry` is one of `config::hook::KEYS_TO_INJECT` or `KEY_CATTER_ENV_CHANGED`, which
+/// the command never sees.
+[[nodiscard]]
+bool is_hook_entry(const char* entry) noexcept;
+
+/**
+ * Write the preload `entry` without the hook library to `out`, which has room for `entry` and
+ * its terminating NUL.
+ *
+ * @return the size written, 0 if no library is left and the entry is dropped.
+ */
+std::size_t sanitize_preload_entry(std::string_view entry, char* out) noexcept;
+
+/**
+ * Call `keep` with each entry of `envp` the command sees, which `sanitize_environment` and the lean
+ * route share. The preload entry without the hook library is written to `allocate(size)`, room
+ * for `size` characters, and dropped if that is nullptr.
+ */
+template <typename Allocate, typename Keep>
+void for_each_sanitized_entry(char* const envp[], Allocate&& allocate, Keep&& keep) {
+    for(auto it = envp; it != nullptr && *it != nullptr; ++it) {
+        if(is_hook_entry(*it)) {
+            continue;
+        }
+        if(env::is_entry_of(*it, config::hook::KEY_PRELOAD)) {
+            char* entry = allocate(std::string_view(*it).size() + 1);
+            if(entry != nullptr && sanitize_preload_entry(*it, entry) != 0) {
+                keep(entry);
+            }
+            continue;
+        }
+        keep(*it);
+    }
+}
+
+/**
+ * Sort environment entries by key.
+ *
+ * @return false if some key appears twice, which a list of keys can not describe.
+ */
+[[nodiscard]]
+bool sort_entries(std::span<std::string_view> entries) noexcept;
+
+/**
+ * Call `visit` with each key whose entries differ between `before` and `after`, both sorted by
+ * key, including the keys added and removed. The preload key is always visited, since the hook
+ * rewrites it.
+ */
+template <typename Before, typename After, typename Visit>
+void for_each_changed_key(const Before& before, const After& after, Visit&& visit) {
+    using env_delta::key_of;
+    auto lhs = std::begin(before);
+    auto rhs = std::begin(after);
+    while(lhs != std::end(before) || rhs != std::end(after)) {
+        auto before_key = lhs != std::end(before) ? key_of(*lhs) : std::string_view{};
+        auto after_key = rhs != std::end(after) ? key_of(*rhs) : std::string_view{};
+        if(rhs == std::end(after) || (lhs != std::end(before) && before_key < after_key)) {
+            // removed
+            visit(before_key);
+            ++lhs;
+        } else if(lhs == std::end(before) || after_key < before_key) {
+            // added
+            visit(after_key);
+            ++rhs;
+        } else {
+            if(std::string_view(*lhs) != std::string_view(*rhs) ||
+               after_key == config::hook::KEY_PRELOAD) {
+                visit(after_key);
+            }
+            ++lhs;
+            ++rhs;
+        }
+    }
+}
+
+/**
+ * Take the entries of `envp` the command sees, sorted by key, to compare later environments
+ * against. Does not allocate: the preload entry is kept as it is rather than sanitized, since
+ * `for_each_changed_key` only looks at its key.
+ *
+ * @param storage room for the entries, which the snapshot is a part of.
+ * @return nullopt if `storage` is too small or some key appears twice, which a list of keys can
+ * not describe.
+ */
+[[nodiscard]]
+std::optional<std::span<const std::string_view>>
+    snapshot_environment(const char* const envp[], std::span<std::string_view> storage) noexcept;
+
+/**
+ * Write what `changed_environment_keys` returns for `current`, the sanitized environment sorted by
+ * key, to `out` unless it is nullptr, without a terminating NUL.
+ *
+ * @return the size of the keys.
+ */
+std::size_t join_changed_keys(std::span<const std::string_view> snapshot,
+                              std::span<const std::string_view> current,
+                              std::string_view base_changes,
+                              char* out) noexcept;
+
+/**
+ * Find the keys whose entries in the sanitized `envp` differ from `snapshot`, see
+ * `for_each_changed_key`, after the keys `base_changes` in which `snapshot` already differs from
+ * the environment of the command.
+ *
+ * @return the keys joined by `env_delta::key_separator`, nullopt if some key appears twice.
+ */
+[[nodiscard]]
+std::optional<std::string> changed_environment_keys(std::span<const std::string_view> snapshot,
+                                                    char* const envp[],
+                                                    std::string_view base_changes = {});
+
+/**
+ * The environment to run an executable matching the exec filter with. It is `envp` as it is, so
+ * the hook stays attached, with `KEY_CATTER_ENV_CHANGED` describing how it differs from the
+ * environment of the command, whose id the process keeps.
+ *
+ * @param snapshot the snapshot of this process, see `snapshot_environment`.
+ * @param base_changes the keys `snapshot` differs in from the environment of the command.
+ */
+[[nodiscard]]
+SanitizedEnv
+    pass_through_environment(char* const envp[],
+                             const std::optional<std::span<const std::string_view>>& snapshot,
+                             std::string_view base_changes);
+
+/**
+ * Call `keep` with each entry `pass_through_environment` returns: those of `envp` but
+ * `KEY_CATTER_ENV_CHANGED`, then the entry of that key with `changed`, written to
+ * `allocate(size)`, room for `size` characters.
+ *
+ * @return false if `allocate` returns nullptr, and `keep` is not called.
+ */
+template <typename Allocate, typename Keep>
+bool for_each_passed_entry(char* const envp[],
+                           std::string_view changed,
+                           Allocate&& allocate,
+                           Keep&& keep) {
+    std::string_view key = config::hook::KEY_CATTER_ENV_CHANGED;
+    char* entry = allocate(key.size() + changed.size() + 2);
+    if(entry == nullptr) {
+        return false;
+    }
+    std::size_t size = key.copy(entry, key.size());
+    entry[size++] = '=';
+    size += changed.copy(entry + size, changed.size());
+    entry[size] = '\0';
+
+    for(auto it = envp; it != nullptr && *it != nullptr; ++it) {
+        if(!env::is_entry_of(*it, key)) {
+            keep(*it);
+        }
+    }
+    keep(entry);
+    return true;
+}
 }  // namespace catter
@@ -5,16 +5,20 @@
 #include <exception>
 #include <filesystem>
 #include <format>
+#include <optional>
 #include <span>
+#include <string>
 #include <string_view>
 #include <vector>
 
 #include "command.h"
 #include "crossplat.h"
 #include "debug.h"
+#include "direct.h"
 #include "env_sanitizer.h"
 #include "environment.h"
 #include "error.h"
+#include "lean.h"
 #include "session.h"
 #include "shared/resolver.h"
 
@@ -60,6 +64,16 @@ char** collect_variadic_envp(va_list* ap) {
     return va_arg(*ap, char**);
 }
 
+std::vector<char*> c_strings(std::vector<std::string>& values) {
+    std::vector<char*> res;
+    res.reserve(values.size() + 1);
+    for(auto& value: values) {
+        res.push_back(value.data());
+    }
+    res.push_back(nullptr);
+    return res;
+}
+
 std::filesystem::path resolve_path_like(const char* path) {
     auto resolved = catter::hook::shared::resolver::resolve_path_like(path);
     if(!resolved.has_value()) {
@@ -152,9 +166,27 @@ PosixSpawnFn* resolve_posix_spawn() {
     return fp;
 }
 
-void Executor::init(const char* const envp[]) noexcept {
+void Executor::init(const char* const envp[],
+                    std::span<const char*> initial_env,
+                    std::span<std::string_view> snapshot) noexcept {
     m_session = Session::make(envp);
+    // `setenv` may replace the array, or change it in place, but the entries stay
+    std::size_t count = 0;
+    while(envp != nullptr && envp[count] != nullptr && count + 1 < initial_env.size()) {
+        initial_env[count] = envp[count];
+        ++count;
+    }
+    if(envp != nullptr && envp[count] == nullptr && count < initial_env.size()) {
+        initial_env[count] = nullptr;
+        m_initial_env = initial_env.data();
+    } else {
+        // too large to copy, the proxies send the whole environment
+        WARN("environment of the process is too large to keep");
+    }
+    m_snapshot = snapshot;
 
+    // resolved here rather than on the first call, which may take the lock of the loader in the
+    // child of a `vfork`
     try {
         m_execve = resolve_execve();
         m_posix_spawn = resolve_posix_spawn();
@@ -171,11 +203,34 @@ void Executor::init(const char* const envp[]) noexcept {
 
 void Executor::init(Session session, ExecveFn* execve, PosixSpawnFn* posix_spawn) noexcept {
     m_session = session;
+    m_loaded = session;
+    m_state = loaded;
     m_execve = execve;
     m_posix_spawn = posix_spawn;
 }
 
+const Session& Executor::session() noexcept {
+    if(m_state.load(std::memory_order_acquire) == loaded) {
+        return m_loaded;
+    }
+    // never waits for another thread, which a `fork` may have left loading for good
+    auto expected = unloaded;
+    if(!m_state.compare_exchange_strong(expected, loading, std::memory_order_acquire)) {
+        return expected == loaded ? m_loaded : m_session;
+    }
+    m_loaded = m_session;
+    if(m_initial_env != nullptr) {
+        m_loaded.load(m_initial_env, m_snapshot);
+    }
+    m_state.store(loaded, std::memory_order_release);
+    return m_loaded;
+}
+
 int Executor::execv(const char* path, char* const argv[]) noexcept {
+    lean::Arena arena;
+    if(auto result = lean_execve(arena, lean::resolve_path_like(path), argv, environment())) {
+        return *result;
+    }
     CATTER_EXEC_BOUNDARY("execv", {
         require_path_arg(path, "path");
         return this->run_execve(resolve_path_like(path).c_str(), argv, environment());
@@ -183,6 +238,10 @@ int Executor::execv(const char* path, char* const argv[]) noexcept {
 }
 
 int Executor::execve(const char* path, char* const argv[], char* const envp[]) noexcept {
+    lean::Arena arena;
+    if(auto result = lean_execve(arena, lean::resolve_path_like(path), argv, envp)) {
+        return *result;
+    }
     CATTER_EXEC_BOUNDARY("execve", {
         require_path_arg(path, "path");
         return this->run_execve(resolve_path_like(path).c_str(), argv, envp);
@@ -190,6 +249,11 @@ int Executor::execve(const char* path, char* const argv[], char* const envp[]) n
 }
 
 int Executor::execvp(const char* file, char* const argv[]) noexcept {
+    lean::Arena arena;
+    auto* executable = lean::resolve_from_path(arena, file, environment());
+    if(auto result = lean_execve(arena, executable, argv, environment())) {
+        return *result;
+    }
     CATTER_EXEC_BOUNDARY("execvp", {
         require_path_arg(file, "file");
         auto envp = environment();
@@ -198,6 +262,11 @@ int Executor::execvp(const char* file, char* const argv[]) noexcept {
 }
 
 int Executor::execvpe(const char* file, char* const argv[], char* const envp[]) noexcept {
+    lean::Arena arena;
+    auto* executable = lean::resolve_from_path(arena, file, environment());
+    if(auto result = lean_execve(arena, executable, argv, envp)) {
+        return *result;
+    }
     CATTER_EXEC_BOUNDARY("execvpe", {
         require_path_arg(file, "file");
         return this->run_execve(resolve_from_path(file, environment()).c_str(), argv, envp);
@@ -237,6 +306,11 @@ int Executor::execvP(const char* file,
                      const char* search_path,
                      char* const argv[],
                      char* const envp[]) noexcept {
+    lean::Arena arena;
+    auto* executable = lean::resolve_from_search_path(arena, file, search_path);
+    if(auto result = lean_execve(arena, executable, argv, envp)) {
+        return *result;
+    }
     CATTER_EXEC_BOUNDARY("execvP", {
         require_path_arg(file, "file");
         require_path_arg(search_path, "search_path");
@@ -245,6 +319,10 @@ int Executor::execvP(const char* file,
 }
 
 int Executor::exect(const char* path, char* const argv[], char* const envp[]) noexcept {
+    lean::Arena arena;
+    if(auto result = lean_execve(arena, lean::resolve_path_like(path), argv, envp)) {
+        return *result;
+    }
     CATTER_EXEC_BOUNDARY("exect", {
         require_path_arg(path, "path");
         return this->run_execve(resolve_path_like(path).c_str(), argv, envp);
@@ -257,6 +335,12 @@ int Executor::posix_spawn(pid_t* pid,
                           const posix_spawnattr_t* attrp,
                           char* const argv[],
                           char* const envp[]) noexcept {
+    lean::Arena arena;
+    auto* executable = lean::resolve_path_like(path);
+    if(auto result =
+           lean_posix_spawn(arena, pid, executable, file_actions, attrp, argv, envp)) {
+        return *result;
+    }
     CATTER_SPAWN_BOUNDARY("posix_spawn", {
         require_path_arg(path, "path");
         return this->run_posix_spawn(pid,
@@ -274,6 +358,12 @@ int Executor::posix_spawnp(pid_t* pid,
                            const posix_spawnattr_t* attrp,
                            char* const argv[],
                            char* const envp[]) noexcept {
+    lean::Arena arena;
+    auto* executable = lean::resolve_from_path(arena, file, environment());
+    if(auto result =
+           lean_posix_spawn(arena, pid, executable, file_actions, attrp, argv, envp)) {
+        return *result;
+    }
     CATTER_SPAWN_BOUNDARY("posix_spawnp", {
         require_path_arg(file, "file");
         return this->run_posix_spawn(pid,
@@ -285,16 +375,69 @@ int Executor::posix_spawnp(pid_t* pid,
     });
 }
 
+std::optional<int> Executor::lean_execve(lean::Arena& arena,
+                                         const char* executable,
+                                         char* const argv[],
+                                         char* const envp[]) noexcept {
+    const auto& session = this->session();
+    if(executable == nullptr || m_execve == nullptr) {
+        return std::nullopt;
+    }
+    if(session.exec_filter.has_value() && session.exec_filter->match(executable)) {
+        auto* env = lean::pass_through_environment(arena, session, envp);
+        if(env == nullptr) {
+            return std::nullopt;
+        }
+        return m_execve(executable, argv, env);
+    }
+    auto exec = lean::proxy_exec(arena, session, executable, argv, envp);
+    if(!exec.has_value()) {
+        return std::nullopt;
+    }
+    return m_execve(exec->path, exec->argv, exec->envp);
+}
+
+std::optional<int> Executor::lean_posix_spawn(lean::Arena& arena,
+                                              pid_t* pid,
+                                              const char* executable,
+                                              const posix_spawn_file_actions_t* file_actions,
+                                              const posix_spawnattr_t* attrp,
+                                              char* const argv[],
+                                              char* const envp[]) noexcept {
+    const auto& session = this->session();
+    if(executable == nullptr || m_posix_spawn == nullptr) {
+        return std::nullopt;
+    }
+    if(session.exec_filter.has_value() && session.exec_filter->match(executable)) {
+        auto* env = lean::pass_through_environment(arena, session, envp);
+        if(env == nullptr) {
+            return std::nullopt;
+        }
+        return m_posix_spawn(pid, executable, file_actions, attrp, argv, env);
+    }
+    auto exec = lean::proxy_exec(arena, session, executable, argv, envp);
+    if(!exec.has_value()) {
+        return std::nullopt;
+    }
+    return m_posix_spawn(pid, exec->path, file_actions, attrp, exec->argv, exec->envp);
+}
+
 int Executor::run_execve(const char* executable, const char* const argv[], char* const envp[]) {
+    const auto& session = this->session();
     if(this->m_execve == nullptr) {
         throw catter::PayloadError(ENOSYS, "hook function \"execve\" not initialized");
     }
+    if(session.exec_filter.has_value() && session.exec_filter->match(executable)) {
+        // the hook stays attached, commands this one runs are reported against its caller
+        auto env = pass_through_environment(envp, session.initial_env, session.base_changes);
+        return m_execve(executable, const_cast<char* const*>(argv), env.data());
+    }
 
     auto clean_env = catter::sanitize_environment(envp);
     auto args = argv_span(argv);
-    if(!m_session.is_valid()) {
+    if(!session.is_valid()) {
         auto command =
-            catter::build_error_command(m_session,
+            catter::build_error_command(session,
                                         "invalid environment of hook library, lost required value",
                                         executable,
                                         args);
@@ -302,7 +445,28 @@ int Executor::run_execve(const char* executable, const char* const argv[], char*
         return m_execve(command.path.c_str(), command.c_argv().data(), clean_env.data());
     }
 
-    auto command = build_proxy_command(m_session, executable, args);
+    auto env_changed = session.initial_env.has_value()
+                           ? changed_environment_keys(*session.initial_env,
+                                                      clean_env.data(),
+                                                      session.base_changes)
+                           : std::nullopt;
+
+    if(!session.direct_pipe.empty()) {
+        if(auto hook_library = find_hook_library(envp); !hook_library.empty()) {
+            auto reply =
+                request_decision(session, executable, args, clean_env.data(), env_changed);
+            if(reply.has_value() && reply->type != direct::reply::FALLBACK) {
+                return this->run_direct_execve(*reply,
+                                               executable,
+                                               argv,
+                                               envp,
+                                               clean_env,
+                                               hook_library);
+            }
+        }
+    }
+
+    auto command = build_proxy_command(session, executable, args, env_changed);
     auto c_argv = command.c_argv();
 
     INFO("execve called with path: {}, argv[0]: {}",
@@ -318,14 +482,24 @@ int Executor::run_posix_spawn(pid_t* pid,
                               const posix_spawnattr_t* attrp,
                               const char* const argv[],
                               char* const envp[]) {
+    const auto& session = this->session();
     if(m_posix_spawn == nullptr) {
         throw catter::PayloadError(ENOSYS, "hook function \"posix_spawn\" not initialized");
     }
+    if(session.exec_filter.has_value() && session.exec_filter->match(executable)) {
+        auto env = pass_through_environment(envp, session.initial_env, session.base_changes);
+        return m_posix_spawn(pid,
+                             executable,
+                             file_actions,
+                             attrp,
+                             const_cast<char* const*>(argv),
+                             env.data());
+    }
     auto clean_env = catter::sanitize_environment(envp);
     auto args = argv_span(argv);
-    if(!m_session.is_valid()) {
+    if(!session.is_valid()) {
         auto command =
-            catter::build_error_command(m_session,
+            catter::build_error_command(session,
                                         "invalid environment of hook library, lost required value",
                                         executable,
                                         args);
@@ -338,7 +512,31 @@ int Executor::run_posix_spawn(pid_t* pid,
                              clean_env.data());
     }
 
-    auto command = build_proxy_command(m_session, executable, args);
+    auto env_changed = session.initial_env.has_value()
+                           ? changed_environment_keys(*session.initial_env,
+                                                      clean_env.data(),
+                                                      session.base_changes)
+                           : std::nullopt;
+
+    if(!session.direct_pipe.empty()) {
+        if(auto hook_library = find_hook_library(envp); !hook_library.empty()) {
+            auto reply =
+                request_decision(session, executable, args, clean_env.data(), env_changed);
+            if(reply.has_value() && reply->type != direct::reply::FALLBACK) {
+                return this->run_direct_posix_spawn(*reply,
+                                                    pid,
+                                                    executable,
+                                                    file_actions,
+                                                    attrp,
+                                                    argv,
+                                                    envp,
+                                                    clean_env,
+                                                    hook_library);
+            }
+        }
+    }
+
+    auto command = build_proxy_command(session, executable, args, env_changed);
     auto c_argv = command.c_argv();
 
     INFO("posix_spawn called with path: {}, argv[0]: {}",
@@ -352,6 +550,65 @@ int Executor::run_posix_spawn(pid_t* pid,
                          clean_env.data());
 }
 
+int Executor::run_direct_execve(direct::reply& reply,
+                                const char* executable,
+                                const char* const argv[],
+                                char* const envp[],
+                                SanitizedEnv& clean_env,
+                                std::string_view hook_library) {
+    if(reply.type == direct::reply::EXEC_ORIGINAL) {
+        auto env = attach_environment(envp, clean_env.data(), hook_library, reply.id);
+        INFO("execve of {} kept by catter, new id: {}", executable, reply.id);
+        return m_execve(executable, const_cast<char* const*>(argv), env.data());
+    }
+
+    auto env = reply.type == direct::reply::WRAP
+                   ? SanitizedEnv{.entries = c_strings(reply.env)}
+                   : attach_environment(envp, c_strings(reply.env).data(), hook_library, reply.id);
+    auto command = Command{
+        .path = std::move(reply.executable),
+        .argv = std::move(reply.args),
+    };
+    INFO("execve replaced by catter, path: {}", command.path);
+    return m_execve(command.path.c_str(), command.c_argv().data(), env.data());
+}
+
+int Executor::run_direct_posix_spawn(direct::reply& reply,
+                                     pid_t* pid,
+                                     const char* executable,
+                                     const posix_spawn_file_actions_t* file_actions,
+                                     const posix_spawnattr_t* attrp,
+                                     const char* const argv[],
+                                     char* const envp[],
+                                     SanitizedEnv& clean_env,
+                                     std::string_view hook_library) {
+    if(reply.type == direct::reply::EXEC_ORIGINAL) {
+        auto env = attach_environment(envp, clean_env.data(), hook_library, reply.id);
+        INFO("posix_spawn of {} kept by catter, new id: {}", executable, reply.id);
+        return m_posix_spawn(pid,
+                             executable,
+                             file_actions,
+                             attrp,
+                             const_cast<char* const*>(argv),
+                             env.data());
+    }
+
+    auto env = reply.type == direct::reply::WRAP
+                   ? SanitizedEnv{.entries = c_strings(reply.env)}
+                   : attach_environment(envp, c_strings(reply.env).data(), hook_library, reply.id);
+    auto command = Command{
+        .path = std::move(reply.executable),
+        .argv = std::move(reply.args),
+    };
+    INFO("posix_spawn replaced by catter, path: {}", command.path);
+    return m_posix_spawn(pid,
+                         command.path.c_str(),
+                         file_actions,
+                         attrp,
+                         command.c_argv().data(),
+                         env.data());
+}
+
 }  // namespace catter
 
 #undef CATTER_EXEC_BOUNDARY
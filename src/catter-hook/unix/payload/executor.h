@@ -1,9 +1,16 @@
 #pragma once
 
+#include <atomic>
 #include <cstdarg>
+#include <optional>
+#include <span>
 #include <spawn.h>
+#include <string_view>
 
+#include "env_sanitizer.h"
+#include "lean.h"
 #include "session.h"
+#include "util/direct.h"
 
 namespace catter {
 
@@ -20,7 +27,18 @@ using PosixSpawnFn = int(pid_t* pid,
  */
 class Executor {
 public:
-    void init(const char* const envp[]) noexcept;
+    /**
+     * Read the session from `envp`, the environment the process started with, and resolve the real
+     * functions. Does not allocate, most processes which load the hook never exec: the snapshot of
+     * the environment and the exec filter wait for the first intercepted call, see `session`.
+     *
+     * @param initial_env room for a copy of `envp`, whose array `setenv` may change later.
+     * @param snapshot room for `Session::initial_env`.
+     */
+    void init(const char* const envp[],
+              std::span<const char*> initial_env,
+              std::span<std::string_view> snapshot) noexcept;
+    /// `session` as it is, already loaded.
     void init(Session session, ExecveFn* execve, PosixSpawnFn* posix_spawn) noexcept;
 
     int execv(const char* path, char* const argv[]) noexcept;
@@ -62,6 +80,26 @@ public:
                      char* const envp[]) noexcept;
 
 private:
+    /// The session, loaded by the first call to get here. Calls which meanwhile come from other
+    /// threads get it as read by `init`, and send their whole environment to catter.
+    const Session& session() noexcept;
+
+    /// The proxy route of `run_execve` in `arena`, see `lean.h`. `executable` is resolved, or
+    /// nullptr if that took the full route already.
+    /// @return nothing if the call takes the full route.
+    std::optional<int> lean_execve(lean::Arena& arena,
+                                   const char* executable,
+                                   char* const argv[],
+                                   char* const envp[]) noexcept;
+
+    std::optional<int> lean_posix_spawn(lean::Arena& arena,
+                                        pid_t* pid,
+                                        const char* executable,
+                                        const posix_spawn_file_actions_t* file_actions,
+                                        const posix_spawnattr_t* attrp,
+                                        char* const argv[],
+                                        char* const envp[]) noexcept;
+
     int run_execve(const char* executable, const char* const argv[], char* const envp[]);
 
     int run_posix_spawn(pid_t* pid,
@@ -70,7 +108,34 @@ private:
                         const posix_spawnattr_t* attrp,
                         const char* const argv[],
                         char* const envp[]);
+
+    /// Apply a direct decision to an exec call. Returns only if the exec fails.
+    int run_direct_execve(direct::reply& reply,
+                          const char* executable,
+                          const char* const argv[],
+                          char* const envp[],
+                          SanitizedEnv& clean_env,
+                          std::string_view hook_library);
+
+    int run_direct_posix_spawn(direct::reply& reply,
+                               pid_t* pid,
+                               const char* executable,
+                               const posix_spawn_file_actions_t* file_actions,
+                               const posix_spawnattr_t* attrp,
+                               const char* const argv[],
+                               char* const envp[],
+                               SanitizedEnv& clean_env,
+                               std::string_view hook_library);
+
     Session m_session;
+    /// `m_session` once loaded, valid when `m_state` is `loaded`.
+    Session m_loaded;
+    const char* const* m_initial_env = nullptr;
+    std::span<std::string_view> m_snapshot{};
+
+    enum State { unloaded, loading, loaded };
+    std::atomic<State> m_state = unloaded;
+
     ExecveFn* m_execve = nullptr;
     PosixSpawnFn* m_posix_spawn = nullptr;
 };
@@ -1,7 +1,9 @@
 #include <atomic>
 #include <cerrno>
 #include <cstdarg>
+#include <cstddef>
 #include <cstdlib>
+#include <string_view>
 #include <spawn.h>
 #include <unistd.h>
 
@@ -33,8 +35,13 @@ namespace {
 
 // This is used for being multi thread safe (loading time only).
 std::atomic<bool> LOADED(false);
-// These are related to the functionality of this library.
-catter::Executor EXECUTOR;
+// These are related to the functionality of this library. Constructed before `on_load` runs,
+// which a constructor of the same priority is not.
+catter::Executor EXECUTOR __attribute__((init_priority(101)));
+// Room for the environment the process started with and its snapshot, see `Executor::init`.
+constexpr std::size_t MAX_INITIAL_ENV = 4096;
+const char* INITIAL_ENV[MAX_INITIAL_ENV + 1];
+std::string_view INITIAL_ENV_SNAPSHOT[MAX_INITIAL_ENV];
 
 }  // namespace
 
@@ -50,12 +57,15 @@ extern "C" EXPORT_SYMBOL void on_load() {
     // Test whether on_load was called already.
     if(LOADED.exchange(true))
         return;
+    // Nothing here allocates outside of DEBUG builds, most processes which load the hook never
+    // exec. The session is loaded on the first intercepted call, which may be an exec in the child
+    // of a `vfork` and does not allocate either, see `lean.h`.
 #ifdef DEBUG
     auto path = catter::util::get_catter_data_path() / catter::config::hook::LOG_PATH_REL;
     catter::log::init_logger("catter-hook", path, false);
 #endif
     INFO("catter hook library loaded, from executable path: {}", get_executable_path());
-    EXECUTOR.init(environment());
+    EXECUTOR.init(environment(), INITIAL_ENV, INITIAL_ENV_SNAPSHOT);
     errno = 0;
 }
 
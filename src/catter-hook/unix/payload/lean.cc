@@ -0,0 +1,238 @@
+#include "lean.h"
+
+#include <charconv>
+#include <climits>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "crossplat.h"
+#include "env_sanitizer.h"
+#include "environment.h"
+#include "session.h"
+#include "unix/config.h"
+
+namespace catter::lean {
+
+namespace {
+
+/// At most what `push_proxy_args` adds before the arguments of the command, without `--direct`.
+constexpr std::size_t max_proxy_args = 14;
+
+std::size_t count_of(char* const values[]) noexcept {
+    std::size_t count = 0;
+    while(values != nullptr && values[count] != nullptr) {
+        ++count;
+    }
+    return count;
+}
+
+/// Room for `size` characters in the arena.
+auto allocate_in(Arena& arena) noexcept {
+    return [&arena](std::size_t size) { return arena.allocate<char>(size); };
+}
+
+/// `sanitize_environment` in the arena.
+char** sanitize_environment(Arena& arena, char* const envp[]) noexcept {
+    // value-initialized, so the entry after the last one kept is the terminating nullptr
+    auto* entries = arena.allocate<char*>(count_of(envp) + 1);
+    if(entries == nullptr) {
+        return nullptr;
+    }
+    std::size_t size = 0;
+    for_each_sanitized_entry(envp, allocate_in(arena), [&](char* entry) {
+        entries[size++] = entry;
+    });
+    return entries;
+}
+
+/// `changed_environment_keys` in the arena, nullptr if some key appears twice.
+const char* changed_environment_keys(Arena& arena,
+                                     std::span<const std::string_view> snapshot,
+                                     char* const envp[],
+                                     std::string_view base_changes) noexcept {
+    const auto count = count_of(envp);
+    auto* entries = arena.allocate<std::string_view>(count);
+    if(entries == nullptr) {
+        return nullptr;
+    }
+    for(std::size_t i = 0; i < count; ++i) {
+        entries[i] = envp[i];
+    }
+    std::span current(entries, count);
+    if(!sort_entries(current)) {
+        return nullptr;
+    }
+
+    // measure first, the arena can not grow a string in place
+    auto* joined =
+        arena.allocate<char>(join_changed_keys(snapshot, current, base_changes, nullptr) + 1);
+    if(joined == nullptr) {
+        return nullptr;
+    }
+    join_changed_keys(snapshot, current, base_changes, joined);
+    return joined;
+}
+
+/// The value of `--origin`, `pid:ppid:tid` of the calling thread.
+const char* format_origin(Arena& arena) noexcept {
+    // three numbers of at most 20 digits and two colons
+    char text[64];
+    char* out = text;
+    out = std::to_chars(out, std::end(text), ::getpid()).ptr;
+    *out++ = ':';
+    out = std::to_chars(out, std::end(text), ::getppid()).ptr;
+    *out++ = ':';
+    out = std::to_chars(out, std::end(text), get_thread_id()).ptr;
+    return arena.copy(std::string_view(text, out));
+}
+
+}  // namespace
+
+char* Arena::copy(std::string_view text) noexcept {
+    auto* out = allocate<char>(text.size() + 1);
+    if(out != nullptr) {
+        text.copy(out, text.size());
+    }
+    return out;
+}
+
+const char* resolve_path_like(const char* file) noexcept {
+    struct stat st{};
+    if(file == nullptr || ::stat(file, &st) != 0 || !S_ISREG(st.st_mode) ||
+       ::access(file, X_OK) != 0) {
+        return nullptr;
+    }
+    return file;
+}
+
+const char* resolve_from_search_path(Arena& arena,
+                                     const char* file,
+                                     const char* search_path) noexcept {
+    if(file == nullptr || search_path == nullptr) {
+        return nullptr;
+    }
+    std::string_view name(file);
+    if(name.contains(config::OS_DIR_SEPARATOR)) {
+        return resolve_path_like(file);
+    }
+
+    char candidate[PATH_MAX];
+    std::string_view dirs(search_path);
+    while(true) {
+        auto pos = dirs.find(config::OS_PATH_SEPARATOR);
+        auto dir = dirs.substr(0, pos);
+        // as the resolver, empty entries and candidates longer than PATH_MAX are skipped
+        if(!dir.empty() && name.size() + dir.size() + 2 <= PATH_MAX) {
+            auto size = dir.copy(candidate, dir.size());
+            if(!dir.ends_with(config::OS_DIR_SEPARATOR)) {
+                candidate[size++] = config::OS_DIR_SEPARATOR;
+            }
+            size += name.copy(candidate + size, name.size());
+            candidate[size] = '\0';
+            if(resolve_path_like(candidate) != nullptr) {
+                return arena.copy(std::string_view(candidate, size));
+            }
+        }
+        if(pos == std::string_view::npos) {
+            return nullptr;
+        }
+        dirs.remove_prefix(pos + 1);
+    }
+}
+
+const char* resolve_from_path(Arena& arena, const char* file, const char* const envp[]) noexcept {
+    if(file == nullptr) {
+        return nullptr;
+    }
+    if(std::string_view(file).contains(config::OS_DIR_SEPARATOR)) {
+        return resolve_path_like(file);
+    }
+    auto path_env = envp == nullptr ? nullptr : env::get_env_value(envp, "PATH");
+    return resolve_from_search_path(arena, file, path_env);
+}
+
+char* const* pass_through_environment(Arena& arena,
+                                      const Session& session,
+                                      char* const envp[]) noexcept {
+    const char* changed = config::hook::ENV_CHANGED_UNKNOWN;
+    if(session.initial_env.has_value()) {
+        auto* clean_env = sanitize_environment(arena, envp);
+        auto* keys =
+            changed_environment_keys(arena, *session.initial_env, clean_env, session.base_changes);
+        if(keys != nullptr) {
+            changed = keys;
+        }
+    }
+
+    // value-initialized, so the entry after the new one is the terminating nullptr
+    auto* entries = arena.allocate<char*>(count_of(envp) + 2);
+    if(entries == nullptr) {
+        return nullptr;
+    }
+    std::size_t size = 0;
+    auto keep = [&](char* entry) {
+        entries[size++] = entry;
+    };
+    if(!for_each_passed_entry(envp, changed, allocate_in(arena), keep)) {
+        return nullptr;
+    }
+    return entries;
+}
+
+std::optional<Exec> proxy_exec(Arena& arena,
+                               const Session& session,
+                               const char* executable,
+                               char* const argv[],
+                               char* const envp[]) noexcept {
+    if(session.proxy_path.empty() || session.self_id.empty() || !session.direct_pipe.empty()) {
+        return std::nullopt;
+    }
+
+    auto* env = sanitize_environment(arena, envp);
+    auto* env_changed =
+        session.initial_env.has_value()
+            ? changed_environment_keys(arena, *session.initial_env, env, session.base_changes)
+            : nullptr;
+    auto* origin = format_origin(arena);
+    const auto argc = count_of(argv);
+    auto* args = arena.allocate<char*>(max_proxy_args + argc + 1);
+    if(arena.exhausted()) {
+        return std::nullopt;
+    }
+
+    std::size_t size = 0;
+    auto push = [&](const char* arg) {
+        args[size++] = const_cast<char*>(arg);
+    };
+    push(session.proxy_path.data());
+    push("-p");
+    push(session.self_id.data());
+    push("--origin");
+    push(origin);
+    if(!session.ipc_pipe.empty()) {
+        push("--ipc");
+        push(session.ipc_pipe.data());
+    }
+    if(!session.exec_filter_file.empty()) {
+        push("--exec-filter");
+        push(session.exec_filter_file.data());
+    }
+    if(env_changed != nullptr) {
+        push("--env-changed");
+        push(env_changed);
+    }
+    push("--exec");
+    push(executable);
+    push("--");
+    for(std::size_t i = 0; i < argc; ++i) {
+        push(argv[i]);
+    }
+    return Exec{.path = session.proxy_path.data(), .argv = args, .envp = env};
+}
+
+}  // namespace catter::lean
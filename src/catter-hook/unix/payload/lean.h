@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+#include "session.h"
+
+/**
+ * The proxy route of the payload without the heap, exceptions or `std::format`.
+ *
+ * The full route in `executor.cc` resolves the executable with `std::filesystem`, copies the
+ * environment into vectors and strings and formats the proxy command, a few dozen allocations for
+ * every exec of a build. Most calls need none of it: with the direct path off, the proxy command
+ * is the executable, the arguments and a handful of session values. This route builds that command
+ * and the sanitized environment in an `Arena` on the stack of the intercepted call, which also
+ * keeps the child of a `vfork` off the locks of the heap it shares with its parent.
+ *
+ * Anything out of the ordinary returns nothing and the call takes the full route: an arena too
+ * small for the command, an executable which does not resolve, an invalid session, or the direct
+ * path being on. This route logs nothing in any build, the hooked functions log each call before.
+ */
+namespace catter::lean {
+
+/// A bump allocator over a fixed buffer, meant to live on the stack of one intercepted call.
+class Arena {
+public:
+    /// Enough for a compiler invocation with a few hundred arguments and environment entries.
+    constexpr static std::size_t capacity = 16 * 1024;
+
+    Arena() noexcept = default;
+    Arena(const Arena&) = delete;
+    Arena& operator= (const Arena&) = delete;
+
+    /// Room for `count` value-initialized `T`, nullptr once the arena is exhausted.
+    template <typename T>
+    T* allocate(std::size_t count) noexcept {
+        static_assert(std::is_trivially_destructible_v<T>, "the arena never destroys objects");
+        const std::size_t start = (m_used + alignof(T) - 1) / alignof(T) * alignof(T);
+        if(m_exhausted || start > capacity || count > (capacity - start) / sizeof(T)) {
+            m_exhausted = true;
+            return nullptr;
+        }
+        m_used = start + count * sizeof(T);
+        auto* objects = reinterpret_cast<T*>(m_buffer + start);
+        std::uninitialized_value_construct_n(objects, count);
+        return objects;
+    }
+
+    /// `text` as a NUL-terminated string, nullptr once the arena is exhausted.
+    char* copy(std::string_view text) noexcept;
+
+    /// Whether an allocation failed, after which everything built from the arena is incomplete.
+    bool exhausted() const noexcept {
+        return m_exhausted;
+    }
+
+private:
+    alignas(std::max_align_t) char m_buffer[capacity];
+    std::size_t m_used = 0;
+    bool m_exhausted = false;
+};
+
+/// As `resolver::resolve_path_like`, `file` itself if it is an executable regular file.
+const char* resolve_path_like(const char* file) noexcept;
+
+/// As `resolver::resolve_from_search_path`, nullptr if `file` is not found.
+const char* resolve_from_search_path(Arena& arena,
+                                     const char* file,
+                                     const char* search_path) noexcept;
+
+/// As `resolver::resolve_from_path_env` with the `PATH` of `envp`. nullptr without a `PATH` too,
+/// the `confstr` fallback is left to the full route.
+const char* resolve_from_path(Arena& arena, const char* file, const char* const envp[]) noexcept;
+
+/// What `pass_through_environment` of `env_sanitizer.h` builds, nullptr if the call takes the
+/// full route.
+char* const* pass_through_environment(Arena& arena,
+                                      const Session& session,
+                                      char* const envp[]) noexcept;
+
+/// What the intercepted call runs instead.
+struct Exec {
+    const char* path;
+    char* const* argv;
+    char* const* envp;
+};
+
+/**
+ * Build what `build_proxy_command` and `sanitize_environment` would for running `executable`.
+ *
+ * @return nothing if the call takes the full route.
+ */
+std::optional<Exec> proxy_exec(Arena& arena,
+                               const Session& session,
+                               const char* executable,
+                               char* const argv[],
+                               char* const envp[]) noexcept;
+
+}  // namespace catter::lean
@@ -1,15 +1,56 @@
 #include "session.h"
 
-#include <string>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "debug.h"
+#include "env_sanitizer.h"
 #include "environment.h"
 #include "unix/config.h"
 
 namespace catter {
 
+namespace {
+
+std::optional<util::ExecFilter> map_exec_filter(const char* path) noexcept {
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        WARN("failed to open exec filter {}", path);
+        return std::nullopt;
+    }
+    struct stat st{};
+    void* data = MAP_FAILED;
+    if(::fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if(data == MAP_FAILED) {
+        WARN("failed to map exec filter {}", path);
+        return std::nullopt;
+    }
+
+    const auto size = static_cast<size_t>(st.st_size);
+    auto filter = util::ExecFilter::decode(std::string_view(static_cast<const char*>(data), size));
+    if(!filter.has_value()) {
+        WARN("exec filter {} is invalid", path);
+        ::munmap(data, size);
+    }
+    return filter;
+}
+
+}  // namespace
+
 Session Session::make(const char* const envp[]) noexcept {
     Session session;
+    if(envp == nullptr) {
+        WARN("environment of the process not found");
+        return session;
+    }
     auto proxy_path = catter::env::get_env_value(envp, config::hook::KEY_CATTER_PROXY_PATH);
     if(proxy_path == nullptr) {
         WARN("catter proxy path not found in environment");
@@ -28,8 +69,40 @@ Session Session::make(const char* const envp[]) noexcept {
         WARN("session is invalid");
         return session;
     }
+    if(auto ipc_pipe = catter::env::get_env_value(envp, config::hook::KEY_CATTER_IPC_PIPE)) {
+        session.ipc_pipe = ipc_pipe;
+    }
+    if(auto direct_pipe = catter::env::get_env_value(envp, config::hook::KEY_CATTER_DIRECT_PIPE)) {
+        session.direct_pipe = direct_pipe;
+    }
+    if(auto filter = catter::env::get_env_value(envp, config::hook::KEY_CATTER_EXEC_FILTER)) {
+        session.exec_filter_file = filter;
+    }
+    if(auto value = catter::env::get_env_value(envp, config::hook::KEY_CATTER_ENV_CHANGED)) {
+        session.base_changes = value;
+    }
 
     INFO("session from env: catter_proxy={}, self_id={}", session.proxy_path, session.self_id);
     return session;
 }
+
+void Session::load(const char* const envp[], std::span<std::string_view> storage) noexcept {
+    if(!is_valid()) {
+        return;
+    }
+    if(!exec_filter_file.empty()) {
+        // the value is the rest of its entry, so it ends in a NUL
+        exec_filter = map_exec_filter(exec_filter_file.data());
+    }
+    if(base_changes == config::hook::ENV_CHANGED_UNKNOWN) {
+        // started by a filtered exec whose environment could not be described, the proxies send
+        // the whole environment
+        WARN("environment of the command is unknown");
+        return;
+    }
+    initial_env = snapshot_environment(envp, storage);
+    if(!initial_env.has_value()) {
+        WARN("environment of the process can not be compared against");
+    }
+}
 }  // namespace catter
@@ -1,21 +1,52 @@
 #pragma once
 
-#include <string>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "util/exec_filter.h"
 
 namespace catter {
 
 /**
  * Represents an intercept session parameter set.
  *
- * It does not own the memory (of the pointed areas).
+ * It does not own the memory (of the pointed areas): the values are views into the environment
+ * the session is read from, so each of them ends in a NUL.
  */
 struct Session {
-    std::string proxy_path{};
-    std::string self_id{};
+    std::string_view proxy_path{};
+    std::string_view self_id{};
+    /// Socket the proxy reaches catter on, passed on with `--ipc`.
+    std::string_view ipc_pipe{};
+    /// Socket to ask catter directly, empty if the direct path is disabled.
+    std::string_view direct_pipe{};
+    /// Sanitized environment the process started with, see `snapshot_environment`. The proxy
+    /// only sends the entries changed against it, since catter already knows it as the
+    /// environment of this command. Empty if it can not be compared against.
+    std::optional<std::span<const std::string_view>> initial_env{};
+    /// Keys `initial_env` differs in from the environment of the command, when this process was
+    /// started by an exec the hook let through, see `KEY_CATTER_ENV_CHANGED`.
+    std::string_view base_changes{};
+    /// File of the executables run without asking catter, passed on with `--exec-filter`.
+    std::string_view exec_filter_file{};
+    /// `exec_filter_file` as mapped. The mapping is never released, copies of the session share it.
+    std::optional<util::ExecFilter> exec_filter{};
 
+    /// Read the values of the session from `envp`. Takes neither `initial_env` nor `exec_filter`,
+    /// see `load`.
     static Session make(const char* const envp[]) noexcept;
 
-    bool is_valid() noexcept {
+    /**
+     * Take `initial_env` from `envp`, the environment the process started with, and map
+     * `exec_filter_file`. Does not allocate, so it is safe on the first intercepted call, which
+     * may come from the child of a `vfork`.
+     *
+     * @param storage room for `initial_env`, it must outlive the session.
+     */
+    void load(const char* const envp[], std::span<std::string_view> storage) noexcept;
+
+    bool is_valid() const noexcept {
         return (!proxy_path.empty() && !self_id.empty());
     }
 };
@@ -27,6 +27,16 @@ constexpr inline char ENV_VAR_PROXY_PATH<char>[] = "CATTER_PROXY_PATH";
 template <>
 constexpr inline wchar_t ENV_VAR_PROXY_PATH<wchar_t>[] = L"CATTER_PROXY_PATH";
 
+/// Pipe the proxies connect to, unique to the catter running the build.
+template <CharT char_t>
+constexpr char_t ENV_VAR_IPC_PIPE[] = {};
+
+template <>
+constexpr inline char ENV_VAR_IPC_PIPE<char>[] = "CATTER_IPC_PIPE";
+
+template <>
+constexpr inline wchar_t ENV_VAR_IPC_PIPE<wchar_t>[] = L"CATTER_IPC_PIPE";
+
 using ipc_id_t = int64_t;
 
 }  // namespace catter::win
@@ -176,6 +176,7 @@ struct StartedProcess {
     RunningProcess process;
     win::Handle stdout_read{};
     win::Handle stderr_read{};
+    int64_t pid = 0;
 };
 
 class ProcessWaiter {
@@ -255,22 +256,36 @@ kota::task<int64_t, kota::error> wait_for_process_exit(RunningProcess process,
     co_return wait_ret->status;
 }
 
-StartedProcess start_process(data::command cmd, data::ipcid_t id, std::string proxy_path) {
+/// @param capture_output if false, the process writes to our own stdout and stderr.
+/// @param inject if false, the process runs without the hook.
+StartedProcess start_process(data::command cmd,
+                             data::ipcid_t id,
+                             std::string proxy_path,
+                             std::string ipc_pipe,
+                             bool capture_output,
+                             bool inject) {
     auto env = std::move(cmd.env);
-    upsert_environment_variable(env, win::ENV_VAR_IPC_ID<char>, std::to_string(id));
-    upsert_environment_variable(env, win::ENV_VAR_PROXY_PATH<char>, proxy_path);
+    if(inject) {
+        upsert_environment_variable(env, win::ENV_VAR_IPC_ID<char>, std::to_string(id));
+        upsert_environment_variable(env, win::ENV_VAR_PROXY_PATH<char>, proxy_path);
+        upsert_environment_variable(env, win::ENV_VAR_IPC_PIPE<char>, ipc_pipe);
+    }
 
     auto env_block = build_environment_block(std::move(env));  // Double null termination
 
-    auto stdout_pipe = create_capture_pipe("stdout");
-    auto stderr_pipe = create_capture_pipe("stderr");
+    AnonymousPipe stdout_pipe;
+    AnonymousPipe stderr_pipe;
+    if(capture_output) {
+        stdout_pipe = create_capture_pipe("stdout");
+        stderr_pipe = create_capture_pipe("stderr");
+    }
 
     STARTUPINFOA si{
         .cb = sizeof(STARTUPINFOA),
         .dwFlags = STARTF_USESTDHANDLES,
         .hStdInput = GetStdHandle(STD_INPUT_HANDLE),
-        .hStdOutput = stdout_pipe.write.get(),
-        .hStdError = stderr_pipe.write.get(),
+        .hStdOutput = capture_output ? stdout_pipe.write.get() : GetStdHandle(STD_OUTPUT_HANDLE),
+        .hStdError = capture_output ? stderr_pipe.write.get() : GetStdHandle(STD_ERROR_HANDLE),
     };
     PROCESS_INFORMATION pi{};
 
@@ -297,8 +312,8 @@ StartedProcess start_process(data::command cmd, data::ipcid_t id, std::string pr
 
     RunningProcess process = {pi};
 
-    if(!try_inject(process.process_handle(),
-                   catter::util::get_catter_root_path() / win::DLL_NAME)) {
+    if(inject && !try_inject(process.process_handle(),
+                             catter::util::get_catter_root_path() / win::DLL_NAME)) {
         throw cpptrace::runtime_error("Failed to inject DLL into target process");
     }
 
@@ -312,22 +327,44 @@ StartedProcess start_process(data::command cmd, data::ipcid_t id, std::string pr
         .process = std::move(process),
         .stdout_read = std::move(stdout_pipe.read),
         .stderr_read = std::move(stderr_pipe.read),
+        .pid = static_cast<int64_t>(pi.dwProcessId),
     };
 }
 }  // namespace
 
-kota::task<data::process_result> run(data::command cmd, data::ipcid_t id, std::string proxy_path) {
-
-    return capture_process_result(
-        [cmd, id, proxy_path](kota::event_loop& loop) mutable -> catter::process_info {
+kota::task<data::process_result> run(data::command cmd, data::ipcid_t id, Options options) {
+    const bool capture_output = options.capture != data::CaptureMode::INHERIT;
+
+    process_event event =
+        [cmd,
+         id,
+         capture_output,
+         inject = options.inject,
+         proxy_path = std::move(options.proxy_path),
+         ipc_pipe = std::move(options.ipc_pipe)](
+            kota::event_loop& loop) mutable -> catter::process_info {
             LOG_INFO("new command id is: {}", id);
-            auto started = start_process(std::move(cmd), id, std::move(proxy_path));
-
+            auto started = start_process(std::move(cmd),
+                                         id,
+                                         std::move(proxy_path),
+                                         std::move(ipc_pipe),
+                                         capture_output,
+                                         inject);
+
+            if(!capture_output) {
+                return {
+                    .wait_task = wait_for_process_exit(std::move(started.process), &loop),
+                    .pid = started.pid,
+                };
+            }
             return {
                 .wait_task = wait_for_process_exit(std::move(started.process), &loop),
                 .stdout_pipe = open_capture_pipe(std::move(started.stdout_read), "stdout", loop),
                 .stderr_pipe = open_capture_pipe(std::move(started.stderr_read), "stderr", loop),
+                .pid = started.pid,
             };
-        });
+        };
+    return capture_process_result(notify_start(std::move(event), std::move(options.on_start)),
+                                  options.capture);
 };
 };  // namespace catter::proxy::hook
@@ -28,6 +28,8 @@ struct CreateProcessA {
         auto converted_cmdline = catter::win::payload::build_proxy_command<char>(
             catter::win::payload::get_proxy_path<char>(),
             catter::win::payload::get_ipc_id<char>(),
+            catter::win::payload::get_origin<char>(),
+            catter::win::payload::get_ipc_pipe<char>(),
             lpApplicationName,
             lpCommandLine);
 
@@ -63,6 +65,8 @@ struct CreateProcessW {
         auto converted_cmdline = catter::win::payload::build_proxy_command<wchar_t>(
             catter::win::payload::get_proxy_path<wchar_t>(),
             catter::win::payload::get_ipc_id<wchar_t>(),
+            catter::win::payload::get_origin<wchar_t>(),
+            catter::win::payload::get_ipc_pipe<wchar_t>(),
             lpApplicationName,
             lpCommandLine);
 
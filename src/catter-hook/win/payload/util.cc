@@ -46,10 +46,21 @@ template <CharT char_t>
 constexpr char_t PROXY_COMMAND_FORMAT[] = {};
 
 template <>
-constexpr inline char PROXY_COMMAND_FORMAT<char>[] = R"("{}" -p {} --exec "{}" -- {})";
+constexpr inline char PROXY_COMMAND_FORMAT<char>[] =
+    R"("{}" -p {} --origin {} --ipc "{}" --exec "{}" -- {})";
 
 template <>
-constexpr inline wchar_t PROXY_COMMAND_FORMAT<wchar_t>[] = LR"("{}" -p {} --exec "{}" -- {})";
+constexpr inline wchar_t PROXY_COMMAND_FORMAT<wchar_t>[] =
+    LR"("{}" -p {} --origin {} --ipc "{}" --exec "{}" -- {})";
+
+template <CharT char_t>
+constexpr char_t ORIGIN_FORMAT[] = {};
+
+template <>
+constexpr inline char ORIGIN_FORMAT<char>[] = "{}:0:{}";
+
+template <>
+constexpr inline wchar_t ORIGIN_FORMAT<wchar_t>[] = L"{}:0:{}";
 
 template <CharT char_t>
 std::basic_string<char_t> resolve_abspath_impl(const char_t* application_name,
@@ -91,14 +102,28 @@ std::basic_string<char_t> get_ipc_id() {
     return GetEnvironmentVariableDynamic<char_t>(catter::win::ENV_VAR_IPC_ID<char_t>, 64);
 }
 
+template <CharT char_t>
+std::basic_string<char_t> get_ipc_pipe() {
+    return GetEnvironmentVariableDynamic<char_t>(catter::win::ENV_VAR_IPC_PIPE<char_t>, 64);
+}
+
+template <CharT char_t>
+std::basic_string<char_t> get_origin() {
+    return std::format(ORIGIN_FORMAT<char_t>, GetCurrentProcessId(), GetCurrentThreadId());
+}
+
 template <CharT char_t>
 std::basic_string<char_t> build_proxy_command(std::basic_string_view<char_t> proxy_path,
                                               std::basic_string_view<char_t> ipc_id,
+                                              std::basic_string_view<char_t> origin,
+                                              std::basic_string_view<char_t> ipc_pipe,
                                               const char_t* application_name,
                                               const char_t* command_line) {
     return std::format(PROXY_COMMAND_FORMAT<char_t>,
                        proxy_path,
                        ipc_id,
+                       origin,
+                       ipc_pipe,
                        resolve_abspath(application_name, command_line),
                        command_line == nullptr ? std::basic_string_view<char_t>{}
                                                : std::basic_string_view<char_t>{command_line});
@@ -112,13 +137,21 @@ template std::basic_string<char> get_proxy_path();
 template std::basic_string<wchar_t> get_proxy_path();
 template std::basic_string<char> get_ipc_id();
 template std::basic_string<wchar_t> get_ipc_id();
+template std::basic_string<char> get_ipc_pipe();
+template std::basic_string<wchar_t> get_ipc_pipe();
+template std::basic_string<char> get_origin();
+template std::basic_string<wchar_t> get_origin();
 
 template std::basic_string<char> build_proxy_command(std::basic_string_view<char> proxy_path,
                                                      std::basic_string_view<char> ipc_id,
+                                                     std::basic_string_view<char> origin,
+                                                     std::basic_string_view<char> ipc_pipe,
                                                      const char* application_name,
                                                      const char* command_line);
 template std::basic_string<wchar_t> build_proxy_command(std::basic_string_view<wchar_t> proxy_path,
                                                         std::basic_string_view<wchar_t> ipc_id,
+                                                        std::basic_string_view<wchar_t> origin,
+                                                        std::basic_string_view<wchar_t> ipc_pipe,
                                                         const wchar_t* application_name,
                                                         const wchar_t* command_line);
 
@@ -18,9 +18,19 @@ std::basic_string<char_t> get_proxy_path();
 template <CharT char_t>
 std::basic_string<char_t> get_ipc_id();
 
+template <CharT char_t>
+std::basic_string<char_t> get_ipc_pipe();
+
+/// The calling process as `<pid>:<ppid>:<tid>`, the parent pid is left 0 as Windows does not
+/// keep it cheaply.
+template <CharT char_t>
+std::basic_string<char_t> get_origin();
+
 template <CharT char_t>
 std::basic_string<char_t> build_proxy_command(std::basic_string_view<char_t> proxy_path,
                                               std::basic_string_view<char_t> ipc_id,
+                                              std::basic_string_view<char_t> origin,
+                                              std::basic_string_view<char_t> ipc_pipe,
                                               const char_t* application_name,
                                               const char_t* command_line);
 
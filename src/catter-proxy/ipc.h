@@ -1,5 +1,8 @@
 #pragma once
+#include <cstdint>
+#include <optional>
 #include <print>
+#include <utility>
 #include <cpptrace/exceptions.hpp>
 #include <kota/async/io/loop.h>
 #include <kota/async/vocab/error.h>
@@ -16,6 +19,9 @@ struct Peer {
     using RequestType = catter::ipc::RequestType;
     template <RequestType Type>
     using Request = catter::ipc::Request<Type>;
+    using NotificationType = catter::ipc::NotificationType;
+    template <NotificationType Type>
+    using Notification = catter::ipc::Notification<Type>;
 
     template <typename Tag, typename Traits = typename kota::ipc::protocol::RequestTraits<Tag>>
     typename kota::task<typename Traits::Result>
@@ -28,6 +34,15 @@ struct Peer {
         }
     }
 
+    template <typename Tag,
+              typename Traits = typename kota::ipc::protocol::NotificationTraits<Tag>>
+    void send_notification(const typename Traits::Params& params) {
+        if(auto ret = this->peer.send_notification<Tag>(params); !ret.has_value()) {
+            throw cpptrace::runtime_error(
+                std::format("IPC notification failed: {}", ret.error().message));
+        }
+    }
+
     kota::task<> run() {
         return this->peer.run();
     }
@@ -48,11 +63,30 @@ struct Peer {
         co_return co_await this->send_request<Request<RequestType::MAKE_DECISION>>(cmd);
     }
 
+    /// Check the mode, create the command and get the decision for it in one round trip.
+    /// @return empty if catter is not in `mode`.
+    kota::task<std::optional<data::decision>> hello(data::ServiceMode mode,
+                                                     data::ipcid_t parent_id,
+                                                     data::command cmd) {
+        co_return co_await this->send_request<Request<RequestType::HELLO>>(
+            {mode, parent_id, std::move(cmd)});
+    }
+
+    /// Returns once catter has the result, so the connection may be closed.
     kota::task<void> finish(data::process_result result) {
         co_await this->send_request<Request<RequestType::FINISH>>(result);
         co_return;
     }
 
+    /// Tell catter the pid of the command, which links the commands it runs to it.
+    void started(int64_t pid) noexcept {
+        try {
+            this->send_notification<Notification<NotificationType::STARTED>>(pid);
+        } catch(...) {
+            // only the ancestry of the commands is worse off
+        }
+    }
+
     kota::task<void> report_error(data::ipcid_t parent_id, std::string error_msg) noexcept {
         try {
             co_await this->send_request<Request<RequestType::REPORT_ERROR>>({parent_id, error_msg});
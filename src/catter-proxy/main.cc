@@ -1,9 +1,15 @@
 #include <cstdint>
+#include <cstdio>
+#include <charconv>
 #include <cstdlib>
 #include <filesystem>
+#include <format>
+#include <functional>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <system_error>
 #include <vector>
 #include <cpptrace/exceptions.hpp>
@@ -16,6 +22,8 @@
 #include "config/catter-proxy.h"
 #include "shared/resolver.h"
 #include "util/crossplat.h"
+#include "util/env_delta.h"
+#include "util/fake_compile.h"
 #include "util/guard.h"
 #include "util/kotatsu.h"
 #include "util/log.h"
@@ -51,9 +59,99 @@ std::string resolve_executable(std::string_view exe, const std::vector<std::stri
 #endif
 }
 
-kota::task<data::process_result> run(data::action act, data::ipcid_t id) {
+/**
+ * Reduce the environment of `cmd` to the keys the hook reported as changed against the parent
+ * command, which catter already knows.
+ */
+void send_env_as_delta(data::command& cmd, data::ipcid_t parent_id, std::string_view changed) {
+    std::vector<std::string> entries;
+    env_delta::select(cmd.env, changed, entries, cmd.env_unset);
+    cmd.env = std::move(entries);
+    cmd.env_base = parent_id;
+}
+
+/// Rebuild the environment to run with, catter answers with a delta against what we sent.
+std::vector<std::string> received_env(const data::command& received, data::ipcid_t id) {
+    if(!received.env_base.has_value()) {
+        return received.env;
+    }
+    if(*received.env_base != id) {
+        throw cpptrace::runtime_error(
+            std::format("unexpected environment base {} for {}", *received.env_base, id));
+    }
+    auto env = catter::util::get_environment();
+    env_delta::apply(env, received.env, received.env_unset);
+    return env;
+}
+
+/// Parse the `<pid>:<ppid>:<tid>` of `--origin`, a malformed one is left unknown.
+data::process_origin parse_origin(std::string_view text) {
+    data::process_origin origin;
+    int64_t* fields[] = {&origin.pid, &origin.ppid, &origin.tid};
+    const char* it = text.data();
+    const char* end = text.data() + text.size();
+    for(std::size_t i = 0; i < std::size(fields); ++i) {
+        auto [ptr, ec] = std::from_chars(it, end, *fields[i]);
+        bool last = i + 1 == std::size(fields);
+        if(ec != std::errc() || (last ? ptr != end : ptr == end || *ptr != ':')) {
+            LOG_WARN("Malformed --origin: {}", text);
+            return {};
+        }
+        it = ptr + 1;
+    }
+    return origin;
+}
+
+/**
+ * Write placeholders of the outputs of `cmd` instead of running it.
+ *
+ * @return `std::nullopt` if the outputs of `cmd` can not be worked out, it has to run then.
+ */
+std::optional<data::process_result> fake(const data::command& cmd) {
+    auto outputs = fake_compile::plan(cmd.args);
+    if(!outputs.has_value()) {
+        return std::nullopt;
+    }
+
+    data::process_result result{.code = 0};
+    result.stats.exec = unix_time_us();
+    try {
+        fake_compile::write(*outputs, cmd.cwd);
+    } catch(const std::exception& e) {
+        // the build reports this like an error of the compiler
+        result.code = 1;
+        result.std_err = std::format("catter-proxy: {}\n", e.what());
+        std::fputs(result.std_err.c_str(), stderr);
+    }
+    result.stats.exit = unix_time_us();
+    return result;
+}
+
+/// The result of a command the script aborted at, which fails without running.
+data::process_result aborted() {
+    data::process_result result{
+        .code = 1,
+        .std_err = "catter-proxy: the script aborted the build\n",
+    };
+    std::fputs(result.std_err.c_str(), stderr);
+    return result;
+}
+
+/// @param on_start called with the pid of the command once it is spawned, if it runs.
+kota::task<data::process_result> run(data::action act,
+                                     data::ipcid_t id,
+                                     const catter::proxy::ProxyOption& opt,
+                                     std::function<void(int64_t)> on_start = {}) {
     using catter::data::action;
 
+    if(act.type == action::FAKE) {
+        if(auto result = fake(act.cmd)) {
+            co_return std::move(*result);
+        }
+        LOG_INFO("Outputs of {} are unknown, run it instead of faking", act.cmd.executable);
+        act.type = action::INJECT;
+    }
+
     switch(act.type) {
         case action::WRAP: {
             kota::process::options opts{
@@ -63,30 +161,118 @@ kota::task<data::process_result> run(data::action act, data::ipcid_t id) {
                 .cwd = act.cmd.cwd,
                 .creation = {.windows_hide = true, .windows_verbatim_arguments = true},
                 .streams = {kota::process::stdio::inherit(),
-                             kota::process::stdio::pipe(false, true),
-                             kota::process::stdio::pipe(false, true)}
+                             output_stream(act.capture),
+                             output_stream(act.capture)}
             };
-            co_return co_await capture_process_result(make_process_event(opts));
+            co_return co_await capture_process_result(
+                notify_start(make_process_event(opts), std::move(on_start)),
+                act.capture);
         }
         case action::INJECT: {
-            co_return co_await proxy::hook::run(act.cmd, id);
+            proxy::hook::Options options{
+                .capture = act.capture,
+                .on_start = std::move(on_start),
+                .inject = !act.ignore_descendants,
+            };
+            if(opt.ipc.has_value()) {
+                options.ipc_pipe = *opt.ipc;
+            }
+            if(opt.direct.has_value()) {
+                options.direct_pipe = *opt.direct;
+            }
+            if(opt.exec_filter.has_value()) {
+                options.exec_filter = *opt.exec_filter;
+            }
+            co_return co_await proxy::hook::run(act.cmd, id, std::move(options));
         }
         case action::DROP: {
             co_return data::process_result{.code = 0};
         }
+        case action::ABORT: {
+            co_return aborted();
+        }
         default: {
             co_return data::process_result{.code = -1};
         }
     }
 }
 
-kota::task<int> proxy_main(const catter::proxy::ProxyOption& opt) noexcept {
+/// @return the action of `--decided`, or of `--fake`, nullopt if it is not one.
+std::optional<decltype(action::type)> decided_action(const catter::proxy::ProxyOption& opt) {
+    if(opt.fake.value()) {
+        return action::FAKE;
+    }
+    if(*opt.decided == "inject") {
+        return action::INJECT;
+    }
+    if(*opt.decided == "wrap") {
+        return action::WRAP;
+    }
+    if(*opt.decided == "drop") {
+        return action::DROP;
+    }
+    if(*opt.decided == "abort") {
+        return action::ABORT;
+    }
+    return std::nullopt;
+}
+
+/// Run the command as catter already decided on the direct path, without asking it again.
+kota::task<int> decided_main(const catter::proxy::ProxyOption& opt) {
+    auto type = decided_action(opt);
+    if(!type.has_value()) {
+        LOG_CRITICAL("Unknown action of --decided: {}", *opt.decided);
+        co_return -1;
+    }
+    if(*type == action::DROP) {
+        // stands in for a dropped command, which reports success
+        co_return 0;
+    }
+    if(*type == action::ABORT) {
+        co_return static_cast<int>(aborted().code);
+    }
+    if(!opt.args.has_value() || !opt.parent_id.has_value()) {
+        LOG_CRITICAL("--decided and --fake need the command id and the command arguments");
+        co_return -1;
+    }
+
+    try {
+        data::command cmd = {
+            .cwd = opt.cwd.has_value() ? *opt.cwd : std::filesystem::current_path().string(),
+            .args = *opt.args,
+            .env = catter::util::get_environment(),
+        };
+        cmd.executable =
+            opt.exec.has_value() ? *opt.exec : resolve_executable(cmd.args.at(0), cmd.env);
+        if(opt.origin.has_value()) {
+            cmd.origin = parse_origin(*opt.origin);
+        }
+
+        auto act = data::action{
+            .type = *type,
+            .cmd = std::move(cmd),
+            // nobody is told about the result, the command writes to the build directly
+            .capture = data::CaptureMode::INHERIT,
+        };
+        auto result = co_await run(std::move(act), *opt.parent_id, opt);
+        co_return static_cast<int>(result.code);
+    } catch(const std::exception& e) {
+        LOG_CRITICAL("Exception in catter-proxy: {}", e.what());
+    }
+    co_return -1;
+}
+
+/// @param started when the proxy started, which is when the command was intercepted.
+kota::task<int> proxy_main(const catter::proxy::ProxyOption& opt, int64_t started) noexcept {
+    if(!opt.ipc.has_value()) {
+        LOG_CRITICAL("--ipc is needed to reach catter");
+        co_return -1;
+    }
     auto& current = kota::event_loop::current();
-    auto ret =
-        co_await kota::pipe::connect(config::ipc::pipe_name(), kota::pipe::options(), current);
+    auto ret = co_await kota::pipe::connect(*opt.ipc, kota::pipe::options(), current);
     if(!ret) {
         LOG_CRITICAL("Failed to connect to IPC pipe: {}, error: {}",
-                     config::ipc::pipe_name(),
+                     *opt.ipc,
                      ret.error().message());
         std::abort();
     }
@@ -97,6 +283,7 @@ kota::task<int> proxy_main(const catter::proxy::ProxyOption& opt) noexcept {
 
     auto [code, _] = co_await kota::when_all{
         [](const catter::proxy::ProxyOption& opt,
+           int64_t started,
            proxy::ipc::Peer& peer) noexcept -> kota::task<int> {
             // ensure peer is closed when proxy_main exits, otherwise the peer might still be
             // running and trying to access resources that have been cleaned up after proxy_main
@@ -119,11 +306,6 @@ kota::task<int> proxy_main(const catter::proxy::ProxyOption& opt) noexcept {
                     throw cpptrace::runtime_error("missing command arguments after --");
                 }
 
-                if(!co_await peer.check_mode(data::ServiceMode::INJECT)) {
-                    throw cpptrace::runtime_error(
-                        "catter is not in inject mode, cannot handle the request");
-                }
-
                 data::command cmd = {
                     .cwd = std::filesystem::current_path().string(),
                     .args = *opt.args,
@@ -136,15 +318,46 @@ kota::task<int> proxy_main(const catter::proxy::ProxyOption& opt) noexcept {
                     cmd.executable = resolve_executable(cmd.args.at(0), cmd.env);
                 }
 
-                auto id = co_await peer.create(*opt.parent_id);
+                if(opt.origin.has_value()) {
+                    cmd.origin = parse_origin(*opt.origin);
+                }
 
-                auto received_act = co_await peer.make_decision(cmd);
+                if(opt.env_changed.has_value()) {
+                    send_env_as_delta(cmd, *opt.parent_id, *opt.env_changed);
+                }
 
-                auto result = co_await run(received_act, id);
+                auto decision = co_await peer.hello(data::ServiceMode::INJECT, *opt.parent_id, cmd);
+                if(!decision.has_value()) {
+                    throw cpptrace::runtime_error(
+                        "catter is not in inject mode, cannot handle the request");
+                }
+                auto [id, received_act] = std::move(*decision);
+                if(received_act.type == action::RESEND) {
+                    // the commands we inherited the environment from are forgotten, a process
+                    // left running in the background outlived them
+                    cmd.env = catter::util::get_environment();
+                    cmd.env_base.reset();
+                    cmd.env_unset.clear();
+                    received_act = co_await peer.make_decision(std::move(cmd));
+                }
+                if(received_act.type != action::DROP && received_act.type != action::ABORT) {
+                    received_act.cmd.env = received_env(received_act.cmd, id);
+                    received_act.cmd.env_base.reset();
+                    received_act.cmd.env_unset.clear();
+                }
 
-                co_await peer.finish(std::move(result));
+                std::function<void(int64_t)> on_start;
+                if((received_act.type == action::INJECT || received_act.type == action::FAKE) &&
+                   !received_act.ignore_descendants) {
+                    // the pid only links the hooked descendants of the command
+                    on_start = [&peer](int64_t pid) { peer.started(pid); };
+                }
+                auto result = co_await run(received_act, id, opt, std::move(on_start));
+                result.stats.spawn = started;
 
-                co_return static_cast<int>(result.code);
+                auto exit_code = static_cast<int>(result.code);
+                co_await peer.finish(std::move(result));
+                co_return exit_code;
             } catch(const std::exception& e) {
                 std::string args;
                 if(opt.args.has_value()) {
@@ -162,16 +375,19 @@ kota::task<int> proxy_main(const catter::proxy::ProxyOption& opt) noexcept {
             }
             co_await peer.report_error(*opt.parent_id, err);
             co_return -1;
-        }(opt, peer),
+        }(opt, started, peer),
         peer.run()};
     co_return code;
 }
 }  // namespace
 
 // we do not output in proxy, it must be invoked by main program.
-// usage: catter-proxy.exe -p <parent ipc id> [--exec <exe path>] -- <args...>
-// TODO: act as a fake compiler
+// usage: catter-proxy.exe -p <parent ipc id> [--origin <pid:ppid:tid>] --ipc <socket>
+//                         [--direct <socket>] [--exec-filter <file>] [--env-changed <keys>]
+//                         [--exec <exe path>] [--fake | --decided <action>] [--cwd <dir>]
+//                         -- <args...>
 int main(int argc, char* argv[], [[maybe_unused]] char* envp[]) {
+    const auto started = unix_time_us();
     try {
         log::init_logger("catter-proxy.log",
                          util::get_catter_data_path() / config::proxy::LOG_PATH_REL,
@@ -189,7 +405,10 @@ int main(int argc, char* argv[], [[maybe_unused]] char* envp[]) {
               [&](const catter::proxy::Option& opt) { cli.usage(std::cerr); })
         .match(catter::proxy::Option::Cate::proxy,
                [&](const auto& opt) {
-                   auto task = proxy_main(opt.proxy_opt);
+                   const auto& proxy_opt = opt.proxy_opt;
+                   auto task = proxy_opt.fake.value() || proxy_opt.decided.has_value()
+                                   ? decided_main(proxy_opt)
+                                   : proxy_main(proxy_opt, started);
                    kota::event_loop loop;
                    loop.schedule(task);
                    loop.run();
@@ -10,11 +10,55 @@ struct ProxyOption {
        help = "specify the parent process ID."
     ) <int> parent_id;
 
+    DecoKV(meta_var = "<pid:ppid:tid>",
+           help = "the process which made the call, as reported by the hook",
+           required = false)
+    <std::string> origin;
+
     DecoKV(meta_var = "<Executable>",
            help = "a path, specify the executable to run",
            required = false)
     <std::string> exec;
 
+    DecoKV(meta_var = "<Socket>",
+           help = "socket of catter, passed on to hooked commands",
+           required = false)
+    <std::string> ipc;
+
+    DecoKV(meta_var = "<Socket>",
+           help = "socket of the direct path, passed on to hooked commands",
+           required = false)
+    <std::string> direct;
+
+    DecoKV(names = {"--exec-filter"},
+           meta_var = "<File>",
+           help = "executables hooked commands run without asking catter, passed on to them",
+           required = false)
+    <std::string> exec_filter;
+
+    DecoKV(names = {"--env-changed"},
+           meta_var = "<Keys>",
+           help = "keys of the environment changed against the parent command, separated by '='",
+           required = false)
+    <std::string> env_changed;
+
+    DecoFlag(names = {"--fake"},
+             help = "write placeholders of the outputs of the command instead of running it, without asking the parent",
+             required = false)
+    fake = false;
+
+    DecoKV(names = {"--decided"},
+           meta_var = "<Action>",
+           help = "run the command as catter decided on the direct path, without asking it: inject, wrap, drop or abort",
+           required = false)
+    <std::string> decided;
+
+    DecoKV(names = {"--cwd"},
+           meta_var = "<Directory>",
+           help = "working directory of a command run by --decided or --fake, defaults to the current one",
+           required = false)
+    <std::string> cwd;
+
     DecoInput(
         meta_var = "<Error Msg>",
         help = "if the input is not after a '--', then it is an error message from the hook",
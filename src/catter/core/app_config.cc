@@ -20,11 +20,21 @@ std::string load_script_content(const std::string& script_path) {
          R"(
     import { scripts, service } from "catter";
     service.register(scripts.cmdTree());
+    )"},
+        {"script::minimal-build",
+         R"(
+    import { scripts, service } from "catter";
+    service.register(scripts.minimalBuild());
     )"},
         {"script::target-tree",
          R"(
     import { scripts, service } from "catter";
     service.register(scripts.targetTree());
+    )"},
+        {"script::trace",
+         R"(
+    import { scripts, service } from "catter";
+    service.register(scripts.trace());
     )"}
     };
 
@@ -1,9 +1,11 @@
 #include "app_runner.h"
 
 #include <exception>
+#include <optional>
 #include <utility>
 
 #include "app_config.h"
+#include "event_log.h"
 #include "option.h"
 #include "runtime_driver.h"
 #include "js/js.h"
@@ -15,6 +17,13 @@ kota::task<> async_run(const core::CatterConfig& config) {
     auto script_config = context.make_script_config();
     auto script_content = load_script_content(script_config.scriptPath);
 
+    std::optional<core::EventLogReader> replay;
+    if(auto path = context.replay_path()) {
+        replay.emplace(*path);
+        script_config.buildSystemCommand = replay->build_command();
+        script_config.buildSystemCommandCwd = replay->cwd();
+    }
+
     js::RuntimeScope runtime;
 
     std::exception_ptr error;
@@ -26,7 +35,18 @@ kota::task<> async_run(const core::CatterConfig& config) {
         context.apply_option_defaults(script_config);
 
         if(script_config.execute) {
-            auto process_result = co_await context.driver.execute(script_config);
+            if(auto workers = script_config.options.decisionWorkers.value_or(0); workers != 0) {
+                co_await js::start_workers(workers,
+                                           script_content,
+                                           script_config.scriptPath,
+                                           script_config);
+            }
+            data::process_result process_result;
+            if(replay.has_value()) {
+                process_result = co_await core::replay(*replay, script_config);
+            } else {
+                process_result = co_await context.driver.execute(script_config);
+            }
             co_await js::on_finish(core::to_js_process_result(std::move(process_result)));
         }
     } catch(...) {
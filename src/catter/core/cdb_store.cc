@@ -0,0 +1,514 @@
+#include "cdb_store.h"
+
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <cpptrace/exceptions.hpp>
+
+namespace catter::core {
+
+namespace {
+
+/// Deeper nesting is rejected rather than risking the stack, no real entry comes close.
+constexpr int max_depth = 256;
+
+/// A field of an entry, `valid` is false when it is present with another type.
+template <typename T>
+struct Field {
+    bool present = false;
+    bool valid = false;
+    T value{};
+
+    bool wrong_type() const noexcept {
+        return present && !valid;
+    }
+};
+
+class Scanner {
+public:
+    Scanner(std::string_view text, std::string_view context) : text(text), context(context) {}
+
+    std::size_t offset() const noexcept {
+        return pos;
+    }
+
+    bool at_end() {
+        skip_ws();
+        return pos == text.size();
+    }
+
+    /// The next character after whitespace, or `\0` at the end.
+    char peek() {
+        skip_ws();
+        return pos < text.size() ? text[pos] : '\0';
+    }
+
+    bool consume(char c) {
+        if(peek() != c) {
+            return false;
+        }
+        ++pos;
+        return true;
+    }
+
+    void expect(char c) {
+        if(!consume(c)) {
+            fail(std::format("expected '{}'", c));
+        }
+    }
+
+    /// Skip over one value of any type.
+    void skip_value(int depth = 0) {
+        if(depth > max_depth) {
+            fail("nested too deeply");
+        }
+        switch(peek()) {
+            case '{': {
+                ++pos;
+                if(consume('}')) {
+                    return;
+                }
+                do {
+                    skip_string();
+                    expect(':');
+                    skip_value(depth + 1);
+                } while(consume(','));
+                expect('}');
+                return;
+            }
+            case '[': {
+                ++pos;
+                if(consume(']')) {
+                    return;
+                }
+                do {
+                    skip_value(depth + 1);
+                } while(consume(','));
+                expect(']');
+                return;
+            }
+            case '"': skip_string(); return;
+            case 't': literal("true"); return;
+            case 'f': literal("false"); return;
+            case 'n': literal("null"); return;
+            default: number(); return;
+        }
+    }
+
+    void skip_string() {
+        read_string(nullptr);
+    }
+
+    /// Read a string, decoding it into `out` if it is set.
+    void read_string(std::string* out) {
+        if(peek() != '"') {
+            fail("expected a string");
+        }
+        ++pos;
+        while(true) {
+            if(pos >= text.size()) {
+                fail("unterminated string");
+            }
+            char c = text[pos++];
+            if(c == '"') {
+                return;
+            }
+            if(static_cast<unsigned char>(c) < 0x20) {
+                fail("control character in string");
+            }
+            if(c != '\\') {
+                if(out) {
+                    out->push_back(c);
+                }
+                continue;
+            }
+            if(pos >= text.size()) {
+                fail("unterminated string");
+            }
+            char escaped = text[pos++];
+            char decoded = '\0';
+            switch(escaped) {
+                case '"': decoded = '"'; break;
+                case '\\': decoded = '\\'; break;
+                case '/': decoded = '/'; break;
+                case 'b': decoded = '\b'; break;
+                case 'f': decoded = '\f'; break;
+                case 'n': decoded = '\n'; break;
+                case 'r': decoded = '\r'; break;
+                case 't': decoded = '\t'; break;
+                case 'u': {
+                    auto code = unicode_escape();
+                    if(out) {
+                        append_utf8(*out, code);
+                    }
+                    continue;
+                }
+                default: fail("invalid escape");
+            }
+            if(out) {
+                out->push_back(decoded);
+            }
+        }
+    }
+
+    [[noreturn]] void fail(std::string_view what) const {
+        throw cpptrace::runtime_error(
+            std::format("{}: invalid JSON at offset {}: {}", context, pos, what));
+    }
+
+private:
+    void skip_ws() noexcept {
+        while(pos < text.size() &&
+              (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+            ++pos;
+        }
+    }
+
+    void literal(std::string_view word) {
+        if(text.substr(pos, word.size()) != word) {
+            fail("unexpected token");
+        }
+        pos += word.size();
+    }
+
+    void number() {
+        auto digits = [this] {
+            auto start = pos;
+            while(pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+                ++pos;
+            }
+            return pos - start;
+        };
+
+        if(pos < text.size() && text[pos] == '-') {
+            ++pos;
+        }
+        if(pos < text.size() && text[pos] == '0') {
+            ++pos;
+        } else if(digits() == 0) {
+            fail("unexpected token");
+        }
+        if(pos < text.size() && text[pos] == '.') {
+            ++pos;
+            if(digits() == 0) {
+                fail("expected a digit");
+            }
+        }
+        if(pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+            ++pos;
+            if(pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+                ++pos;
+            }
+            if(digits() == 0) {
+                fail("expected a digit");
+            }
+        }
+    }
+
+    uint32_t hex4() {
+        if(pos + 4 > text.size()) {
+            fail("invalid unicode escape");
+        }
+        uint32_t code = 0;
+        for(int i = 0; i < 4; ++i) {
+            char c = text[pos++];
+            code <<= 4;
+            if(c >= '0' && c <= '9') {
+                code |= c - '0';
+            } else if(c >= 'a' && c <= 'f') {
+                code |= c - 'a' + 10;
+            } else if(c >= 'A' && c <= 'F') {
+                code |= c - 'A' + 10;
+            } else {
+                fail("invalid unicode escape");
+            }
+        }
+        return code;
+    }
+
+    /// Decode the rest of a `\u` escape, joining surrogate pairs. A lone surrogate is kept as is,
+    /// like `JSON.parse` keeps it.
+    uint32_t unicode_escape() {
+        auto code = hex4();
+        if(code >= 0xD800 && code <= 0xDBFF && text.substr(pos, 2) == "\\u") {
+            auto saved = pos;
+            pos += 2;
+            auto low = hex4();
+            if(low >= 0xDC00 && low <= 0xDFFF) {
+                return 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            pos = saved;
+        }
+        return code;
+    }
+
+    static void append_utf8(std::string& out, uint32_t code) {
+        if(code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if(code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if(code < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+    std::string_view text;
+    std::string_view context;
+    std::size_t pos = 0;
+};
+
+void read_string_field(Scanner& scanner, Field<std::string>& field) {
+    field = {.present = true};
+    if(scanner.peek() == '"') {
+        scanner.read_string(&field.value);
+        field.valid = true;
+    } else {
+        scanner.skip_value();
+    }
+}
+
+void read_string_list_field(Scanner& scanner, Field<std::vector<std::string>>& field) {
+    field = {.present = true};
+    if(scanner.peek() != '[') {
+        scanner.skip_value();
+        return;
+    }
+    scanner.expect('[');
+    field.valid = true;
+    if(scanner.consume(']')) {
+        return;
+    }
+    do {
+        if(field.valid && scanner.peek() == '"') {
+            scanner.read_string(&field.value.emplace_back());
+        } else {
+            field.valid = false;
+            scanner.skip_value(1);
+        }
+    } while(scanner.consume(','));
+    scanner.expect(']');
+}
+
+/// The fields `CDBManager` looks at, checked with the same messages in the same order.
+struct Entry {
+    Field<std::string> directory;
+    Field<std::string> file;
+    Field<std::string> command;
+    Field<std::vector<std::string>> arguments;
+    Field<std::string> output;
+
+    void validate(std::string_view context) const {
+        auto error = [&](std::string_view what) {
+            return cpptrace::runtime_error(std::format("{}: {}", context, what));
+        };
+        if(!directory.valid || directory.value.empty()) {
+            throw error(R"("directory" must be a non-empty string)");
+        }
+        if(!file.valid || file.value.empty()) {
+            throw error(R"("file" must be a non-empty string)");
+        }
+        if(command.wrong_type()) {
+            throw error(R"("command" must be a string)");
+        }
+        if(arguments.wrong_type()) {
+            throw error(R"("arguments" must be a string array)");
+        }
+        if(!command.present && !arguments.present) {
+            throw error(R"(expected "command" or "arguments")");
+        }
+        if(output.wrong_type()) {
+            throw error(R"("output" must be a string)");
+        }
+    }
+
+    /// Identifies an entry within its source file, an absent field is the same as an empty one.
+    std::string key() const {
+        std::string key;
+        auto append = [&key](std::string_view part) {
+            key += std::format("{}:", part.size());
+            key += part;
+        };
+        append(output.value);
+        append(command.value);
+        for(const auto& argument: arguments.value) {
+            append(argument);
+        }
+        return key;
+    }
+};
+
+Entry read_entry(Scanner& scanner, std::string_view context) {
+    if(scanner.peek() != '{') {
+        scanner.skip_value();
+        throw cpptrace::runtime_error(std::format("{}: expected object item", context));
+    }
+    scanner.expect('{');
+
+    Entry entry;
+    if(scanner.consume('}')) {
+        return entry;
+    }
+    std::string name;
+    do {
+        name.clear();
+        scanner.read_string(&name);
+        scanner.expect(':');
+        if(name == "directory") {
+            read_string_field(scanner, entry.directory);
+        } else if(name == "file") {
+            read_string_field(scanner, entry.file);
+        } else if(name == "command") {
+            read_string_field(scanner, entry.command);
+        } else if(name == "arguments") {
+            read_string_list_field(scanner, entry.arguments);
+        } else if(name == "output") {
+            read_string_field(scanner, entry.output);
+        } else {
+            scanner.skip_value(1);
+        }
+    } while(scanner.consume(','));
+    scanner.expect('}');
+    return entry;
+}
+
+void indent(std::string& out, int depth) {
+    out.push_back('\n');
+    out.append(static_cast<std::size_t>(depth) * 2, ' ');
+}
+
+}  // namespace
+
+CDBStore CDBStore::parse(std::string content, const FileKey& file_key, std::string_view context) {
+    CDBStore store;
+    store.content = std::move(content);
+
+    Scanner scanner(store.content, context);
+    if(scanner.at_end()) {
+        return store;
+    }
+    if(scanner.peek() != '[') {
+        throw cpptrace::runtime_error(
+            std::format("CDB file must contain a JSON array: {}", context));
+    }
+    scanner.expect('[');
+
+    if(!scanner.consume(']')) {
+        std::size_t index = 0;
+        do {
+            scanner.peek();
+            auto begin = scanner.offset();
+            auto item_context = std::format("{}[{}]", context, index++);
+            auto entry = read_entry(scanner, item_context);
+            entry.validate(item_context);
+
+            auto file = file_key(entry.directory.value, entry.file.value);
+            auto [it, inserted] = store.group_index.try_emplace(file, store.groups.size());
+            if(inserted) {
+                store.groups.push_back(Group{.file = std::move(file)});
+            }
+            auto& group = store.groups[it->second];
+            Span span{.offset = begin, .size = scanner.offset() - begin};
+            auto [entry_it, added] = group.index.try_emplace(entry.key(), group.entries.size());
+            if(added) {
+                group.entries.push_back(span);
+            } else {
+                group.entries[entry_it->second] = span;
+            }
+        } while(scanner.consume(','));
+        scanner.expect(']');
+    }
+    if(!scanner.at_end()) {
+        scanner.fail("unexpected content after the array");
+    }
+    return store;
+}
+
+CDBStore CDBStore::load(const std::filesystem::path& path, const FileKey& file_key) {
+    std::ifstream input(path, std::ios::binary);
+    if(!input) {
+        throw cpptrace::runtime_error(std::format("Failed to read CDB: {}", path.string()));
+    }
+    std::string content{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+    return parse(std::move(content), file_key, path.string());
+}
+
+void CDBStore::for_each(const std::unordered_set<std::string>& excluded,
+                        const std::function<void(std::string_view entry)>& visit) const {
+    std::string_view text = this->content;
+    for(const auto& group: this->groups) {
+        if(excluded.contains(group.file)) {
+            continue;
+        }
+        for(const auto& span: group.entries) {
+            visit(text.substr(span.offset, span.size));
+        }
+    }
+}
+
+std::string CDBStore::pretty(std::string_view entry) {
+    std::string out;
+    out.reserve(entry.size() * 2);
+    int depth = 0;
+    for(std::size_t i = 0; i < entry.size(); ++i) {
+        char c = entry[i];
+        switch(c) {
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r': break;
+            case '"': {
+                // copy the string as written, escapes included
+                auto begin = i++;
+                while(entry[i] != '"') {
+                    i += entry[i] == '\\' ? 2 : 1;
+                }
+                out.append(entry.substr(begin, i - begin + 1));
+                break;
+            }
+            case '{':
+            case '[': {
+                auto next = entry.find_first_not_of(" \t\n\r", i + 1);
+                char close = c == '{' ? '}' : ']';
+                if(next != std::string_view::npos && entry[next] == close) {
+                    out.push_back(c);
+                    out.push_back(close);
+                    i = next;
+                } else {
+                    out.push_back(c);
+                    indent(out, ++depth);
+                }
+                break;
+            }
+            case '}':
+            case ']': {
+                indent(out, --depth);
+                out.push_back(c);
+                break;
+            }
+            case ',': {
+                out.push_back(',');
+                indent(out, depth);
+                break;
+            }
+            case ':': {
+                out.append(": ");
+                break;
+            }
+            default: out.push_back(c); break;
+        }
+    }
+    return out;
+}
+
+}  // namespace catter::core
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace catter::core {
+
+/**
+ * The entries of an existing `compile_commands.json`, kept as the JSON text they were read from.
+ *
+ * Entries are grouped by source file and deduplicated the same way `CDBManager` does it, so the
+ * inherited part of a large database is validated and merged without ever becoming JS objects.
+ * Entries keep every field they were written with.
+ */
+class CDBStore {
+public:
+    /// Maps the `directory` and `file` of an entry to the key of its source file.
+    using FileKey = std::function<std::string(std::string_view directory, std::string_view file)>;
+
+    /**
+     * @param context prefix of error messages, usually the path of the database.
+     * @throws cpptrace::runtime_error if `content` is not valid JSON or not a valid database.
+     */
+    static CDBStore parse(std::string content, const FileKey& file_key, std::string_view context);
+
+    /// @throws cpptrace::runtime_error if the file can not be read or `parse` fails.
+    static CDBStore load(const std::filesystem::path& path, const FileKey& file_key);
+
+    /// Visit the entries whose source file is not in `excluded`, grouped by source file.
+    void for_each(const std::unordered_set<std::string>& excluded,
+                  const std::function<void(std::string_view entry)>& visit) const;
+
+    /// Format one entry like `JSON.stringify(entry, null, 2)` does, keeping scalars as written.
+    static std::string pretty(std::string_view entry);
+
+private:
+    struct Span {
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    struct Group {
+        std::string file;
+        std::vector<Span> entries;
+        /// Entry key to its index in `entries`, a later duplicate replaces the earlier one.
+        std::unordered_map<std::string, std::size_t> index;
+    };
+
+    std::string content;
+    std::vector<Group> groups;
+    std::unordered_map<std::string, std::size_t> group_index;
+};
+
+}  // namespace catter::core
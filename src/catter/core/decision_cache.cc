@@ -0,0 +1,200 @@
+#include "decision_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <utility>
+#include <cpptrace/exceptions.hpp>
+
+#include "util/bincode.h"
+
+namespace catter::core {
+
+namespace {
+
+constexpr std::string_view magic = "catter-decision-cache";
+/// Bump when the layout of the file changes, older files are then dropped.
+constexpr uint32_t format_version = 2;
+
+struct Record {
+    uint64_t key = 0;
+    js::ActionType action = js::ActionType::skip;
+    std::optional<js::CaptureMode> capture;
+    bool ignore_descendants = false;
+    std::string state;
+};
+
+/// The whole file, a single frame.
+struct Content {
+    std::string magic;
+    uint32_t version = 0;
+    uint64_t script = 0;
+    std::vector<Record> entries;
+};
+
+bool cacheable(js::ActionType action) {
+    switch(action) {
+        case js::ActionType::skip:
+        case js::ActionType::drop:
+        case js::ActionType::fake: return true;
+        default: return false;
+    }
+}
+
+/// @return nullopt if the response file can not be read.
+std::optional<std::string> read_response_file(std::string_view cwd, std::string_view name) {
+    std::filesystem::path path(name);
+    if(path.is_relative()) {
+        path = std::filesystem::path(cwd) / path;
+    }
+    std::ifstream file(path, std::ios::binary);
+    if(!file.good()) {
+        return std::nullopt;
+    }
+    return std::string{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+}  // namespace
+
+static_assert(std::ranges::is_sorted(DecisionCache::compiler_env));
+
+Fingerprint& Fingerprint::add(std::string_view value) noexcept {
+    constexpr uint64_t prime = 0x100'0000'01b3;
+    // the length keeps {"ab", "c"} and {"a", "bc"} apart
+    auto size = static_cast<uint64_t>(value.size());
+    for(int shift = 0; shift < 64; shift += 8) {
+        hash = (hash ^ ((size >> shift) & 0xFF)) * prime;
+    }
+    for(unsigned char c: value) {
+        hash = (hash ^ c) * prime;
+    }
+    return *this;
+}
+
+Fingerprint& Fingerprint::add(std::span<const std::string> values) noexcept {
+    add(std::to_string(values.size()));
+    for(const auto& value: values) {
+        add(value);
+    }
+    return *this;
+}
+
+DecisionCache DecisionCache::load(const std::filesystem::path& path, uint64_t script) {
+    DecisionCache cache(script);
+
+    std::ifstream file(path, std::ios::binary);
+    if(!file.good()) {
+        return cache;
+    }
+    std::string content{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+    // a truncated or foreign file is dropped as a whole rather than trusted in part
+    auto size = bincode::frame_size(content);
+    if(!size.has_value() || *size != content.size()) {
+        return cache;
+    }
+    auto decoded = bincode::decode<Content>(
+        std::string_view(content).substr(bincode::frame_header_size));
+    if(!decoded.has_value() || decoded->magic != magic || decoded->version != format_version ||
+       decoded->script != script) {
+        return cache;
+    }
+
+    std::unordered_map<uint64_t, Entry> entries;
+    for(auto& record: decoded->entries) {
+        if(!cacheable(record.action)) {
+            return cache;
+        }
+        entries.insert_or_assign(record.key,
+                                 Entry{
+                                     .action = record.action,
+                                     .capture = record.capture,
+                                     .ignore_descendants = record.ignore_descendants,
+                                     .state = std::move(record.state),
+                                 });
+    }
+    cache.entries = std::move(entries);
+    return cache;
+}
+
+void DecisionCache::save(const std::filesystem::path& path) const {
+    Content saved{
+        .magic = std::string(magic),
+        .version = format_version,
+        .script = script,
+    };
+    saved.entries.reserve(entries.size());
+    for(const auto& [key, entry]: entries) {
+        saved.entries.push_back({
+            .key = key,
+            .action = entry.action,
+            .capture = entry.capture,
+            .ignore_descendants = entry.ignore_descendants,
+            .state = entry.state,
+        });
+    }
+    auto content = bincode::frame(saved);
+    if(!content.has_value()) {
+        throw cpptrace::runtime_error(
+            std::format("Failed to encode decision cache {}", path.string()));
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    if(ec) {
+        throw cpptrace::runtime_error(
+            std::format("Failed to create {}: {}", path.parent_path().string(), ec.message()));
+    }
+
+    // another catter may read the cache meanwhile, it must never see half of it
+    auto temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(content->data(), static_cast<std::streamsize>(content->size()));
+        if(!file.good()) {
+            throw cpptrace::runtime_error(
+                std::format("Failed to write decision cache {}", temporary.string()));
+        }
+    }
+    std::filesystem::rename(temporary, path, ec);
+    if(ec) {
+        throw cpptrace::runtime_error(
+            std::format("Failed to write decision cache {}: {}", path.string(), ec.message()));
+    }
+}
+
+uint64_t DecisionCache::key(std::string_view cwd,
+                            std::string_view exe,
+                            std::span<const std::string> argv,
+                            std::span<const std::string> env) {
+    Fingerprint fingerprint;
+    fingerprint.add(cwd).add(exe).add(argv).add(env);
+    for(std::size_t i = 1; i < argv.size(); ++i) {
+        std::string_view arg = argv[i];
+        if(arg.size() > 1 && arg.starts_with('@')) {
+            auto content = read_response_file(cwd, arg.substr(1));
+            // a missing file is not the same as an empty one
+            fingerprint.add(content.has_value() ? "1" : "0").add(content.value_or(""));
+        }
+    }
+    return fingerprint.value();
+}
+
+const DecisionCache::Entry* DecisionCache::find(uint64_t key) const {
+    auto it = entries.find(key);
+    return it == entries.end() ? nullptr : &it->second;
+}
+
+void DecisionCache::store(uint64_t key, Entry entry) {
+    if(auto it = entries.find(key); it != entries.end() && it->second == entry) {
+        return;
+    }
+    entries.insert_or_assign(key, std::move(entry));
+    dirty = true;
+}
+
+}  // namespace catter::core
@@ -0,0 +1,126 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "js/capi/type.h"
+
+namespace catter::core {
+
+/**
+ * Decisions of `onCommand` kept on disk across runs, keyed by a fingerprint of the command.
+ *
+ * An incremental build runs mostly the same commands as the run before, so a command the script
+ * asked to cache with `ctx.cache` is answered natively the next time it is seen, without calling
+ * the script. The state the script attached is handed to `onMerge` instead.
+ *
+ * A cache belongs to one script: entries written by another script, script arguments or version of
+ * the script library are dropped when it is loaded.
+ */
+class DecisionCache {
+public:
+    struct Entry {
+        /// Only `skip`, `drop` and `fake`.
+        js::ActionType action;
+        std::optional<js::CaptureMode> capture;
+        bool ignore_descendants = false;
+        std::string state;
+
+        bool operator== (const Entry&) const = default;
+    };
+
+    /// Variables which change what a compiler does with the same arguments, always in the key.
+    /// Sorted.
+    constexpr static std::array<std::string_view, 22> compiler_env = {
+        "AR",
+        "CC",
+        "CCC_OVERRIDE_OPTIONS",
+        "CFLAGS",
+        "CL",
+        "COMPILER_PATH",
+        "CPATH",
+        "CPLUS_INCLUDE_PATH",
+        "CPPFLAGS",
+        "CXX",
+        "CXXFLAGS",
+        "C_INCLUDE_PATH",
+        "GCC_EXEC_PREFIX",
+        "INCLUDE",
+        "LDFLAGS",
+        "LIB",
+        "LIBRARY_PATH",
+        "MACOSX_DEPLOYMENT_TARGET",
+        "OBJCPLUS_INCLUDE_PATH",
+        "OBJC_INCLUDE_PATH",
+        "SDKROOT",
+        "_CL_",
+    };
+
+    /// @param script a fingerprint of everything that makes the script decide differently.
+    explicit DecisionCache(uint64_t script) : script(script) {}
+
+    /**
+     * Read the cache at `path`. A missing or unreadable file, or one written for another script,
+     * gives an empty cache, it is only a cache.
+     */
+    static DecisionCache load(const std::filesystem::path& path, uint64_t script);
+
+    /**
+     * Write the cache to `path` through a temporary file, creating the directory.
+     *
+     * @throws cpptrace::runtime_error if the file can not be written.
+     */
+    void save(const std::filesystem::path& path) const;
+
+    /**
+     * The key of a command. The content of each `@file` argument takes part too, as relative
+     * paths against `cwd`: a response file may change while the command stays the same.
+     *
+     * @param env the entries of the environment which take part in the key.
+     */
+    static uint64_t key(std::string_view cwd,
+                        std::string_view exe,
+                        std::span<const std::string> argv,
+                        std::span<const std::string> env);
+
+    const Entry* find(uint64_t key) const;
+
+    void store(uint64_t key, Entry entry);
+
+    /// Whether something was stored since the cache was loaded.
+    bool modified() const noexcept {
+        return dirty;
+    }
+
+    std::size_t size() const noexcept {
+        return entries.size();
+    }
+
+private:
+    uint64_t script;
+    std::unordered_map<uint64_t, Entry> entries;
+    bool dirty = false;
+};
+
+/// A stable 64-bit FNV-1a hash, unlike `std::hash` it is the same in every run.
+class Fingerprint {
+public:
+    Fingerprint& add(std::string_view value) noexcept;
+
+    Fingerprint& add(std::span<const std::string> values) noexcept;
+
+    uint64_t value() const noexcept {
+        return hash;
+    }
+
+private:
+    uint64_t hash = 0xcbf2'9ce4'8422'2325;
+};
+
+}  // namespace catter::core
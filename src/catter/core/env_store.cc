@@ -0,0 +1,78 @@
+#include "env_store.h"
+
+#include <algorithm>
+#include <format>
+#include <utility>
+#include <cpptrace/exceptions.hpp>
+
+#include "util/env_delta.h"
+
+namespace catter::core {
+
+EnvStore::Ref EnvStore::resolve(const data::command& cmd) const {
+    if(!cmd.env_base.has_value()) {
+        return std::make_shared<const Node>(Node{.changed = cmd.env});
+    }
+
+    auto it = this->envs.find(*cmd.env_base);
+    if(it == this->envs.end()) {
+        throw cpptrace::runtime_error(
+            std::format("Environment of command {} is unknown", *cmd.env_base));
+    }
+    return derive(it->second, cmd.env, cmd.env_unset);
+}
+
+bool EnvStore::resolvable(const data::command& cmd) const {
+    return !cmd.env_base.has_value() || this->envs.contains(*cmd.env_base);
+}
+
+void EnvStore::store(data::ipcid_t id, Ref env) {
+    this->envs.insert_or_assign(id, std::move(env));
+}
+
+void EnvStore::release(data::ipcid_t id) {
+    this->envs.erase(id);
+}
+
+EnvStore::Ref EnvStore::derive(Ref base,
+                               std::vector<std::string> changed,
+                               std::vector<std::string> unset) {
+    if(changed.empty() && unset.empty()) {
+        return base;
+    }
+    return std::make_shared<const Node>(Node{
+        .base = std::move(base),
+        .changed = std::move(changed),
+        .unset = std::move(unset),
+    });
+}
+
+std::vector<std::string> EnvStore::materialize(const Ref& env) {
+    std::vector<const Node*> chain;
+    for(auto node = env.get(); node != nullptr; node = node->base.get()) {
+        chain.push_back(node);
+    }
+
+    std::vector<std::string> result;
+    for(auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        env_delta::apply(result, (*it)->changed, (*it)->unset);
+    }
+    return result;
+}
+
+const std::string* EnvStore::find(const Ref& env, std::string_view key) {
+    for(auto node = env.get(); node != nullptr; node = node->base.get()) {
+        // `env_delta::apply` removes `unset` before it applies `changed`
+        for(auto it = node->changed.rbegin(); it != node->changed.rend(); ++it) {
+            if(env_delta::key_of(*it) == key) {
+                return &*it;
+            }
+        }
+        if(std::ranges::find(node->unset, key) != node->unset.end()) {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace catter::core
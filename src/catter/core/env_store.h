@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "util/data.h"
+
+namespace catter::core {
+
+/**
+ * Environments of the commands in a session.
+ *
+ * Commands usually inherit the environment of their parent unchanged, so each environment is kept
+ * as the delta against the one it was derived from, and only materialized when it is read.
+ */
+class EnvStore {
+public:
+    struct Node;
+    using Ref = std::shared_ptr<const Node>;
+
+    struct Node {
+        Ref base;
+        std::vector<std::string> changed;
+        std::vector<std::string> unset;
+    };
+
+    /**
+     * Resolve the environment sent with `cmd`, either a full environment or a delta against a
+     * stored command.
+     *
+     * @throws cpptrace::runtime_error if `cmd.env_base` is not stored.
+     */
+    Ref resolve(const data::command& cmd) const;
+
+    /// @return whether `resolve` knows the environment `cmd` is sent against.
+    bool resolvable(const data::command& cmd) const;
+
+    /// Remember `env` as the environment command `id` runs with.
+    void store(data::ipcid_t id, Ref env);
+
+    /**
+     * Command `id` is forgotten. The environments derived from it stay valid, a command still sent
+     * against it has to be sent with its full environment instead.
+     */
+    void release(data::ipcid_t id);
+
+    std::size_t size() const noexcept {
+        return envs.size();
+    }
+
+    /// @return `base` with the delta applied, `base` itself if the delta is empty.
+    static Ref derive(Ref base, std::vector<std::string> changed, std::vector<std::string> unset);
+
+    static std::vector<std::string> materialize(const Ref& env);
+
+    /// @return the `KEY=VALUE` entry of `key` in `env` without materializing it, null if unset.
+    static const std::string* find(const Ref& env, std::string_view key);
+
+private:
+    std::unordered_map<data::ipcid_t, Ref> envs;
+};
+
+}  // namespace catter::core
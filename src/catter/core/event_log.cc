@@ -0,0 +1,238 @@
+#include "event_log.h"
+
+#include <format>
+#include <system_error>
+#include <utility>
+#include <cpptrace/exceptions.hpp>
+
+#include "util/bincode.h"
+#include "util/env_delta.h"
+#include "util/kotatsu.h"
+
+namespace catter::core {
+
+namespace {
+
+constexpr std::string_view magic = "catter-event-log";
+/// Bump when the layout of an event changes.
+constexpr uint32_t format_version = 4;
+
+/// The first frame of the log.
+struct Header {
+    std::string magic;
+    uint32_t version = 0;
+    std::string cwd;
+    std::vector<std::string> build_command;
+};
+
+/// An event as it is kept, the environment of `cmd` is a delta against the one of `parent`.
+struct Record {
+    uint8_t type = 0;
+    data::ipcid_t id = 0;
+    data::ipcid_t parent = 0;
+    int64_t time = 0;
+    data::command cmd{};
+    std::string error{};
+    data::process_result result{};
+};
+
+/**
+ * @param remaining the bytes left in `file`, a garbage length must not allocate gigabytes.
+ * @return the body of the next frame, nullopt at the end of the file or at a truncated frame.
+ */
+std::optional<std::string> read_frame(std::ifstream& file, uintmax_t& remaining) {
+    std::string header(bincode::frame_header_size, '\0');
+    if(remaining < header.size() ||
+       !file.read(header.data(), static_cast<std::streamsize>(header.size()))) {
+        return std::nullopt;
+    }
+    remaining -= header.size();
+
+    auto size = bincode::body_size(header);
+    if(remaining < size) {
+        return std::nullopt;
+    }
+    std::string body(size, '\0');
+    if(!file.read(body.data(), static_cast<std::streamsize>(body.size()))) {
+        return std::nullopt;
+    }
+    remaining -= size;
+    return body;
+}
+
+}  // namespace
+
+template <typename T>
+void EventLogWriter::append(const T& record) {
+    auto frame = bincode::frame(record);
+    if(!frame.has_value()) {
+        throw cpptrace::runtime_error("Failed to encode an event of the event log");
+    }
+    file.write(frame->data(), static_cast<std::streamsize>(frame->size()));
+    if(!file.good()) {
+        throw cpptrace::runtime_error("Failed to append to the event log");
+    }
+}
+
+EventLogWriter::EventLogWriter(const std::filesystem::path& path,
+                               const std::string& cwd,
+                               const std::vector<std::string>& build_command) :
+    file(path, std::ios::binary | std::ios::trunc) {
+    if(!file.good()) {
+        throw cpptrace::runtime_error(std::format("Failed to create event log {}", path.string()));
+    }
+
+    append(Header{
+        .magic = std::string(magic),
+        .version = format_version,
+        .cwd = cwd,
+        .build_command = build_command,
+    });
+}
+
+void EventLogWriter::command(data::ipcid_t id,
+                             data::ipcid_t parent,
+                             const data::command& cmd,
+                             const EnvStore::Ref& env) {
+    std::vector<std::string> changed;
+    std::vector<std::string> unset;
+    auto it = envs.find(parent);
+    auto base = it == envs.end() ? nullptr : it->second;
+    if(env != base) {
+        if(env != nullptr && env->base == base) {
+            // derived from the parent directly, which is how most commands get their environment
+            changed = env->changed;
+            unset = env->unset;
+        } else {
+            env_delta::diff(EnvStore::materialize(base),
+                            EnvStore::materialize(env),
+                            changed,
+                            unset);
+        }
+    }
+    envs.insert_or_assign(id, env);
+    commands.add(id, parent, {});
+
+    append(Record{
+        .type = LogEvent::COMMAND,
+        .id = id,
+        .parent = parent,
+        .time = unix_time_us(),
+        .cmd = {
+                .cwd = cmd.cwd,
+                .executable = cmd.executable,
+                .args = cmd.args,
+                .env = std::move(changed),
+                .env_unset = std::move(unset),
+                .origin = cmd.origin,
+                },
+    });
+}
+
+void EventLogWriter::error(data::ipcid_t id, data::ipcid_t parent, const std::string& message) {
+    append(Record{
+        .type = LogEvent::CAPTURE_ERROR,
+        .id = id,
+        .parent = parent,
+        .time = unix_time_us(),
+        .error = message,
+    });
+}
+
+void EventLogWriter::result(data::ipcid_t id, const data::process_result& result) {
+    for(auto forgotten: commands.exited(id)) {
+        envs.erase(forgotten);
+    }
+
+    append(Record{
+        .type = LogEvent::RESULT,
+        .id = id,
+        .time = unix_time_us(),
+        .result = result,
+    });
+}
+
+void EventLogWriter::finish(const data::process_result& result) {
+    append(Record{
+        .type = LogEvent::FINISH,
+        .time = unix_time_us(),
+        .result = result,
+    });
+    file.flush();
+}
+
+EventLogReader::EventLogReader(const std::filesystem::path& path) :
+    file(path, std::ios::binary) {
+    std::error_code ec;
+    remaining = std::filesystem::file_size(path, ec);
+    if(!file.good() || ec) {
+        throw cpptrace::runtime_error(std::format("Failed to open event log {}", path.string()));
+    }
+
+    auto header = read_frame(file, remaining);
+    if(!header.has_value()) {
+        throw cpptrace::runtime_error(std::format("{} is not an event log", path.string()));
+    }
+    auto decoded = bincode::decode<Header>(*header);
+    if(!decoded.has_value() || decoded->magic != magic) {
+        throw cpptrace::runtime_error(std::format("{} is not an event log", path.string()));
+    }
+    if(decoded->version != format_version) {
+        throw cpptrace::runtime_error(std::format("Event log {} has version {}, expected {}",
+                                                  path.string(),
+                                                  decoded->version,
+                                                  format_version));
+    }
+    build_cwd = std::move(decoded->cwd);
+    command = std::move(decoded->build_command);
+}
+
+std::optional<LogEvent> EventLogReader::next() {
+    auto body = read_frame(file, remaining);
+    if(!body.has_value()) {
+        return std::nullopt;
+    }
+
+    auto record = bincode::decode<Record>(*body);
+    if(!record.has_value() || record->type > LogEvent::FINISH) {
+        return std::nullopt;
+    }
+    LogEvent event{
+        .type = static_cast<decltype(LogEvent::type)>(record->type),
+        .id = record->id,
+        .parent = record->parent,
+        .time = record->time,
+    };
+
+    switch(event.type) {
+        case LogEvent::COMMAND: {
+            event.cmd = std::move(record->cmd);
+            auto it = envs.find(event.parent);
+            auto env = EnvStore::derive(it == envs.end() ? nullptr : it->second,
+                                        std::exchange(event.cmd.env, {}),
+                                        std::exchange(event.cmd.env_unset, {}));
+            event.cmd.env = EnvStore::materialize(env);
+            envs.insert_or_assign(event.id, std::move(env));
+            commands.add(event.id, event.parent, {});
+            break;
+        }
+        case LogEvent::CAPTURE_ERROR: {
+            event.error = std::move(record->error);
+            break;
+        }
+        case LogEvent::RESULT: {
+            event.result = std::move(record->result);
+            for(auto forgotten: commands.exited(event.id)) {
+                envs.erase(forgotten);
+            }
+            break;
+        }
+        case LogEvent::FINISH: {
+            event.result = std::move(record->result);
+            break;
+        }
+    }
+    return event;
+}
+
+}  // namespace catter::core
@@ -0,0 +1,117 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "env_store.h"
+#include "process_table.h"
+#include "util/data.h"
+
+namespace catter::core {
+
+/**
+ * A build captured by `--record`, which `--replay` feeds to a script again without running
+ * anything.
+ *
+ * The log is a header followed by one `bincode::frame` per event, appended as the build goes, so a
+ * log cut short by a crash is still readable up to its last complete event. The environment of a
+ * command is kept as the delta against the one of its parent, as long as the parent is known: the
+ * writer and the reader both forget a command as `ProcessTable` does, on the same events.
+ */
+struct LogEvent {
+    enum : uint8_t {
+        COMMAND,        // A command was intercepted, before catter decided about it
+        CAPTURE_ERROR,  // A command could not be captured
+        RESULT,         // A command exited
+        FINISH,         // The build exited, `id` is 0
+    } type;
+
+    data::ipcid_t id = 0;
+    data::ipcid_t parent = 0;
+    /// Microseconds since the Unix epoch, when catter saw the event.
+    int64_t time = 0;
+    /// For `COMMAND`, with the full environment and no `env_base`.
+    data::command cmd{};
+    /// For `CAPTURE_ERROR`.
+    std::string error{};
+    /// For `RESULT` and `FINISH`.
+    data::process_result result{};
+};
+
+class EventLogWriter {
+public:
+    /**
+     * Create the log at `path`, replacing an existing one.
+     *
+     * @throws cpptrace::runtime_error if the file can not be created.
+     */
+    EventLogWriter(const std::filesystem::path& path,
+                   const std::string& cwd,
+                   const std::vector<std::string>& build_command);
+
+    /// @param env the resolved environment of the command.
+    void command(data::ipcid_t id,
+                 data::ipcid_t parent,
+                 const data::command& cmd,
+                 const EnvStore::Ref& env);
+
+    void error(data::ipcid_t id, data::ipcid_t parent, const std::string& message);
+
+    void result(data::ipcid_t id, const data::process_result& result);
+
+    /// Also flushes the log.
+    void finish(const data::process_result& result);
+
+    /// The environments kept for the deltas of commands still to come.
+    std::size_t environments() const noexcept {
+        return envs.size();
+    }
+
+private:
+    template <typename T>
+    void append(const T& record);
+
+    std::ofstream file;
+    /// The environments of the logged commands, the base of the delta of their children.
+    std::unordered_map<data::ipcid_t, EnvStore::Ref> envs;
+    /// Decides when an environment is not needed anymore.
+    ProcessTable commands;
+};
+
+class EventLogReader {
+public:
+    /// @throws cpptrace::runtime_error if the file can not be read or is not an event log.
+    explicit EventLogReader(const std::filesystem::path& path);
+
+    /// The working directory of the recorded build.
+    const std::string& cwd() const noexcept {
+        return build_cwd;
+    }
+
+    const std::vector<std::string>& build_command() const noexcept {
+        return command;
+    }
+
+    /// @return the next event, nullopt at the end of the log or at a malformed event.
+    std::optional<LogEvent> next();
+
+    /// As `EventLogWriter::environments`.
+    std::size_t environments() const noexcept {
+        return envs.size();
+    }
+
+private:
+    std::ifstream file;
+    uintmax_t remaining = 0;
+    std::string build_cwd;
+    std::vector<std::string> command;
+    std::unordered_map<data::ipcid_t, EnvStore::Ref> envs;
+    ProcessTable commands;
+};
+
+}  // namespace catter::core
@@ -2,28 +2,67 @@
 
 #include <cassert>
 #include <cstddef>
+#include <exception>
 #include <format>
 #include <memory>
 #include <new>
 #include <optional>
 #include <print>
+#include <span>
+#include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
+#include <cpptrace/exceptions.hpp>
 #include <kota/support/functional.h>
 #include <kota/support/type_traits.h>
 #include <kota/meta/enum.h>
 #include <kota/ipc/codec/bincode.h>
 
+#include "config/catter-proxy.h"
+#include "config/ipc.h"
+#include "util/bincode.h"
+#include "util/crossplat.h"
 #include "util/data.h"
+#include "util/direct.h"
 #include "util/enum.h"
 #include "util/log.h"
 
 namespace catter::ipc {
 using namespace data;
 
-kota::task<void> accept(std::unique_ptr<InjectService> service, kota::pipe client) {
+namespace {
+
+/// The service handles FINISH after it was answered, `accept` waits for that before it returns.
+struct Finishing {
+    bool received = false;
+    kota::event done;
+    std::exception_ptr error;
+};
+
+kota::task<> finish(std::shared_ptr<InjectService> service,
+                    data::process_result result,
+                    std::shared_ptr<Finishing> finishing) {
+    try {
+        co_await service->finish(std::move(result));
+    } catch(...) {
+        finishing->error = std::current_exception();
+    }
+    finishing->done.set();
+}
+
+/// Notification handlers may run after `peer.run` returned, so they own the service too.
+kota::task<> started(std::shared_ptr<InjectService> service, int64_t pid) {
+    co_await service->started(pid);
+}
+
+}  // namespace
+
+kota::task<void> accept(std::unique_ptr<InjectService> owned, kota::pipe client) {
+    std::shared_ptr<InjectService> service = std::move(owned);
+    auto finishing = std::make_shared<Finishing>();
     kota::ipc::BincodePeer peer(kota::event_loop::current(),
                                 std::make_unique<kota::ipc::StreamTransport>(std::move(client)));
     using Context = kota::ipc::BincodePeer::RequestContext;
@@ -46,13 +85,29 @@ kota::task<void> accept(std::unique_ptr<InjectService> service, kota::pipe clien
             co_return co_await service->make_decision(params);
         });
 
+    peer.on_request<Request<RequestType::HELLO>>(
+        [&](const Context& ctx, const Request<RequestType::HELLO>::Params& params)
+            -> kota::ipc::RequestResult<Request<RequestType::HELLO>> {
+            if(params.mode != data::ServiceMode::INJECT) {
+                co_return std::optional<data::decision>{};
+            }
+            auto id = co_await service->create(params.parent_id);
+            co_return data::decision{id, co_await service->make_decision(params.cmd)};
+        });
+
     peer.on_request<Request<RequestType::FINISH>>(
         [&](const Context& ctx, const Request<RequestType::FINISH>::Params& params)
             -> kota::ipc::RequestResult<Request<RequestType::FINISH>> {
-            co_await service->finish(params);
+            // the proxy waits until catter has the result, not for `onExecution`
+            finishing->received = true;
+            kota::event_loop::current().schedule(finish(service, params, finishing));
             co_return nullptr;
         });
 
+    peer.on_notification<Notification<NotificationType::STARTED>>(
+        [service](const Notification<NotificationType::STARTED>::Params& params)
+            -> kota::task<> { return started(service, params); });
+
     peer.on_request<Request<RequestType::REPORT_ERROR>>(
         [&](const Context& ctx, const Request<RequestType::REPORT_ERROR>::Params& params)
             -> kota::ipc::RequestResult<Request<RequestType::REPORT_ERROR>> {
@@ -62,6 +117,158 @@ kota::task<void> accept(std::unique_ptr<InjectService> service, kota::pipe clien
 
     co_await peer.run();
     LOG_INFO("IPC peer disconnected");
+    if(finishing->received) {
+        co_await finishing->done.wait();
+        if(finishing->error) {
+            std::rethrow_exception(finishing->error);
+        }
+    }
+    co_return;
+}
+
+namespace {
+
+direct::reply reply_with_command(direct::reply::Type type, ipcid_t id, data::command cmd) {
+    return direct::reply{
+        .type = type,
+        .id = id,
+        .executable = std::move(cmd.executable),
+        .args = std::move(cmd.args),
+        // a delta is always against the environment the payload sent
+        .env_delta = cmd.env_base.has_value(),
+        .env = std::move(cmd.env),
+        .env_unset = std::move(cmd.env_unset),
+    };
+}
+
+/**
+ * Hand the decided command to catter-proxy, for what the payload can not do in place. It runs the
+ * command as `mode` says, without asking catter again.
+ */
+direct::reply reply_with_proxy(ipcid_t id, std::vector<std::string> mode, data::command cmd) {
+    auto proxy_path = (util::get_catter_root_path() / config::proxy::EXE_NAME).string();
+    std::vector<std::string> args = {proxy_path,
+                                     "-p",
+                                     std::to_string(id),
+                                     "--ipc",
+                                     std::string(config::ipc::pipe_name())};
+#ifndef CATTER_WINDOWS
+    args.insert(args.end(), {"--direct", std::string(config::ipc::direct_pipe_name())});
+#endif
+    util::append_range_to_vector(args, mode);
+    if(!cmd.executable.empty()) {
+        args.insert(args.end(), {"--exec", cmd.executable});
+    }
+    args.emplace_back("--");
+    util::append_range_to_vector(args, cmd.args);
+    cmd.executable = std::move(proxy_path);
+    cmd.args = std::move(args);
+    return reply_with_command(direct::reply::WRAP, id, std::move(cmd));
+}
+
+direct::reply to_direct_reply(ipcid_t id, data::action act, const data::command& original) {
+    bool runs = act.type != data::action::DROP && act.type != data::action::ABORT &&
+                act.type != data::action::RESEND;
+    // the caller can not move to another directory safely, see `direct::reply`
+    if(runs && act.cmd.cwd != original.cwd) {
+        std::vector<std::string> mode = {"--fake"};
+        if(act.type != data::action::FAKE) {
+            bool hooked = act.type == data::action::INJECT && !act.ignore_descendants;
+            mode = {"--decided", hooked ? "inject" : "wrap"};
+        }
+        mode.insert(mode.end(), {"--cwd", act.cmd.cwd});
+        return reply_with_proxy(id, std::move(mode), std::move(act.cmd));
+    }
+
+    switch(act.type) {
+        case data::action::DROP: {
+            // the caller gets a real process which exits successfully, like from the proxy
+            return reply_with_proxy(id, {"--decided", "drop"}, data::command{});
+        }
+        case data::action::ABORT: {
+            // the caller gets a process which fails, like from the proxy
+            return reply_with_proxy(id, {"--decided", "abort"}, data::command{});
+        }
+        case data::action::INJECT: {
+            if(act.ignore_descendants) {
+                return reply_with_command(direct::reply::WRAP, id, std::move(act.cmd));
+            }
+            if(act.cmd.executable == original.executable && act.cmd.args == original.args &&
+               act.cmd.env_base == id && act.cmd.env.empty() && act.cmd.env_unset.empty()) {
+                // the payload still has the command, do not send it back
+                return direct::reply{.type = direct::reply::EXEC_ORIGINAL, .id = id};
+            }
+            return reply_with_command(direct::reply::EXEC, id, std::move(act.cmd));
+        }
+        case data::action::WRAP: {
+            return reply_with_command(direct::reply::WRAP, id, std::move(act.cmd));
+        }
+        case data::action::RESEND: {
+            // catter-proxy asks again with the full environment
+            return direct::reply{.type = direct::reply::FALLBACK, .id = id};
+        }
+        case data::action::FAKE: {
+            // the proxy writes the placeholders on its own, and runs the command with the hook if
+            // it can not be faked
+            return reply_with_proxy(id, {"--fake"}, std::move(act.cmd));
+        }
+    }
+    throw cpptrace::runtime_error("Unhandled action type");
+}
+
+}  // namespace
+
+kota::task<void> accept_direct(std::unique_ptr<InjectService> service, kota::pipe client) {
+    std::string buffer;
+    std::optional<size_t> frame_size;
+    while(!(frame_size = bincode::frame_size(buffer))) {
+        auto chunk = co_await client.read_chunk();
+        if(!chunk) {
+            if(chunk.error() == kota::error::end_of_file ||
+               chunk.error() == kota::error::broken_pipe) {
+                LOG_WARN("Direct client disconnected before sending a request");
+                co_return;
+            }
+            throw cpptrace::runtime_error(
+                std::format("Direct client read failed: {}", chunk.error().message()));
+        }
+        buffer.append(chunk->data(), chunk->size());
+        client.consume(chunk->size());
+    }
+
+    auto body = std::string_view(buffer).substr(bincode::frame_header_size,
+                                                *frame_size - bincode::frame_header_size);
+    auto request = direct::decode_request(body);
+    if(!request.has_value()) {
+        throw cpptrace::runtime_error("Malformed direct request");
+    }
+
+    data::command cmd{
+        .cwd = std::move(request->cwd),
+        .executable = std::move(request->executable),
+        .args = std::move(request->args),
+        .env = std::move(request->env),
+        .env_unset = std::move(request->env_unset),
+        .origin = {.pid = request->pid, .ppid = request->ppid, .tid = request->tid},
+    };
+    if(request->env_delta) {
+        cmd.env_base = request->parent_id;
+    }
+
+    auto id = co_await service->create(request->parent_id);
+    auto act = co_await service->make_decision(cmd);
+    co_await service->detach();
+    auto frame = direct::encode(to_direct_reply(id, std::move(act), cmd));
+    if(!frame.has_value()) {
+        throw cpptrace::runtime_error(std::format("Failed to encode the direct reply of {}", id));
+    }
+
+    if(auto err = co_await client.write(std::span<const char>(frame->data(), frame->size()));
+       err.has_error()) {
+        throw cpptrace::runtime_error(
+            std::format("Direct client write failed: {}", err.message()));
+    }
+    LOG_INFO("Direct request of {} answered", id);
     co_return;
 }
 
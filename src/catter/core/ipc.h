@@ -27,10 +27,22 @@ public:
 
     virtual kota::task<ipcid_t> create(ipcid_t parent_id) = 0;
     virtual kota::task<data::action> make_decision(data::command cmd) = 0;
+    /// The proxy launched the decided command as process `pid`.
+    virtual kota::task<> started(int64_t pid) = 0;
     virtual kota::task<> finish(data::process_result result) = 0;
+    /// No `finish` follows, the command runs on without catter, see `accept_direct`.
+    virtual kota::task<> detach() = 0;
     virtual kota::task<> report_error(ipcid_t parent_id, std::string error_msg) = 0;
 };
 
 kota::task<void> accept(std::unique_ptr<InjectService> service, kota::pipe client);
 
+/**
+ * Serve one request of the direct path, sent by the hook payload itself.
+ *
+ * The command is created and decided as usual, but `detach` follows instead of `finish`: the
+ * payload runs the command in place, so its exit is never observed by catter.
+ */
+kota::task<void> accept_direct(std::unique_ptr<InjectService> service, kota::pipe client);
+
 }  // namespace catter::ipc
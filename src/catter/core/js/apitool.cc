@@ -1,5 +1,8 @@
 #include "apitool.h"
 
+#include <deque>
+#include <mutex>
+
 #include "js.h"
 
 namespace catter::apitool {
@@ -9,6 +12,47 @@ std::vector<api_register>& api_registers() {
     static std::vector<api_register> registers{};
     return registers;
 }
+
+namespace {
+
+struct CallStatsRegistry {
+    std::mutex mutex;
+    // a deque keeps the counters in place as CAPIs are registered
+    std::deque<CallStats> stats;
+};
+
+CallStatsRegistry& call_stats_registry() {
+    static CallStatsRegistry registry;
+    return registry;
+}
+
+}  // namespace
+
+CallStats& register_call_stats(std::string_view name) {
+    // the scope of the function is noise for a script
+    if(auto pos = name.rfind("::"); pos != std::string_view::npos) {
+        name.remove_prefix(pos + 2);
+    }
+    auto& registry = call_stats_registry();
+    std::lock_guard lock(registry.mutex);
+    return registry.stats.emplace_back(std::string(name));
+}
+
+std::vector<CallStatsSnapshot> call_stats() {
+    auto& registry = call_stats_registry();
+    std::lock_guard lock(registry.mutex);
+    std::vector<CallStatsSnapshot> snapshots;
+    for(auto& stats: registry.stats) {
+        if(auto calls = stats.calls.load(std::memory_order_relaxed); calls != 0) {
+            snapshots.push_back({
+                .name = stats.name,
+                .calls = calls,
+                .time = std::chrono::nanoseconds(stats.nanoseconds.load(std::memory_order_relaxed)),
+            });
+        }
+    }
+    return snapshots;
+}
 }  // namespace catter::apitool
 
 namespace catter::capi::util {
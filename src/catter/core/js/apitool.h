@@ -1,7 +1,11 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <format>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -57,6 +61,58 @@ constexpr std::string_view capi_name() {
     return std::string_view{name.data(), name.size()};
 }
 
+/// Calls of one CAPI, counted whether they are logged or not.
+struct CallStats {
+    std::string name;
+    std::atomic<uint64_t> calls = 0;
+    std::atomic<int64_t> nanoseconds = 0;
+};
+
+/// Register the counters of the CAPI `name`, they live as long as the process.
+CallStats& register_call_stats(std::string_view name);
+
+struct CallStatsSnapshot {
+    std::string name;
+    uint64_t calls;
+    std::chrono::nanoseconds time;
+};
+
+/// The counters of the CAPIs called so far.
+std::vector<CallStatsSnapshot> call_stats();
+
+template <auto V>
+CallStats& call_stats_of() {
+    static CallStats& stats = register_call_stats(capi_name<V>());
+    return stats;
+}
+
+/// Adds the time of a call, also when it throws.
+class CallTimer {
+public:
+    explicit CallTimer(CallStats& stats) noexcept :
+        stats(stats), start(std::chrono::steady_clock::now()) {}
+
+    CallTimer(const CallTimer&) = delete;
+    CallTimer& operator= (const CallTimer&) = delete;
+
+    ~CallTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        stats.calls.fetch_add(1, std::memory_order_relaxed);
+        stats.nanoseconds.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+            std::memory_order_relaxed);
+    }
+
+private:
+    CallStats& stats;
+    std::chrono::steady_clock::time_point start;
+};
+
+/// Whether CAPI calls are logged. Their arguments are only serialized when they are.
+inline bool tracing() noexcept {
+    return SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO && spdlog::should_log(spdlog::level::info);
+}
+
 template <auto V, typename Sign = std::remove_pointer_t<decltype(V)>>
 struct hooked {
     static_assert(kota::dependent_false<Sign>, "Unsupported function signature for hooking");
@@ -91,6 +147,10 @@ static R invoke_with_log(const std::string& args_s, CallArgs&&... call_args) {
 template <auto V, typename R, typename... Args>
 struct hooked<V, R(Args...)> {
     static R call(Args... args) {
+        CallTimer timer(call_stats_of<V>());
+        if(!tracing()) {
+            return V(std::forward<Args>(args)...);
+        }
         return invoke_with_log<V, R>(serialize_args(args...), std::forward<Args>(args)...);
     }
 };
@@ -98,6 +158,10 @@ struct hooked<V, R(Args...)> {
 template <auto V, typename R, typename... Args>
 struct hooked<V, R(JSContext*, Args...)> {
     static R call(JSContext* ctx, Args... args) {
+        CallTimer timer(call_stats_of<V>());
+        if(!tracing()) {
+            return V(ctx, std::forward<Args>(args)...);
+        }
         return invoke_with_log<V, R>(serialize_args(args...), ctx, std::forward<Args>(args)...);
     }
 };
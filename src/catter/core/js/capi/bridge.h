@@ -7,7 +7,7 @@
  * This module centralizes the policy used by the C API data model to cross the C++/JavaScript
  * boundary. `Bridge<T>` provides the conversion entry points and delegates ordinary values to the
  * qjs wrappers. Specialized bridges add support for reflected structs, string-backed enums,
- * vectors, and tagged unions.
+ * vectors (of values, enums or reflected structs), and tagged unions.
  *
  * Reflected structs are converted field by field. Optional fields accept `undefined` when reading
  * and are omitted when empty during writing. A reflected type may define a nested `name_mapper`
@@ -19,6 +19,7 @@
  * use `make_reflected_object` and `to_reflected_object` for object conversion.
  */
 
+#include <cstddef>
 #include <cstdint>
 #include <format>
 #include <optional>
@@ -255,6 +256,29 @@ struct Bridge<std::vector<T>> {
     }
 };
 
+template <typename T>
+    requires kota::meta::reflectable_class<T>
+struct Bridge<std::vector<T>> {
+    static std::vector<T> from_js(const qjs::Value& value) {
+        auto array = value.as<qjs::Object>();
+        auto length = array["length"].as<uint32_t>();
+        std::vector<T> values;
+        values.reserve(length);
+        for(uint32_t i = 0; i < length; ++i) {
+            values.push_back(Bridge<T>::from_js(array[std::to_string(i)]));
+        }
+        return values;
+    }
+
+    static auto to_js(JSContext* ctx, const std::vector<T>& vec) {
+        auto array = qjs::Object{ctx, JS_NewArray(ctx)};
+        for(std::size_t i = 0; i < vec.size(); ++i) {
+            array.set_property(std::to_string(i), to_reflected_object(ctx, vec[i]));
+        }
+        return array;
+    }
+};
+
 template <typename T>
 struct Bridge<std::vector<T>> {
     static std::vector<T> from_js(const qjs::Value& value) {
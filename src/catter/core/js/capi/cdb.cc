@@ -0,0 +1,231 @@
+#include <cctype>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../apitool.h"
+#include "../qjs.h"
+#include "cdb_store.h"
+
+namespace fs = std::filesystem;
+using namespace catter::capi::util;
+
+// compile_commands.json writer
+// entries are written one by one into a temporary file next to the target, which replaces the
+// target once the array is closed, so readers never see a half written database
+namespace {
+
+struct CDBWriter {
+    fs::path target;
+    fs::path temp;
+    std::ofstream out;
+    uint64_t entries = 0;
+};
+
+// every thread running a script has its own table, see js::WorkerPool
+thread_local int64_t cdb_writer_id_cnt = 1;
+thread_local std::unordered_map<int64_t, CDBWriter> open_cdb_writers;
+
+CDBWriter& writer_of(int64_t writer_id) {
+    auto it = open_cdb_writers.find(writer_id);
+    if(it == open_cdb_writers.end()) {
+        throw catter::qjs::Exception("Invalid CDB writer id: " + std::to_string(writer_id));
+    }
+    return it->second;
+}
+
+/// Remove the writer from the table, it is closed when the returned handle goes away.
+auto take_writer(int64_t writer_id) {
+    auto node = open_cdb_writers.extract(writer_id);
+    if(node.empty()) {
+        throw catter::qjs::Exception("Invalid CDB writer id: " + std::to_string(writer_id));
+    }
+    return node;
+}
+
+/// Write `entry` as an element of the top level array, indented like `JSON.stringify(items,
+/// null, 2)` would. JSON text has no raw newline inside strings, so splitting lines is safe.
+void write_entry(std::ofstream& out, std::string_view entry) {
+    while(!entry.empty()) {
+        auto end = entry.find('\n');
+        auto line = entry.substr(0, end);
+        out << "  " << line;
+        if(end == std::string_view::npos) {
+            break;
+        }
+        out << '\n';
+        entry.remove_prefix(end + 1);
+    }
+}
+
+CAPI(cdb_writer_open, (std::string path)->int64_t) {
+    CDBWriter writer;
+    writer.target = absolute_of(path);
+    writer.temp = writer.target;
+    writer.temp += ".tmp";
+
+    std::error_code ec;
+    if(writer.target.has_parent_path()) {
+        fs::create_directories(writer.target.parent_path(), ec);
+        if(ec) {
+            throw catter::qjs::Exception("Failed to create directory for CDB: " + path +
+                                         ", error: " + ec.message());
+        }
+    }
+    writer.out.open(writer.temp, std::ios::out | std::ios::trunc | std::ios::binary);
+    if(!writer.out.is_open()) {
+        throw catter::qjs::Exception("Failed to open CDB for writing: " + writer.temp.string());
+    }
+    writer.out << '[';
+
+    auto id = cdb_writer_id_cnt++;
+    open_cdb_writers.emplace(id, std::move(writer));
+    return id;
+}
+
+void append_entry(CDBWriter& writer, std::string_view entry) {
+    writer.out << (writer.entries == 0 ? "\n" : ",\n");
+    write_entry(writer.out, entry);
+    if(!writer.out) {
+        throw catter::qjs::Exception("Failed to write CDB: " + writer.temp.string());
+    }
+    ++writer.entries;
+}
+
+
+/// Append one entry, given as its JSON text.
+CAPI(cdb_writer_append, (int64_t writer_id, std::string entry)->void) {
+    append_entry(writer_of(writer_id), entry);
+}
+
+/// Close the array and move the file in place of the target.
+CAPI(cdb_writer_close, (int64_t writer_id)->void) {
+    auto node = take_writer(writer_id);
+    auto& writer = node.mapped();
+    writer.out << (writer.entries == 0 ? "]" : "\n]");
+    writer.out.close();
+    if(!writer.out) {
+        std::error_code ignored;
+        fs::remove(writer.temp, ignored);
+        throw catter::qjs::Exception("Failed to write CDB: " + writer.temp.string());
+    }
+
+    std::error_code ec;
+    fs::rename(writer.temp, writer.target, ec);
+    if(ec) {
+        std::error_code ignored;
+        fs::remove(writer.temp, ignored);
+        throw catter::qjs::Exception("Failed to replace CDB: " + writer.target.string() +
+                                     ", error: " + ec.message());
+    }
+}
+
+/// Drop the temporary file and leave the target untouched.
+CAPI(cdb_writer_abort, (int64_t writer_id)->void) {
+    auto node = take_writer(writer_id);
+    node.mapped().out.close();
+    std::error_code ignored;
+    fs::remove(node.mapped().temp, ignored);
+}
+
+}  // namespace
+
+// entries inherited from an existing compile_commands.json
+// they stay on this side and are only turned into JS objects when a script asks for them, see
+// core::CDBStore
+namespace {
+
+thread_local int64_t cdb_store_id_cnt = 1;
+thread_local std::unordered_map<int64_t, catter::core::CDBStore> open_cdb_stores;
+
+catter::core::CDBStore& store_of(int64_t store_id) {
+    auto it = open_cdb_stores.find(store_id);
+    if(it == open_cdb_stores.end()) {
+        throw catter::qjs::Exception("Invalid CDB store id: " + std::to_string(store_id));
+    }
+    return it->second;
+}
+
+/// Same as `path.isAbsolute` on the JS side.
+bool is_absolute_like(std::string_view path) {
+    return path.starts_with('/') || path.starts_with("\\\\") ||
+           (path.size() >= 3 && std::isalpha(static_cast<unsigned char>(path[0])) &&
+            path[1] == ':' && (path[2] == '/' || path[2] == '\\'));
+}
+
+/// Same as `fileKey` in cdb-manager.ts, entries of both sides have to agree on it.
+std::string file_key(std::string_view directory, std::string_view file) {
+    auto path =
+        is_absolute_like(file) ? fs::path(file) : absolute_of(std::string(directory)) / file;
+    return path.lexically_normal().string();
+}
+
+std::unordered_set<std::string> excluded_files(catter::qjs::Object files) {
+    auto list = files.as<catter::qjs::Array<std::string>>().as<std::vector<std::string>>();
+    return {std::make_move_iterator(list.begin()), std::make_move_iterator(list.end())};
+}
+
+CAPI(cdb_store_load, (std::string path)->int64_t) {
+    try {
+        auto store = catter::core::CDBStore::load(absolute_of(path), file_key);
+        auto id = cdb_store_id_cnt++;
+        open_cdb_stores.emplace(id, std::move(store));
+        return id;
+    } catch(const catter::qjs::Exception&) {
+        throw;
+    } catch(const std::exception& e) {
+        throw catter::qjs::Exception(e.what());
+    }
+}
+
+/// Count the entries whose source file is not in `excluded`.
+CAPI(cdb_store_size, (int64_t store_id, catter::qjs::Object excluded)->int64_t) {
+    int64_t size = 0;
+    store_of(store_id).for_each(excluded_files(std::move(excluded)),
+                                [&size](std::string_view) { ++size; });
+    return size;
+}
+
+/// The entries whose source file is not in `excluded`, as the JSON text of an array.
+CAPI(cdb_store_items, (int64_t store_id, catter::qjs::Object excluded)->std::string) {
+    std::string items = "[";
+    store_of(store_id).for_each(excluded_files(std::move(excluded)),
+                                [&items](std::string_view entry) {
+                                    if(items.size() > 1) {
+                                        items.push_back(',');
+                                    }
+                                    items.append(entry);
+                                });
+    items.push_back(']');
+    return items;
+}
+
+/// Append the entries whose source file is not in `excluded` to a writer.
+/// @return the number of entries written.
+CAPI(cdb_store_write,
+     (int64_t store_id, int64_t writer_id, catter::qjs::Object excluded)->int64_t) {
+    auto& store = store_of(store_id);
+    auto& writer = writer_of(writer_id);
+    int64_t written = 0;
+    store.for_each(excluded_files(std::move(excluded)), [&](std::string_view entry) {
+        append_entry(writer, catter::core::CDBStore::pretty(entry));
+        ++written;
+    });
+    return written;
+}
+
+CAPI(cdb_store_close, (int64_t store_id)->void) {
+    if(open_cdb_stores.erase(store_id) == 0) {
+        throw catter::qjs::Exception("Invalid CDB store id: " + std::to_string(store_id));
+    }
+}
+
+}  // namespace
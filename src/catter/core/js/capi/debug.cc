@@ -0,0 +1,25 @@
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "type.h"
+#include "../apitool.h"
+
+namespace qjs = catter::qjs;
+
+namespace {
+
+CTX_CAPI(debug_capi_stats, (JSContext * ctx)->qjs::Object) {
+    std::vector<catter::js::CapiStats> stats;
+    for(auto& snapshot: catter::apitool::call_stats()) {
+        stats.push_back({
+            .name = std::move(snapshot.name),
+            .calls = static_cast<int64_t>(snapshot.calls),
+            .totalUs = std::chrono::duration_cast<std::chrono::microseconds>(snapshot.time).count(),
+        });
+    }
+    return catter::js::Bridge<std::vector<catter::js::CapiStats>>::to_js(ctx, stats);
+}
+
+}  // namespace
@@ -23,11 +23,12 @@ struct HttpResponse {
     qjs::Object headers;
 };
 
-int64_t http_client_id_cnt = 1;
-std::unordered_map<int64_t, kota::http::client> http_clients;
+// clients belong to the loop of the thread running the script, see js::WorkerPool
+thread_local int64_t http_client_id_cnt = 1;
+thread_local std::unordered_map<int64_t, kota::http::client> http_clients;
 
 kota::http::client& default_http_client() {
-    static kota::http::client client;
+    thread_local kota::http::client client;
     return client;
 }
 
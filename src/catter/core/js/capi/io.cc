@@ -33,10 +33,10 @@ CAPI(stdout_print_blue, (const std::string content)->void) {
 }  // namespace
 
 // file read / write
-// notice that we have ensure that is in single thread
+// every thread running a script has its own table, see js::WorkerPool
 namespace {
-static int64_t file_id_cnt = 1;
-static std::unordered_map<int64_t, std::fstream> open_files;
+thread_local int64_t file_id_cnt = 1;
+thread_local std::unordered_map<int64_t, std::fstream> open_files;
 
 CAPI(file_open, (std::string path)->int64_t) {
     std::fstream fs;
@@ -1,6 +1,19 @@
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "type.h"
+#include "util/kotatsu.h"
 #include "../apitool.h"
 
+namespace qjs = catter::qjs;
+
 namespace {
+
+template <typename T>
+using JsTask = kota::task<T, qjs::Error>;
+
 CAPI(os_name, ()->std::string) {
 #ifdef __linux__
     return "linux";
@@ -27,4 +40,60 @@ CAPI(os_arch, ()->std::string) {
 #endif
 }
 
+std::vector<std::string> to_strings(qjs::Object array) {
+    std::vector<std::string> strings;
+    auto len = array["length"].as<uint32_t>();
+    strings.reserve(len);
+    for(uint32_t i = 0; i < len; ++i) {
+        strings.push_back(array[std::to_string(i)].as<std::string>());
+    }
+    return strings;
+}
+
+// without an environment the process gets the one of catter, not the one of the build, so it is
+// not captured
+CTX_ASYNC_CAPI(os_run,
+               (JSContext * ctx,
+                std::string file,
+                qjs::Object js_args,
+                std::string cwd,
+                qjs::Object js_env)
+                   ->JsTask<qjs::Object>) {
+    kota::process::options opts{
+        .file = file,
+        .args = to_strings(std::move(js_args)),
+        .cwd = cwd,
+        .creation = {.windows_hide = true, .windows_verbatim_arguments = true},
+        .streams = {kota::process::stdio::inherit(),
+                     kota::process::stdio::pipe(false, true),
+                     kota::process::stdio::pipe(false, true)}
+    };
+    if(auto env = to_strings(std::move(js_env)); !env.empty()) {
+        opts.env = std::move(env);
+    }
+
+    catter::data::process_result result;
+    std::string failure;
+    try {
+        result = co_await catter::capture_process_result(catter::make_process_event(opts),
+                                                         catter::data::CaptureMode::TAIL,
+                                                         nullptr,
+                                                         nullptr);
+    } catch(const std::exception& e) {
+        failure = e.what();
+    }
+    if(!failure.empty()) {
+        co_await kota::fail(
+            qjs::Error::internal_error(ctx, "Failed to run `{}`: {}", file, failure));
+    }
+
+    // the usage of the children of catter is not the one of this process, leave the stats out
+    co_return catter::js::ProcessResult{
+        .code = result.code,
+        .stdOut = std::move(result.std_out),
+        .stdErr = std::move(result.std_err),
+    }
+        .to_object(ctx);
+}
+
 }  // namespace
@@ -22,4 +22,12 @@ CAPI(service_on_execution, (qjs::Object cb)->void) {
     catter::js::set_on_execution(std::move(cb));
 }
 
+CAPI(service_on_collect, (qjs::Object cb)->void) {
+    catter::js::set_on_collect(std::move(cb));
+}
+
+CAPI(service_on_merge, (qjs::Object cb)->void) {
+    catter::js::set_on_merge(std::move(cb));
+}
+
 }  // namespace
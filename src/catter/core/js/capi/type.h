@@ -3,7 +3,36 @@
 
 namespace catter::js {
 
-enum class ActionType { skip, drop, abort, modify };
+enum class ActionType { skip, drop, abort, modify, fake };
+
+/// How much of the output of a command is kept for `onExecution`, see `data::CaptureMode`.
+enum class CaptureMode { inherit, tail, full };
+
+/**
+ * A decision catter makes natively, without calling `onCommand`. All conditions which are set have
+ * to hold, see `core::RuleTable`.
+ */
+struct CommandRule {
+    static CommandRule make(qjs::Object object) {
+        return make_reflected_object<CommandRule>(std::move(object));
+    }
+
+    qjs::Object to_object(JSContext* ctx) const {
+        return to_reflected_object(ctx, *this);
+    }
+
+    bool operator== (const CommandRule&) const = default;
+
+public:
+    /// Glob on the file name of the executable, or on its path if it contains a separator.
+    std::optional<std::string> exe;
+    /// ECMAScript regular expression searched in the executable path.
+    std::optional<std::string> exePattern;
+    /// Globs on the leading arguments, after `argv[0]`.
+    std::optional<std::vector<std::string>> args;
+    /// Only `skip` and `drop`.
+    ActionType action;
+};
 
 struct CatterOptions {
     enum class StdioMode { inherit, capture };
@@ -21,6 +50,21 @@ struct CatterOptions {
 public:
     bool log;
     std::optional<StdioMode> stdioMode;
+    std::optional<bool> directHook;
+    std::optional<uint32_t> decisionWorkers;
+    std::optional<std::vector<CommandRule>> rules;
+    /// Used for commands whose action does not set it, `tail` if unset.
+    std::optional<CaptureMode> capture;
+    /// Answer the commands `onCommand` asked to cache from disk, see `core::DecisionCache`.
+    std::optional<bool> decisionCache;
+    /// Names of the environment variables which are part of the cache key.
+    std::optional<std::vector<std::string>> decisionCacheEnv;
+    /// Write every command and its result to this file, see `core::EventLogWriter`.
+    std::optional<std::string> record;
+    /// Connections the socket of catter queues, `config::ipc::BACKLOG` if unset.
+    std::optional<uint32_t> ipcBacklog;
+    /// Skip every command at once and hand it to `onCommand` meanwhile.
+    std::optional<bool> observeOnly;
 };
 
 struct CatterRuntime {
@@ -63,6 +107,24 @@ public:
     bool execute;
 };
 
+/// See `data::process_origin`.
+struct ProcessOrigin {
+    static ProcessOrigin make(qjs::Object object) {
+        return make_reflected_object<ProcessOrigin>(std::move(object));
+    }
+
+    qjs::Object to_object(JSContext* ctx) const {
+        return to_reflected_object(ctx, *this);
+    }
+
+    bool operator== (const ProcessOrigin&) const = default;
+
+public:
+    int64_t pid;
+    int64_t ppid;
+    int64_t tid;
+};
+
 struct CommandData {
     static CommandData make(qjs::Object object) {
         return make_reflected_object<CommandData>(std::move(object));
@@ -81,6 +143,30 @@ public:
     std::vector<std::string> env;
     CatterRuntime runtime;
     std::optional<int64_t> parent;
+    /// Set when the hook reported the process which asked to run the command.
+    std::optional<ProcessOrigin> origin;
+};
+
+/// See `data::process_stats`.
+struct ProcessStats {
+    static ProcessStats make(qjs::Object object) {
+        return make_reflected_object<ProcessStats>(std::move(object));
+    }
+
+    qjs::Object to_object(JSContext* ctx) const {
+        return to_reflected_object(ctx, *this);
+    }
+
+    bool operator== (const ProcessStats&) const = default;
+
+public:
+    int64_t pid;
+    int64_t spawn;
+    int64_t exec;
+    int64_t exit;
+    int64_t userTime;
+    int64_t systemTime;
+    int64_t maxRss;
 };
 
 struct ProcessResult {
@@ -110,6 +196,26 @@ public:
     int64_t code;
     std::string stdOut;
     std::string stdErr;
+    std::optional<ProcessStats> stats;
+};
+
+/// See `apitool::CallStats`.
+struct CapiStats {
+    static CapiStats make(qjs::Object object) {
+        return make_reflected_object<CapiStats>(std::move(object));
+    }
+
+    qjs::Object to_object(JSContext* ctx) const {
+        return to_reflected_object(ctx, *this);
+    }
+
+    bool operator== (const CapiStats&) const = default;
+
+public:
+    std::string name;
+    int64_t calls;
+    /// Time spent in the calls, in microseconds.
+    int64_t totalUs;
 };
 
 struct CatterErr {
@@ -172,11 +278,53 @@ public:
     std::string meta_var;
 };
 
-using Action =
-    TaggedUnion<ActionType::skip, ActionType::drop, ActionType::abort, ActionType::modify>;
+/// What `ctx.cache` asked to remember of a decision, for the next runs.
+struct CachedDecision {
+    static CachedDecision make(qjs::Object object) {
+        return make_reflected_object<CachedDecision>(std::move(object));
+    }
+
+    qjs::Object to_object(JSContext* ctx) const {
+        return to_reflected_object(ctx, *this);
+    }
+
+    bool operator== (const CachedDecision&) const = default;
+
+public:
+    /// JSON of the state handed to `onMerge` when the decision is reused.
+    std::string state;
+    bool ignoreDescendants;
+};
+
+using Action = TaggedUnion<ActionType::skip,
+                           ActionType::drop,
+                           ActionType::abort,
+                           ActionType::modify,
+                           ActionType::fake>;
+
+TAG<ActionType::skip> {
+    std::optional<CaptureMode> capture;
+    std::optional<CachedDecision> cache;
+    /// Run the command without the hook, catter does not hear of its descendants.
+    std::optional<bool> ignoreDescendants;
+    bool operator== (const Tag& other) const = default;
+};
+
+TAG<ActionType::drop> {
+    std::optional<CachedDecision> cache;
+    bool operator== (const Tag& other) const = default;
+};
 
 TAG<ActionType::modify> {
     CommandData data;
+    std::optional<CaptureMode> capture;
+    std::optional<bool> ignoreDescendants;
+    bool operator== (const Tag& other) const = default;
+};
+
+TAG<ActionType::fake> {
+    std::optional<CachedDecision> cache;
+    std::optional<bool> ignoreDescendants;
     bool operator== (const Tag& other) const = default;
 };
 
@@ -0,0 +1,199 @@
+#include "command_object.h"
+
+#include <array>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+#include <quickjs.h>
+
+namespace catter::js {
+
+namespace {
+
+struct CommandObject {
+    CommandData data;
+    EnvLoader env_loader;
+};
+
+using Register = qjs::Object::Register<CommandObject>;
+
+enum LazyField : int { argv_field, env_field, runtime_field };
+
+constexpr std::array<const char*, 3> lazy_fields{"argv", "env", "runtime"};
+
+CommandObject* opaque_of(JSContext* ctx, JSValueConst object) noexcept {
+    return static_cast<CommandObject*>(JS_GetOpaque(object, Register::get(JS_GetRuntime(ctx))));
+}
+
+/// Convert a field, dropping the C++ copy which is not needed any more.
+qjs::Object materialize(JSContext* ctx, CommandObject& command, LazyField field) {
+    switch(field) {
+        case argv_field: {
+            auto argv = qjs::Array<std::string>::from(ctx, command.data.argv);
+            std::vector<std::string>{}.swap(command.data.argv);
+            return qjs::Object{ctx, argv.release()};
+        }
+        case env_field: {
+            auto env = qjs::Array<std::string>::from(
+                ctx,
+                command.env_loader ? command.env_loader() : command.data.env);
+            std::vector<std::string>{}.swap(command.data.env);
+            command.env_loader = {};
+            return qjs::Object{ctx, env.release()};
+        }
+        case runtime_field: {
+            return command.data.runtime.to_object(ctx);
+        }
+    }
+    std::unreachable();
+}
+
+/// Replace the accessor of `field` on `this_val` by a data property holding `value`.
+bool settle(JSContext* ctx, JSValueConst this_val, int field, JSValueConst value) noexcept {
+    return JS_DefinePropertyValueStr(ctx,
+                                     this_val,
+                                     lazy_fields[field],
+                                     JS_DupValue(ctx, value),
+                                     JS_PROP_C_W_E) >= 0;
+}
+
+JSValue lazy_field_get(JSContext* ctx,
+                       JSValueConst this_val,
+                       [[maybe_unused]] int argc,
+                       [[maybe_unused]] JSValueConst* argv,
+                       int field) noexcept {
+    auto* command = opaque_of(ctx, this_val);
+    if(!command) {
+        return JS_ThrowTypeError(ctx,
+                                 "%s read from an object which is not a CommandData",
+                                 lazy_fields[field]);
+    }
+
+    JSValue value;
+    try {
+        value = materialize(ctx, *command, static_cast<LazyField>(field)).release();
+    } catch(const qjs::Exception& e) {
+        return JS_ThrowInternalError(ctx, "Exception in C++ function: %s", e.what());
+    } catch(const std::exception& e) {
+        return JS_ThrowInternalError(ctx, "Unexpected exception: %s", e.what());
+    }
+    if(!settle(ctx, this_val, field, value)) {
+        JS_FreeValue(ctx, value);
+        return JS_EXCEPTION;
+    }
+    return value;
+}
+
+JSValue lazy_field_set(JSContext* ctx,
+                       JSValueConst this_val,
+                       int argc,
+                       JSValueConst* argv,
+                       int field) noexcept {
+    if(!settle(ctx, this_val, field, argc > 0 ? argv[0] : JS_UNDEFINED)) {
+        return JS_EXCEPTION;
+    }
+    return JS_UNDEFINED;
+}
+
+JSClassID class_id(JSContext* ctx) noexcept {
+    auto rt = JS_GetRuntime(ctx);
+    if(auto it = Register::find(rt); it != Register::end()) {
+        return it->second.id;
+    }
+    JSClassDef def{"CommandData",
+                   [](JSRuntime* rt, JSValue obj) {
+                       delete static_cast<CommandObject*>(JS_GetOpaque(obj, Register::get(rt)));
+                   },
+                   nullptr,
+                   nullptr,
+                   nullptr};
+    return Register::create(rt, &def);
+}
+
+/// The class prototype of `ctx`, which holds the accessors every instance copies.
+qjs::Object prototype_of(JSContext* ctx, JSClassID id) {
+    auto proto = qjs::Object{ctx, JS_GetClassProto(ctx, id)};
+    if(JS_IsObject(proto.value())) {
+        return proto;
+    }
+
+    proto = qjs::Object::empty_one(ctx);
+    for(int field = 0; field < static_cast<int>(lazy_fields.size()); ++field) {
+        auto getter = qjs::Value{
+            ctx,
+            JS_NewCFunctionMagic(ctx,
+                                 lazy_field_get,
+                                 lazy_fields[field],
+                                 0,
+                                 JS_CFUNC_generic_magic,
+                                 field)};
+        auto setter = qjs::Value{
+            ctx,
+            JS_NewCFunctionMagic(ctx,
+                                 lazy_field_set,
+                                 lazy_fields[field],
+                                 1,
+                                 JS_CFUNC_generic_magic,
+                                 field)};
+        if(getter.is_exception() || setter.is_exception()) {
+            throw qjs::JSException::dump(ctx);
+        }
+        auto atom = qjs::Atom{ctx, JS_NewAtom(ctx, lazy_fields[field])};
+        if(JS_DefinePropertyGetSet(ctx,
+                                   proto.value(),
+                                   atom.value(),
+                                   getter.release(),
+                                   setter.release(),
+                                   JS_PROP_CONFIGURABLE) < 0) {
+            throw qjs::JSException::dump(ctx);
+        }
+    }
+    JS_SetClassProto(ctx, id, JS_DupValue(ctx, proto.value()));
+    return proto;
+}
+
+}  // namespace
+
+qjs::Object make_command_object(JSContext* ctx, CommandData data, EnvLoader env_loader) {
+    auto id = class_id(ctx);
+    auto proto = prototype_of(ctx, id);
+
+    auto object = qjs::Object{ctx, JS_NewObjectProtoClass(ctx, proto.value(), id)};
+    if(!JS_IsObject(object.value())) {
+        throw qjs::JSException::dump(ctx);
+    }
+    object.set_property("cwd", data.cwd);
+    object.set_property("exe", data.exe);
+    auto parent = data.parent;
+    JS_SetOpaque(object.value(),
+                 new CommandObject{.data = std::move(data), .env_loader = std::move(env_loader)});
+
+    // own accessors, so that spreading or enumerating the object still sees every field
+    for(auto name: lazy_fields) {
+        auto atom = qjs::Atom{ctx, JS_NewAtom(ctx, name)};
+        JSPropertyDescriptor desc;
+        int found = JS_GetOwnProperty(ctx, &desc, proto.value(), atom.value());
+        if(found < 0) {
+            throw qjs::JSException::dump(ctx);
+        } else if(found == 0) {
+            throw qjs::Exception("CommandData prototype has no accessor for {}", name);
+        }
+        JS_FreeValue(ctx, desc.value);
+        if(JS_DefinePropertyGetSet(ctx,
+                                   object.value(),
+                                   atom.value(),
+                                   desc.getter,
+                                   desc.setter,
+                                   JS_PROP_CONFIGURABLE | JS_PROP_ENUMERABLE) < 0) {
+            throw qjs::JSException::dump(ctx);
+        }
+    }
+
+    if(parent.has_value()) {
+        object.set_property("parent", *parent);
+    }
+    return object;
+}
+
+}  // namespace catter::js
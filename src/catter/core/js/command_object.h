@@ -0,0 +1,23 @@
+#pragma once
+
+#include <quickjs.h>
+
+#include "js.h"
+#include "qjs.h"
+#include "capi/type.h"
+
+namespace catter::js {
+
+/**
+ * Expose `data` to the script as an instance of the native `CommandData` class, which owns it.
+ *
+ * `cwd`, `exe` and `parent` are plain properties. `argv`, `env` and `runtime` are own enumerable
+ * accessors shared by all instances, which convert the field on first read and then replace
+ * themselves by a plain data property. A script which decides by `exe` alone never copies the
+ * arguments or the environment onto the JS heap.
+ *
+ * @param env_loader if set, `data.env` is ignored and `env` is produced by it.
+ */
+qjs::Object make_command_object(JSContext* ctx, CommandData data, EnvLoader env_loader = {});
+
+}  // namespace catter::js
@@ -2,16 +2,21 @@
 
 #include <cassert>
 #include <exception>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <type_traits>
 #include <utility>
+#include <vector>
 #include <quickjs.h>
 #include <cpptrace/exceptions.hpp>
 
 #include "apitool.h"
 #include "async.h"
+#include "command_object.h"
 #include "esm_loader.h"
+#include "worker_pool.h"
 
 extern "C" {
     extern const char _binary_lib_js_start[];
@@ -30,6 +35,10 @@ using OnCommand = qjs::Function<qjs::Promise(uint32_t id, qjs::Object data)>;
 
 using OnExecution = qjs::Function<qjs::Promise(uint32_t id, qjs::Object data)>;
 
+using OnCollect = qjs::Function<qjs::Promise()>;
+
+using OnMerge = qjs::Function<qjs::Promise(qjs::Object states)>;
+
 struct RuntimeState {
     RuntimeConfig config;
     qjs::Runtime runtime;
@@ -38,28 +47,26 @@ struct RuntimeState {
     OnFinish on_finish;
     OnCommand on_command;
     OnExecution on_execution;
+    OnCollect on_collect;
+    OnMerge on_merge;
+    std::unique_ptr<WorkerPool> workers;
 
     void reset(RuntimeConfig next_config) {
         on_start = {};
         on_finish = {};
         on_command = {};
         on_execution = {};
+        on_collect = {};
+        on_merge = {};
+        workers.reset();
         runtime = qjs::Runtime::create();
         runtime.set_module_loader(std::make_unique<EsmModuleLoader>(next_config.pwd));
         config = std::move(next_config);
     }
 };
 
-RuntimeState state{};
-
-std::string_view js_lib_source() {
-    const std::string_view js_lib{_binary_lib_js_start, _binary_lib_js_end};
-    auto last = js_lib.find_last_not_of('\0');
-    if(last == std::string_view::npos) {
-        return {};
-    }
-    return js_lib.substr(0, last + 1);
-}
+/// Every thread running scripts has its own runtime, see `WorkerPool`.
+thread_local RuntimeState state{};
 
 kota::task<> eval_module(std::string_view input, const char* filename) {
     auto ctx = state.runtime.context();
@@ -84,6 +91,15 @@ kota::task<T> wait_for_callback_promise(qjs::Promise promise) {
 
 }  // namespace
 
+std::string_view library_source() {
+    const std::string_view js_lib{_binary_lib_js_start, _binary_lib_js_end};
+    auto last = js_lib.find_last_not_of('\0');
+    if(last == std::string_view::npos) {
+        return {};
+    }
+    return js_lib.substr(0, last + 1);
+}
+
 const RuntimeConfig& get_global_runtime_config() {
     return state.config;
 }
@@ -109,7 +125,7 @@ kota::task<> RuntimeScope::start(RuntimeConfig config) {
         for(auto& reg: catter::apitool::api_registers()) {
             reg(mod, ctx);
         }
-        co_await eval_module(js_lib_source(), "catter");
+        co_await eval_module(library_source(), "catter");
     } catch(...) {
         error = std::current_exception();
     }
@@ -128,6 +144,7 @@ kota::task<> RuntimeScope::stop() {
         co_return;
     }
 
+    state.workers.reset();
     co_await state.js_loop.stop();
     started = false;
     co_return;
@@ -156,12 +173,22 @@ kota::task<> on_finish(ProcessResult result) {
     if(!state.on_finish) {
         throw cpptrace::runtime_error("service.onFinish is not registered");
     }
+    if(state.workers) {
+        auto states = co_await state.workers->stop();
+        state.workers.reset();
+        co_await on_merge(std::move(states));
+    }
     co_await wait_for_callback_promise(
         state.on_finish(result.to_object(state.on_finish.context())));
     co_return;
 }
 
-kota::task<Action> on_command(uint32_t id, std::expected<CommandData, CatterErr> data) {
+kota::task<Action> on_command(uint32_t id,
+                              std::expected<CommandData, CatterErr> data,
+                              EnvLoader env_loader) {
+    if(state.workers) {
+        co_return co_await state.workers->on_command(id, std::move(data), std::move(env_loader));
+    }
     if(!state.on_command) {
         throw cpptrace::runtime_error("service.onCommand is not registered");
     }
@@ -173,7 +200,10 @@ kota::task<Action> on_command(uint32_t id, std::expected<CommandData, CatterErr>
     auto command_result = qjs::Object::empty_one(state.on_command.context());
     if(data.has_value()) {
         command_result.set_property("success", true);
-        command_result.set_property("data", data->to_object(state.on_command.context()));
+        command_result.set_property("data",
+                                    make_command_object(state.on_command.context(),
+                                                        std::move(*data),
+                                                        std::move(env_loader)));
     } else {
         command_result.set_property("success", false);
         command_result.set_property("error", data.error().to_object(state.on_command.context()));
@@ -184,6 +214,10 @@ kota::task<Action> on_command(uint32_t id, std::expected<CommandData, CatterErr>
 }
 
 kota::task<> on_execution(uint32_t id, ProcessResult result) {
+    if(state.workers) {
+        co_await state.workers->on_execution(id, std::move(result));
+        co_return;
+    }
     if(!state.on_execution) {
         throw cpptrace::runtime_error("service.onExecution is not registered");
     }
@@ -192,6 +226,38 @@ kota::task<> on_execution(uint32_t id, ProcessResult result) {
     co_return;
 }
 
+kota::task<std::optional<std::string>> on_collect() {
+    if(!state.on_collect) {
+        co_return std::nullopt;
+    }
+    co_return co_await wait_for_callback_promise<std::string>(state.on_collect());
+}
+
+kota::task<> on_merge(std::vector<std::string> states) {
+    if(!state.on_merge) {
+        co_return;
+    }
+    auto ctx = state.on_merge.context();
+    auto array = qjs::Array<std::string>::from(ctx, states);
+    co_await wait_for_callback_promise(state.on_merge(qjs::Object{ctx, array.release()}));
+    co_return;
+}
+
+kota::task<> start_workers(std::size_t count,
+                           std::string_view content,
+                           std::string_view filepath,
+                           const CatterConfig& config) {
+    if(state.workers) {
+        throw cpptrace::runtime_error("Worker runtimes are already started");
+    }
+    state.workers = co_await WorkerPool::start(count,
+                                               state.config,
+                                               std::string(content),
+                                               std::string(filepath),
+                                               config);
+    co_return;
+}
+
 void set_on_start(qjs::Object cb) {
     state.on_start = cb.as<OnStart>();
 }
@@ -208,4 +274,12 @@ void set_on_execution(qjs::Object cb) {
     state.on_execution = cb.as<OnExecution>();
 }
 
+void set_on_collect(qjs::Object cb) {
+    state.on_collect = cb.as<OnCollect>();
+}
+
+void set_on_merge(qjs::Object cb) {
+    state.on_merge = cb.as<OnMerge>();
+}
+
 }  // namespace catter::js
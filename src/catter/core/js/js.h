@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstddef>
 #include <expected>
 #include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <vector>
 #include <kota/async/runtime/task.h>
 
 #include "async.h"
@@ -17,6 +22,9 @@ struct RuntimeConfig {
 
 const RuntimeConfig& get_global_runtime_config();
 
+/// The source of the `catter` module, which every script runs with.
+std::string_view library_source();
+
 class RuntimeScope {
 public:
     RuntimeScope() = default;
@@ -42,10 +50,39 @@ void set_on_start(qjs::Object cb);
 void set_on_finish(qjs::Object cb);
 void set_on_command(qjs::Object cb);
 void set_on_execution(qjs::Object cb);
+void set_on_collect(qjs::Object cb);
+void set_on_merge(qjs::Object cb);
 
 kota::task<CatterConfig> on_start(const CatterConfig& config);
 kota::task<> on_finish(ProcessResult result);
-kota::task<Action> on_command(uint32_t id, std::expected<CommandData, CatterErr> data);
+/// Produces the environment of a command on demand, see `on_command`.
+using EnvLoader = std::function<std::vector<std::string>()>;
+
+/**
+ * @param env_loader if set, `data.env` is ignored and the `env` property seen by the script is
+ * produced by it, only when the script reads it.
+ */
+kota::task<Action> on_command(uint32_t id,
+                              std::expected<CommandData, CatterErr> data,
+                              EnvLoader env_loader = {});
 kota::task<> on_execution(uint32_t id, ProcessResult result);
 
+/// @return the serialized state of the script, or nothing if it does not register `onCollect`.
+kota::task<std::optional<std::string>> on_collect();
+/// Hand the states collected from the workers, or kept by the decision cache, to the script
+/// before `on_finish`.
+kota::task<> on_merge(std::vector<std::string> states);
+
+/**
+ * Load the script into `count` worker runtimes on their own threads, `on_command` and
+ * `on_execution` are dispatched to them from then on. `on_finish` merges their state back and
+ * stops them. See `WorkerPool`.
+ *
+ * @param config the config returned by `on_start`, replayed on every worker.
+ */
+kota::task<> start_workers(std::size_t count,
+                           std::string_view content,
+                           std::string_view filepath,
+                           const CatterConfig& config);
+
 }  // namespace catter::js
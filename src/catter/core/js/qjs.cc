@@ -3,6 +3,8 @@
 #include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <functional>
+#include <string>
 #include <utility>
 #include <quickjs.h>
 
@@ -15,6 +17,52 @@ void* next_runtime_token() noexcept {
     return reinterpret_cast<void*>(next.fetch_add(1, std::memory_order_relaxed));
 }
 
+/// Replace the lazy accessor on `this_val` by a data property holding `value`.
+bool settle_lazy_property(JSContext* ctx,
+                          JSValueConst this_val,
+                          JSValueConst name,
+                          JSValueConst value) noexcept {
+    JSAtom atom = JS_ValueToAtom(ctx, name);
+    if(atom == JS_ATOM_NULL) {
+        return false;
+    }
+    int ret = JS_DefinePropertyValue(ctx, this_val, atom, JS_DupValue(ctx, value), JS_PROP_C_W_E);
+    JS_FreeAtom(ctx, atom);
+    return ret >= 0;
+}
+
+// func_data: [compute function, property name]
+JSValue lazy_property_get(JSContext* ctx,
+                          JSValueConst this_val,
+                          [[maybe_unused]] int argc,
+                          [[maybe_unused]] JSValueConst* argv,
+                          [[maybe_unused]] int magic,
+                          JSValueConst* func_data) noexcept {
+    JSValue value = JS_Call(ctx, func_data[0], JS_UNDEFINED, 0, nullptr);
+    if(JS_IsException(value)) {
+        return value;
+    }
+    if(!settle_lazy_property(ctx, this_val, func_data[1], value)) {
+        JS_FreeValue(ctx, value);
+        return JS_EXCEPTION;
+    }
+    return value;
+}
+
+JSValue lazy_property_set(JSContext* ctx,
+                          JSValueConst this_val,
+                          int argc,
+                          JSValueConst* argv,
+                          [[maybe_unused]] int magic,
+                          JSValueConst* func_data) noexcept {
+    JSValueConst value = argc > 0 ? argv[0] : JS_UNDEFINED;
+    if(!settle_lazy_property(ctx, this_val, func_data[1], value)) {
+        return JS_EXCEPTION;
+    }
+    return JS_UNDEFINED;
+}
+
+
 }  // namespace
 
 Exception::Exception(const std::string& details) : cpptrace::runtime_error(std::string(details)) {}
@@ -209,6 +257,30 @@ std::optional<Value> Object::get_optional_property(const char* prop_name) const
     }
 }
 
+void Object::define_lazy_property(const char* prop_name, std::function<Object()> compute) {
+    auto ctx = this->context();
+    auto compute_fn = Function<Object()>::from(ctx, std::move(compute));
+    auto name = Value::from(ctx, std::string(prop_name));
+    JSValueConst func_data[] = {compute_fn.value(), name.value()};
+
+    auto getter = Value{ctx, JS_NewCFunctionData(ctx, lazy_property_get, 0, 0, 2, func_data)};
+    auto setter = Value{ctx, JS_NewCFunctionData(ctx, lazy_property_set, 1, 0, 2, func_data)};
+    if(getter.is_exception() || setter.is_exception()) {
+        throw qjs::JSException::dump(ctx);
+    }
+
+    auto atom = Atom{ctx, JS_NewAtom(ctx, prop_name)};
+    int ret = JS_DefinePropertyGetSet(ctx,
+                                      this->value(),
+                                      atom.value(),
+                                      getter.release(),
+                                      setter.release(),
+                                      JS_PROP_CONFIGURABLE | JS_PROP_ENUMERABLE);
+    if(ret < 0) {
+        throw qjs::JSException::dump(ctx);
+    }
+}
+
 Object Object::empty_one(JSContext* ctx) noexcept {
     return Object{ctx, JS_NewObject(ctx)};
 }
@@ -7,6 +7,7 @@
 #include <exception>
 #include <expected>
 #include <format>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <print>
@@ -282,6 +283,16 @@ public:
         set_property(prop_name.c_str(), std::forward<T>(val));
     }
 
+    /**
+     * @brief Define an enumerable property whose value is computed on first read.
+     *
+     * The first read or write replaces the accessor with a plain data property, so `compute` runs
+     * at most once and the property behaves like any other afterwards.
+     *
+     * @throws qjs::Exception if the property can not be defined.
+     */
+    void define_lazy_property(const char* prop_name, std::function<Object()> compute);
+
     template <typename T>
     static Object from(T&& value) noexcept {
         return detail::object_trans<std::remove_cvref_t<T>>::from(std::forward<T>(value));
@@ -346,7 +357,8 @@ public:
             void* runtime_token = nullptr;
         };
 
-        inline static std::unordered_map<JSRuntime*, Entry> class_ids{};
+        /// Every runtime is only used by the thread which created it.
+        inline static thread_local std::unordered_map<JSRuntime*, Entry> class_ids{};
     };
 
     static Object empty_one(JSContext* ctx) noexcept;
@@ -0,0 +1,227 @@
+#include "worker_pool.h"
+
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cpptrace/exceptions.hpp>
+
+#include "util/guard.h"
+
+namespace catter::js {
+
+namespace {
+
+struct Boot {
+    kota::event ready{};
+    std::exception_ptr error{};
+};
+
+/// Body of a worker thread, runs on its own loop until `quit` is set.
+kota::task<> serve(kota::event& quit,
+                   std::optional<kota::relay>& relay,
+                   kota::relay& reply,
+                   std::shared_ptr<Boot> boot,
+                   RuntimeConfig config,
+                   std::string content,
+                   std::string filepath,
+                   CatterConfig catter_config) {
+    RuntimeScope runtime;
+    try {
+        co_await runtime.start(std::move(config));
+        co_await run_script(content, filepath);
+        co_await on_start(catter_config);
+    } catch(...) {
+        boot->error = std::current_exception();
+    }
+    reply.send([boot]() { boot->ready.set(); });
+
+    // even a failed worker waits, the pool may still send to `relay` until then
+    co_await quit.wait();
+    co_await runtime.stop();
+    // nothing keeps the loop alive after this, the thread returns
+    relay.reset();
+    co_return;
+}
+
+}  // namespace
+
+struct WorkerPool::Worker {
+    std::thread thread;
+    /// Owned by `thread`.
+    kota::event_loop* loop = nullptr;
+    /// Wakes `loop`, set up by `thread` before it reports ready.
+    std::optional<kota::relay> relay;
+    /// Only touched on `thread`.
+    kota::event quit{};
+    /// Jobs sent and not answered yet, only touched by the pool.
+    std::size_t in_flight = 0;
+};
+
+WorkerPool::WorkerPool() : reply(kota::event_loop::current().create_relay()) {}
+
+WorkerPool::~WorkerPool() {
+    this->quit_all();
+}
+
+kota::task<std::unique_ptr<WorkerPool>> WorkerPool::start(std::size_t count,
+                                                          RuntimeConfig config,
+                                                          std::string content,
+                                                          std::string filepath,
+                                                          CatterConfig catter_config) {
+    if(count == 0) {
+        throw cpptrace::runtime_error("WorkerPool needs at least one worker");
+    }
+
+    std::unique_ptr<WorkerPool> pool(new WorkerPool());
+    std::vector<std::shared_ptr<Boot>> boots;
+    std::exception_ptr error;
+    try {
+        for(std::size_t i = 0; i < count; ++i) {
+            auto worker = std::make_unique<Worker>();
+            auto boot = std::make_shared<Boot>();
+            worker->thread = std::thread([worker = worker.get(),
+                                          reply = &pool->reply,
+                                          boot,
+                                          config,
+                                          content,
+                                          filepath,
+                                          catter_config]() mutable {
+                kota::event_loop loop;
+                worker->loop = &loop;
+                worker->relay.emplace(loop.create_relay());
+                loop.schedule(serve(worker->quit,
+                                    worker->relay,
+                                    *reply,
+                                    std::move(boot),
+                                    std::move(config),
+                                    std::move(content),
+                                    std::move(filepath),
+                                    std::move(catter_config)));
+                loop.run();
+            });
+            pool->workers.push_back(std::move(worker));
+            boots.push_back(std::move(boot));
+        }
+    } catch(...) {
+        error = std::current_exception();
+    }
+
+    // wait for every started worker, the pool can only be stopped once they are all set up
+    for(auto& boot: boots) {
+        co_await boot->ready.wait();
+        if(boot->error && !error) {
+            error = boot->error;
+        }
+    }
+    if(error) {
+        pool.reset();
+        std::rethrow_exception(error);
+    }
+    co_return pool;
+}
+
+kota::task<Action> WorkerPool::on_command(uint32_t id,
+                                          std::expected<CommandData, CatterErr> data,
+                                          EnvLoader env_loader) {
+    auto& worker = this->pick();
+    if(data.has_value()) {
+        this->assigned[id] = &worker;
+    }
+
+    std::optional<Action> action;
+    co_await this->call(worker, [&]() -> kota::task<> {
+        action = co_await js::on_command(id, std::move(data), std::move(env_loader));
+    });
+    co_return std::move(*action);
+}
+
+kota::task<> WorkerPool::on_execution(uint32_t id, ProcessResult result) {
+    Worker* worker = nullptr;
+    if(auto it = this->assigned.find(id); it != this->assigned.end()) {
+        worker = it->second;
+        this->assigned.erase(it);
+    } else {
+        worker = &this->pick();
+    }
+
+    co_await this->call(*worker, [&]() -> kota::task<> {
+        co_await js::on_execution(id, std::move(result));
+    });
+    co_return;
+}
+
+kota::task<std::vector<std::string>> WorkerPool::stop() {
+    std::vector<std::string> states;
+    for(auto& worker: this->workers) {
+        std::optional<std::string> collected;
+        co_await this->call(*worker, [&]() -> kota::task<> { collected = co_await on_collect(); });
+        if(collected.has_value()) {
+            states.push_back(std::move(*collected));
+        }
+    }
+    this->quit_all();
+    co_return states;
+}
+
+kota::task<> WorkerPool::call(Worker& worker, kota::function<kota::task<>()> job) {
+    struct State {
+        kota::function<kota::task<>()> job;
+        kota::event done{};
+        std::exception_ptr error{};
+    };
+
+    // shared with both threads, the last one to let go of it frees it
+    auto state = std::make_shared<State>();
+    state->job = std::move(job);
+    ++worker.in_flight;
+    auto guard = util::make_guard([&worker] noexcept { --worker.in_flight; });
+
+    worker.relay->send([state, loop = worker.loop, reply = &this->reply]() {
+        loop->schedule([](std::shared_ptr<State> state, kota::relay* reply) -> kota::task<> {
+            try {
+                co_await state->job();
+            } catch(...) {
+                state->error = std::current_exception();
+            }
+            reply->send([state]() { state->done.set(); });
+            co_return;
+        }(state, reply));
+    });
+
+    co_await state->done.wait();
+    if(state->error) {
+        std::rethrow_exception(state->error);
+    }
+    co_return;
+}
+
+WorkerPool::Worker& WorkerPool::pick() noexcept {
+    auto best = this->next % this->workers.size();
+    for(std::size_t i = 1; i < this->workers.size(); ++i) {
+        auto index = (this->next + i) % this->workers.size();
+        if(this->workers[index]->in_flight < this->workers[best]->in_flight) {
+            best = index;
+        }
+    }
+    this->next = best + 1;
+    return *this->workers[best];
+}
+
+void WorkerPool::quit_all() noexcept {
+    for(auto& worker: this->workers) {
+        if(worker->thread.joinable()) {
+            worker->relay->send([worker = worker.get()]() { worker->quit.set(); });
+        }
+    }
+    for(auto& worker: this->workers) {
+        if(worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+}  // namespace catter::js
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <kota/support/functional.h>
+#include <kota/async/async.h>
+
+#include "js.h"
+#include "capi/type.h"
+
+namespace catter::js {
+
+/**
+ * Extra runtimes loaded with the same script as the main one, each running on its own thread
+ * with its own event loop, so that the decisions for different commands are made in parallel.
+ *
+ * A command is given to the least busy worker, which runs both its `onCommand` and its
+ * `onExecution`. `onStart` is replayed on every worker with the final config and `onFinish` only
+ * runs on the main runtime. A worker only sees its own commands: state spanning several commands
+ * has to be serialized by `onCollect` on every worker and is handed to `onMerge` on the main
+ * runtime, see `stop`.
+ *
+ * All members are used from the thread that started the pool.
+ */
+class WorkerPool {
+public:
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator= (const WorkerPool&) = delete;
+
+    WorkerPool(WorkerPool&&) = delete;
+    WorkerPool& operator= (WorkerPool&&) = delete;
+
+    /// Stops the workers which are still running, without collecting their state.
+    ~WorkerPool();
+
+    /// Start `count` workers, run the script and then `onStart` with `catter_config` on each.
+    static kota::task<std::unique_ptr<WorkerPool>> start(std::size_t count,
+                                                         RuntimeConfig config,
+                                                         std::string content,
+                                                         std::string filepath,
+                                                         CatterConfig catter_config);
+
+    /// @param env_loader called on the worker thread.
+    kota::task<Action> on_command(uint32_t id,
+                                  std::expected<CommandData, CatterErr> data,
+                                  EnvLoader env_loader);
+
+    kota::task<> on_execution(uint32_t id, ProcessResult result);
+
+    /**
+     * Collect the state of every worker with `onCollect`, then stop them.
+     *
+     * @return the collected states in worker order, workers without `onCollect` are left out.
+     */
+    kota::task<std::vector<std::string>> stop();
+
+private:
+    struct Worker;
+
+    WorkerPool();
+
+    kota::task<> call(Worker& worker, kota::function<kota::task<>()> job);
+
+    Worker& pick() noexcept;
+
+    void quit_all() noexcept;
+
+    /// Resumes waiters on this thread once a worker is done with a job.
+    kota::relay reply;
+    std::vector<std::unique_ptr<Worker>> workers;
+    /// The worker which decided each command, to run its `onExecution` too.
+    std::unordered_map<uint32_t, Worker*> assigned;
+    std::size_t next = 0;
+};
+
+}  // namespace catter::js
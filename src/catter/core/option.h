@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <cstdio>
 #include <exception>
 #include <filesystem>
@@ -10,6 +11,7 @@
 #include <kota/deco/deco.h>
 
 #include "runtime_driver.h"
+#include "config/ipc.h"
 #include "js/capi/type.h"
 
 namespace catter::core {
@@ -101,6 +103,45 @@ struct CatterConfig {
         required = false)
     <js::CatterOptions::StdioMode> stdio_mode = js::CatterOptions::StdioMode::inherit;
 
+    DecoFlag(
+        names = {"--direct-hook"},
+        help =
+            "let the hook library ask catter for decisions itself instead of exec'ing catter-proxy for every command; Linux and macOS only",
+        required = false)
+    direct_hook = false;
+
+    DecoKV(
+        names = {"--decision-workers"},
+        meta_var = "<N>",
+        help =
+            "run onCommand and onExecution in N extra script runtimes on their own threads, the script merges their state with onCollect and onMerge; default to 0, off",
+        required = false)
+    <uint32_t> decision_workers = 0;
+
+    DecoKV(
+        names = {"--ipc-backlog"},
+        meta_var = "<N>",
+        help =
+            "connections the socket of catter queues before a proxy waits to connect; raise it for builds running very many commands at once; default to 1024",
+        required = false)
+    <uint32_t> ipc_backlog = static_cast<uint32_t>(catter::config::ipc::BACKLOG);
+
+    DecoKV(
+        names = {"--record"},
+        meta_var = "<File>",
+        help =
+            "write every captured command and its result to <File>, for --replay; the file is replaced",
+        required = false)
+    <std::string> record = std::string{};
+
+    DecoKV(
+        names = {"--replay"},
+        meta_var = "<File>",
+        help =
+            "feed the build recorded with --record to the script instead of running a build; the recorded build command and directory are used",
+        required = false)
+    <std::string> replay = std::string{};
+
     DecoPack(
         meta_var = "<Args>",
         help =
@@ -129,10 +170,29 @@ struct RunContext {
         return config.working_dir->path;
     }
 
+    /// The event log to replay instead of running the build, if any.
+    std::optional<std::filesystem::path> replay_path() const {
+        if(config.replay->empty()) {
+            return std::nullopt;
+        }
+        return std::filesystem::absolute(config.replay.value());
+    }
+
+    std::optional<std::string> record_path() const {
+        if(config.record->empty()) {
+            return std::nullopt;
+        }
+        return std::filesystem::absolute(config.record.value()).string();
+    }
+
     js::CatterOptions option_defaults() const {
         return js::CatterOptions{
             .log = config.log,
             .stdioMode = config.stdio_mode.value(),
+            .directHook = config.direct_hook.value(),
+            .decisionWorkers = config.decision_workers.value(),
+            .record = record_path(),
+            .ipcBacklog = config.ipc_backlog.value(),
         };
     }
 
@@ -152,6 +212,18 @@ struct RunContext {
         if(!script_config.options.stdioMode.has_value()) {
             script_config.options.stdioMode = config.stdio_mode.value();
         }
+        if(!script_config.options.directHook.has_value()) {
+            script_config.options.directHook = config.direct_hook.value();
+        }
+        if(!script_config.options.decisionWorkers.has_value()) {
+            script_config.options.decisionWorkers = config.decision_workers.value();
+        }
+        if(!script_config.options.record.has_value()) {
+            script_config.options.record = record_path();
+        }
+        if(!script_config.options.ipcBacklog.has_value()) {
+            script_config.options.ipcBacklog = config.ipc_backlog.value();
+        }
     }
 };
 
@@ -0,0 +1,72 @@
+#include "process_table.h"
+
+namespace catter::core {
+
+data::ipcid_t ProcessTable::add(data::ipcid_t id,
+                                data::ipcid_t reported,
+                                const data::process_origin& origin) {
+    auto parent = reported;
+    // spawned by the command itself, or by a fork of it which then called exec
+    if(auto caller = running(origin.pid); caller != 0 && caller != id) {
+        parent = caller;
+    } else if(auto forker = running(origin.ppid); forker != 0 && forker != id) {
+        parent = forker;
+    }
+    auto [entry, inserted] = entries.try_emplace(id, Entry{.parent = parent, .origin = origin});
+    if(!inserted) {
+        return entry->second.parent;
+    }
+    if(auto it = entries.find(parent); it != entries.end()) {
+        ++it->second.children;
+    }
+    return parent;
+}
+
+void ProcessTable::started(data::ipcid_t id, int64_t pid) {
+    auto it = entries.find(id);
+    if(it == entries.end() || pid <= 0) {
+        return;
+    }
+    it->second.pid = pid;
+    // a pid still indexed for another command is stale, its process is gone
+    by_pid.insert_or_assign(pid, id);
+}
+
+std::vector<data::ipcid_t> ProcessTable::exited(data::ipcid_t id) {
+    auto it = entries.find(id);
+    if(it == entries.end()) {
+        return {};
+    }
+    it->second.exited = true;
+    if(auto running = by_pid.find(it->second.pid);
+       it->second.pid != 0 && running != by_pid.end() && running->second == id) {
+        by_pid.erase(running);
+    }
+
+    std::vector<data::ipcid_t> forgotten;
+    while(it != entries.end() && it->second.exited && it->second.children == 0) {
+        auto parent = it->second.parent;
+        forgotten.push_back(it->first);
+        entries.erase(it);
+        it = entries.find(parent);
+        if(it != entries.end()) {
+            --it->second.children;
+        }
+    }
+    return forgotten;
+}
+
+const ProcessTable::Entry* ProcessTable::find(data::ipcid_t id) const {
+    auto it = entries.find(id);
+    return it == entries.end() ? nullptr : &it->second;
+}
+
+data::ipcid_t ProcessTable::running(int64_t pid) const {
+    if(pid <= 0) {
+        return 0;
+    }
+    auto it = by_pid.find(pid);
+    return it == by_pid.end() ? 0 : it->second;
+}
+
+}  // namespace catter::core
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "util/data.h"
+
+namespace catter::core {
+
+/**
+ * The commands of a session and the processes running them.
+ *
+ * A proxy reports the parent it was handed through the environment, which is the nearest hooked
+ * command the environment was inherited from rather than the process which made the call. The
+ * hook also reports the calling process, so a command is linked to the running command whose
+ * process made the call, or whose process forked the caller, as `fork` and `exec` go.
+ *
+ * Every command keeps its parent, walking up the ancestry takes one lookup per step. A command is
+ * forgotten once it exited and every command linked to it was forgotten, so a long build only
+ * keeps the commands still running and their ancestors.
+ */
+class ProcessTable {
+public:
+    struct Entry {
+        data::ipcid_t parent = 0;
+        data::process_origin origin{};
+        /// The process running the command, 0 until it started.
+        int64_t pid = 0;
+        /// The commands linked to this one which are not forgotten yet.
+        std::size_t children = 0;
+        bool exited = false;
+    };
+
+    /**
+     * Add a command, linked to the running command whose process called it if there is one.
+     *
+     * @param reported the parent the proxy reported.
+     * @return the parent of the command.
+     */
+    data::ipcid_t add(data::ipcid_t id,
+                      data::ipcid_t reported,
+                      const data::process_origin& origin);
+
+    /// The command runs as process `pid`, its children are linked to it.
+    void started(data::ipcid_t id, int64_t pid);
+
+    /**
+     * The process of the command is gone, the system may give its pid to another one.
+     *
+     * @return the commands this forgets: the command itself unless a linked one is still known,
+     * then each ancestor which exited and was only waiting for it.
+     */
+    std::vector<data::ipcid_t> exited(data::ipcid_t id);
+
+    /// @return nullptr if the command is unknown.
+    const Entry* find(data::ipcid_t id) const;
+
+    /// @return the running command of process `pid`, 0 if there is none.
+    data::ipcid_t running(int64_t pid) const;
+
+    std::size_t size() const noexcept {
+        return entries.size();
+    }
+
+private:
+    std::unordered_map<data::ipcid_t, Entry> entries;
+    std::unordered_map<int64_t, data::ipcid_t> by_pid;
+};
+
+}  // namespace catter::core
@@ -0,0 +1,97 @@
+#include "rule_table.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <regex>
+#include <utility>
+#include <cpptrace/exceptions.hpp>
+
+#include "util/exec_filter.h"
+
+namespace catter::core {
+
+namespace {
+
+bool is_separator(char c) noexcept {
+    return c == '/' || c == '\\';
+}
+
+std::string_view file_name_of(std::string_view path) noexcept {
+    auto pos = path.find_last_of("/\\");
+    return pos == std::string_view::npos ? path : path.substr(pos + 1);
+}
+
+}  // namespace
+
+RuleTable RuleTable::compile(const std::vector<js::CommandRule>& rules) {
+    RuleTable table;
+    table.rules.reserve(rules.size());
+    for(std::size_t i = 0; i < rules.size(); ++i) {
+        const auto& rule = rules[i];
+        if(rule.action != js::ActionType::skip && rule.action != js::ActionType::drop) {
+            throw cpptrace::runtime_error(
+                std::format("options.rules[{}]: only skip and drop can be decided natively", i));
+        }
+
+        Rule compiled{
+            .exe = rule.exe,
+            .args = rule.args.value_or(std::vector<std::string>{}),
+            .action = rule.action,
+        };
+        if(compiled.exe.has_value()) {
+            compiled.exe_is_path = std::ranges::any_of(*compiled.exe, is_separator);
+        }
+        if(rule.exePattern.has_value()) {
+            try {
+                compiled.exe_pattern.emplace(*rule.exePattern, std::regex::ECMAScript);
+            } catch(const std::regex_error& e) {
+                throw cpptrace::runtime_error(
+                    std::format("options.rules[{}]: invalid exePattern: {}", i, e.what()));
+            }
+        }
+        table.rules.push_back(std::move(compiled));
+    }
+    return table;
+}
+
+std::optional<js::ActionType> RuleTable::match(std::string_view exe,
+                                               std::span<const std::string> argv) const {
+    auto args = argv.empty() ? argv : argv.subspan(1);
+    for(const auto& rule: this->rules) {
+        if(rule.exe.has_value() &&
+           !util::glob_match(*rule.exe, rule.exe_is_path ? exe : file_name_of(exe))) {
+            continue;
+        }
+        if(rule.exe_pattern.has_value() &&
+           !std::regex_search(exe.begin(), exe.end(), *rule.exe_pattern)) {
+            continue;
+        }
+        if(rule.args.size() > args.size()) {
+            continue;
+        }
+        bool args_match = true;
+        for(std::size_t i = 0; i < rule.args.size() && args_match; ++i) {
+            args_match = util::glob_match(rule.args[i], args[i]);
+        }
+        if(args_match) {
+            return rule.action;
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<std::string> RuleTable::pass_through() const {
+    std::vector<std::string> globs;
+    for(const auto& rule: this->rules) {
+        if(rule.action == js::ActionType::drop) {
+            break;
+        }
+        if(rule.exe.has_value() && !rule.exe_pattern.has_value() && rule.args.empty()) {
+            globs.push_back(*rule.exe);
+        }
+    }
+    return globs;
+}
+
+}  // namespace catter::core
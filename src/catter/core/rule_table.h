@@ -0,0 +1,50 @@
+#pragma once
+#include <optional>
+#include <regex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "js/capi/type.h"
+
+namespace catter::core {
+
+/**
+ * The rules a script registers in `options.rules`, compiled once per session.
+ *
+ * Most commands of a build, like shells or `mkdir`, are always skipped. A matching rule decides
+ * them without converting the command to a JS object and waiting for `onCommand`. The first
+ * matching rule wins.
+ */
+class RuleTable {
+public:
+    /// @throws cpptrace::runtime_error on an invalid pattern or an action a rule can not take.
+    static RuleTable compile(const std::vector<js::CommandRule>& rules);
+
+    bool empty() const noexcept {
+        return rules.empty();
+    }
+
+    /// @param argv the full argument vector, including `argv[0]`.
+    std::optional<js::ActionType> match(std::string_view exe,
+                                        std::span<const std::string> argv) const;
+
+    /// The `exe` globs of the rules which skip a command on its executable alone, up to the first
+    /// rule which drops. Whatever its arguments, a command matching one of them is skipped, so
+    /// the hook may run it without asking, see `util::ExecFilter`.
+    std::vector<std::string> pass_through() const;
+
+private:
+    struct Rule {
+        std::optional<std::string> exe;
+        bool exe_is_path = false;
+        std::optional<std::regex> exe_pattern;
+        std::vector<std::string> args;
+        js::ActionType action;
+    };
+
+    std::vector<Rule> rules;
+};
+
+}  // namespace catter::core
@@ -1,20 +1,43 @@
 #include "runtime_driver.h"
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
 #include <expected>
 #include <format>
+#include <fstream>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 #include <cpptrace/exceptions.hpp>
+#include <kota/async/async.h>
 
+#include "app_config.h"
+#include "decision_cache.h"
+#include "env_store.h"
+#include "event_log.h"
 #include "ipc.h"
+#include "process_table.h"
+#include "rule_table.h"
 #include "session.h"
 #include "config/catter-proxy.h"
+#include "config/catter.h"
+#include "config/ipc.h"
 #include "js/js.h"
 #include "util/crossplat.h"
+#include "util/env_delta.h"
+#include "util/exec_filter.h"
+#include "util/guard.h"
+#include "util/log.h"
 
 namespace catter::core {
 namespace {
@@ -27,9 +50,98 @@ Session::StdioMode to_process_stdio_mode(js::CatterOptions::StdioMode mode) {
     throw cpptrace::runtime_error("Unhandled catter output mode");
 }
 
+data::CaptureMode to_capture_mode(js::CaptureMode mode) {
+    switch(mode) {
+        case js::CaptureMode::inherit: return data::CaptureMode::INHERIT;
+        case js::CaptureMode::tail: return data::CaptureMode::TAIL;
+        case js::CaptureMode::full: return data::CaptureMode::FULL;
+    }
+
+    throw cpptrace::runtime_error("Unhandled capture mode");
+}
+
+/// @return nullopt if the hook did not report the calling process.
+std::optional<js::ProcessOrigin> to_js_origin(const data::process_origin& origin) {
+    if(origin.pid == 0) {
+        return std::nullopt;
+    }
+    return js::ProcessOrigin{.pid = origin.pid, .ppid = origin.ppid, .tid = origin.tid};
+}
+
 class InjectService final : public ipc::InjectService {
 public:
-    InjectService(data::ipcid_t id, const js::CatterRuntime* runtime) : id(id), runtime(runtime) {}
+    /// State of the whole session, shared by all commands which run on the same loop.
+    struct Shared {
+        EnvStore envs;
+        RuleTable rules;
+        /// Commands decided by a rule, which the script never sees, to their nearest ancestor
+        /// which it does see.
+        std::unordered_map<data::ipcid_t, data::ipcid_t> hidden;
+        /// For actions which do not choose how much output to keep.
+        data::CaptureMode capture = data::CaptureMode::TAIL;
+        /// Decisions of earlier runs, if `options.decisionCache` is on.
+        std::optional<DecisionCache> cache;
+        /// Sorted names of the environment variables in the cache key.
+        std::vector<std::string> cache_env;
+        /// Commands answered from the cache, with the states `onMerge` gets for them.
+        std::vector<std::string> cached_states;
+        /// Commands answered from the cache, hidden from `onCommand` but not from `onExecution`.
+        std::unordered_set<data::ipcid_t> cached;
+        /// Commands whose descendants are skipped natively, the script or a cached decision
+        /// ignored them.
+        std::unordered_set<data::ipcid_t> ignored;
+        /// Set by `options.record`.
+        std::optional<EventLogWriter> log;
+        /// Links commands to the command whose process called them.
+        ProcessTable processes;
+        /// Commands of the direct path, oldest first, see `detach`.
+        std::deque<data::ipcid_t> detached;
+        /// Set by `options.observeOnly`.
+        bool observe_only = false;
+        /// Commands handed to `onCommand` which it did not answer yet, set once it did.
+        std::unordered_map<data::ipcid_t, std::shared_ptr<kota::event>> observing;
+        /// What `onCommand` threw for observed commands and the commands the script aborted at,
+        /// reported once the build is over.
+        std::string errors;
+
+        data::CaptureMode capture_of(std::optional<js::CaptureMode> requested) const {
+            return requested.has_value() ? to_capture_mode(*requested) : capture;
+        }
+
+        /// The process of command `id` is gone, or catter will not hear of it again.
+        void exited(data::ipcid_t id) {
+            // what is still running keeps what it may resolve against, see `ProcessTable`
+            for(auto forgotten: processes.exited(id)) {
+                envs.release(forgotten);
+            }
+        }
+
+        data::ipcid_t visible(data::ipcid_t id) const {
+            auto it = hidden.find(id);
+            return it == hidden.end() ? id : it->second;
+        }
+
+        /// The script never sees command `id`, its children are reported against its nearest
+        /// ancestor which the script does see.
+        void hide(data::ipcid_t id, data::ipcid_t parent_id) {
+            hidden.emplace(id, visible(parent_id));
+        }
+
+        uint64_t cache_key_of(const data::command& cmd, const EnvStore::Ref& requested) const {
+            std::vector<std::string> env;
+            for(const auto& key: cache_env) {
+                if(const auto* entry = EnvStore::find(requested, key)) {
+                    env.push_back(*entry);
+                }
+            }
+            return DecisionCache::key(cmd.cwd, cmd.executable, cmd.args, env);
+        }
+    };
+
+    InjectService(data::ipcid_t id,
+                  const js::CatterRuntime* runtime,
+                  std::shared_ptr<Shared> shared) :
+        id(id), runtime(runtime), shared(std::move(shared)) {}
 
     kota::task<data::ipcid_t> create(data::ipcid_t parent_id) override {
         this->parent_id = parent_id;
@@ -37,68 +149,416 @@ public:
     }
 
     kota::task<data::action> make_decision(data::command cmd) override {
-        auto act = co_await js::on_command(this->id,
-                                           js::CommandData{
-                                               .cwd = cmd.cwd,
-                                               .exe = cmd.executable,
-                                               .argv = cmd.args,
-                                               .env = cmd.env,
-                                               .runtime = *runtime,
-                                               .parent = this->parent_id,
-                                           });
+        if(!this->shared->envs.resolvable(cmd)) {
+            // a process which outlived the commands it inherited the environment from
+            co_return data::action{.type = data::action::RESEND, .cmd = {}};
+        }
+        this->parent_id = this->shared->processes.add(this->id, this->parent_id, cmd.origin);
+        auto requested = this->shared->envs.resolve(cmd);
+        if(this->shared->log.has_value()) {
+            this->shared->log->command(this->id, this->parent_id, cmd, requested);
+        }
+
+        // the script may still ignore the descendants of the command which runs this one
+        if(auto it = this->shared->observing.find(this->parent_id);
+           it != this->shared->observing.end()) {
+            auto answered = it->second;
+            // either way the command is skipped, only a rule dropping it has to wait
+            if(this->shared->rules.match(cmd.executable, cmd.args) != js::ActionType::drop) {
+                this->shared->observing.emplace(this->id, std::make_shared<kota::event>());
+                kota::event_loop::current().schedule(settle(this->shared,
+                                                            this->runtime,
+                                                            this->id,
+                                                            this->parent_id,
+                                                            cmd,
+                                                            requested,
+                                                            std::move(answered)));
+                co_return this->skip(std::move(cmd),
+                                     std::move(requested),
+                                     this->shared->capture_of(std::nullopt));
+            }
+            co_await answered->wait();
+        }
+
+        if(this->shared->ignored.contains(this->parent_id)) {
+            this->hide();
+            co_return this->ignore_descendants(
+                this->skip(std::move(cmd), std::move(requested), data::CaptureMode::INHERIT));
+        }
+
+        std::optional<uint64_t> cache_key;
+        if(this->shared->cache.has_value()) {
+            cache_key = this->shared->cache_key_of(cmd, requested);
+            if(const auto* entry = this->shared->cache->find(*cache_key)) {
+                co_return this->replay(*entry, std::move(cmd), std::move(requested));
+            }
+        }
+
+        if(auto decided = this->shared->rules.match(cmd.executable, cmd.args)) {
+            this->hide();
+            if(*decided == js::ActionType::drop) {
+                co_return data::action{.type = data::action::DROP, .cmd = {}};
+            }
+            // nobody looks at the output of a command the script does not see
+            co_return this->skip(std::move(cmd), std::move(requested), data::CaptureMode::INHERIT);
+        }
+
+        auto load_env = env_loader(requested);
+        auto data = command_data(*this->shared, this->runtime, this->parent_id, cmd);
+        if(this->shared->observe_only) {
+            this->shared->observing.emplace(this->id, std::make_shared<kota::event>());
+            kota::event_loop::current().schedule(
+                observe(this->shared, this->id, std::move(data), load_env, cache_key));
+            co_return this->skip(std::move(cmd),
+                                 std::move(requested),
+                                 this->shared->capture_of(std::nullopt));
+        }
+
+        auto act = co_await js::on_command(this->id, std::move(data), load_env);
+        if(cache_key.has_value()) {
+            remember(*this->shared, *cache_key, act);
+        }
 
         switch(act.type()) {
             case js::ActionType::drop: {
                 co_return data::action{.type = data::action::DROP, .cmd = {}};
             }
             case js::ActionType::skip: {
-                co_return data::action{.type = data::action::INJECT, .cmd = std::move(cmd)};
+                auto& tag = act.get<js::ActionType::skip>();
+                auto capture = this->shared->capture_of(tag.capture);
+                co_return this->ignore_descendants(
+                    this->skip(std::move(cmd), std::move(requested), capture),
+                    tag.ignoreDescendants.value_or(false));
             }
             case js::ActionType::modify: {
                 auto& tag = act.get<js::ActionType::modify>();
-                co_return data::action{
+                // send back what the script changed, the proxy still has the environment it sent
+                std::vector<std::string> changed;
+                std::vector<std::string> unset;
+                env_delta::diff(load_env(), tag.data.env, changed, unset);
+                this->shared->envs.store(this->id,
+                                         EnvStore::derive(std::move(requested), changed, unset));
+                data::action modified{
                     .type = data::action::INJECT,
                     .cmd = {
                             .cwd = std::move(tag.data.cwd),
                             .executable = std::move(tag.data.exe),
                             .args = std::move(tag.data.argv),
-                            .env = std::move(tag.data.env),
-                            }
+                            .env = std::move(changed),
+                            .env_base = this->id,
+                            .env_unset = std::move(unset),
+                            },
+                    .capture = this->shared->capture_of(tag.capture),
                 };
+                co_return this->ignore_descendants(std::move(modified),
+                                                   tag.ignoreDescendants.value_or(false));
             }
-            // TODO: handle js::ActionType::abort
-            default: {
-                throw cpptrace::runtime_error("Unhandled action type");
+            case js::ActionType::fake: {
+                // the proxy runs the command with the hook if it can not fake it
+                auto fake = this->skip(std::move(cmd),
+                                       std::move(requested),
+                                       this->shared->capture_of(std::nullopt));
+                fake.type = data::action::FAKE;
+                co_return this->ignore_descendants(
+                    std::move(fake),
+                    act.get<js::ActionType::fake>().ignoreDescendants.value_or(false));
+            }
+            case js::ActionType::abort: {
+                // the command fails, which stops the build as a failing command would, and catter
+                // fails once it is over
+                this->shared->errors += std::format("The script aborted at command {}\n", this->id);
+                co_return data::action{.type = data::action::ABORT, .cmd = {}};
             }
         }
+        throw cpptrace::runtime_error("Unhandled action type");
+    }
+
+    kota::task<> started(int64_t pid) override {
+        this->shared->processes.started(this->id, pid);
+        co_return;
+    }
+
+    kota::task<> detach() override {
+        // catter never hears of the exit, the oldest commands are taken as exited instead so a
+        // long build does not grow the tables, `RESEND` recovers a command which still refers
+        // to one
+        auto& detached = this->shared->detached;
+        detached.push_back(this->id);
+        if(detached.size() > config::core::DETACHED_COMMANDS_KEPT) {
+            this->shared->exited(detached.front());
+            detached.pop_front();
+        }
+        co_return;
     }
 
     kota::task<> finish(data::process_result result) override {
+        this->shared->exited(this->id);
+        if(this->shared->log.has_value()) {
+            this->shared->log->result(this->id, result);
+        }
+        if(auto it = this->shared->observing.find(this->id); it != this->shared->observing.end()) {
+            // the script hears of the command before its result, if it hears of it at all
+            auto answered = it->second;
+            co_await answered->wait();
+        }
+        if(this->shared->hidden.contains(this->id) && !this->shared->cached.erase(this->id)) {
+            co_return;
+        }
         co_await js::on_execution(this->id, to_js_process_result(std::move(result)));
         co_return;
     }
 
     kota::task<> report_error(data::ipcid_t parent_id, std::string error_msg) override {
+        if(this->shared->log.has_value()) {
+            this->shared->log->error(this->id, parent_id, error_msg);
+        }
         co_await js::on_command(
             id,
-            std::unexpected(js::CatterErr{.msg = std::move(error_msg), .parent = parent_id}));
+            std::unexpected(js::CatterErr{
+                .msg = std::move(error_msg),
+                .parent = this->shared->visible(parent_id),
+            }));
         co_return;
     }
 
+    /// Wait until `onCommand` answered every observed command, see `options.observeOnly`.
+    /// @throws cpptrace::runtime_error with what it threw for them, and where the script aborted.
+    static kota::task<> drain(std::shared_ptr<Shared> shared) {
+        while(!shared->observing.empty()) {
+            auto answered = shared->observing.begin()->second;
+            co_await answered->wait();
+        }
+        if(!shared->errors.empty()) {
+            throw cpptrace::runtime_error(std::exchange(shared->errors, {}));
+        }
+    }
+
     struct Factory {
         const js::CatterRuntime* runtime;
+        std::shared_ptr<Shared> shared = std::make_shared<Shared>();
 
         std::unique_ptr<InjectService> operator() (data::ipcid_t id) const {
-            return std::make_unique<InjectService>(id, runtime);
+            return std::make_unique<InjectService>(id, runtime, shared);
         }
     };
 
 private:
+    void hide() {
+        this->shared->hide(this->id, this->parent_id);
+    }
+
+    /// Materializes the environment of the command once, when the script first reads it.
+    static js::EnvLoader env_loader(EnvStore::Ref requested) {
+        auto requested_env = std::make_shared<std::optional<std::vector<std::string>>>();
+        return [requested = std::move(requested), requested_env]() {
+            if(!requested_env->has_value()) {
+                *requested_env = EnvStore::materialize(requested);
+            }
+            return **requested_env;
+        };
+    }
+
+    static js::CommandData command_data(const Shared& shared,
+                                        const js::CatterRuntime* runtime,
+                                        data::ipcid_t parent_id,
+                                        const data::command& cmd) {
+        return js::CommandData{
+            .cwd = cmd.cwd,
+            .exe = cmd.executable,
+            .argv = cmd.args,
+            .runtime = *runtime,
+            .parent = shared.visible(parent_id),
+            .origin = to_js_origin(cmd.origin),
+        };
+    }
+
+    /**
+     * Let the script see the command while it already runs. The action it returns only decides
+     * whether the descendants of the command are ignored and what the cache keeps, the command
+     * itself was skipped.
+     */
+    static kota::task<> observe(std::shared_ptr<Shared> shared,
+                                data::ipcid_t id,
+                                js::CommandData data,
+                                js::EnvLoader load_env,
+                                std::optional<uint64_t> cache_key) {
+        try {
+            auto act = co_await js::on_command(id, std::move(data), std::move(load_env));
+            if(cache_key.has_value()) {
+                // the command ran as skipped, whatever the script answered
+                remember(*shared, *cache_key, act, true);
+            }
+            bool ignore = act.visit([]<auto E>(const js::Tag<E>& tag) -> bool {
+                if constexpr(requires { tag.ignoreDescendants; }) {
+                    return tag.ignoreDescendants.value_or(false);
+                }
+                return false;
+            });
+            if(ignore) {
+                shared->ignored.insert(id);
+            }
+            if(act.type() == js::ActionType::abort) {
+                // the command already runs, the build fails once it is over
+                shared->errors += std::format("The script aborted at observed command {}\n", id);
+            }
+        } catch(const std::exception& ex) {
+            shared->errors +=
+                std::format("Exception in observed command {}: {}\n", id, ex.what());
+        }
+
+        auto node = shared->observing.extract(id);
+        node.mapped()->set();
+    }
+
+    /**
+     * Decide a command which was skipped while `onCommand` of its parent ran, once it returned,
+     * as `make_decision` would have. Only what the command was run with can not change: a
+     * command ignored or answered from the cache this way still ran with the hook.
+     */
+    static kota::task<> settle(std::shared_ptr<Shared> shared,
+                               const js::CatterRuntime* runtime,
+                               data::ipcid_t id,
+                               data::ipcid_t parent_id,
+                               data::command cmd,
+                               EnvStore::Ref requested,
+                               std::shared_ptr<kota::event> parent) {
+        co_await parent->wait();
+
+        bool ignore = shared->ignored.contains(parent_id);
+        bool decided = ignore || shared->rules.match(cmd.executable, cmd.args).has_value();
+        std::optional<uint64_t> cache_key;
+        if(!ignore && shared->cache.has_value()) {
+            cache_key = shared->cache_key_of(cmd, requested);
+            if(const auto* entry = shared->cache->find(*cache_key)) {
+                shared->cached_states.push_back(entry->state);
+                shared->cached.insert(id);
+                ignore = entry->ignore_descendants;
+                decided = true;
+            }
+        }
+        if(!decided) {
+            auto data = command_data(*shared, runtime, parent_id, cmd);
+            auto load_env = env_loader(std::move(requested));
+            co_await observe(shared, id, std::move(data), std::move(load_env), cache_key);
+            co_return;
+        }
+
+        shared->hide(id, parent_id);
+        if(ignore) {
+            shared->ignored.insert(id);
+        }
+        auto node = shared->observing.extract(id);
+        node.mapped()->set();
+    }
+
+    /**
+     * Keep the decision if the script asked to cache it, see `ctx.cache`.
+     *
+     * @param observed the action was not applied, the command is kept as skipped.
+     */
+    static void remember(Shared& shared,
+                         uint64_t key,
+                         const js::Action& act,
+                         bool observed = false) {
+        std::optional<DecisionCache::Entry> entry = act.visit(
+            [&]<auto E>(const js::Tag<E>& tag) -> std::optional<DecisionCache::Entry> {
+                if constexpr(requires { tag.cache; }) {
+                    if(tag.cache.has_value()) {
+                        DecisionCache::Entry entry{
+                            .action = E,
+                            .ignore_descendants = tag.cache->ignoreDescendants,
+                            .state = tag.cache->state,
+                        };
+                        if constexpr(requires { tag.capture; }) {
+                            entry.capture = tag.capture;
+                        }
+                        return entry;
+                    }
+                }
+                return std::nullopt;
+            });
+        if(entry.has_value()) {
+            if(observed) {
+                entry->action = js::ActionType::skip;
+                entry->capture.reset();
+            }
+            shared.cache->store(key, std::move(*entry));
+        }
+    }
+
+    /// Answer the command as the script did in an earlier run, without asking it.
+    data::action replay(const DecisionCache::Entry& entry,
+                        data::command cmd,
+                        EnvStore::Ref requested) {
+        this->hide();
+        this->shared->cached_states.push_back(entry.state);
+        this->shared->cached.insert(this->id);
+
+        switch(entry.action) {
+            case js::ActionType::drop: {
+                return data::action{.type = data::action::DROP, .cmd = {}};
+            }
+            case js::ActionType::fake: {
+                auto fake = this->skip(std::move(cmd),
+                                       std::move(requested),
+                                       this->shared->capture_of(std::nullopt));
+                fake.type = data::action::FAKE;
+                return this->ignore_descendants(std::move(fake), entry.ignore_descendants);
+            }
+            default: {
+                return this->ignore_descendants(this->skip(std::move(cmd),
+                                                           std::move(requested),
+                                                           this->shared->capture_of(entry.capture)),
+                                                entry.ignore_descendants);
+            }
+        }
+    }
+
+    /**
+     * Run the command without the hook, so catter does not hear of its descendants. Those which
+     * reach it anyway, from a process the hook could not leave, are skipped natively.
+     */
+    data::action ignore_descendants(data::action act, bool ignore = true) {
+        if(ignore) {
+            this->shared->ignored.insert(this->id);
+            act.ignore_descendants = true;
+        }
+        return act;
+    }
+
+    /// Run the command as requested, with the hook.
+    data::action skip(data::command cmd, EnvStore::Ref requested, data::CaptureMode capture) {
+        this->shared->envs.store(this->id, std::move(requested));
+        return data::action{
+            .type = data::action::INJECT,
+            .cmd = {
+                    .cwd = std::move(cmd.cwd),
+                    .executable = std::move(cmd.executable),
+                    .args = std::move(cmd.args),
+                    .env_base = this->id,
+                    },
+            .capture = capture,
+        };
+    }
+
     data::ipcid_t id = 0;
     data::ipcid_t parent_id = 0;
     const js::CatterRuntime* runtime = nullptr;
+    std::shared_ptr<Shared> shared;
 };
 
+InjectService::Factory make_factory(const js::CatterConfig& config) {
+    InjectService::Factory factory{.runtime = &config.runtime};
+    if(config.options.rules.has_value()) {
+        factory.shared->rules = RuleTable::compile(*config.options.rules);
+    }
+    if(config.options.capture.has_value()) {
+        factory.shared->capture = to_capture_mode(*config.options.capture);
+    }
+    factory.shared->observe_only = config.options.observeOnly.value_or(false);
+    return factory;
+}
+
 class InjectRuntimeDriver final : public RuntimeDriver {
 public:
     std::string_view name() const noexcept override {
@@ -107,7 +567,11 @@ public:
 
     const js::CatterRuntime& runtime() const noexcept override {
         const static js::CatterRuntime value{
-            .supportActions = {js::ActionType::drop, js::ActionType::skip, js::ActionType::modify},
+            .supportActions = {js::ActionType::drop,
+                               js::ActionType::skip,
+                               js::ActionType::abort,
+                               js::ActionType::modify,
+                               js::ActionType::fake},
             .type = js::CatterRuntime::Type::inject,
             .supportParentId = true,
         };
@@ -127,18 +591,133 @@ public:
                 {
                        proxy_path.string(),
                        "-p", "0",
-                       "--", },
+                       "--ipc", std::string(config::ipc::pipe_name()),
+                       },
             .mode = to_process_stdio_mode(
                 config.options.stdioMode.value_or(js::CatterOptions::StdioMode::inherit)),
         };
+
+        const bool direct = config.options.directHook.value_or(false);
+        if(direct) {
+#ifdef CATTER_WINDOWS
+            throw cpptrace::runtime_error("directHook is not supported on Windows");
+#else
+            launch_plan.args.emplace_back("--direct");
+            launch_plan.args.emplace_back(config::ipc::direct_pipe_name());
+#endif
+        }
+
+        auto factory = make_factory(config);
+        std::filesystem::path filter_path;
+#ifndef CATTER_WINDOWS
+        // a recorded build must see every command, the hook would not report the filtered ones
+        if(!config.options.record.has_value()) {
+            if(auto globs = factory.shared->rules.pass_through(); !globs.empty()) {
+                filter_path = config::ipc::exec_filter_path();
+                publish_exec_filter(filter_path, globs);
+                launch_plan.args.emplace_back("--exec-filter");
+                launch_plan.args.emplace_back(filter_path.string());
+                LOG_INFO("{} executables run without asking, see {}",
+                         globs.size(),
+                         filter_path.string());
+            }
+        }
+#endif
+        auto remove_filter = util::make_guard([&filter_path]() noexcept {
+            if(!filter_path.empty()) {
+                std::error_code ec;
+                std::filesystem::remove(filter_path, ec);
+            }
+        });
+
+        launch_plan.args.emplace_back("--");
         util::append_range_to_vector(launch_plan.args, config.buildSystemCommand);
 
+        std::filesystem::path cache_path;
+        if(config.options.decisionCache.value_or(false)) {
+            cache_path = decision_cache_path(config);
+            factory.shared->cache = DecisionCache::load(cache_path, script_fingerprint(config));
+            factory.shared->cache_env = decision_cache_env(config);
+        }
+        if(config.options.record.has_value()) {
+            factory.shared->log.emplace(*config.options.record,
+                                        config.buildSystemCommandCwd,
+                                        config.buildSystemCommand);
+        }
+        auto shared = factory.shared;
+
         Session session;
         auto session_plan =
-            Session::make_run_plan(std::move(launch_plan),
-                                   InjectService::Factory{.runtime = &config.runtime});
+            Session::make_run_plan(std::move(launch_plan), std::move(factory), direct);
+        if(config.options.ipcBacklog.has_value()) {
+            session_plan.backlog = static_cast<int>(*config.options.ipcBacklog);
+        }
+
+        auto result = co_await session.run(std::move(session_plan));
+        co_await InjectService::drain(shared);
+        if(shared->log.has_value()) {
+            shared->log->finish(result);
+        }
 
-        co_return co_await session.run(std::move(session_plan));
+        if(shared->cache.has_value()) {
+            LOG_INFO("{} commands answered from the decision cache {}",
+                     shared->cached_states.size(),
+                     cache_path.string());
+            if(shared->cache->modified()) {
+                shared->cache->save(cache_path);
+            }
+            if(!shared->cached_states.empty()) {
+                co_await js::on_merge(std::move(shared->cached_states));
+            }
+        }
+        co_return result;
+    }
+
+private:
+    /// Written once before the build starts, the hook maps it read-only.
+    static void publish_exec_filter(const std::filesystem::path& path,
+                                    const std::vector<std::string>& globs) {
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        auto content = util::ExecFilter::encode(globs);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        if(!file.good()) {
+            throw cpptrace::runtime_error(
+                std::format("Failed to write exec filter {}", path.string()));
+        }
+    }
+
+    /// Everything besides the command which changes what the script decides.
+    static uint64_t script_fingerprint(const js::CatterConfig& config) {
+        return Fingerprint()
+            .add(js::library_source())
+            .add(app::load_script_content(config.scriptPath))
+            .add(config.scriptArgs)
+            .add(decision_cache_env(config))
+            .value();
+    }
+
+    /// `DecisionCache::compiler_env` and `options.decisionCacheEnv`, sorted.
+    static std::vector<std::string> decision_cache_env(const js::CatterConfig& config) {
+        std::vector<std::string> env(DecisionCache::compiler_env.begin(),
+                                     DecisionCache::compiler_env.end());
+        util::append_range_to_vector(
+            env,
+            config.options.decisionCacheEnv.value_or(std::vector<std::string>{}));
+        std::ranges::sort(env);
+        auto [first, last] = std::ranges::unique(env);
+        env.erase(first, last);
+        return env;
+    }
+
+    static std::filesystem::path decision_cache_path(const js::CatterConfig& config) {
+        auto id = Fingerprint()
+                      .add(std::filesystem::absolute(config.buildSystemCommandCwd).string())
+                      .add(config.scriptPath)
+                      .value();
+        return util::get_catter_data_path() / config::core::DECISION_CACHE_DIR_REL /
+               std::format("{:016x}.bin", id);
     }
 };
 
@@ -166,11 +745,74 @@ const RuntimeDriver& default_runtime_driver() noexcept {
     return inject_runtime_driver();
 }
 
+kota::task<data::process_result> replay(EventLogReader& log, const js::CatterConfig& config) {
+    auto factory = make_factory(config);
+    std::unordered_map<data::ipcid_t, std::unique_ptr<InjectService>> running;
+    data::process_result result;
+    bool finished = false;
+    std::string error_msg;
+
+    while(auto event = log.next()) {
+        try {
+            switch(event->type) {
+                case LogEvent::COMMAND: {
+                    auto service = factory(event->id);
+                    co_await service->create(event->parent);
+                    co_await service->make_decision(std::move(event->cmd));
+                    running.insert_or_assign(event->id, std::move(service));
+                    break;
+                }
+                case LogEvent::CAPTURE_ERROR: {
+                    co_await factory(event->id)->report_error(event->parent,
+                                                              std::move(event->error));
+                    break;
+                }
+                case LogEvent::RESULT: {
+                    // the command may have been decided without a result being kept
+                    if(auto node = running.extract(event->id)) {
+                        co_await node.mapped()->finish(std::move(event->result));
+                    }
+                    break;
+                }
+                case LogEvent::FINISH: {
+                    result = std::move(event->result);
+                    finished = true;
+                    break;
+                }
+            }
+        } catch(const std::exception& ex) {
+            // like a session, one failed command does not stop the others
+            error_msg +=
+                std::format("Exception in replayed command {}: {}\n", event->id, ex.what());
+        }
+    }
+    try {
+        co_await InjectService::drain(factory.shared);
+    } catch(const std::exception& ex) {
+        error_msg += ex.what();
+    }
+
+    if(!error_msg.empty()) {
+        throw cpptrace::runtime_error(std::move(error_msg));
+    }
+    if(!finished) {
+        LOG_WARN("The event log ends before the build, it was cut short");
+    }
+    co_return result;
+}
+
 js::ProcessResult to_js_process_result(data::process_result result) {
     return js::ProcessResult{
         .code = result.code,
         .stdOut = std::move(result.std_out),
         .stdErr = std::move(result.std_err),
+        .stats = js::ProcessStats{.pid = result.stats.pid,
+                                  .spawn = result.stats.spawn,
+                                  .exec = result.stats.exec,
+                                  .exit = result.stats.exit,
+                                  .userTime = result.stats.user_time,
+                                  .systemTime = result.stats.system_time,
+                                  .maxRss = result.stats.max_rss},
     };
 }
 
@@ -3,6 +3,7 @@
 #include <string_view>
 #include <kota/async/runtime/task.h>
 
+#include "event_log.h"
 #include "js/capi/type.h"
 #include "util/data.h"
 
@@ -22,4 +23,12 @@ const RuntimeDriver& default_runtime_driver() noexcept;
 
 js::ProcessResult to_js_process_result(data::process_result result);
 
+/**
+ * Feed the build recorded in `log` to the script as the inject driver would, with the rules of
+ * `config`, without running anything. The decision cache is neither read nor written.
+ *
+ * @return the recorded result of the build, or an exit code of -1 if the log ends before it.
+ */
+kota::task<data::process_result> replay(EventLogReader& log, const js::CatterConfig& config);
+
 }  // namespace catter::core
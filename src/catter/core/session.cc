@@ -2,11 +2,15 @@
 
 #include <cassert>
 #include <format>
-#include <list>
+#include <memory>
 #include <optional>
-#include <ranges>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <cpptrace/exceptions.hpp>
 #include <kota/async/async.h>
 
@@ -19,56 +23,94 @@
 
 namespace catter {
 
-kota::task<data::process_result> Session::run(RunPlan run_plan) {
+namespace {
+
+std::unique_ptr<Session::PipeAcceptor> listen_on(std::string_view name, int backlog) {
 #ifndef _WIN32
-    if(std::filesystem::exists(config::ipc::pipe_name())) {
-        std::filesystem::remove(config::ipc::pipe_name());
+    if(std::filesystem::exists(name)) {
+        std::filesystem::remove(name);
     }
 #endif
-    auto& current_loop = kota::event_loop::current();
-    auto acc_ret =
-        kota::pipe::listen(config::ipc::pipe_name(), kota::pipe::options(), current_loop);
+    kota::pipe::options options;
+    options.backlog = backlog;
+    auto acc_ret = kota::pipe::listen(name, options, kota::event_loop::current());
 
     if(!acc_ret) {
         throw cpptrace::runtime_error(
             std::format("Failed to create acceptor: {}", acc_ret.error().message()));
     }
+    return std::make_unique<Session::PipeAcceptor>(std::move(*acc_ret));
+}
+
+/// Run `client`, then hand its id to `finished` so that the loop can drop its task.
+kota::task<void> track(kota::task<void> client,
+                       data::ipcid_t id,
+                       std::vector<data::ipcid_t>& finished,
+                       std::string& error_msg) {
+    try {
+        co_await std::move(client);
+    } catch(const std::exception& ex) {
+        error_msg += std::format("Exception in client task: {}\n", ex.what());
+    }
+    finished.push_back(id);
+}
 
-    this->acc = std::make_unique<PipeAcceptor>(std::move(*acc_ret));
+}  // namespace
 
-    auto loop_task = this->loop(std::move(run_plan.callback));
+kota::task<data::process_result> Session::run(RunPlan run_plan) {
+    this->acc = listen_on(config::ipc::pipe_name(), run_plan.backlog);
+
+    kota::task<void> direct_task = []() -> kota::task<void> { co_return; }();
+    if(run_plan.direct_callback.has_value()) {
+#ifdef CATTER_WINDOWS
+        throw cpptrace::runtime_error("The direct path is not supported on Windows");
+#else
+        this->direct_acc = listen_on(config::ipc::direct_pipe_name(), run_plan.backlog);
+        direct_task = this->loop(*this->direct_acc, std::move(*run_plan.direct_callback));
+#endif
+    }
+
+    auto loop_task = this->loop(*this->acc, std::move(run_plan.callback));
     auto spawn_task = this->spawn(std::move(run_plan.launch_plan.executable),
                                   std::move(run_plan.launch_plan.args),
                                   std::move(run_plan.launch_plan.cwd),
                                   run_plan.launch_plan.mode);
 
-    auto [_, process_result] = co_await kota::when_all{std::move(loop_task), std::move(spawn_task)};
+    auto [_1, _2, process_result] = co_await kota::when_all{std::move(loop_task),
+                                                            std::move(direct_task),
+                                                            std::move(spawn_task)};
     co_return std::move(process_result);
 }
 
-kota::task<void> Session::loop(ClientAcceptor acceptor) {
-    std::list<kota::task<void>> linked_clients;
-    for(auto i: std::views::iota(data::ipcid_t(1))) {
-        auto client = co_await this->acc->accept();
+kota::task<void> Session::loop(PipeAcceptor& acc, ClientAcceptor acceptor) {
+    // a build runs far more commands than it runs at once, so the tasks of the clients which are
+    // done are dropped as the loop goes instead of being kept until the build exits
+    std::unordered_map<data::ipcid_t, kota::task<void>> linked_clients;
+    std::vector<data::ipcid_t> finished;
+    std::string error_msg;
+
+    while(true) {
+        auto client = co_await acc.accept();
+        for(auto id: finished) {
+            linked_clients.erase(id);
+        }
+        finished.clear();
         if(!client) {
             assert(client.error() == kota::error::operation_aborted);
             // Accept can fail with operation_aborted when the acceptor is stopped, which is
             // expected
             break;
         }
-        linked_clients.push_back(acceptor(i, std::move(*client)));
-        kota::event_loop::current().schedule(linked_clients.back());
-        LOG_INFO("Accepted new client with id: {}", i);
+        auto id = this->next_id++;
+        auto [it, _] = linked_clients.emplace(
+            id,
+            track(acceptor(id, std::move(*client)), id, finished, error_msg));
+        kota::event_loop::current().schedule(it->second);
+        LOG_INFO("Accepted new client with id: {}", id);
     }
 
-    std::string error_msg;
-
-    for(auto& client_task: linked_clients) {
-        try {
-            client_task.result();  // Await completion and propagate exceptions
-        } catch(const std::exception& ex) {
-            error_msg += std::format("Exception in client task: {}\n", ex.what());
-        }
+    for(auto& [_, client_task]: linked_clients) {
+        client_task.result();  // Await completion, `track` keeps the exceptions in `error_msg`
     }
     if(!error_msg.empty()) {
         throw cpptrace::runtime_error(std::move(error_msg));
@@ -76,21 +118,32 @@ kota::task<void> Session::loop(ClientAcceptor acceptor) {
     co_return;
 }
 
+void Session::stop_acceptors() noexcept {
+    for(auto* acceptor: {&this->acc, &this->direct_acc}) {
+        if(*acceptor) {
+            auto err = (*acceptor)->stop();
+            acceptor->reset();
+            if(err.has_error()) {
+                LOG_ERROR("Failed to stop acceptor: {}", err.message());
+            }
+        }
+    }
+#ifndef _WIN32
+    // the names are unique to this catter, nobody would reuse and remove them later
+    for(auto name: {config::ipc::pipe_name(), config::ipc::direct_pipe_name()}) {
+        std::error_code ec;
+        std::filesystem::remove(name, ec);
+    }
+#endif
+}
+
 kota::task<data::process_result> Session::spawn(std::string executable,
                                                 std::vector<std::string> args,
                                                 std::string cwd,
                                                 StdioMode mode) {
     // for exception safety: ensure acceptor is stopped when spawn exits, since spawn failure should
     // prevent the session from running
-    auto guard = util::make_guard([&]() noexcept {
-        if(this->acc) {
-            auto err = this->acc->stop();
-            this->acc.reset();
-            if(err.has_error()) {
-                LOG_ERROR("Failed to stop acceptor: {}", err.message());
-            }
-        }
-    });
+    auto guard = util::make_guard([&]() noexcept { this->stop_acceptors(); });
 
     std::string args_str;
     for(const auto& arg: args) {
@@ -114,9 +167,15 @@ kota::task<data::process_result> Session::spawn(std::string executable,
 
     switch(mode) {
         case StdioMode::inherit:
-            co_return co_await capture_process_result(make_process_event(opts), stdout, stderr);
+            co_return co_await capture_process_result(make_process_event(opts),
+                                                      data::CaptureMode::TAIL,
+                                                      stdout,
+                                                      stderr);
         case StdioMode::capture:
-            co_return co_await capture_process_result(make_process_event(opts), nullptr, nullptr);
+            co_return co_await capture_process_result(make_process_event(opts),
+                                                      data::CaptureMode::TAIL,
+                                                      nullptr,
+                                                      nullptr);
     }
 
     std::abort();
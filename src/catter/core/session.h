@@ -4,8 +4,8 @@
 #include <cstdint>
 #include <filesystem>
 #include <format>
-#include <list>
 #include <memory>
+#include <optional>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -14,6 +14,7 @@
 #include <kota/async/async.h>
 
 #include "ipc.h"
+#include "config/ipc.h"
 #include "util/data.h"
 
 namespace catter {
@@ -53,25 +54,40 @@ public:
     struct RunPlan {
         ProcessLaunchPlan launch_plan;
         ClientAcceptor callback;
+        /// Serves the direct path of the hook payload, disabled when empty.
+        std::optional<ClientAcceptor> direct_callback = std::nullopt;
+        /// Connections the sockets queue before a proxy has to wait, see `config::ipc::BACKLOG`.
+        int backlog = config::ipc::BACKLOG;
     };
 
     /**
      * Create a run plan with the given launch plan and client accepted callback.
      * @param launch_plan The plan for launching the process.
      * @param factory The factory for creating service instances when a client is accepted.
+     * @param direct Whether to also listen on the direct path socket.
      * @return A run plan containing the launch plan and client accepted callback.
      */
     template <typename ServiceFactoryType>
         requires ServiceFactoryLike<std::decay_t<ServiceFactoryType>>
-    static auto make_run_plan(ProcessLaunchPlan launch_plan, ServiceFactoryType&& factory) {
-        return RunPlan{
+    static auto make_run_plan(ProcessLaunchPlan launch_plan,
+                              ServiceFactoryType&& factory,
+                              bool direct = false) {
+        auto shared_factory = std::make_shared<std::decay_t<ServiceFactoryType>>(
+            std::forward<ServiceFactoryType>(factory));
+
+        RunPlan plan{
             .launch_plan = std::move(launch_plan),
             .callback =
-                [factory = std::forward<ServiceFactoryType>(factory)](data::ipcid_t id,
-                                                                      kota::pipe&& client) {
-                    return ipc::accept(factory(id), std::move(client));
+                [shared_factory](data::ipcid_t id, kota::pipe&& client) {
+                    return ipc::accept((*shared_factory)(id), std::move(client));
                 },
         };
+        if(direct) {
+            plan.direct_callback = [shared_factory](data::ipcid_t id, kota::pipe&& client) {
+                return ipc::accept_direct((*shared_factory)(id), std::move(client));
+            };
+        }
+        return plan;
     }
 
     /**
@@ -83,7 +99,9 @@ public:
     kota::task<data::process_result> run(RunPlan run_plan);
 
 private:
-    kota::task<void> loop(ClientAcceptor acceptor);
+    kota::task<void> loop(PipeAcceptor& acc, ClientAcceptor acceptor);
+
+    void stop_acceptors() noexcept;
 
     kota::task<data::process_result> spawn(std::string executable,
                                            std::vector<std::string> args,
@@ -91,6 +109,9 @@ private:
                                            StdioMode mode);
 
     std::unique_ptr<PipeAcceptor> acc = nullptr;
+    std::unique_ptr<PipeAcceptor> direct_acc = nullptr;
+    /// Shared by all acceptors, so ids stay unique within the session.
+    data::ipcid_t next_id = 1;
 };
 
 }  // namespace catter
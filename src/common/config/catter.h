@@ -1,5 +1,10 @@
 #pragma once
+#include <cstddef>
 
 namespace catter::config::core {
 constexpr static char LOG_PATH_REL[] = "log/catter.log";
+/// One file per build directory and script, see `core::DecisionCache`.
+constexpr static char DECISION_CACHE_DIR_REL[] = "cache/decisions";
+/// Commands of the direct path known at once, catter never hears of their exit.
+constexpr static std::size_t DETACHED_COMMANDS_KEPT = 4096;
 };  // namespace catter::config::core
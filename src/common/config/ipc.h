@@ -1,15 +1,73 @@
 #pragma once
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <string>
+#include <string_view>
+
 #include "util/crossplat.h"
 
+#ifndef CATTER_WINDOWS
+#include <sys/un.h>
+#endif
+
+/// The sockets are named after the catter process listening on them, so that several catter
+/// runs do not steal each other's clients. Only catter itself may call these, the proxy and the
+/// hook are handed the names by their parent.
 namespace catter::config::ipc {
 
+/// Pending connections a socket of catter queues, a parallel build connects many proxies at once.
+constexpr static int BACKLOG = 1024;
+
+/// Tells apart the sockets of this catter from those of others running at the same time.
+inline std::string_view session_id() {
+    static std::string id = std::format("{:016x}", util::unique_id());
+    return id;
+}
+
+#ifndef CATTER_WINDOWS
+/**
+ * @return `name` in the data directory of catter, or in `$XDG_RUNTIME_DIR` or `/tmp` if that path
+ * does not fit in `sockaddr_un::sun_path`, 108 bytes on Linux and 104 on macOS.
+ */
+inline std::string socket_path(std::string_view name) {
+    constexpr auto limit = sizeof(sockaddr_un{}.sun_path);
+    auto path = (util::get_catter_data_path() / name).string();
+    if(path.size() < limit) {
+        return path;
+    }
+    if(const char* runtime = std::getenv("XDG_RUNTIME_DIR"); runtime != nullptr && *runtime) {
+        path = (std::filesystem::path(runtime) / name).string();
+        if(path.size() < limit) {
+            return path;
+        }
+    }
+    return (std::filesystem::path("/tmp") / name).string();
+}
+#endif
+
 inline std::string_view pipe_name() {
 #ifdef CATTER_WINDOWS
-    return R"(\\.\pipe\catter-ipc)";
+    static std::string path = std::format(R"(\\.\pipe\catter-ipc-{})", session_id());
 #else
-    static std::string path = util::get_catter_data_path() / "pipe-catter-ipc.sock";
-    return path;
+    static std::string path = socket_path(std::format("pipe-catter-ipc-{}.sock", session_id()));
 #endif
+    return path;
+}
+
+#ifndef CATTER_WINDOWS
+/// Socket the hook payload connects to when the direct path is enabled.
+inline std::string_view direct_pipe_name() {
+    static std::string path = socket_path(std::format("pipe-catter-direct-{}.sock", session_id()));
+    return path;
 }
 
+/// File of the executables the hook payload runs without asking, see `util/exec_filter.h`.
+inline std::string_view exec_filter_path() {
+    static std::string path =
+        (util::get_catter_data_path() / std::format("exec-filter-{}.bin", session_id())).string();
+    return path;
+}
+#endif
+
 }  // namespace catter::config::ipc
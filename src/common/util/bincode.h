@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <kota/ipc/codec/bincode.h>
+
+/**
+ * Length-prefixed frames of values in the bincode of kotatsu, the encoding `BincodePeer` speaks,
+ * for the sockets and files which are not served by a peer: the direct path, the event log and
+ * the decision cache.
+ *
+ * A frame is a little-endian `u32` body length followed by the body.
+ */
+namespace catter::bincode {
+
+/// Size of the frame header.
+constexpr inline std::size_t frame_header_size = 4;
+
+/// @return the value as a frame, nullopt if it can not be encoded.
+template <typename T>
+std::optional<std::string> frame(const T& value) {
+    auto bytes = kota::codec::bincode::to_bytes(value);
+    if(!bytes.has_value()) {
+        return std::nullopt;
+    }
+    auto size = static_cast<uint32_t>(bytes->size());
+    std::string buffer;
+    buffer.reserve(frame_header_size + bytes->size());
+    for(int shift = 0; shift < 32; shift += 8) {
+        buffer.push_back(static_cast<char>((size >> shift) & 0xFF));
+    }
+    buffer.append(reinterpret_cast<const char*>(bytes->data()), bytes->size());
+    return buffer;
+}
+
+/// @return the body size in a frame header, `header` holds at least `frame_header_size` bytes.
+inline uint32_t body_size(std::string_view header) noexcept {
+    uint32_t size = 0;
+    for(int i = 0; i < static_cast<int>(frame_header_size); ++i) {
+        size |= static_cast<uint32_t>(static_cast<uint8_t>(header[i])) << (i * 8);
+    }
+    return size;
+}
+
+/// @return the total size of the first frame in `buffered`, or nullopt if it is incomplete.
+inline std::optional<std::size_t> frame_size(std::string_view buffered) noexcept {
+    if(buffered.size() < frame_header_size) {
+        return std::nullopt;
+    }
+    auto size = body_size(buffered);
+    if(buffered.size() - frame_header_size < size) {
+        return std::nullopt;
+    }
+    return frame_header_size + size;
+}
+
+/// @param body a frame body, without the frame header.
+/// @return nullopt if `body` is not a `T`.
+template <typename T>
+std::optional<T> decode(std::string_view body) {
+    auto value =
+        kota::codec::bincode::from_bytes<T>(std::as_bytes(std::span(body.data(), body.size())));
+    if(!value.has_value()) {
+        return std::nullopt;
+    }
+    return std::move(*value);
+}
+
+}  // namespace catter::bincode
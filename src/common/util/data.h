@@ -1,8 +1,10 @@
 #pragma once
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 #include <kota/ipc/protocol.h>
 
 namespace catter::data {
@@ -10,17 +12,49 @@ namespace catter::data {
 using ipcid_t = int32_t;
 using timestamp_t = uint64_t;
 
+/// The process which asked to run a command, as the hook saw it. 0 where unknown.
+struct process_origin {
+    int64_t pid = 0;   // The process which called exec or spawn
+    int64_t ppid = 0;  // Its parent, 0 on Windows
+    int64_t tid = 0;   // The thread which made the call
+};
+
 struct command {
     std::string cwd{};
     std::string executable{};
     std::vector<std::string> args{};
     std::vector<std::string> env{};
+    /// If set, `env` only holds the entries changed against the environment of command
+    /// `env_base`, and `env_unset` the keys removed from it. See `util/env_delta.h`.
+    std::optional<ipcid_t> env_base{};
+    std::vector<std::string> env_unset{};
+    /// Only sent to catter, which ignores it in the commands it answers with.
+    process_origin origin{};
+};
+
+/// Where the time of a command went, timestamps are microseconds since the Unix epoch.
+struct process_stats {
+    int64_t pid = 0;
+    int64_t spawn = 0;        // The command was intercepted, before catter decided about it
+    int64_t exec = 0;         // The command itself started
+    int64_t exit = 0;         // The command exited
+    int64_t user_time = 0;    // CPU time in user mode, in microseconds
+    int64_t system_time = 0;  // CPU time in kernel mode, in microseconds
+    int64_t max_rss = 0;      // Peak resident set size, in KiB
 };
 
 struct process_result {
     int64_t code = -1;
     std::string std_out{};
     std::string std_err{};
+    process_stats stats{};
+};
+
+/// How much of the output of a command catter keeps for its `process_result`.
+enum class CaptureMode : uint8_t {
+    TAIL,     // Keep the last `PipeProxy::output_limit` bytes of each stream
+    INHERIT,  // Let the command write to the streams of its caller, nothing is kept
+    FULL,     // Keep the whole output
 };
 
 struct action {
@@ -28,15 +62,28 @@ struct action {
         DROP,    // Do not execute the command
         INJECT,  // Inject <catter-payload> into the command
         WRAP,    // Wrap the command execution, and return its exit code
+        FAKE,    // Write placeholders of the outputs instead of executing the command
+        ABORT,   // Fail the command without executing it, the script aborted the build
+        RESEND,  // Catter forgot `env_base`, ask again with the full environment
     } type;
 
     command cmd;
+    CaptureMode capture = CaptureMode::TAIL;
+    /// INJECT and FAKE only: run the command without the hook, so its descendants are not
+    /// reported to catter.
+    bool ignore_descendants = false;
 };
 
 enum class ServiceMode : uint8_t {
     INJECT,
 };
 
+/// What catter decided for a newly created command.
+struct decision {
+    ipcid_t id;
+    action act;
+};
+
 }  // namespace catter::data
 
 namespace catter::ipc {
@@ -46,6 +93,7 @@ enum class RequestType : uint8_t {
     CREATE,
     MAKE_DECISION,
     REPORT_ERROR,
+    HELLO,
     FINISH,
 };
 
@@ -84,12 +132,42 @@ struct Request<RequestType::REPORT_ERROR> {
     constexpr inline static std::string_view method = "report_error";
 };
 
+/// CHECK_MODE, CREATE and MAKE_DECISION in a single round trip.
+template <>
+struct Request<RequestType::HELLO> {
+    struct Params {
+        data::ServiceMode mode;
+        data::ipcid_t parent_id;
+        data::command cmd;
+    };
+
+    /// Empty if catter is not in the requested mode.
+    using Result = std::optional<data::decision>;
+    constexpr inline static std::string_view method = "hello";
+};
+
+/// Answered as soon as catter has the result, before `onExecution` runs.
 template <>
 struct Request<RequestType::FINISH> {
     using Params = data::process_result;
     using Result = std::nullptr_t;
     constexpr inline static std::string_view method = "finish";
 };
+
+/// Messages which expect no response.
+enum class NotificationType : uint8_t {
+    STARTED,
+};
+
+template <NotificationType Type>
+struct Notification;
+
+/// The proxy launched the command, with this pid. Not sent for commands which do not run.
+template <>
+struct Notification<NotificationType::STARTED> {
+    using Params = int64_t;
+    constexpr inline static std::string_view method = "started";
+};
 };  // namespace catter::ipc
 
 namespace kota::ipc::protocol {
@@ -98,4 +176,7 @@ using namespace catter::ipc;
 template <RequestType Type>
 struct RequestTraits<Request<Type>> : Request<Type> {};
 
+template <NotificationType Type>
+struct NotificationTraits<Notification<Type>> : Notification<Type> {};
+
 }  // namespace kota::ipc::protocol
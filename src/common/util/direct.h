@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bincode.h"
+
+/**
+ * Messages of the direct path, where the hook payload asks catter for a decision itself instead of
+ * exec'ing catter-proxy. One connection carries exactly one request and one reply, each a
+ * `bincode::frame`.
+ */
+namespace catter::direct {
+
+constexpr inline uint32_t protocol_version = 4;
+
+struct request {
+    /// Checked first, a payload of another catter gets no answer and falls back.
+    uint32_t version = protocol_version;
+    int32_t parent_id = 0;
+    std::string cwd;
+    std::string executable;
+    std::vector<std::string> args;
+    /// If `env_delta` is set, `env` only holds the entries changed against the environment of
+    /// `parent_id` and `env_unset` the keys removed from it, see `util/env_delta.h`.
+    bool env_delta = false;
+    std::vector<std::string> env;
+    std::vector<std::string> env_unset{};
+    /// The calling process, its parent and the calling thread, see `data::process_origin`.
+    int64_t pid = 0;
+    int64_t ppid = 0;
+    int64_t tid = 0;
+};
+
+struct reply {
+    enum class Type : uint8_t {
+        /// Run the intercepted command as it is, with the hook attached.
+        EXEC_ORIGINAL,
+        /// Run `executable` with `args` instead, with the hook attached.
+        EXEC,
+        /// Run `executable` with `args` instead, without the hook.
+        WRAP,
+        /// Catter can not answer, go through catter-proxy.
+        FALLBACK,
+    };
+    using enum Type;
+
+    Type type = FALLBACK;
+    int32_t id = 0;
+    /// The command always runs in the working directory of the caller: catter wraps one which
+    /// moves elsewhere in catter-proxy, changing it in the caller would not be safe.
+    std::string executable{};
+    std::vector<std::string> args{};
+    /// If set, `env` and `env_unset` are a delta against the environment of the request.
+    bool env_delta = false;
+    std::vector<std::string> env{};
+    std::vector<std::string> env_unset{};
+};
+
+inline std::optional<std::string> encode(const request& req) {
+    return bincode::frame(req);
+}
+
+inline std::optional<std::string> encode(const reply& rep) {
+    return bincode::frame(rep);
+}
+
+/// @param body a frame body, without the frame header.
+inline std::optional<request> decode_request(std::string_view body) {
+    auto req = bincode::decode<request>(body);
+    if(!req.has_value() || req->version != protocol_version) {
+        return std::nullopt;
+    }
+    return req;
+}
+
+/// @param body a frame body, without the frame header.
+inline std::optional<reply> decode_reply(std::string_view body) {
+    auto rep = bincode::decode<reply>(body);
+    if(!rep.has_value() || rep->type > reply::FALLBACK) {
+        return std::nullopt;
+    }
+    return rep;
+}
+
+}  // namespace catter::direct
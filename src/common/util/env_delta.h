@@ -0,0 +1,131 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Environment deltas. Most commands of a build inherit the environment of their parent unchanged,
+ * so it is sent as the entries changed against the parent plus the keys removed from it.
+ *
+ * Header-only and std-only, it is shared with the hook payload.
+ */
+namespace catter::env_delta {
+
+/// Separates keys in a key list, it never appears in an environment key.
+constexpr inline char key_separator = '=';
+
+/// @return the key of a `KEY=VALUE` entry, the whole entry if it has no `=`.
+constexpr std::string_view key_of(std::string_view entry) noexcept {
+    return entry.substr(0, entry.find('='));
+}
+
+inline std::string join_keys(const std::vector<std::string_view>& keys) {
+    std::string joined;
+    for(const auto& key: keys) {
+        if(!joined.empty()) {
+            joined += key_separator;
+        }
+        joined += key;
+    }
+    return joined;
+}
+
+inline std::vector<std::string_view> split_keys(std::string_view joined) {
+    std::vector<std::string_view> keys;
+    while(!joined.empty()) {
+        auto pos = joined.find(key_separator);
+        keys.push_back(joined.substr(0, pos));
+        if(pos == std::string_view::npos) {
+            break;
+        }
+        joined.remove_prefix(pos + 1);
+    }
+    return keys;
+}
+
+/**
+ * Describe `env` as a delta against an environment that differs from it only in `keys`, as
+ * produced by `join_keys`.
+ *
+ * @param env entries convertible to `std::string_view`.
+ */
+template <typename Range>
+void select(const Range& env,
+            std::string_view keys,
+            std::vector<std::string>& changed,
+            std::vector<std::string>& unset) {
+    std::unordered_set<std::string_view> pending;
+    for(auto key: split_keys(keys)) {
+        pending.insert(key);
+    }
+    for(const auto& entry: env) {
+        std::string_view view(entry);
+        if(auto it = pending.find(key_of(view)); it != pending.end()) {
+            pending.erase(it);
+            changed.emplace_back(view);
+        }
+    }
+    unset.assign(pending.begin(), pending.end());
+}
+
+/**
+ * Apply a delta to `env` in place. Entries of `changed` replace the entry with the same key where
+ * it is, or are appended if the key is new.
+ */
+inline void apply(std::vector<std::string>& env,
+                  const std::vector<std::string>& changed,
+                  const std::vector<std::string>& unset) {
+    if(!unset.empty()) {
+        std::unordered_set<std::string_view> removed(unset.begin(), unset.end());
+        std::erase_if(env,
+                      [&](const std::string& entry) { return removed.contains(key_of(entry)); });
+    }
+    if(changed.empty()) {
+        return;
+    }
+
+    std::unordered_map<std::string_view, std::size_t> index;
+    index.reserve(env.size());
+    for(std::size_t i = 0; i < env.size(); ++i) {
+        index.emplace(key_of(env[i]), i);
+    }
+    for(const auto& entry: changed) {
+        if(auto it = index.find(key_of(entry)); it != index.end()) {
+            env[it->second] = entry;
+        } else {
+            env.push_back(entry);
+        }
+    }
+}
+
+/// Compute the delta turning `from` into `to`, the inverse of `apply`.
+inline void diff(const std::vector<std::string>& from,
+                 const std::vector<std::string>& to,
+                 std::vector<std::string>& changed,
+                 std::vector<std::string>& unset) {
+    std::unordered_map<std::string_view, std::string_view> before;
+    before.reserve(from.size());
+    for(const auto& entry: from) {
+        before.emplace(key_of(entry), entry);
+    }
+
+    std::unordered_set<std::string_view> kept;
+    kept.reserve(to.size());
+    for(const auto& entry: to) {
+        auto key = key_of(entry);
+        kept.insert(key);
+        if(auto it = before.find(key); it == before.end() || it->second != entry) {
+            changed.push_back(entry);
+        }
+    }
+    for(const auto& [key, _]: before) {
+        if(!kept.contains(key)) {
+            unset.emplace_back(key);
+        }
+    }
+}
+
+}  // namespace catter::env_delta
@@ -0,0 +1,122 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+/**
+ * Executables the hook payload runs without asking catter, published by catter in a file the
+ * payload maps read-only. Shells, `sed` or `mkdir` are exec'd thousands of times by a configure
+ * step, and a script skips them anyway; for them the payload calls the real `execve` directly
+ * instead of exec'ing catter-proxy.
+ *
+ * The file is a line with the magic and the format version, then one pattern per line, each line
+ * ending in a newline. A pattern is a glob on the file name of the executable, or on its full path
+ * if it contains a separator.
+ */
+namespace catter::util {
+
+/// Match the whole `text` against `pattern`, where `*` matches any run of characters and `?` any
+/// single character.
+constexpr bool glob_match(std::string_view pattern, std::string_view text) noexcept {
+    std::size_t p = 0;
+    std::size_t t = 0;
+    // where to resume after the last `*` if the rest does not match
+    std::size_t star = std::string_view::npos;
+    std::size_t star_text = 0;
+    while(t < text.size()) {
+        if(p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            ++p;
+            ++t;
+        } else if(p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            star_text = t;
+        } else if(star != std::string_view::npos) {
+            p = star + 1;
+            t = ++star_text;
+        } else {
+            return false;
+        }
+    }
+    while(p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+class ExecFilter {
+public:
+    constexpr static std::string_view magic = "catter-exec-filter";
+    constexpr static uint32_t format_version = 1;
+
+    /// Patterns which are empty or hold a newline can not match a path worth filtering, they are
+    /// left out.
+    static std::string encode(std::span<const std::string> patterns) {
+        std::string content = std::format("{} {}\n", magic, format_version);
+        for(const auto& pattern: patterns) {
+            if(!pattern.empty() && pattern.find('\n') == std::string::npos) {
+                content += pattern;
+                content += '\n';
+            }
+        }
+        return content;
+    }
+
+    /// The filter is a view into `data`, which must outlive it. Does not allocate, the payload
+    /// decodes it on the first intercepted call.
+    /// @return nothing if `data` is not a filter of this version.
+    static std::optional<ExecFilter> decode(std::string_view data) noexcept {
+        // a file cut short ends in the middle of a line
+        if(!data.starts_with(magic) || !data.ends_with('\n')) {
+            return std::nullopt;
+        }
+        data.remove_prefix(magic.size());
+        uint32_t version = 0;
+        auto [end, ec] = std::from_chars(data.data() + 1, data.data() + data.size(), version);
+        if(!data.starts_with(' ') || ec != std::errc{} || version != format_version ||
+           *end != '\n') {
+            return std::nullopt;
+        }
+        data.remove_prefix(end + 1 - data.data());
+
+        // an empty pattern only comes from a broken file
+        if(data.starts_with('\n') || data.contains("\n\n")) {
+            return std::nullopt;
+        }
+        ExecFilter filter;
+        filter.patterns = data;
+        return filter;
+    }
+
+    bool empty() const noexcept {
+        return patterns.empty();
+    }
+
+    /// Whether `executable`, a resolved path, is run without asking catter.
+    bool match(std::string_view executable) const noexcept {
+        auto pos = executable.find_last_of("/\\");
+        auto name = pos == std::string_view::npos ? executable : executable.substr(pos + 1);
+        auto rest = patterns;
+        while(!rest.empty()) {
+            auto end = rest.find('\n');
+            auto glob = rest.substr(0, end);
+            bool on_path = glob.find_first_of("/\\") != std::string_view::npos;
+            if(glob_match(glob, on_path ? executable : name)) {
+                return true;
+            }
+            rest.remove_prefix(end + 1);
+        }
+        return false;
+    }
+
+private:
+    /// The patterns, one per line, each ending in a newline.
+    std::string_view patterns;
+};
+
+}  // namespace catter::util
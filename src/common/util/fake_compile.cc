@@ -0,0 +1,708 @@
+#include "fake_compile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cpptrace/exceptions.hpp>
+#include <kota/option/option.h>
+
+#include "opt/external/clang.h"
+#include "opt/external/llvm_lib.h"
+#include "opt/external/nvcc.h"
+
+namespace catter::fake_compile {
+
+namespace {
+
+namespace eo = kota::option;
+
+enum class Driver { GCC, CL, NVCC, AR, LIB };
+
+#ifdef CATTER_WINDOWS
+constexpr std::string_view object_extension = ".obj";
+constexpr std::string_view executable_name = "a.exe";
+#else
+constexpr std::string_view object_extension = ".o";
+constexpr std::string_view executable_name = "a.out";
+#endif
+
+std::string_view filename_of(std::string_view path) {
+    auto slash = path.find_last_of("/\\");
+    return slash == std::string_view::npos ? path : path.substr(slash + 1);
+}
+
+std::string_view stem_of(std::string_view path) {
+    auto name = filename_of(path);
+    auto dot = name.rfind('.');
+    return dot == std::string_view::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+std::string lowercase_extension_of(std::string_view path) {
+    auto name = filename_of(path);
+    auto dot = name.rfind('.');
+    std::string ext(dot == std::string_view::npos ? std::string_view{} : name.substr(dot));
+    std::ranges::transform(ext, ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext;
+}
+
+std::string replace_extension(std::string_view path, std::string_view ext) {
+    auto name = filename_of(path);
+    auto dot = name.rfind('.');
+    auto keep = dot == std::string_view::npos || dot == 0 ? path.size()
+                                                          : path.size() - name.size() + dot;
+    return std::string(path.substr(0, keep)) + std::string(ext);
+}
+
+bool is_directory_like(std::string_view path) {
+    return path.ends_with('/') || path.ends_with('\\');
+}
+
+/// Inputs a compiler driver passes on to the linker instead of compiling them.
+bool is_linker_input(std::string_view path) {
+    constexpr std::string_view linker_inputs[] =
+        {".o", ".obj", ".a", ".lib", ".so", ".dylib", ".dll", ".res", ".def", ".tbd"};
+    auto ext = lowercase_extension_of(path);
+    return std::ranges::find(linker_inputs, ext) != std::ranges::end(linker_inputs) ||
+           filename_of(path).find(".so.") != std::string_view::npos;
+}
+
+/// Escape a path for the target or prerequisite list of a Makefile rule.
+std::string make_escape(std::string_view path) {
+    std::string escaped;
+    escaped.reserve(path.size());
+    for(auto c: path) {
+        if(c == ' ' || c == '#') {
+            escaped += '\\';
+        } else if(c == '$') {
+            escaped += '$';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+bool is_version(std::string_view text) {
+    return !text.empty() && std::ranges::all_of(text, [](unsigned char c) {
+        return std::isdigit(c) || c == '.';
+    });
+}
+
+std::optional<Driver> driver_of(std::string_view program) {
+    std::string name(filename_of(program));
+    std::ranges::transform(name, name.begin(), [](unsigned char c) { return std::tolower(c); });
+    if(name.ends_with(".exe")) {
+        name.resize(name.size() - 4);
+    }
+    // drop a version suffix, e.g. gcc-13, clang-18
+    if(auto dash = name.rfind('-');
+       dash != std::string::npos && is_version(std::string_view(name).substr(dash + 1))) {
+        name.resize(dash);
+    }
+    // drop a target or tool prefix, e.g. x86_64-linux-gnu-gcc, clang-cl, llvm-ar
+    if(auto dash = name.rfind('-'); dash != std::string::npos) {
+        name.erase(0, dash + 1);
+    }
+
+    if(name == "gcc" || name == "g++" || name == "cc" || name == "c++" || name == "clang" ||
+       name == "clang++") {
+        return Driver::GCC;
+    }
+    if(name == "cl") {
+        return Driver::CL;
+    }
+    if(name == "nvcc") {
+        return Driver::NVCC;
+    }
+    if(name == "ar") {
+        return Driver::AR;
+    }
+    if(name == "lib") {
+        return Driver::LIB;
+    }
+    return std::nullopt;
+}
+
+struct Arg {
+    unsigned id;
+    /// The option that was spelled, `id` is the one it is an alias of.
+    unsigned spelled;
+    std::vector<std::string> values;
+};
+
+/// @return the arguments after `argv[0]`, `std::nullopt` if an option misses its value.
+std::optional<std::vector<Arg>> parse(const eo::OptTable& table,
+                                      std::span<const std::string> argv,
+                                      eo::Visibility visibility) {
+    std::vector<std::string> args(argv.begin() + 1, argv.end());
+    std::vector<Arg> parsed;
+    unsigned missing_arg_index = 0;
+    unsigned missing_arg_count = 0;
+    const char* missing_reason = nullptr;
+    table.parse_args(
+        args,
+        missing_arg_index,
+        missing_arg_count,
+        [&](eo::ParsedArgument arg) {
+            Arg item{
+                .id = arg.unaliased_option_id.has_value() ? arg.unaliased_option_id->id()
+                                                          : arg.option_id.id(),
+                .spelled = arg.option_id.id(),
+            };
+            for(auto value: arg.values) {
+                item.values.emplace_back(value);
+            }
+            if(item.values.empty()) {
+                item.values.emplace_back(arg.get_spelling_view());
+            }
+            parsed.push_back(std::move(item));
+        },
+        visibility,
+        &missing_reason);
+    if(missing_arg_count != 0) {
+        return std::nullopt;
+    }
+    return parsed;
+}
+
+bool is(const Arg& arg, unsigned id) {
+    return arg.id == id || arg.spelled == id;
+}
+
+output depfile_of(std::string_view object,
+                  std::string_view source,
+                  const std::optional<std::string>& path,
+                  const std::vector<std::string>& targets) {
+    std::string rule;
+    if(targets.empty()) {
+        rule = make_escape(object);
+    }
+    for(const auto& target: targets) {
+        rule += rule.empty() ? "" : " ";
+        rule += target;
+    }
+    rule += ": ";
+    rule += make_escape(source);
+    rule += '\n';
+    return output{
+        .kind = output::DEPFILE,
+        .path = path.value_or(replace_extension(object, ".d")),
+        .content = std::move(rule),
+    };
+}
+
+/// gcc, clang and clang-cl, the latter understands the options of cl.
+std::optional<std::vector<output>> plan_clang(std::span<const std::string> argv, bool cl) {
+    namespace id = opt::clang;
+    auto parsed = parse(id::table(), argv, eo::Visibility(cl ? id::CLOption : id::DefaultVis));
+    if(!parsed.has_value()) {
+        return std::nullopt;
+    }
+
+    bool compile = false;
+    bool assemble = false;
+    bool llvm = false;
+    bool dll = false;
+    bool depfile = false;
+    std::optional<std::string> out;
+    std::optional<std::string> object_out;
+    std::optional<std::string> executable_out;
+    std::optional<std::string> depfile_path;
+    std::vector<std::string> targets;
+    std::vector<std::string> inputs;
+    for(auto& arg: *parsed) {
+        if(is(arg, id::ID_E) || is(arg, id::ID_M) || is(arg, id::ID_MM) ||
+           is(arg, id::ID__SLASH_E) || is(arg, id::ID__SLASH_EP) || is(arg, id::ID__SLASH_P)) {
+            // the preprocessed text is read by whoever runs this
+            return std::nullopt;
+        }
+        if(is(arg, id::ID_fsyntax_only) || is(arg, id::ID__SLASH_Zs)) {
+            return std::vector<output>{};
+        }
+
+        if(is(arg, id::ID_c) || is(arg, id::ID__SLASH_c)) {
+            compile = true;
+        } else if(is(arg, id::ID_S)) {
+            assemble = true;
+        } else if(is(arg, id::ID_emit_llvm)) {
+            llvm = true;
+        } else if(is(arg, id::ID__SLASH_LD) || is(arg, id::ID__SLASH_LDd)) {
+            dll = true;
+        } else if(is(arg, id::ID_o) || is(arg, id::ID__SLASH_o)) {
+            out = std::move(arg.values.front());
+        } else if(is(arg, id::ID__SLASH_Fo)) {
+            object_out = std::move(arg.values.front());
+        } else if(is(arg, id::ID__SLASH_Fe)) {
+            executable_out = std::move(arg.values.front());
+        } else if(is(arg, id::ID_MD) || is(arg, id::ID_MMD)) {
+            depfile = true;
+        } else if(is(arg, id::ID_MF)) {
+            depfile_path = std::move(arg.values.front());
+        } else if(is(arg, id::ID_MT)) {
+            targets.push_back(std::move(arg.values.front()));
+        } else if(is(arg, id::ID_MQ)) {
+            targets.push_back(make_escape(arg.values.front()));
+        } else if(is(arg, id::ID_INPUT) || is(arg, id::ID__SLASH_Tc) ||
+                  is(arg, id::ID__SLASH_Tp)) {
+            inputs.push_back(std::move(arg.values.front()));
+        }
+    }
+
+    if(inputs.empty() || std::ranges::find(inputs, "-") != inputs.end() || out == "-") {
+        return std::nullopt;
+    }
+
+    std::vector<output> outputs;
+    if(compile || assemble) {
+        std::vector<std::string_view> sources;
+        for(const auto& input: inputs) {
+            if(!is_linker_input(input)) {
+                sources.push_back(input);
+            }
+        }
+
+        std::string_view ext = cl ? ".obj" : ".o";
+        auto kind = output::OBJECT;
+        if(assemble || llvm) {
+            ext = assemble ? (llvm ? ".ll" : ".s") : ".bc";
+            kind = output::OTHER;
+        }
+        if(!object_out.has_value()) {
+            object_out = std::move(out);
+        }
+        if(sources.empty() || (sources.size() > 1 && object_out.has_value() &&
+                               !is_directory_like(*object_out)) ||
+           (sources.size() > 1 && depfile_path.has_value())) {
+            return std::nullopt;
+        }
+
+        for(auto source: sources) {
+            std::string path;
+            if(!object_out.has_value()) {
+                path = std::string(stem_of(source)) + std::string(ext);
+            } else if(is_directory_like(*object_out)) {
+                path = *object_out + std::string(stem_of(source)) + std::string(ext);
+            } else {
+                path = *object_out;
+            }
+            if(depfile) {
+                outputs.push_back(depfile_of(path, source, depfile_path, targets));
+            }
+            outputs.push_back(output{.kind = kind, .path = std::move(path)});
+        }
+        return outputs;
+    }
+
+    if(depfile) {
+        // the depfiles of a compile and link in one go are named after temporary objects
+        return std::nullopt;
+    }
+
+    std::string path;
+    if(!cl) {
+        path = out.value_or(std::string(executable_name));
+    } else {
+        auto name = std::string(stem_of(inputs.front())) + (dll ? ".dll" : ".exe");
+        auto given = executable_out.has_value() ? std::move(executable_out) : std::move(out);
+        if(!given.has_value()) {
+            path = std::move(name);
+        } else if(is_directory_like(*given)) {
+            path = *given + name;
+        } else {
+            path = std::move(*given);
+        }
+        if(dll) {
+            // the import library link.exe writes next to the dll
+            outputs.push_back(
+                output{.kind = output::ARCHIVE, .path = replace_extension(path, ".lib")});
+        }
+    }
+    // an empty object rather than an empty file, so later links taking it as input still work
+    outputs.push_back(output{.kind = output::OBJECT, .path = std::move(path)});
+    return outputs;
+}
+
+std::optional<std::vector<output>> plan_nvcc(std::span<const std::string> argv) {
+    namespace id = opt::nvcc;
+    auto parsed = parse(id::table(), argv, eo::Visibility());
+    if(!parsed.has_value()) {
+        return std::nullopt;
+    }
+
+    std::optional<std::string_view> ext;
+    bool lib = false;
+    bool depfile = false;
+    std::optional<std::string> out;
+    std::optional<std::string> out_dir;
+    std::optional<std::string> depfile_path;
+    std::vector<std::string> targets;
+    std::vector<std::string> inputs;
+    for(auto& arg: *parsed) {
+        switch(arg.id) {
+            case id::ID_preprocess:
+            case id::ID_generate_dependencies:
+            case id::ID_generate_nonsystem_dependencies:
+            case id::ID_run:
+            case id::ID_cuda:
+            case id::ID_device_link: {
+                return std::nullopt;
+            }
+            case id::ID_compile:
+            case id::ID_device_c: {
+                ext = object_extension;
+                break;
+            }
+            case id::ID_ptx: {
+                ext = ".ptx";
+                break;
+            }
+            case id::ID_cubin: {
+                ext = ".cubin";
+                break;
+            }
+            case id::ID_fatbin: {
+                ext = ".fatbin";
+                break;
+            }
+            case id::ID_optix_ir: {
+                ext = ".optixir";
+                break;
+            }
+            case id::ID_lib: {
+                lib = true;
+                break;
+            }
+            case id::ID_output_file: {
+                out = std::move(arg.values.front());
+                break;
+            }
+            case id::ID_output_directory: {
+                out_dir = std::move(arg.values.front());
+                break;
+            }
+            case id::ID_generate_dependencies_with_compile:
+            case id::ID_generate_nonsystem_dependencies_with_compile: {
+                depfile = true;
+                break;
+            }
+            case id::ID_dependency_output: {
+                depfile_path = std::move(arg.values.front());
+                break;
+            }
+            case id::ID_dependency_target_name: {
+                targets.push_back(std::move(arg.values.front()));
+                break;
+            }
+            case id::ID_INPUT: {
+                inputs.push_back(std::move(arg.values.front()));
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+
+    if(inputs.empty()) {
+        return std::nullopt;
+    }
+    auto in_dir = [&](std::string path) {
+        if(!out_dir.has_value() || is_directory_like(*out_dir)) {
+            return out_dir.value_or("") + path;
+        }
+        return *out_dir + "/" + path;
+    };
+
+    std::vector<output> outputs;
+    if(lib) {
+        // the default name of the library is not documented
+        if(!out.has_value()) {
+            return std::nullopt;
+        }
+        outputs.push_back(output{.kind = output::ARCHIVE, .path = in_dir(std::move(*out))});
+        return outputs;
+    }
+
+    if(!ext.has_value()) {
+        if(depfile) {
+            return std::nullopt;
+        }
+        auto path = in_dir(out.value_or(std::string(executable_name)));
+        outputs.push_back(output{.kind = output::OBJECT, .path = std::move(path)});
+        return outputs;
+    }
+
+    if(inputs.size() > 1 && (out.has_value() || depfile_path.has_value())) {
+        return std::nullopt;
+    }
+    auto kind = *ext == object_extension ? output::OBJECT : output::OTHER;
+    for(const auto& input: inputs) {
+        auto path = in_dir(out.value_or(std::string(stem_of(input)) + std::string(*ext)));
+        if(depfile) {
+            outputs.push_back(depfile_of(path, input, depfile_path, targets));
+        }
+        outputs.push_back(output{.kind = kind, .path = std::move(path)});
+    }
+    return outputs;
+}
+
+/// ar [--plugin <plugin>] [-]<operation>[modifiers] [relpos] [count] <archive> [members...]
+std::optional<std::vector<output>> plan_ar(std::span<const std::string> argv) {
+    std::string operation;
+    bool thin = false;
+    size_t i = 1;
+    for(; i < argv.size() && argv[i].starts_with('-') && argv[i].size() > 1; ++i) {
+        if(argv[i] == "--plugin") {
+            ++i;
+        } else if(argv[i] == "--thin") {
+            thin = true;
+        } else if(!argv[i].starts_with("--")) {
+            operation += argv[i].substr(1);
+        }
+    }
+    if(operation.empty() && i < argv.size()) {
+        operation = argv[i++];
+    }
+
+    // only creating or extending an archive can be faked, an MRI script names it on stdin
+    if(operation.find_first_of("rq") == std::string::npos ||
+       operation.find('M') != std::string::npos) {
+        return std::nullopt;
+    }
+    thin = thin || operation.find('T') != std::string::npos;
+    // positional modifiers and instance counts take an argument before the archive
+    if(operation.find_first_of("abi") != std::string::npos) {
+        ++i;
+    }
+    if(operation.find('N') != std::string::npos) {
+        ++i;
+    }
+    if(i >= argv.size()) {
+        return std::nullopt;
+    }
+
+    return std::vector<output>{
+        output{.kind = thin ? output::THIN_ARCHIVE : output::ARCHIVE, .path = argv[i]}
+    };
+}
+
+std::optional<std::vector<output>> plan_lib(std::span<const std::string> argv) {
+    namespace id = opt::llvm_lib;
+    auto parsed = parse(id::table(), argv, eo::Visibility());
+    if(!parsed.has_value()) {
+        return std::nullopt;
+    }
+
+    bool thin = false;
+    std::optional<std::string> out;
+    std::optional<std::string> first_input;
+    for(auto& arg: *parsed) {
+        if(arg.id == id::ID_lst) {
+            return std::nullopt;
+        }
+        if(arg.id == id::ID_llvmlibthin) {
+            thin = true;
+        } else if(arg.id == id::ID_out) {
+            out = std::move(arg.values.front());
+        } else if(arg.id == id::ID_INPUT && !first_input.has_value()) {
+            first_input = std::move(arg.values.front());
+        }
+    }
+
+    if(!out.has_value()) {
+        if(!first_input.has_value()) {
+            return std::nullopt;
+        }
+        out = replace_extension(*first_input, ".lib");
+    }
+    return std::vector<output>{
+        output{.kind = thin ? output::THIN_ARCHIVE : output::ARCHIVE, .path = std::move(*out)}
+    };
+}
+
+void put(std::string& bytes, uint64_t value, int size) {
+    for(int i = 0; i < size; ++i) {
+        bytes.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+/// ELF64 relocatable file with a null section and the section name table.
+[[maybe_unused]] std::string elf_object(uint16_t machine, uint32_t flags) {
+    constexpr std::string_view names{"\0.shstrtab\0", 11};
+    constexpr uint64_t header_size = 64;
+    constexpr uint64_t section_header_size = 64;
+    constexpr uint64_t section_headers = 80;
+
+    std::string bytes("\x7f" "ELF", 4);
+    put(bytes, 2, 1);  // ELFCLASS64
+    put(bytes, 1, 1);  // ELFDATA2LSB
+    put(bytes, 1, 1);  // EV_CURRENT
+    bytes.resize(16, '\0');
+    put(bytes, 1, 2);  // ET_REL
+    put(bytes, machine, 2);
+    put(bytes, 1, 4);
+    put(bytes, 0, 8);  // e_entry
+    put(bytes, 0, 8);  // e_phoff
+    put(bytes, section_headers, 8);
+    put(bytes, flags, 4);
+    put(bytes, header_size, 2);
+    put(bytes, 0, 2);  // e_phentsize
+    put(bytes, 0, 2);  // e_phnum
+    put(bytes, section_header_size, 2);
+    put(bytes, 2, 2);  // e_shnum
+    put(bytes, 1, 2);  // e_shstrndx
+
+    bytes.append(names);
+    bytes.resize(section_headers + section_header_size, '\0');
+    put(bytes, 1, 4);  // sh_name
+    put(bytes, 3, 4);  // SHT_STRTAB
+    put(bytes, 0, 8);  // sh_flags
+    put(bytes, 0, 8);  // sh_addr
+    put(bytes, header_size, 8);
+    put(bytes, names.size(), 8);
+    put(bytes, 0, 4);  // sh_link
+    put(bytes, 0, 4);  // sh_info
+    put(bytes, 1, 8);  // sh_addralign
+    put(bytes, 0, 8);  // sh_entsize
+    return bytes;
+}
+
+/// 64 bit Mach-O object without load commands.
+[[maybe_unused]] std::string macho_object(uint32_t cpu_type, uint32_t cpu_subtype) {
+    std::string bytes;
+    put(bytes, 0xFEEDFACF, 4);  // MH_MAGIC_64
+    put(bytes, cpu_type, 4);
+    put(bytes, cpu_subtype, 4);
+    put(bytes, 1, 4);  // MH_OBJECT
+    put(bytes, 0, 4);  // ncmds
+    put(bytes, 0, 4);  // sizeofcmds
+    put(bytes, 0, 4);  // flags
+    put(bytes, 0, 4);  // reserved
+    return bytes;
+}
+
+/// COFF object without sections or symbols.
+[[maybe_unused]] std::string coff_object(uint16_t machine) {
+    std::string bytes;
+    put(bytes, machine, 2);
+    bytes.resize(20, '\0');
+    return bytes;
+}
+
+std::string host_object() {
+#if defined(CATTER_WINDOWS) && (defined(_M_X64) || defined(__x86_64__))
+    return coff_object(0x8664);
+#elif defined(CATTER_WINDOWS) && (defined(_M_ARM64) || defined(__aarch64__))
+    return coff_object(0xAA64);
+#elif defined(CATTER_MAC) && defined(__x86_64__)
+    return macho_object(0x01000007, 3);
+#elif defined(CATTER_MAC) && defined(__aarch64__)
+    return macho_object(0x0100000C, 0);
+#elif defined(__x86_64__)
+    return elf_object(62, 0);
+#elif defined(__aarch64__)
+    return elf_object(183, 0);
+#elif defined(__riscv) && __riscv_xlen == 64
+    // RVC and the double float ABI, what rv64gc objects carry
+    return elf_object(243, 0x5);
+#else
+    return {};
+#endif
+}
+
+}  // namespace
+
+std::optional<std::vector<output>> plan(std::span<const std::string> argv) {
+    if(argv.empty()) {
+        return std::nullopt;
+    }
+    auto driver = driver_of(argv.front());
+    if(!driver.has_value()) {
+        return std::nullopt;
+    }
+    auto args = argv.subspan(1);
+    if(std::ranges::any_of(args, [](const std::string& arg) { return arg.starts_with('@'); })) {
+        // response files are not expanded
+        return std::nullopt;
+    }
+    if(*driver == Driver::GCC && std::ranges::find(args, "--driver-mode=cl") != args.end()) {
+        driver = Driver::CL;
+    }
+
+    std::optional<std::vector<output>> outputs;
+    switch(*driver) {
+        case Driver::GCC:
+        case Driver::CL: {
+            outputs = plan_clang(argv, *driver == Driver::CL);
+            break;
+        }
+        case Driver::NVCC: {
+            outputs = plan_nvcc(argv);
+            break;
+        }
+        case Driver::AR: {
+            outputs = plan_ar(argv);
+            break;
+        }
+        case Driver::LIB: {
+            outputs = plan_lib(argv);
+            break;
+        }
+    }
+
+    auto is_object = [](const output& out) { return out.kind == output::OBJECT; };
+    if(outputs.has_value() && empty_object().empty() && std::ranges::any_of(*outputs, is_object)) {
+        return std::nullopt;
+    }
+    return outputs;
+}
+
+std::string_view empty_object() {
+    static const std::string object = host_object();
+    return object;
+}
+
+std::string placeholder(const output& out) {
+    switch(out.kind) {
+        case output::OBJECT: {
+            return std::string(empty_object());
+        }
+        case output::ARCHIVE: {
+            return "!<arch>\n";
+        }
+        case output::THIN_ARCHIVE: {
+            return "!<thin>\n";
+        }
+        case output::DEPFILE: {
+            return out.content;
+        }
+        case output::OTHER: {
+            return {};
+        }
+    }
+    return {};
+}
+
+void write(std::span<const output> outputs, const std::filesystem::path& cwd) {
+    for(const auto& out: outputs) {
+        auto path = std::filesystem::path(out.path);
+        if(path.is_relative()) {
+            path = cwd / path;
+        }
+        auto content = placeholder(out);
+        std::ofstream file(path, std::ios::out | std::ios::trunc | std::ios::binary);
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        file.close();
+        if(!file) {
+            throw cpptrace::runtime_error(std::format("failed to write {}", path.string()));
+        }
+    }
+}
+
+}  // namespace catter::fake_compile
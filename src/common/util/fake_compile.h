@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Fake compilation. Instead of running a compiler, catter-proxy works out the files the command
+ * would write with the option tables of `opt/external` and writes placeholders of them, so the
+ * build goes on to its link steps without compiling anything.
+ *
+ * Placeholders are empty but valid files: objects in the format of the host, archives without
+ * members and depfiles naming only the source file.
+ */
+namespace catter::fake_compile {
+
+struct output {
+    enum : uint8_t {
+        OBJECT,        // An object file without sections or symbols
+        ARCHIVE,       // A static library without members
+        THIN_ARCHIVE,  // A thin static library without members
+        DEPFILE,       // A Makefile rule, its text is in `content`
+        OTHER,         // Anything else, written as an empty file
+    } kind;
+
+    /// Relative to the working directory of the command, unless it is absolute.
+    std::string path;
+    std::string content{};
+};
+
+/**
+ * Work out the files `argv` writes. Compiler drivers (gcc, clang, clang-cl, cl, nvcc) and archivers
+ * (ar, llvm-ar, lib, llvm-lib) are recognized by the name of `argv[0]`.
+ *
+ * @return the outputs of the command, `std::nullopt` if the command is not recognized or its
+ * outputs can not be faked, e.g. the preprocessed text of `-E`. Such a command has to run.
+ */
+std::optional<std::vector<output>> plan(std::span<const std::string> argv);
+
+/// @return the bytes of an empty object file for the host, empty if the host format is unknown.
+std::string_view empty_object();
+
+/// @return the bytes written for `out`.
+std::string placeholder(const output& out);
+
+/**
+ * Write the placeholders of `outputs`, relative paths are resolved against `cwd`. Directories are
+ * not created, a real compiler does not create them either.
+ *
+ * @throws cpptrace::runtime_error if a file can not be written.
+ */
+void write(std::span<const output> outputs, const std::filesystem::path& cwd);
+
+}  // namespace catter::fake_compile
@@ -1,12 +1,19 @@
 #pragma once
 #include <cassert>
+#include <chrono>
+#include <cstdint>
 #include <cstdio>
 #include <format>
+#include <functional>
+#include <limits>
 #include <stdexcept>
 #include <cpptrace/exceptions.hpp>
 #include <kota/support/functional.h>
 #include <kota/async/async.h>
 #include <kota/async/runtime/when.h>
+#ifndef CATTER_WINDOWS
+#include <sys/resource.h>
+#endif
 
 #include "data.h"
 #include "pipe_proxy.h"
@@ -18,6 +25,7 @@ struct process_info {
     kota::task<int64_t, kota::error> wait_task;
     kota::pipe stdout_pipe;
     kota::pipe stderr_pipe;
+    int64_t pid = 0;
 };
 
 using process_event = kota::function<process_info(kota::event_loop&)>;
@@ -30,6 +38,8 @@ inline process_event make_process_event(kota::process::options& opts) {
                 std::format("process spawn failed: {}", spawn_ret.error().message()));
         }
 
+        // read it before the process is moved into the wait task
+        auto pid = static_cast<int64_t>(spawn_ret->proc.pid());
         return {
             .wait_task = [](kota::process proc) noexcept -> kota::task<int64_t, kota::error> {
                 auto wait_ret = co_await proc.wait();
@@ -40,18 +50,88 @@ inline process_event make_process_event(kota::process::options& opts) {
             }(std::move(spawn_ret->proc)),
             .stdout_pipe = std::move(spawn_ret->stdout_pipe),
             .stderr_pipe = std::move(spawn_ret->stderr_pipe),
+            .pid = pid,
         };
     };
 }
 
-inline kota::task<data::process_result> capture_process_result(process_event proc_event,
-                                                               FILE* stdout_sink = stdout,
-                                                               FILE* stderr_sink = stderr) {
+/// Call `on_start` with the pid of the process of `event` once it is spawned, if set.
+inline process_event notify_start(process_event event, std::function<void(int64_t)> on_start) {
+    if(!on_start) {
+        return event;
+    }
+    return [event = std::move(event),
+            on_start = std::move(on_start)](kota::event_loop& loop) mutable -> process_info {
+        auto info = event(loop);
+        on_start(info.pid);
+        return info;
+    };
+}
+
+inline int64_t unix_time_us() noexcept {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+/// Fill the CPU time and peak memory of `stats` from the children we have waited for, which is
+/// the command and everything it waited for when there is only one. Linux and macOS only.
+inline void read_children_usage(data::process_stats& stats) noexcept {
+#ifndef CATTER_WINDOWS
+    rusage usage{};
+    if(getrusage(RUSAGE_CHILDREN, &usage) != 0) {
+        return;
+    }
+    stats.user_time = usage.ru_utime.tv_sec * 1'000'000 + usage.ru_utime.tv_usec;
+    stats.system_time = usage.ru_stime.tv_sec * 1'000'000 + usage.ru_stime.tv_usec;
+#ifdef CATTER_MAC
+    stats.max_rss = usage.ru_maxrss / 1024;  // bytes on macOS
+#else
+    stats.max_rss = usage.ru_maxrss;
+#endif
+#else
+    (void)stats;
+#endif
+}
+
+/// The stdout or stderr to give a child whose output is kept as `capture` asks.
+inline kota::process::stdio output_stream(data::CaptureMode capture) {
+    if(capture == data::CaptureMode::INHERIT) {
+        return kota::process::stdio::inherit();
+    }
+    return kota::process::stdio::pipe(false, true);
+}
+
+/**
+ * Wait for the process and collect its output.
+ *
+ * With `CaptureMode::INHERIT` the process must have been spawned with our own streams, see
+ * `output_stream`, so there is no pipe to read and the result has no output. Otherwise its
+ * output is forwarded to the sinks while it runs.
+ */
+inline kota::task<data::process_result>
+    capture_process_result(process_event proc_event,
+                           data::CaptureMode capture = data::CaptureMode::TAIL,
+                           FILE* stdout_sink = stdout,
+                           FILE* stderr_sink = stderr) {
     auto& current_loop = kota::event_loop::current();
 
-    auto [wait_task, stdout_pipe, stderr_pipe] = proc_event(current_loop);
-    util::PipeProxy stdout_proxy(std::move(stdout_pipe), stdout_sink, "stdout");
-    util::PipeProxy stderr_proxy(std::move(stderr_pipe), stderr_sink, "stderr");
+    auto [wait_task, stdout_pipe, stderr_pipe, pid] = proc_event(current_loop);
+    data::process_stats stats{.pid = pid, .exec = unix_time_us()};
+    if(capture == data::CaptureMode::INHERIT) {
+        auto code = co_await std::move(wait_task);
+        if(!code) {
+            throw cpptrace::runtime_error(
+                std::format("process wait failed: {}", code.error().message()));
+        }
+        stats.exit = unix_time_us();
+        read_children_usage(stats);
+        co_return data::process_result{.code = *code, .stats = stats};
+    }
+
+    const auto limit = capture == data::CaptureMode::FULL ? std::numeric_limits<size_t>::max()
+                                                          : util::PipeProxy::output_limit;
+    util::PipeProxy stdout_proxy(std::move(stdout_pipe), stdout_sink, "stdout", limit);
+    util::PipeProxy stderr_proxy(std::move(stderr_pipe), stderr_sink, "stderr", limit);
 
     auto ret = co_await kota::when_all{std::move(wait_task),
                                        stdout_proxy.monitor(),
@@ -63,11 +143,14 @@ inline kota::task<data::process_result> capture_process_result(process_event pro
     }
 
     auto [code, _1, _2] = *ret;
+    stats.exit = unix_time_us();
+    read_children_usage(stats);
 
     co_return data::process_result{
         .code = code,
         .std_out = stdout_proxy.output(),
         .std_err = stderr_proxy.output(),
+        .stats = stats,
     };
 }
 }  // namespace catter
@@ -72,7 +72,8 @@ kota::task<void> PipeProxy::monitor() {
         // while the full stream is still forwarded to the sink in real time.
         PipeProxy::append_bounded_output(output_buffer,
                                          std::string_view(chunk->data(), chunk->size()),
-                                         output_truncated);
+                                         output_truncated,
+                                         limit);
 
         if(sink != nullptr) {
             std::span<const char> bytes(chunk->data(), chunk->size());
@@ -13,8 +13,9 @@ public:
     constexpr static size_t output_limit = 64 * 1024;
     constexpr static std::string_view truncation_marker = "[... truncated leading output ...]\n";
 
-    PipeProxy(kota::pipe&& pipe, FILE* sink, std::string_view name) :
-        pipe(std::move(pipe)), sink(sink), name(name) {
+    /// @param limit how much of the output is kept, the leading part is dropped beyond it.
+    PipeProxy(kota::pipe&& pipe, FILE* sink, std::string_view name, size_t limit = output_limit) :
+        pipe(std::move(pipe)), sink(sink), name(name), limit(limit) {
         output_buffer.reserve(1024);
     }
 
@@ -44,6 +45,7 @@ private:
     kota::pipe pipe{};
     FILE* sink = nullptr;
     std::string name{};
+    size_t limit = output_limit;
     std::string output_buffer{};
     bool output_truncated = false;
 };
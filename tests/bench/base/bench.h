@@ -0,0 +1,120 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <string_view>
+
+/**
+ * @file bench.h
+ * @brief A small benchmark harness in the manner of Google Benchmark.
+ *
+ * A benchmark runs its measured code in `for(auto _: state)`. It is first run once, then with ten
+ * times the iterations until a run takes `--min-time` milliseconds, and the last run is reported
+ * as one JSON object per line:
+ *
+ *   {"name":"bridge/command_data/to_js","iterations":10000,"ns_per_op":1234.5}
+ *
+ * `--filter <text>` only runs the benchmarks whose name contains it.
+ */
+namespace catter::bench {
+
+class State {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit State(std::size_t iterations) noexcept : iterations(iterations) {}
+
+    struct Sentinel {};
+
+    class Iterator {
+    public:
+        explicit Iterator(State& state) noexcept : state(state), left(state.iterations) {}
+
+        bool operator!= (Sentinel) noexcept {
+            if(left != 0) {
+                return true;
+            }
+            state.stop();
+            return false;
+        }
+
+        void operator++ () noexcept {
+            --left;
+        }
+
+        /// Nothing to use, `_` only counts.
+        int operator* () const noexcept {
+            return 0;
+        }
+
+    private:
+        State& state;
+        std::size_t left;
+    };
+
+    Iterator begin() noexcept {
+        start = clock::now();
+        return Iterator(*this);
+    }
+
+    Sentinel end() noexcept {
+        return {};
+    }
+
+    /// Leave the setup of an iteration out of the measure.
+    void pause() noexcept {
+        paused_at = clock::now();
+    }
+
+    void resume() noexcept {
+        excluded += clock::now() - paused_at;
+    }
+
+    std::size_t count() const noexcept {
+        return iterations;
+    }
+
+    clock::duration elapsed() const noexcept {
+        return stop_at - start - excluded;
+    }
+
+private:
+    void stop() noexcept {
+        stop_at = clock::now();
+    }
+
+    std::size_t iterations;
+    clock::time_point start{};
+    clock::time_point stop_at{};
+    clock::time_point paused_at{};
+    clock::duration excluded{};
+};
+
+/// Keep `value` from being optimized away.
+template <typename T>
+void do_not_optimize(T&& value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    static volatile const void* sink;
+    sink = &value;
+#else
+    asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+using Function = void (*)(State&);
+
+struct Registration {
+    Registration(std::string_view name, Function function);
+};
+
+}  // namespace catter::bench
+
+#define BENCH_MERGE_IMPL(x, y) x##y
+#define BENCH_MERGE(x, y) BENCH_MERGE_IMPL(x, y)
+
+/// BENCHMARK("group/name") { for(auto _: state) { ... } }
+#define BENCHMARK(NAME)                                                                            \
+    static void BENCH_MERGE(bench_fn_, __LINE__)(catter::bench::State & state);                    \
+    static catter::bench::Registration BENCH_MERGE(bench_reg_, __LINE__)(                          \
+        NAME,                                                                                      \
+        BENCH_MERGE(bench_fn_, __LINE__));                                                         \
+    static void BENCH_MERGE(bench_fn_, __LINE__)(catter::bench::State & state)
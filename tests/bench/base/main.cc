@@ -0,0 +1,77 @@
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <print>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "util/log.h"
+
+namespace catter::bench {
+
+namespace {
+
+std::vector<std::pair<std::string_view, Function>>& registry() {
+    static std::vector<std::pair<std::string_view, Function>> benchmarks;
+    return benchmarks;
+}
+
+constexpr std::size_t max_iterations = 1'000'000'000;
+
+}  // namespace
+
+Registration::Registration(std::string_view name, Function function) {
+    registry().emplace_back(name, function);
+}
+
+}  // namespace catter::bench
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::chrono::milliseconds min_time{200};
+    for(int i = 1; i + 1 < argc; i += 2) {
+        std::string_view key{argv[i]};
+        if(key == "--filter") {
+            filter = argv[i + 1];
+        } else if(key == "--min-time") {
+            min_time = std::chrono::milliseconds(std::atoll(argv[i + 1]));
+        } else {
+            std::println(std::cerr, "unknown option {}", key);
+            return 1;
+        }
+    }
+
+    // as in a build without `--log`
+    catter::log::mute_logger();
+
+    using namespace catter::bench;
+    for(auto [name, function]: registry()) {
+        if(!name.contains(filter)) {
+            continue;
+        }
+        try {
+            std::size_t iterations = 1;
+            while(true) {
+                State state(iterations);
+                function(state);
+                if(state.elapsed() >= min_time || iterations >= max_iterations) {
+                    auto ns = std::chrono::duration<double, std::nano>(state.elapsed()).count();
+                    std::println(R"({{"name":"{}","iterations":{},"ns_per_op":{:.1f}}})",
+                                 name,
+                                 iterations,
+                                 ns / static_cast<double>(iterations));
+                    break;
+                }
+                iterations *= 10;
+            }
+        } catch(const std::exception& e) {
+            std::println(std::cerr, "{} failed: {}", name, e.what());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,431 @@
+// A synthetic build: trivial children run through every call the hook intercepts, so what catter
+// adds to each command of a build can be tracked commit by commit.
+//
+// usage: bench [--count <N>] [--jobs <N>] [--method <name|all>] [--catter <path>]
+//        bench --driver [--setup <name>] [--count <N>] [--jobs <N>] [--method <name|all>]
+//              [--out <file>]
+//        bench --startup [--count <N>] [--jobs <N>] [--method <name|all>] [--hook <path>]
+//              [--program <path>]
+//
+// Without `--driver`, the driver runs once without catter, once under `catter -m inject
+// script::cdb`, and once under a script which lets every command run. One JSON object per line
+// is printed for each setup and method, e.g.
+//   {"setup":"cdb","method":"execve","count":500,"jobs":8,"wall_us":...,"p50_us":...,...}
+//
+// With `--startup`, `--program` (`/bin/true` by default) is run without and then with the hook
+// library preloaded, as setups `plain` and `payload`. It never execs, so this is what loading the
+// hook costs every process of a build.
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cpptrace/exceptions.hpp>
+
+#include "util/crossplat.h"
+#include "util/exception.h"
+
+extern char** environ;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr std::string_view methods[] = {
+    "execve",
+    "execv",
+    "execvp",
+#ifdef CATTER_LINUX
+    "execvpe",
+#endif
+    "execl",
+    "execlp",
+    "execle",
+    "posix_spawn",
+    "posix_spawnp",
+    "vfork",
+};
+
+#ifdef CATTER_LINUX
+constexpr char preload_key[] = "LD_PRELOAD";
+constexpr char hook_library[] = "libcatter-hook-unix.so";
+#else
+constexpr char preload_key[] = "DYLD_INSERT_LIBRARIES";
+constexpr char hook_library[] = "libcatter-hook-unix.dylib";
+#endif
+
+struct Options {
+    bool driver = false;
+    bool startup = false;
+    std::string setup = "plain";
+    std::size_t count = 500;
+    std::size_t jobs = 8;
+    std::string method = "all";
+    fs::path catter{};
+    fs::path out{};
+    fs::path hook{};
+    fs::path program = "/bin/true";
+};
+
+std::size_t parse_size(std::string_view key, std::string_view text) {
+    std::size_t value = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if(ec != std::errc() || ptr != text.data() + text.size() || value == 0) {
+        throw cpptrace::runtime_error(std::format("{} needs a positive number, got {}", key, text));
+    }
+    return value;
+}
+
+Options parse(std::span<char*> args) {
+    Options opt;
+    for(std::size_t i = 0; i < args.size(); ++i) {
+        std::string_view key = args[i];
+        if(key == "--driver") {
+            opt.driver = true;
+            continue;
+        }
+        if(key == "--startup") {
+            opt.startup = true;
+            continue;
+        }
+        if(i + 1 == args.size()) {
+            throw cpptrace::runtime_error(std::format("{} needs a value", key));
+        }
+        std::string_view value = args[++i];
+        if(key == "--setup") {
+            opt.setup = value;
+        } else if(key == "--count") {
+            opt.count = parse_size(key, value);
+        } else if(key == "--jobs") {
+            opt.jobs = parse_size(key, value);
+        } else if(key == "--method") {
+            opt.method = value;
+        } else if(key == "--catter") {
+            opt.catter = value;
+        } else if(key == "--out") {
+            opt.out = value;
+        } else if(key == "--hook") {
+            opt.hook = value;
+        } else if(key == "--program") {
+            opt.program = value;
+        } else {
+            throw cpptrace::runtime_error(std::format("unknown option {}", key));
+        }
+    }
+    if(opt.method != "all" && std::ranges::find(methods, opt.method) == std::end(methods)) {
+        throw cpptrace::runtime_error(std::format("unknown method {}", opt.method));
+    }
+    return opt;
+}
+
+/// The child is this executable again, which exits at once when called with `--child`.
+struct Child {
+    std::string path;
+    std::string name;
+
+    char* const* argv(bool by_name) {
+        args[0] = by_name ? name.data() : path.data();
+        return args;
+    }
+
+    char flag[8] = "--child";
+    char* args[3] = {nullptr, flag, nullptr};
+};
+
+[[noreturn]] void exec_child(std::string_view method, Child& child) {
+    if(method == "execve") {
+        ::execve(child.path.c_str(), child.argv(false), environ);
+    } else if(method == "execv") {
+        ::execv(child.path.c_str(), child.argv(false));
+    } else if(method == "execvp") {
+        ::execvp(child.name.c_str(), child.argv(true));
+#ifdef CATTER_LINUX
+    } else if(method == "execvpe") {
+        ::execvpe(child.name.c_str(), child.argv(true), environ);
+#endif
+    } else if(method == "execl") {
+        ::execl(child.path.c_str(), child.path.c_str(), child.flag, static_cast<char*>(nullptr));
+    } else if(method == "execlp") {
+        ::execlp(child.name.c_str(), child.name.c_str(), child.flag, static_cast<char*>(nullptr));
+    } else if(method == "execle") {
+        ::execle(child.path.c_str(),
+                 child.path.c_str(),
+                 child.flag,
+                 static_cast<char*>(nullptr),
+                 environ);
+    }
+    ::_exit(127);
+}
+
+pid_t launch(std::string_view method, Child& child) {
+    pid_t pid = 0;
+    if(method.starts_with("posix_spawn")) {
+        bool by_name = method == "posix_spawnp";
+        int err = by_name ? ::posix_spawnp(&pid,
+                                           child.name.c_str(),
+                                           nullptr,
+                                           nullptr,
+                                           child.argv(true),
+                                           environ)
+                          : ::posix_spawn(&pid,
+                                          child.path.c_str(),
+                                          nullptr,
+                                          nullptr,
+                                          child.argv(false),
+                                          environ);
+        if(err != 0) {
+            throw catter::system_error(err, std::system_category(), "posix_spawn failed");
+        }
+        return pid;
+    }
+
+    if(method == "vfork") {
+        // the child runs on the memory of the driver until it execs, as the children of a shell
+        auto* argv = child.argv(false);
+        pid = ::vfork();
+        if(pid == 0) {
+            ::execve(child.path.c_str(), argv, environ);
+            ::_exit(127);
+        }
+        if(pid < 0) {
+            throw catter::system_error(errno, std::system_category(), "vfork failed");
+        }
+        return pid;
+    }
+
+    pid = ::fork();
+    if(pid < 0) {
+        throw catter::system_error(errno, std::system_category(), "fork failed");
+    }
+    if(pid == 0) {
+        exec_child(method, child);
+    }
+    return pid;
+}
+
+int64_t percentile(const std::vector<int64_t>& sorted, double p) {
+    // nearest rank
+    auto rank = static_cast<std::size_t>(p * static_cast<double>(sorted.size()) + 0.999999);
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+/// Keep `jobs` children running until `count` exited, as a parallel build does.
+std::string run_method(const Options& opt, std::string_view method, Child& child) {
+    std::unordered_map<pid_t, clock_type::time_point> running;
+    std::vector<int64_t> latencies;
+    latencies.reserve(opt.count);
+
+    auto start = clock_type::now();
+    std::size_t launched = 0;
+    while(latencies.size() < opt.count) {
+        while(launched < opt.count && running.size() < opt.jobs) {
+            auto spawned = clock_type::now();
+            running.emplace(launch(method, child), spawned);
+            ++launched;
+        }
+
+        int status = 0;
+        pid_t pid = ::waitpid(-1, &status, 0);
+        if(pid < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            throw catter::system_error(errno, std::system_category(), "waitpid failed");
+        }
+        auto it = running.find(pid);
+        if(it == running.end()) {
+            continue;
+        }
+        if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            throw cpptrace::runtime_error(std::format("a child run by {} failed", method));
+        }
+        using std::chrono::microseconds;
+        latencies.push_back(
+            std::chrono::duration_cast<microseconds>(clock_type::now() - it->second).count());
+        running.erase(it);
+    }
+    auto wall = std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - start);
+
+    std::ranges::sort(latencies);
+    int64_t total = 0;
+    for(auto latency: latencies) {
+        total += latency;
+    }
+    return std::format(
+        R"({{"setup":"{}","method":"{}","count":{},"jobs":{},"wall_us":{},"mean_us":{},)"
+        R"("p50_us":{},"p90_us":{},"p99_us":{},"max_us":{}}})",
+        opt.setup,
+        method,
+        opt.count,
+        opt.jobs,
+        wall.count(),
+        total / static_cast<int64_t>(latencies.size()),
+        percentile(latencies, 0.50),
+        percentile(latencies, 0.90),
+        percentile(latencies, 0.99),
+        latencies.back());
+}
+
+int driver_main(const Options& opt) {
+    auto self = catter::util::get_executable_path();
+    Child child{.path = self.string(), .name = self.filename().string()};
+
+    // the `p` variants find the child by name
+    std::string path = self.parent_path().string();
+    if(const char* inherited = std::getenv("PATH"); inherited != nullptr) {
+        path = std::format("{}:{}", path, inherited);
+    }
+    ::setenv("PATH", path.c_str(), 1);
+
+    std::ofstream file;
+    if(!opt.out.empty()) {
+        file.open(opt.out, std::ios::app);
+    }
+    std::ostream& out = opt.out.empty() ? std::cout : file;
+    for(auto method: methods) {
+        if(opt.method == "all" || opt.method == method) {
+            out << run_method(opt, method, child) << '\n';
+        }
+    }
+    out.flush();
+    return out.good() ? 0 : 1;
+}
+
+int startup_main(Options opt) {
+    auto self = catter::util::get_executable_path();
+    auto hook = opt.hook.empty() ? self.parent_path() / hook_library : opt.hook;
+    if(!fs::exists(hook)) {
+        throw cpptrace::runtime_error(std::format("hook library not found at {}", hook.string()));
+    }
+    Child child{.path = opt.program.string(), .name = opt.program.filename().string()};
+
+    std::string path = opt.program.parent_path().string();
+    if(const char* inherited = std::getenv("PATH"); inherited != nullptr) {
+        path = std::format("{}:{}", path, inherited);
+    }
+    ::setenv("PATH", path.c_str(), 1);
+
+    // only the children load the library, this process is not hooked
+    for(std::string_view setup: {"plain", "payload"}) {
+        opt.setup = setup;
+        if(setup == "payload") {
+            ::setenv(preload_key, hook.c_str(), 1);
+        }
+        for(auto method: methods) {
+            if(opt.method == "all" || opt.method == method) {
+                std::println("{}", run_method(opt, method, child));
+            }
+        }
+    }
+    ::unsetenv(preload_key);
+    return 0;
+}
+
+int run(std::vector<std::string> argv) {
+    std::vector<char*> args;
+    for(auto& arg: argv) {
+        args.push_back(arg.data());
+    }
+    args.push_back(nullptr);
+
+    pid_t pid = 0;
+    if(int err = ::posix_spawn(&pid, args[0], nullptr, nullptr, args.data(), environ); err != 0) {
+        throw catter::system_error(err, std::system_category(), argv[0]);
+    }
+    int status = 0;
+    while(::waitpid(pid, &status, 0) < 0) {
+        if(errno != EINTR) {
+            throw catter::system_error(errno, std::system_category(), "waitpid failed");
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int compare_main(const Options& opt) {
+    auto self = catter::util::get_executable_path();
+    auto catter = opt.catter.empty() ? self.parent_path() / "catter" : opt.catter;
+    auto dir = fs::temp_directory_path() / std::format("catter-bench-{}", ::getpid());
+    fs::create_directories(dir);
+    auto out = dir / "results.jsonl";
+
+    struct Setup {
+        std::string_view name;
+        std::vector<std::string> prefix;
+    };
+
+    std::vector<Setup> setups = {
+        {"plain", {}},
+        {"cdb",
+         {catter.string(), "-m", "inject", "script::cdb", "-o", (dir / "cdb.json").string(), "--"}},
+        {"noop", {catter.string(), "-m", "inject", BENCH_NOOP_SCRIPT, "--"}},
+    };
+
+    int ret = 0;
+    for(auto& setup: setups) {
+        auto argv = setup.prefix;
+        argv.insert(argv.end(),
+                    {self.string(),
+                     "--driver",
+                     "--setup",
+                     std::string(setup.name),
+                     "--count",
+                     std::to_string(opt.count),
+                     "--jobs",
+                     std::to_string(opt.jobs),
+                     "--method",
+                     opt.method,
+                     "--out",
+                     out.string()});
+        if(int code = run(std::move(argv)); code != 0) {
+            std::println(std::cerr, "setup {} failed with {}", setup.name, code);
+            ret = 1;
+            break;
+        }
+    }
+
+    std::ifstream results(out);
+    for(std::string line; std::getline(results, line);) {
+        std::println("{}", line);
+    }
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    return ret;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if(argc == 2 && std::string_view(argv[1]) == "--child") {
+        return 0;
+    }
+
+    try {
+        auto opt = parse(std::span<char*>(argv + 1, argc - 1));
+        if(opt.startup) {
+            return startup_main(std::move(opt));
+        }
+        return opt.driver ? driver_main(opt) : compare_main(opt);
+    } catch(const std::exception& e) {
+        std::println(std::cerr, "bench: {}", e.what());
+        return 1;
+    }
+}
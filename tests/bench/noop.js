@@ -0,0 +1,6 @@
+// Lets every command run unchanged, so the bench measures the cost of reaching the script.
+import { service } from "catter";
+
+service.register({
+  onCommand() {},
+});
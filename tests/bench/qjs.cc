@@ -0,0 +1,296 @@
+// Microbenchmarks of the QuickJS bridge: what it costs to hand a command to the script, to take
+// its answer back, and to call between C++ and JS.
+//
+// usage: bench-qjs [--filter <text>] [--min-time <ms>]
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <string>
+#include <vector>
+#include <cpptrace/exceptions.hpp>
+#include <kota/async/async.h>
+
+#include "bench.h"
+#include "js/apitool.h"
+#include "js/async.h"
+#include "js/command_object.h"
+#include "js/qjs.h"
+#include "js/capi/type.h"
+
+using namespace catter;
+using bench::do_not_optimize;
+
+namespace {
+
+constexpr int eval_flags = JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_STRICT;
+
+/// A compiler invocation as a CMake project emits it.
+js::CommandData compile_command() {
+    js::CommandData command{
+        .cwd = "/home/user/project/build",
+        .exe = "/usr/bin/clang++",
+        .argv = {"clang++", "-DNDEBUG", "-DFMT_HEADER_ONLY=1"},
+        .runtime = {.supportActions = {js::ActionType::skip,
+                                       js::ActionType::drop,
+                                       js::ActionType::abort,
+                                       js::ActionType::modify},
+                    .type = js::CatterRuntime::Type::inject,
+                    .supportParentId = true},
+        .parent = 12,
+        .origin = js::ProcessOrigin{.pid = 4242, .ppid = 4200, .tid = 4242},
+    };
+    for(int i = 0; i < 24; ++i) {
+        command.argv.push_back(std::format("-I/home/user/project/third_party/lib{}/include", i));
+    }
+    command.argv.insert(command.argv.end(),
+                        {"-std=c++23",
+                         "-O2",
+                         "-g",
+                         "-Wall",
+                         "-Wextra",
+                         "-fPIC",
+                         "-MD",
+                         "-MT",
+                         "src/CMakeFiles/app.dir/module/parser.cc.o",
+                         "-MF",
+                         "src/CMakeFiles/app.dir/module/parser.cc.o.d",
+                         "-o",
+                         "src/CMakeFiles/app.dir/module/parser.cc.o",
+                         "-c",
+                         "/home/user/project/src/module/parser.cc"});
+    for(int i = 0; i < 60; ++i) {
+        command.env.push_back(std::format("VARIABLE_{}=/some/typical/value/of/an/environment/{}",
+                                          i,
+                                          i));
+    }
+    return command;
+}
+
+js::ProcessResult compile_result() {
+    return js::ProcessResult{
+        .code = 1,
+        .stdOut = {},
+        .stdErr = std::string(4096, 'w'),
+        .stats = js::ProcessStats{.pid = 4243,
+                                  .spawn = 1'700'000'000'000'000,
+                                  .exec = 1'700'000'000'000'120,
+                                  .exit = 1'700'000'000'950'000,
+                                  .userTime = 880'000,
+                                  .systemTime = 60'000,
+                                  .maxRss = 210'000},
+    };
+}
+
+std::vector<std::string> strings() {
+    std::vector<std::string> values;
+    for(int i = 0; i < 100; ++i) {
+        values.push_back(std::format("-I/home/user/project/third_party/lib{}/include", i));
+    }
+    return values;
+}
+
+std::string echo(std::string value) {
+    return value;
+}
+
+int64_t add_one(int64_t value) {
+    return value + 1;
+}
+
+kota::task<int64_t, qjs::Error> answer() {
+    co_return 42;
+}
+
+/// Run `body` with a running `JsLoop`, as the script of catter runs.
+template <typename Body>
+void with_js_loop(Body body) {
+    auto task = [](Body body) -> kota::task<> {
+        auto runtime = qjs::Runtime::create();
+        auto ctx = runtime.context();
+        js::JsLoop js_loop;
+
+        auto& loop = kota::event_loop::current();
+        loop.schedule(js_loop.run(runtime, loop));
+
+        std::exception_ptr error;
+        try {
+            co_await body(ctx, js_loop);
+        } catch(...) {
+            error = std::current_exception();
+        }
+
+        co_await js_loop.stop();
+
+        if(error) {
+            std::rethrow_exception(error);
+        }
+    }(std::move(body));
+
+    kota::event_loop loop;
+    loop.schedule(task);
+    loop.run();
+    task.result();
+}
+
+}  // namespace
+
+BENCHMARK("bridge/command_data/to_js") {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    auto command = compile_command();
+    for(auto _: state) {
+        auto object = command.to_object(ctx.js_context());
+        do_not_optimize(object);
+    }
+}
+
+BENCHMARK("bridge/command_data/lazy_object") {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    auto command = compile_command();
+    for(auto _: state) {
+        state.pause();
+        auto copy = command;
+        state.resume();
+        auto object = js::make_command_object(ctx.js_context(), std::move(copy));
+        do_not_optimize(object);
+    }
+}
+
+BENCHMARK("bridge/command_data/from_js") {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    auto object = compile_command().to_object(ctx.js_context());
+    for(auto _: state) {
+        auto command = js::CommandData::make(object);
+        do_not_optimize(command);
+    }
+}
+
+BENCHMARK("bridge/process_result/to_js") {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    auto result = compile_result();
+    for(auto _: state) {
+        auto object = result.to_object(ctx.js_context());
+        do_not_optimize(object);
+    }
+}
+
+BENCHMARK("bridge/process_result/from_js") {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    auto object = compile_result().to_object(ctx.js_context());
+    for(auto _: state) {
+        auto result = js::ProcessResult::make(object);
+        do_not_optimize(result);
+    }
+}
+
+BENCHMARK("bridge/strings_x100/to_js") {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    auto values = strings();
+    for(auto _: state) {
+        auto array = js::Bridge<std::vector<std::string>>::to_js(ctx.js_context(), values);
+        do_not_optimize(array);
+    }
+}
+
+BENCHMARK("bridge/strings_x100/from_js") {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    qjs::Value array{js::Bridge<std::vector<std::string>>::to_js(ctx.js_context(), strings())};
+    for(auto _: state) {
+        auto values = js::Bridge<std::vector<std::string>>::from_js(array);
+        do_not_optimize(values);
+    }
+}
+
+BENCHMARK("function/cpp_to_js") {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    auto add = ctx.eval("(x) => x + 1", "<eval>", eval_flags)
+                   .as<qjs::Function<int64_t(int64_t)>>();
+    int64_t value = 0;
+    for(auto _: state) {
+        value = add(value);
+    }
+    do_not_optimize(value);
+}
+
+BENCHMARK("function/js_to_cpp_x1000") {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    ctx.global_this().set_property(
+        "addOne",
+        qjs::Function<int64_t(int64_t)>::from(ctx.js_context(),
+                                              [](int64_t value) { return value + 1; }));
+    auto calls = ctx.eval("(n) => { let x = 0; for (let i = 0; i < n; i++) x = addOne(x); }",
+                          "<eval>",
+                          eval_flags)
+                     .as<qjs::Function<void(int64_t)>>();
+    for(auto _: state) {
+        calls(1000);
+    }
+}
+
+BENCHMARK("capi/raw") {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    auto fn = qjs::Function<int64_t(int64_t)>::from_raw<&add_one>(ctx.js_context(), "add_one");
+    int64_t value = 0;
+    for(auto _: state) {
+        value = fn(value);
+    }
+    do_not_optimize(value);
+}
+
+BENCHMARK("capi/hooked") {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    auto fn = apitool::to_js_function<&add_one>(ctx.js_context(), "add_one");
+    int64_t value = 0;
+    for(auto _: state) {
+        value = fn(value);
+    }
+    do_not_optimize(value);
+}
+
+BENCHMARK("capi/hooked_string") {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    auto fn = apitool::to_js_function<&echo>(ctx.js_context(), "echo");
+    std::string path = "/home/user/project/build/compile_commands.json";
+    for(auto _: state) {
+        auto value = fn(path);
+        do_not_optimize(value);
+    }
+}
+
+BENCHMARK("async/promise_to_task") {
+    with_js_loop([&state](qjs::Context& ctx, js::JsLoop& js_loop) -> kota::task<> {
+        for(auto _: state) {
+            auto cap = qjs::PromiseCapability::create(ctx.js_context());
+            cap.executor.resolve(int64_t{42});
+            auto value = co_await js_loop.promise_to_task<int64_t>(cap.promise);
+            if(!value) {
+                throw cpptrace::runtime_error("promise was rejected");
+            }
+            do_not_optimize(value);
+        }
+    });
+}
+
+BENCHMARK("async/task_round_trip") {
+    with_js_loop([&state](qjs::Context& ctx, js::JsLoop& js_loop) -> kota::task<> {
+        for(auto _: state) {
+            auto value = co_await js_loop.promise_to_task<int64_t>(
+                js_loop.task_to_promise(ctx.js_context(), answer()));
+            if(!value) {
+                throw cpptrace::runtime_error("promise was rejected");
+            }
+            do_not_optimize(value);
+        }
+    });
+}
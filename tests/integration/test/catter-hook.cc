@@ -14,7 +14,7 @@
 // RUN: %if !system-windows %{ %it_catter_hook --test posix_spawn | FileCheck %s --check-prefix=CHECK-OUTPUT %}
 // RUN: %if !system-windows %{ %it_catter_hook --test posix_spawnp | FileCheck %s --check-prefix=CHECK-OUTPUT %}
 
-// CHECK-OUTPUT: -p 0 --exec /bin/echo -- /bin/echo Hello, World!
+// CHECK-OUTPUT: -p 0 --origin {{[0-9]+:[0-9]+:[0-9]+}} --ipc {{"?}}it-catter-ipc{{"?}} --exec /bin/echo -- /bin/echo Hello, World!
 // clang-format on
 #include <format>
 #include <functional>
@@ -224,7 +224,7 @@ int main(int argc, char* argv[]) {
                 .args = {executable, args[2]},
                 .env = catter::util::get_environment(),
             };
-            auto task = catter::proxy::hook::run(cmd, 0);
+            auto task = catter::proxy::hook::run(cmd, 0, {.ipc_pipe = "it-catter-ipc"});
             kota::event_loop loop;
             loop.schedule(task);
             loop.run();
@@ -1,6 +1,9 @@
 // clang-format off
 // RUN: "%it_catter_proxy" "%catter_proxy" -p 0 --exec "%it_catter_proxy" -- it-catter-proxy --child | FileCheck %s --check-prefix=EXPLICIT -DIT_PROXY="%it_catter_proxy"
 // RUN: "%it_catter_proxy" "%catter_proxy" -p 0 -- "%it_catter_proxy" --child | FileCheck %s --check-prefix=IMPLICIT -DIT_PROXY="%it_catter_proxy"
+// RUN: "%it_catter_proxy" "%catter_proxy" -p 0 -- "%it_catter_proxy" --child-inherit | FileCheck %s --check-prefix=INHERIT -DIT_PROXY="%it_catter_proxy"
+// RUN: %if !system-windows %{ "%it_catter_proxy" "%catter_proxy" -p 0 -- cc -c fake.c -MD -o "%t.o" | FileCheck %s --check-prefix=FAKE %}
+// RUN: %if !system-windows %{ cat "%t.d" | FileCheck %s --check-prefix=FAKE-DEP %}
 // RUN: not "%it_catter_proxy" "%catter_proxy" -p 0 | FileCheck %s --check-prefix=MISSING
 // RUN: not "%it_catter_proxy" "%catter_proxy" -p 0 -- nonexistent-executable-catter-proxy-test | FileCheck %s --check-prefix=NONEXISTENT
 //
@@ -18,6 +21,20 @@
 // IMPLICIT-NEXT: event=finish code=0 stdout="child output" stderr=""
 // IMPLICIT-NEXT: proxy=exit code=0 stdout="child output" stderr=""
 //
+// INHERIT: event=create service=1 parent=0
+// INHERIT-NEXT: event=decision executable="[[IT_PROXY]]" cwd="{{.*}}" argc=2
+// INHERIT-NEXT: event=argument index=0 value="[[IT_PROXY]]"
+// INHERIT-NEXT: event=argument index=1 value="--child-inherit"
+// INHERIT-NEXT: event=finish code=0 stdout="" stderr=""
+// INHERIT-NEXT: proxy=exit code=0 stdout="child output" stderr=""
+//
+// FAKE: event=create service=1 parent=0
+// FAKE-NEXT: event=decision executable="{{.*}}cc" cwd="{{.*}}" argc=6
+// FAKE: event=finish code=0 stdout="" stderr=""
+// FAKE-NEXT: proxy=exit code=0 stdout="" stderr=""
+//
+// FAKE-DEP: {{.+}}.o: fake.c
+//
 // MISSING-NOT: event=create
 // MISSING-NOT: event=decision
 // MISSING-NOT: event=finish
@@ -44,6 +61,7 @@
 
 #include "ipc.h"
 #include "session.h"
+#include "config/ipc.h"
 #include "util/data.h"
 #include "util/log.h"
 
@@ -68,7 +86,24 @@ public:
         for(size_t index = 0; index < cmd.args.size(); ++index) {
             std::println(R"(event=argument index={} value="{}")", index, cmd.args[index]);
         }
-        co_return data::action{.type = data::action::WRAP, .cmd = std::move(cmd)};
+        if(cmd.args.front() == "cc") {
+            // nothing is compiled, the proxy writes placeholders of the outputs
+            co_return data::action{.type = data::action::FAKE, .cmd = std::move(cmd)};
+        }
+        // the child writes to the stdout of the proxy, which the session still captures
+        auto capture = cmd.args.back() == "--child-inherit" ? data::CaptureMode::INHERIT
+                                                            : data::CaptureMode::TAIL;
+        co_return data::action{.type = data::action::WRAP,
+                               .cmd = std::move(cmd),
+                               .capture = capture};
+    }
+
+    kota::task<> started(int64_t pid) override {
+        co_return;
+    }
+
+    kota::task<> detach() override {
+        co_return;
     }
 
     kota::task<> finish(data::process_result result) override {
@@ -99,8 +134,11 @@ namespace {
 int run_proxy(int argc, char* argv[]) {
     const std::string proxy_path = argv[1];
     std::vector<std::string> args;
-    args.reserve(static_cast<size_t>(argc - 1));
+    args.reserve(static_cast<size_t>(argc + 1));
     args.push_back(proxy_path);
+    // the socket of this session, which catter passes to every proxy
+    args.push_back("--ipc");
+    args.push_back(std::string(config::ipc::pipe_name()));
     for(int index = 2; index < argc; ++index) {
         args.emplace_back(argv[index]);
     }
@@ -127,7 +165,8 @@ int run_proxy(int argc, char* argv[]) {
 }  // namespace
 
 int main(int argc, char* argv[]) {
-    if(argc == 2 && std::string_view(argv[1]) == "--child") {
+    if(argc == 2 &&
+       (std::string_view(argv[1]) == "--child" || std::string_view(argv[1]) == "--child-inherit")) {
         std::print("child output");
         return 0;
     }
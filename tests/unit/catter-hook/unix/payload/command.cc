@@ -1,13 +1,16 @@
 #include "command.h"
 
 #include <filesystem>
+#include <format>
 #include <optional>
 #include <span>
 #include <string_view>
 #include <vector>
+#include <unistd.h>
 #include <kota/zest/macro.h>
 #include <kota/zest/zest.h>
 
+#include "crossplat.h"
 #include "session.h"
 
 namespace ct = catter;
@@ -15,6 +18,11 @@ namespace ct = catter;
 namespace {
 ct::Session session{.proxy_path = "/usr/local/bin/catter-proxy", .self_id = "99"};
 
+/// The commands are built in the calling process.
+std::string origin() {
+    return std::format("{}:{}:{}", ::getpid(), ::getppid(), get_thread_id());
+}
+
 TEST_SUITE(cmd_builder) {
 
 TEST_CASE(proxy_cmd_constructs_correct_arguments) {
@@ -37,6 +45,8 @@ TEST_CASE(proxy_cmd_constructs_correct_arguments) {
         session.proxy_path,
         "-p",
         session.self_id,
+        "--origin",
+        origin(),
         "--exec",
         target_path,
         "--",
@@ -47,6 +57,62 @@ TEST_CASE(proxy_cmd_constructs_correct_arguments) {
     EXPECT_TRUE(cmd.argv == expected_argv);
 };
 
+TEST_CASE(proxy_cmd_forwards_sockets) {
+    ct::Session direct_session = session;
+    direct_session.ipc_pipe = "/tmp/ipc.sock";
+    direct_session.direct_pipe = "/tmp/direct.sock";
+    direct_session.exec_filter_file = "/tmp/exec-filter.bin";
+
+    std::vector<const char*> original_argv = {"cc", nullptr};
+    auto cmd = ct::build_proxy_command(
+        direct_session,
+        "/usr/bin/cc",
+        std::span<const char* const>{original_argv.data(), original_argv.size() - 1});
+
+    std::vector<std::string> expected_argv = {
+        session.proxy_path,
+        "-p",
+        session.self_id,
+        "--origin",
+        origin(),
+        "--ipc",
+        "/tmp/ipc.sock",
+        "--direct",
+        "/tmp/direct.sock",
+        "--exec-filter",
+        "/tmp/exec-filter.bin",
+        "--exec",
+        "/usr/bin/cc",
+        "--",
+        "cc",
+    };
+    EXPECT_TRUE(cmd.argv == expected_argv);
+};
+
+TEST_CASE(proxy_cmd_forwards_changed_env_keys) {
+    std::vector<const char*> original_argv = {"cc", nullptr};
+    auto cmd = ct::build_proxy_command(
+        session,
+        "/usr/bin/cc",
+        std::span<const char* const>{original_argv.data(), original_argv.size() - 1},
+        "CC=PATH");
+
+    std::vector<std::string> expected_argv = {
+        session.proxy_path,
+        "-p",
+        session.self_id,
+        "--origin",
+        origin(),
+        "--env-changed",
+        "CC=PATH",
+        "--exec",
+        "/usr/bin/cc",
+        "--",
+        "cc",
+    };
+    EXPECT_TRUE(cmd.argv == expected_argv);
+};
+
 TEST_CASE(error_cmd_formats_message_correctly_without_separator) {
     std::filesystem::path target_path = "/usr/bin/invalid";
 
@@ -70,12 +136,14 @@ TEST_CASE(error_cmd_formats_message_correctly_without_separator) {
     EXPECT_TRUE(last_arg.find("Catter Proxy Error: File not found") != std::string::npos);
     EXPECT_TRUE(last_arg.find("in command: invalid --help") != std::string::npos);
 
-    EXPECT_TRUE(cmd.argv.size() == 6);
+    EXPECT_TRUE(cmd.argv.size() == 8);
     EXPECT_TRUE(cmd.argv.at(0) == session.proxy_path);
     EXPECT_TRUE(cmd.argv.at(1) == "-p");
     EXPECT_TRUE(cmd.argv.at(2) == session.self_id);
-    EXPECT_TRUE(cmd.argv.at(3) == "--exec");
-    EXPECT_TRUE(cmd.argv.at(4) == target_path);
+    EXPECT_TRUE(cmd.argv.at(3) == "--origin");
+    EXPECT_TRUE(cmd.argv.at(4) == origin());
+    EXPECT_TRUE(cmd.argv.at(5) == "--exec");
+    EXPECT_TRUE(cmd.argv.at(6) == target_path);
 };
 };  // TEST_SUITE(cmd_builder)
 }  // namespace
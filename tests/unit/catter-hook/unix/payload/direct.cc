@@ -0,0 +1,81 @@
+#include "direct.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <kota/zest/zest.h>
+
+#include "environment.h"
+#include "unix/config.h"
+
+namespace ct = catter;
+namespace cfg = catter::config::hook;
+
+namespace {
+
+const char* find_entry(char* const* envp, std::string_view key) {
+    for(std::size_t i = 0; envp[i] != nullptr; ++i) {
+        if(ct::env::is_entry_of(envp[i], key)) {
+            return envp[i];
+        }
+    }
+    return nullptr;
+}
+
+TEST_SUITE(direct_payload) {
+TEST_CASE(find_hook_library_picks_hook_from_preload) {
+    std::string hook_lib = std::string("/opt/catter/") + cfg::HOOK_LIB_NAME;
+    std::string preload = std::string(cfg::KEY_PRELOAD) + "=/tmp/libkeep.so:" + hook_lib;
+
+    const char* env[] = {"LANG=C", preload.c_str(), nullptr};
+    EXPECT_TRUE(ct::find_hook_library(env) == hook_lib);
+
+    const char* without_hook[] = {"LANG=C", nullptr};
+    EXPECT_TRUE(ct::find_hook_library(without_hook).empty());
+};
+
+TEST_CASE(attach_environment_restores_hook_and_replaces_id) {
+    std::string hook_lib = std::string("/opt/catter/") + cfg::HOOK_LIB_NAME;
+    std::string old_id = std::string(cfg::KEY_CATTER_COMMAND_ID) + "=7";
+    std::string proxy = std::string(cfg::KEY_CATTER_PROXY_PATH) + "=/opt/catter/catter-proxy";
+    std::string ipc = std::string(cfg::KEY_CATTER_IPC_PIPE) + "=/tmp/ipc.sock";
+    std::string direct = std::string(cfg::KEY_CATTER_DIRECT_PIPE) + "=/tmp/direct.sock";
+    std::string preload = std::string(cfg::KEY_PRELOAD) + "=" + hook_lib;
+    const char* envp[] = {
+        old_id.c_str(),
+        proxy.c_str(),
+        ipc.c_str(),
+        direct.c_str(),
+        preload.c_str(),
+        nullptr,
+    };
+
+    std::string lang = "LANG=C";
+    char* clean_env[] = {lang.data(), nullptr};
+
+    auto attached = ct::attach_environment(envp, clean_env, hook_lib, 42);
+    auto result = attached.data();
+
+    EXPECT_TRUE(std::string_view(find_entry(result, "LANG")) == lang);
+    EXPECT_TRUE(std::string_view(find_entry(result, cfg::KEY_PRELOAD)) == preload);
+    EXPECT_TRUE(std::string_view(find_entry(result, cfg::KEY_CATTER_COMMAND_ID)) ==
+                std::string(cfg::KEY_CATTER_COMMAND_ID) + "=42");
+    EXPECT_TRUE(std::string_view(find_entry(result, cfg::KEY_CATTER_PROXY_PATH)) == proxy);
+    EXPECT_TRUE(std::string_view(find_entry(result, cfg::KEY_CATTER_IPC_PIPE)) == ipc);
+    EXPECT_TRUE(std::string_view(find_entry(result, cfg::KEY_CATTER_DIRECT_PIPE)) == direct);
+};
+
+TEST_CASE(attach_environment_appends_to_existing_preload) {
+    std::string hook_lib = std::string("/opt/catter/") + cfg::HOOK_LIB_NAME;
+    const char* envp[] = {nullptr};
+
+    std::string user_preload = std::string(cfg::KEY_PRELOAD) + "=/tmp/libuser.so";
+    char* env[] = {user_preload.data(), nullptr};
+
+    auto attached = ct::attach_environment(envp, env, hook_lib, 1);
+    EXPECT_TRUE(std::string_view(find_entry(attached.data(), cfg::KEY_PRELOAD)) ==
+                user_preload + ":" + hook_lib);
+};
+};  // TEST_SUITE(direct_payload)
+
+}  // namespace
@@ -1,6 +1,7 @@
 #include "env_sanitizer.h"
 
 #include <cstddef>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <kota/zest/zest.h>
@@ -63,6 +64,92 @@ TEST_CASE(preload_becomes_empty_when_only_hook_entry_exists) {
     auto cleaned_preload = find_entry(clean_envp, cfg::KEY_PRELOAD);
     EXPECT_TRUE(cleaned_preload == nullptr);
 };
+
+TEST_CASE(changed_keys_cover_modified_added_and_removed_entries) {
+    std::string path = "PATH=/usr/bin";
+    std::string lang = "LANG=C";
+    std::string home = "HOME=/root";
+    char* initial[] = {path.data(), lang.data(), home.data(), nullptr};
+    std::string_view storage[3];
+    auto snapshot = ct::snapshot_environment(initial, storage);
+    EXPECT_TRUE(snapshot.has_value());
+
+    EXPECT_TRUE(ct::changed_environment_keys(*snapshot, initial) == "");
+
+    std::string new_path = "PATH=/opt/bin:/usr/bin";
+    std::string cc = "CC=clang";
+    char* current[] = {cc.data(), home.data(), new_path.data(), nullptr};
+    EXPECT_TRUE(ct::changed_environment_keys(*snapshot, current) == "CC=LANG=PATH");
+};
+
+TEST_CASE(changed_keys_always_report_preload) {
+    std::string preload = std::string(cfg::KEY_PRELOAD) + "=/tmp/libkeep.so";
+    char* env[] = {preload.data(), nullptr};
+    std::string_view storage[1];
+    auto snapshot = ct::snapshot_environment(env, storage);
+    EXPECT_TRUE(snapshot.has_value());
+    EXPECT_TRUE(ct::changed_environment_keys(*snapshot, env) == std::string(cfg::KEY_PRELOAD));
+};
+
+TEST_CASE(snapshot_holds_what_the_command_sees) {
+    std::string hook_lib = "/tmp/";
+    hook_lib += cfg::RELATIVE_PATH_OF_HOOK_LIB;
+    std::string command_id = std::string(cfg::KEY_CATTER_COMMAND_ID) + "=42";
+    std::string hook_only = std::string(cfg::KEY_PRELOAD) + "=" + hook_lib;
+    std::string lang = "LANG=C";
+    std::string cc = "CC=clang";
+    char* env[] = {lang.data(), command_id.data(), hook_only.data(), cc.data(), nullptr};
+
+    std::string_view storage[2];
+    auto snapshot = ct::snapshot_environment(env, storage);
+    ASSERT_TRUE(snapshot.has_value());
+    ASSERT_TRUE(snapshot->size() == 2);
+    EXPECT_TRUE((*snapshot)[0] == cc);
+    EXPECT_TRUE((*snapshot)[1] == lang);
+    EXPECT_TRUE(ct::changed_environment_keys(*snapshot, ct::sanitize_environment(env).data()) ==
+                "");
+
+    // a preload entry which keeps a library is still there for the command
+    std::string preload = std::string(cfg::KEY_PRELOAD) + "=/tmp/libkeep.so:" + hook_lib;
+    char* preloaded[] = {lang.data(), preload.data(), cc.data(), nullptr};
+    EXPECT_FALSE(ct::snapshot_environment(preloaded, storage).has_value());
+    std::string_view more[3];
+    snapshot = ct::snapshot_environment(preloaded, more);
+    ASSERT_TRUE(snapshot.has_value());
+    EXPECT_TRUE(snapshot->size() == 3);
+};
+
+TEST_CASE(duplicated_keys_can_not_be_described) {
+    std::string first = "A=1";
+    std::string second = "A=2";
+    char* env[] = {first.data(), second.data(), nullptr};
+    std::string_view storage[2];
+    EXPECT_FALSE(ct::snapshot_environment(env, storage).has_value());
+
+    char* clean[] = {first.data(), nullptr};
+    auto snapshot = ct::snapshot_environment(clean, storage);
+    EXPECT_FALSE(ct::changed_environment_keys(*snapshot, env).has_value());
+};
+
+TEST_CASE(pass_through_environment_describes_its_base) {
+    std::string lang = "LANG=C";
+    std::string added = "ADDED=1";
+    std::string stale = std::string(cfg::KEY_CATTER_ENV_CHANGED) + "=OLD";
+    char* start[] = {lang.data(), nullptr};
+    std::string_view storage[1];
+    auto snapshot = ct::snapshot_environment(start, storage);
+
+    char* env[] = {lang.data(), added.data(), stale.data(), nullptr};
+    auto passed = ct::pass_through_environment(env, snapshot, "BASE");
+    EXPECT_TRUE(find_entry(passed.data(), "ADDED") != nullptr);
+    EXPECT_TRUE(std::string_view(find_entry(passed.data(), cfg::KEY_CATTER_ENV_CHANGED)) ==
+                std::string(cfg::KEY_CATTER_ENV_CHANGED) + "=BASE=ADDED");
+
+    // without a snapshot the process can not tell its base either
+    auto unknown = ct::pass_through_environment(env, std::nullopt, "");
+    EXPECT_TRUE(std::string_view(find_entry(unknown.data(), cfg::KEY_CATTER_ENV_CHANGED)) ==
+                std::string(cfg::KEY_CATTER_ENV_CHANGED) + "=" + cfg::ENV_CHANGED_UNKNOWN);
+};
 };  // TEST_SUITE(env_sanitizer)
 
 }  // namespace
@@ -1,8 +1,10 @@
 #include "executor.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdlib>
 #include <filesystem>
+#include <format>
 #include <initializer_list>
 #include <optional>
 #include <string>
@@ -10,10 +12,13 @@
 #include <system_error>
 #include <vector>
 #include <spawn.h>
+#include <unistd.h>
 #include <kota/zest/zest.h>
 
 #include "temp_file_manager.h"
 #include "unix/config.h"
+#include "util/env_delta.h"
+#include "util/exec_filter.h"
 
 namespace ct = catter;
 namespace cfg = catter::config::hook;
@@ -142,14 +147,17 @@ void expect_proxy_command(const CapturedCall& call,
                           const fs::path& executable,
                           std::string_view argv0) {
     EXPECT_TRUE(call.path == session.proxy_path);
-    EXPECT_TRUE(call.argv.size() >= 7);
+    EXPECT_TRUE(call.argv.size() >= 9);
     EXPECT_TRUE(call.argv.at(0) == session.proxy_path);
     EXPECT_TRUE(call.argv.at(1) == "-p");
     EXPECT_TRUE(call.argv.at(2) == session.self_id);
-    EXPECT_TRUE(call.argv.at(3) == "--exec");
-    EXPECT_TRUE(call.argv.at(4) == executable.string());
-    EXPECT_TRUE(call.argv.at(5) == "--");
-    EXPECT_TRUE(call.argv.at(6) == argv0);
+    EXPECT_TRUE(call.argv.at(3) == "--origin");
+    // the fakes run in the calling process
+    EXPECT_TRUE(call.argv.at(4).starts_with(std::format("{}:{}:", ::getpid(), ::getppid())));
+    EXPECT_TRUE(call.argv.at(5) == "--exec");
+    EXPECT_TRUE(call.argv.at(6) == executable.string());
+    EXPECT_TRUE(call.argv.at(7) == "--");
+    EXPECT_TRUE(call.argv.at(8) == argv0);
 }
 
 TEST_SUITE(executor) {
@@ -176,8 +184,8 @@ TEST_CASE(execve_builds_proxy_command_with_sanitized_environment) {
     EXPECT_TRUE(result == 42);
     EXPECT_TRUE(exec_call.calls == 1);
     expect_proxy_command(exec_call, valid_session, executable, "execve-tool");
-    EXPECT_TRUE(exec_call.argv.at(7) == "-c");
-    EXPECT_TRUE(exec_call.argv.at(8) == "main.cc");
+    EXPECT_TRUE(exec_call.argv.at(9) == "-c");
+    EXPECT_TRUE(exec_call.argv.at(10) == "main.cc");
     EXPECT_TRUE(!has_env_entry(exec_call.envp, cfg::KEY_CATTER_COMMAND_ID));
     EXPECT_TRUE(!has_env_entry(exec_call.envp, cfg::KEY_CATTER_PROXY_PATH));
     EXPECT_TRUE(has_env_entry(exec_call.envp, "LANG"));
@@ -274,6 +282,69 @@ TEST_CASE(spawn_boundary_returns_error_code) {
     EXPECT_TRUE(spawn_call.calls == 0);
 }
 
+TEST_CASE(filtered_shell_passes_on_the_environment_of_its_command) {
+    exec_call.reset();
+    auto shell = create_executable("filtered-sh");
+    auto compiler = create_executable("filtered-cc");
+    auto content = catter::util::ExecFilter::encode(std::vector<std::string>{"filtered-sh"});
+
+    // the command catter knows, as its proxy started it
+    std::string proxy_path = std::string(cfg::KEY_CATTER_PROXY_PATH) + "=/tmp/catter-proxy";
+    std::string command_id = std::string(cfg::KEY_CATTER_COMMAND_ID) + "=7";
+    MutableCStrings command_env = {proxy_path, command_id, "HOME=/home/user", "CFLAGS=-O0"};
+    auto make_session = ct::Session::make(command_env.data());
+    std::string_view make_snapshot[8];
+    make_session.load(command_env.data(), make_snapshot);
+    make_session.exec_filter = catter::util::ExecFilter::decode(content);
+
+    // make exports variables and runs a shell, which the hook lets through
+    MutableCStrings make_env =
+        {proxy_path, command_id, "HOME=/home/user", "CFLAGS=-O2", "EXPORTED=1"};
+    MutableCStrings shell_argv = {"sh", "-c", "cc -c main.c"};
+    ct::Executor make;
+    make.init(make_session, fake_execve, fake_posix_spawn);
+    make.execve(shell.c_str(), shell_argv.data(), make_env.data());
+    ASSERT_TRUE(exec_call.path == shell.string());
+
+    // the shell starts with that environment, changes it again and runs the compiler
+    auto shell_env = exec_call.envp;
+    std::vector<char*> shell_envp;
+    for(auto& entry: shell_env) {
+        shell_envp.push_back(entry.data());
+    }
+    shell_envp.push_back(nullptr);
+    auto shell_session = ct::Session::make(shell_envp.data());
+    std::string_view shell_snapshot[8];
+    shell_session.load(shell_envp.data(), shell_snapshot);
+    EXPECT_TRUE(shell_session.self_id == "7");
+
+    std::string shell_set = "SHELL_SET=1";
+    shell_envp.back() = shell_set.data();
+    shell_envp.push_back(nullptr);
+
+    MutableCStrings compiler_argv = {"cc", "-c", "main.c"};
+    ct::Executor sh;
+    sh.init(shell_session, fake_execve, fake_posix_spawn);
+    sh.execve(compiler.c_str(), compiler_argv.data(), shell_envp.data());
+    EXPECT_TRUE(exec_call.path == shell_session.proxy_path);
+
+    // catter rebuilds the environment of the compiler from the one of the command
+    auto flag = std::ranges::find(exec_call.argv, "--env-changed");
+    ASSERT_TRUE(flag != exec_call.argv.end() && flag + 1 != exec_call.argv.end());
+    std::vector<std::string> rebuilt = {"HOME=/home/user", "CFLAGS=-O0"};
+    std::vector<std::string> changed;
+    std::vector<std::string> unset;
+    catter::env_delta::select(exec_call.envp, *(flag + 1), changed, unset);
+    catter::env_delta::apply(rebuilt, changed, unset);
+
+    auto expected = exec_call.envp;
+    std::ranges::sort(expected);
+    std::ranges::sort(rebuilt);
+    EXPECT_TRUE(rebuilt == expected);
+    EXPECT_TRUE(std::ranges::find(rebuilt, "EXPORTED=1") != rebuilt.end());
+    EXPECT_TRUE(std::ranges::find(rebuilt, "CFLAGS=-O2") != rebuilt.end());
+}
+
 };  // TEST_SUITE(executor)
 
 }  // namespace
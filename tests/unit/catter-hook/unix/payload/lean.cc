@@ -0,0 +1,168 @@
+#include "lean.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include <kota/zest/zest.h>
+
+#include "command.h"
+#include "env_sanitizer.h"
+#include "session.h"
+#include "temp_file_manager.h"
+#include "shared/resolver.h"
+#include "unix/config.h"
+
+namespace ct = catter;
+namespace cfg = catter::config::hook;
+namespace fs = std::filesystem;
+
+namespace {
+
+ct::TempFileManager manager("./tmp-lean");
+
+std::vector<std::string> collect_values(char* const values[]) {
+    std::vector<std::string> result;
+    for(std::size_t i = 0; values != nullptr && values[i] != nullptr; ++i) {
+        result.emplace_back(values[i]);
+    }
+    return result;
+}
+
+std::vector<char*> c_strings(std::vector<std::string>& values) {
+    std::vector<char*> result;
+    for(auto& value: values) {
+        result.push_back(value.data());
+    }
+    result.push_back(nullptr);
+    return result;
+}
+
+TEST_SUITE(lean) {
+
+TEST_CASE(proxy_exec_matches_full_route) {
+    std::vector<std::string> initial = {"HOME=/home/user", "LANG=C", "PATH=/usr/bin"};
+    auto initial_ptrs = c_strings(initial);
+    std::string_view snapshot[4];
+    ct::Session session{
+        .proxy_path = "/tmp/catter-proxy",
+        .self_id = "7",
+        .ipc_pipe = "/tmp/catter.sock",
+        .initial_env = ct::snapshot_environment(initial_ptrs.data(), snapshot),
+        .exec_filter_file = "/tmp/exec-filter-1.bin",
+    };
+
+    std::vector<std::string> env = {
+        std::string(cfg::KEY_CATTER_COMMAND_ID) + "=99",
+        "PATH=/opt/bin:/usr/bin",
+        std::string(cfg::KEY_PRELOAD) + "=/tmp/libkeep.so::/tmp/" + cfg::HOOK_LIB_NAME + ":",
+        "LANG=C",
+        "CC=clang",
+    };
+    std::vector<std::string> args = {"clang", "-c", "main.cc"};
+    auto envp = c_strings(env);
+    auto argv = c_strings(args);
+
+    ct::lean::Arena arena;
+    auto exec = ct::lean::proxy_exec(arena, session, "/usr/bin/clang", argv.data(), envp.data());
+    ASSERT_TRUE(exec.has_value());
+
+    auto clean_env = ct::sanitize_environment(envp.data());
+    auto env_changed = ct::changed_environment_keys(*session.initial_env, clean_env.data());
+    auto command = ct::build_proxy_command(session,
+                                           "/usr/bin/clang",
+                                           ct::ArgvRef(argv.data(), args.size()),
+                                           env_changed);
+
+    EXPECT_TRUE(exec->path == session.proxy_path);
+    // the same thread of the same process, so even the origin is the same
+    EXPECT_TRUE(collect_values(exec->argv) == command.argv);
+    EXPECT_TRUE(collect_values(exec->envp) == collect_values(clean_env.data()));
+};
+
+TEST_CASE(pass_through_environment_matches_full_route) {
+    std::vector<std::string> initial = {"HOME=/home/user", "LANG=C"};
+    auto initial_ptrs = c_strings(initial);
+    std::string_view snapshot[2];
+    ct::Session session{
+        .proxy_path = "/tmp/catter-proxy",
+        .self_id = "7",
+        .initial_env = ct::snapshot_environment(initial_ptrs.data(), snapshot),
+        .base_changes = "BASE",
+    };
+
+    std::vector<std::string> env = {
+        std::string(cfg::KEY_CATTER_COMMAND_ID) + "=7",
+        std::string(cfg::KEY_CATTER_ENV_CHANGED) + "=OLD",
+        "LANG=en_US.UTF-8",
+        "EXPORTED=1",
+    };
+    auto envp = c_strings(env);
+
+    ct::lean::Arena arena;
+    auto* passed = ct::lean::pass_through_environment(arena, session, envp.data());
+    ASSERT_TRUE(passed != nullptr);
+    auto full = ct::pass_through_environment(envp.data(), session.initial_env, "BASE");
+    EXPECT_TRUE(collect_values(passed) == collect_values(full.data()));
+
+    ct::Session unknown{.proxy_path = "/tmp/catter-proxy", .self_id = "7"};
+    passed = ct::lean::pass_through_environment(arena, unknown, envp.data());
+    ASSERT_TRUE(passed != nullptr);
+    full = ct::pass_through_environment(envp.data(), std::nullopt, "");
+    EXPECT_TRUE(collect_values(passed) == collect_values(full.data()));
+};
+
+TEST_CASE(unusual_calls_take_the_full_route) {
+    std::vector<std::string> args = {"tool"};
+    auto argv = c_strings(args);
+
+    ct::Session direct{.proxy_path = "/tmp/catter-proxy",
+                       .self_id = "7",
+                       .direct_pipe = "/tmp/direct.sock"};
+    ct::lean::Arena arena;
+    EXPECT_FALSE(ct::lean::proxy_exec(arena, direct, "/bin/tool", argv.data(), nullptr));
+
+    ct::Session invalid{};
+    EXPECT_FALSE(ct::lean::proxy_exec(arena, invalid, "/bin/tool", argv.data(), nullptr));
+
+    // a command which does not fit
+    ct::Session session{.proxy_path = "/tmp/catter-proxy", .self_id = "7"};
+    std::vector<std::string> many(ct::lean::Arena::capacity / sizeof(char*), "-Iinclude");
+    auto long_argv = c_strings(many);
+    ct::lean::Arena small;
+    EXPECT_FALSE(ct::lean::proxy_exec(small, session, "/bin/tool", long_argv.data(), nullptr));
+    EXPECT_TRUE(small.exhausted());
+};
+
+TEST_CASE(resolves_as_the_resolver) {
+    std::error_code ec;
+    manager.create("bin/lean-tool", ec);
+    EXPECT_TRUE(!ec);
+    auto dir = fs::absolute(manager.root / "bin").string();
+    auto search_path = std::string("::/definitely/missing:") + dir + ":";
+
+    ct::lean::Arena arena;
+    auto* resolved = ct::lean::resolve_from_search_path(arena, "lean-tool", search_path.c_str());
+    auto expected =
+        ct::hook::shared::resolver::resolve_from_search_path("lean-tool", search_path.c_str());
+    ASSERT_TRUE(resolved != nullptr && expected.has_value());
+    EXPECT_TRUE(std::string_view(resolved) == expected->string());
+
+    auto with_slash = dir + "/";
+    resolved = ct::lean::resolve_from_search_path(arena, "lean-tool", with_slash.c_str());
+    ASSERT_TRUE(resolved != nullptr);
+    EXPECT_TRUE(std::string_view(resolved) == expected->string());
+
+    EXPECT_TRUE(ct::lean::resolve_from_search_path(arena, "missing", search_path.c_str()) ==
+                nullptr);
+    EXPECT_TRUE(ct::lean::resolve_path_like("/definitely/missing/tool") == nullptr);
+    // a directory is not an executable
+    EXPECT_TRUE(ct::lean::resolve_path_like(dir.c_str()) == nullptr);
+};
+
+};  // TEST_SUITE(lean)
+
+}  // namespace
@@ -1,6 +1,7 @@
 
 #include "win/payload/util.h"
 
+#include <format>
 #include <string>
 #include <windows.h>
 #include <kota/zest/zest.h>
@@ -46,28 +47,44 @@ TEST_CASE(get_ipc_id_reads_environment_variable) {
     EXPECT_TRUE(ct::win::payload::get_ipc_id<wchar_t>() == L"12345");
 };
 
+TEST_CASE(get_ipc_pipe_reads_environment_variable) {
+    ScopedEnvVar scope(L"CATTER_IPC_PIPE", LR"(\\.\pipe\catter-ipc-1f)");
+    EXPECT_TRUE(ct::win::payload::get_ipc_pipe<char>() == R"(\\.\pipe\catter-ipc-1f)");
+    EXPECT_TRUE(ct::win::payload::get_ipc_pipe<wchar_t>() == LR"(\\.\pipe\catter-ipc-1f)");
+};
+
+TEST_CASE(get_origin_names_the_calling_process) {
+    auto origin = std::format("{}:0:{}", GetCurrentProcessId(), GetCurrentThreadId());
+    EXPECT_TRUE(ct::win::payload::get_origin<char>() == origin);
+    EXPECT_TRUE(ct::win::payload::get_origin<wchar_t>().size() == origin.size());
+};
+
 TEST_CASE(build_proxy_command_quotes_proxy_and_exec_paths) {
     auto command =
         ct::win::payload::build_proxy_command<char>(R"(C:\Program Files\Catter\catter-proxy.exe)",
                                                     "12345",
+                                                    "4242:0:7",
+                                                    R"(\\.\pipe\catter-ipc-1f)",
                                                     R"(C:\Program Files\LLVM\bin\clang-cl.exe)",
                                                     R"("clang-cl.exe" /c main.cc)");
 
     EXPECT_TRUE(
         command ==
-        R"("C:\Program Files\Catter\catter-proxy.exe" -p 12345 --exec "C:\Program Files\LLVM\bin\clang-cl.exe" -- "clang-cl.exe" /c main.cc)");
+        R"("C:\Program Files\Catter\catter-proxy.exe" -p 12345 --origin 4242:0:7 --ipc "\\.\pipe\catter-ipc-1f" --exec "C:\Program Files\LLVM\bin\clang-cl.exe" -- "clang-cl.exe" /c main.cc)");
 };
 
 TEST_CASE(build_proxy_command_supports_wide_strings) {
     auto command = ct::win::payload::build_proxy_command<wchar_t>(
         LR"(C:\Program Files\Catter\catter-proxy.exe)",
         L"12345",
+        L"4242:0:7",
+        LR"(\\.\pipe\catter-ipc-1f)",
         LR"(C:\Program Files\LLVM\bin\clang-cl.exe)",
         LR"("clang-cl.exe" /c main.cc)");
 
     EXPECT_TRUE(
         command ==
-        LR"("C:\Program Files\Catter\catter-proxy.exe" -p 12345 --exec "C:\Program Files\LLVM\bin\clang-cl.exe" -- "clang-cl.exe" /c main.cc)");
+        LR"("C:\Program Files\Catter\catter-proxy.exe" -p 12345 --origin 4242:0:7 --ipc "\\.\pipe\catter-ipc-1f" --exec "C:\Program Files\LLVM\bin\clang-cl.exe" -- "clang-cl.exe" /c main.cc)");
 };
 };  // TEST_SUITE(win_payload_util)
 
@@ -0,0 +1,88 @@
+#include "cdb_store.h"
+
+#include <exception>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <kota/zest/macro.h>
+#include <kota/zest/zest.h>
+
+using namespace catter;
+
+namespace {
+
+std::string join_key(std::string_view directory, std::string_view file) {
+    return std::string(directory) + "/" + std::string(file);
+}
+
+std::vector<std::string> entries_of(const core::CDBStore& store,
+                                    const std::unordered_set<std::string>& excluded = {}) {
+    std::vector<std::string> entries;
+    store.for_each(excluded, [&](std::string_view entry) { entries.emplace_back(entry); });
+    return entries;
+}
+
+bool parse_fails(std::string content) {
+    try {
+        (void)core::CDBStore::parse(std::move(content), join_key, "db");
+    } catch(const std::exception&) {
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+TEST_SUITE(cdb_store) {
+TEST_CASE(entries_are_grouped_and_deduplicated) {
+    auto store = core::CDBStore::parse(R"([
+  {"directory": "/b", "file": "a.cc", "arguments": ["cc", "-c", "a.cc"], "extra": [1, {}]},
+  {"directory": "/b", "file": "b.cc", "command": "cc -c b.cc \"é\""},
+  {"directory": "/b", "file": "a.cc", "arguments": ["cc", "-c", "a.cc"], "v": 2},
+  {"directory": "/b", "file": "a.cc", "arguments": ["cc", "-c", "a.cc", "-O2"]}
+])",
+                                       join_key,
+                                       "db");
+
+    auto all = entries_of(store);
+    EXPECT_TRUE(all.size() == 3);
+    EXPECT_TRUE(all[0].ends_with(R"("v": 2})"));
+    EXPECT_TRUE(all[1].ends_with(R"("-O2"]})"));
+    EXPECT_TRUE(all[2].contains("b.cc"));
+
+    auto rest = entries_of(store, {"/b/a.cc"});
+    EXPECT_TRUE(rest.size() == 1);
+    EXPECT_TRUE(rest[0] == all[2]);
+
+    EXPECT_TRUE(entries_of(core::CDBStore::parse(" \n", join_key, "db")).empty());
+    EXPECT_TRUE(entries_of(core::CDBStore::parse("[]", join_key, "db")).empty());
+};
+
+TEST_CASE(pretty_matches_json_stringify) {
+    EXPECT_TRUE(core::CDBStore::pretty(R"({"a":[ "x", {} ,[]],"b" : {"c": null}})") ==
+                "{\n"
+                "  \"a\": [\n"
+                "    \"x\",\n"
+                "    {},\n"
+                "    []\n"
+                "  ],\n"
+                "  \"b\": {\n"
+                "    \"c\": null\n"
+                "  }\n"
+                "}");
+};
+
+TEST_CASE(invalid_databases_are_rejected) {
+    EXPECT_TRUE(parse_fails(R"({})"));
+    EXPECT_TRUE(parse_fails(R"([1])"));
+    EXPECT_TRUE(parse_fails(R"([{"directory": "/b", "file": "a.cc"}])"));
+    EXPECT_TRUE(parse_fails(R"([{"directory": "", "file": "a.cc", "command": "cc"}])"));
+    EXPECT_TRUE(parse_fails(R"([{"directory": "/b", "file": "a.cc", "command": 1}])"));
+    EXPECT_TRUE(parse_fails(R"([{"directory": "/b", "file": "a.cc", "arguments": ["cc", 1]}])"));
+    EXPECT_TRUE(parse_fails(R"([{"directory": "/b", "file": "a.cc", "command": "cc"},])"));
+    EXPECT_TRUE(parse_fails(R"([{"directory": "/b", "file": "a.cc", "command": "c\q"}])"));
+    EXPECT_TRUE(parse_fails(R"([{"directory": "/b", "file": "a.cc", "command": "cc"}] [])"));
+};
+};  // TEST_SUITE(cdb_store)
@@ -0,0 +1,134 @@
+#include "decision_cache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <kota/zest/macro.h>
+#include <kota/zest/zest.h>
+
+#include "temp_file_manager.h"
+
+using namespace catter;
+using core::DecisionCache;
+
+namespace {
+
+uint64_t key_of(std::vector<std::string> argv, std::vector<std::string> env = {}) {
+    return DecisionCache::key("/src", argv.front(), argv, env);
+}
+
+DecisionCache::Entry fake_entry() {
+    return {
+        .action = js::ActionType::fake,
+        .ignore_descendants = true,
+        .state = R"([[{"cwd":"/src"}]])",
+    };
+}
+
+}  // namespace
+
+TEST_SUITE(decision_cache) {
+TEST_CASE(key_covers_the_whole_command) {
+    auto key = key_of({"cc", "-c", "a.c"});
+
+    EXPECT_EQ(key, key_of({"cc", "-c", "a.c"}));
+    EXPECT_TRUE(key != key_of({"cc", "-c", "b.c"}));
+    EXPECT_TRUE(key != key_of({"cc", "-c", "a.c"}, {"CFLAGS=-O2"}));
+    std::vector<std::string> argv = {"cc", "-c", "a.c"};
+    EXPECT_TRUE(key != DecisionCache::key("/other", "cc", argv, {}));
+    // arguments are not simply concatenated
+    EXPECT_TRUE(key_of({"cc", "-ca.c"}) != key_of({"cc", "-c", "a.c"}));
+};
+
+TEST_CASE(key_covers_response_files) {
+    auto root = std::filesystem::temp_directory_path() / "catter-decision-cache-response";
+    TempFileManager manager(root);
+    std::filesystem::create_directories(root);
+    auto cwd = root.string();
+    std::vector<std::string> argv = {"cc", "@args.rsp"};
+
+    auto missing = DecisionCache::key(cwd, "cc", argv, {});
+    std::ofstream(root / "args.rsp", std::ios::binary | std::ios::trunc) << "";
+    auto empty = DecisionCache::key(cwd, "cc", argv, {});
+    EXPECT_TRUE(missing != empty);
+
+    std::ofstream(root / "args.rsp", std::ios::binary | std::ios::trunc) << "-c a.c";
+    auto key = DecisionCache::key(cwd, "cc", argv, {});
+    EXPECT_TRUE(key != empty);
+    EXPECT_EQ(key, DecisionCache::key(cwd, "cc", argv, {}));
+
+    std::ofstream(root / "args.rsp", std::ios::binary | std::ios::trunc) << "-c b.c";
+    EXPECT_TRUE(key != DecisionCache::key(cwd, "cc", argv, {}));
+    // found through an absolute path as well
+    std::vector<std::string> absolute = {"cc", "@" + (root / "args.rsp").string()};
+    auto before = DecisionCache::key("/", "cc", absolute, {});
+    std::ofstream(root / "args.rsp", std::ios::binary | std::ios::trunc) << "-c c.c";
+    EXPECT_TRUE(before != DecisionCache::key("/", "cc", absolute, {}));
+};
+
+TEST_CASE(store_marks_changes_only) {
+    DecisionCache cache(1);
+    EXPECT_FALSE(cache.modified());
+    EXPECT_TRUE(cache.find(7) == nullptr);
+
+    cache.store(7, fake_entry());
+    ASSERT_TRUE(cache.find(7) != nullptr);
+    EXPECT_TRUE(*cache.find(7) == fake_entry());
+    EXPECT_TRUE(cache.modified());
+
+    auto loaded = DecisionCache::load("/nonexistent/catter/decisions.bin", 1);
+    EXPECT_EQ(loaded.size(), 0U);
+    loaded.store(7, fake_entry());
+    EXPECT_TRUE(loaded.modified());
+};
+
+TEST_CASE(save_and_load) {
+    auto root = std::filesystem::temp_directory_path() / "catter-decision-cache-test";
+    TempFileManager manager(root);
+    auto path = root / "nested" / "cache.bin";
+
+    DecisionCache cache(42);
+    cache.store(1, fake_entry());
+    cache.store(2,
+                {
+                    .action = js::ActionType::skip,
+                    .capture = js::CaptureMode::inherit,
+                    .state = "[null]",
+                });
+    cache.save(path);
+
+    auto loaded = DecisionCache::load(path, 42);
+    EXPECT_EQ(loaded.size(), 2U);
+    EXPECT_FALSE(loaded.modified());
+    ASSERT_TRUE(loaded.find(1) != nullptr);
+    EXPECT_TRUE(*loaded.find(1) == fake_entry());
+    ASSERT_TRUE(loaded.find(2) != nullptr);
+    EXPECT_TRUE(loaded.find(2)->capture == js::CaptureMode::inherit);
+
+    // storing what is already there needs no save
+    loaded.store(1, fake_entry());
+    EXPECT_FALSE(loaded.modified());
+
+    // decisions of another script are not trusted
+    EXPECT_EQ(DecisionCache::load(path, 43).size(), 0U);
+};
+
+TEST_CASE(truncated_file_is_dropped) {
+    auto root = std::filesystem::temp_directory_path() / "catter-decision-cache-truncated";
+    TempFileManager manager(root);
+    auto path = root / "cache.bin";
+
+    DecisionCache cache(42);
+    cache.store(1, fake_entry());
+    cache.store(2, fake_entry());
+    cache.save(path);
+
+    auto size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size - 3);
+    EXPECT_EQ(DecisionCache::load(path, 42).size(), 0U);
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "garbage";
+    EXPECT_EQ(DecisionCache::load(path, 42).size(), 0U);
+};
+};  // TEST_SUITE(decision_cache)
@@ -0,0 +1,82 @@
+#include "env_store.h"
+
+#include <exception>
+#include <string>
+#include <vector>
+#include <kota/zest/macro.h>
+#include <kota/zest/zest.h>
+
+#include "util/data.h"
+
+using namespace catter;
+
+TEST_SUITE(env_store) {
+TEST_CASE(children_resolve_against_stored_parent) {
+    core::EnvStore store;
+
+    auto root = store.resolve(data::command{.env = {"PATH=/usr/bin", "LANG=C"}});
+    store.store(1, root);
+
+    auto same = store.resolve(data::command{.env_base = 1});
+    EXPECT_TRUE(same == root);
+
+    auto child = store.resolve(data::command{
+        .env = {"CC=clang"},
+        .env_base = 1,
+        .env_unset = {"LANG"},
+    });
+    store.store(2, child);
+    EXPECT_TRUE(core::EnvStore::materialize(child) ==
+                std::vector<std::string>{"PATH=/usr/bin", "CC=clang"});
+
+    auto grandchild = store.resolve(data::command{.env = {"PATH=/opt/bin"}, .env_base = 2});
+    EXPECT_TRUE(core::EnvStore::materialize(grandchild) ==
+                std::vector<std::string>{"PATH=/opt/bin", "CC=clang"});
+    EXPECT_TRUE(core::EnvStore::materialize(root) ==
+                std::vector<std::string>{"PATH=/usr/bin", "LANG=C"});
+};
+
+TEST_CASE(find_reads_through_the_deltas) {
+    core::EnvStore store;
+    store.store(1, store.resolve(data::command{.env = {"PATH=/usr/bin", "LANG=C", "CC=gcc"}}));
+    auto child = store.resolve(data::command{
+        .env = {"CC=clang"},
+        .env_base = 1,
+        .env_unset = {"LANG"},
+    });
+
+    auto cc = core::EnvStore::find(child, "CC");
+    EXPECT_TRUE(cc != nullptr && *cc == "CC=clang");
+    auto path = core::EnvStore::find(child, "PATH");
+    EXPECT_TRUE(path != nullptr && *path == "PATH=/usr/bin");
+    EXPECT_TRUE(core::EnvStore::find(child, "LANG") == nullptr);
+    EXPECT_TRUE(core::EnvStore::find(child, "CPATH") == nullptr);
+};
+
+TEST_CASE(unknown_base_is_rejected) {
+    core::EnvStore store;
+    EXPECT_FALSE(store.resolvable(data::command{.env_base = 42}));
+    EXPECT_TRUE(store.resolvable(data::command{.env = {"PATH=/usr/bin"}}));
+    bool thrown = false;
+    try {
+        (void)store.resolve(data::command{.env_base = 42});
+    } catch(const std::exception&) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+};
+
+TEST_CASE(released_base_stays_valid_for_derived_environments) {
+    core::EnvStore store;
+    store.store(1, store.resolve(data::command{.env = {"PATH=/usr/bin"}}));
+    auto child = store.resolve(data::command{.env = {"CC=clang"}, .env_base = 1});
+    store.store(2, child);
+
+    store.release(1);
+    EXPECT_EQ(store.size(), 1U);
+    std::vector<std::string> expected = {"PATH=/usr/bin", "CC=clang"};
+    EXPECT_TRUE(core::EnvStore::materialize(child) == expected);
+    auto grandchild = store.resolve(data::command{.env_base = 2});
+    EXPECT_TRUE(grandchild == child);
+};
+};  // TEST_SUITE(env_store)
@@ -0,0 +1,165 @@
+#include "event_log.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+#include <kota/zest/macro.h>
+#include <kota/zest/zest.h>
+
+#include "temp_file_manager.h"
+
+using namespace catter;
+using core::EnvStore;
+using core::LogEvent;
+
+namespace {
+
+data::command command_of(std::vector<std::string> argv) {
+    return data::command{.cwd = "/src", .executable = argv.front(), .args = argv};
+}
+
+}  // namespace
+
+TEST_SUITE(event_log) {
+TEST_CASE(record_and_read_back) {
+    auto root = std::filesystem::temp_directory_path() / "catter-event-log-test";
+    TempFileManager manager(root);
+    std::filesystem::create_directories(root);
+    auto path = root / "build.log";
+
+    auto make_env = EnvStore::derive(nullptr, {"PATH=/bin", "CC=cc"}, {});
+    auto cc_env = EnvStore::derive(make_env, {"LANG=C"}, {"CC"});
+    // not derived from its parent, as after a `modify` of the parent
+    auto ld_env = EnvStore::derive(nullptr, {"PATH=/usr/bin"}, {});
+    {
+        core::EventLogWriter writer(root / "build.log", "/src", {"make", "-j8"});
+        writer.command(1, 0, command_of({"make"}), make_env);
+        auto cc = command_of({"cc", "-c", "a.c"});
+        cc.origin = {.pid = 101, .ppid = 100, .tid = 102};
+        writer.command(2, 1, cc, cc_env);
+        writer.command(3, 1, command_of({"sh", "-c", "true"}), make_env);
+        writer.error(4, 1, "no payload");
+        writer.command(5, 1, command_of({"ld", "a.o"}), ld_env);
+        writer.result(2, {.code = 1, .std_err = "a.c: error", .stats = {.pid = 42, .exit = 7}});
+        writer.finish({.code = 2});
+    }
+
+    core::EventLogReader reader(path);
+    EXPECT_EQ(reader.cwd(), "/src");
+    std::vector<std::string> build_command = {"make", "-j8"};
+    EXPECT_TRUE(reader.build_command() == build_command);
+
+    std::vector<LogEvent> events;
+    while(auto event = reader.next()) {
+        events.push_back(std::move(*event));
+    }
+    ASSERT_EQ(events.size(), 7U);
+
+    EXPECT_TRUE(events[0].type == LogEvent::COMMAND);
+    EXPECT_TRUE(events[0].cmd.env == EnvStore::materialize(make_env));
+    EXPECT_TRUE(events[0].time > 0);
+
+    EXPECT_EQ(events[1].parent, 1);
+    std::vector<std::string> cc_args = {"cc", "-c", "a.c"};
+    EXPECT_TRUE(events[1].cmd.args == cc_args);
+    EXPECT_TRUE(events[1].cmd.env == EnvStore::materialize(cc_env));
+    EXPECT_EQ(events[1].cmd.origin.pid, 101);
+    EXPECT_EQ(events[1].cmd.origin.ppid, 100);
+    EXPECT_EQ(events[1].cmd.origin.tid, 102);
+    EXPECT_EQ(events[0].cmd.origin.pid, 0);
+    EXPECT_TRUE(events[2].cmd.env == EnvStore::materialize(make_env));
+
+    EXPECT_TRUE(events[3].type == LogEvent::CAPTURE_ERROR);
+    EXPECT_EQ(events[3].error, "no payload");
+
+    EXPECT_TRUE(events[4].cmd.env == EnvStore::materialize(ld_env));
+
+    EXPECT_TRUE(events[5].type == LogEvent::RESULT);
+    EXPECT_EQ(events[5].id, 2);
+    EXPECT_EQ(events[5].result.code, 1);
+    EXPECT_EQ(events[5].result.std_err, "a.c: error");
+    EXPECT_EQ(events[5].result.stats.exit, 7);
+
+    EXPECT_TRUE(events[6].type == LogEvent::FINISH);
+    EXPECT_EQ(events[6].result.code, 2);
+};
+
+TEST_CASE(long_build_forgets_finished_commands) {
+    auto root = std::filesystem::temp_directory_path() / "catter-event-log-long";
+    TempFileManager manager(root);
+    std::filesystem::create_directories(root);
+    auto path = root / "build.log";
+
+    auto make_env = EnvStore::derive(nullptr, {"PATH=/bin"}, {});
+    auto cc_env = EnvStore::derive(make_env, {"CC=cc"}, {});
+    {
+        core::EventLogWriter writer(path, "/src", {"make"});
+        writer.command(1, 0, command_of({"make"}), make_env);
+        for(data::ipcid_t id = 2; id < 2000; id += 2) {
+            writer.command(id, 1, command_of({"cc", "-c", "a.c"}), cc_env);
+            writer.command(id + 1, id, command_of({"as", "a.s"}), cc_env);
+            writer.result(id, {});
+            writer.result(id + 1, {});
+        }
+        EXPECT_EQ(writer.environments(), 1U);
+        // a command whose parent is forgotten is written against nothing
+        writer.command(2000, 2, command_of({"ld", "a.o"}), cc_env);
+        writer.result(1, {});
+        writer.finish({});
+    }
+
+    core::EventLogReader reader(path);
+    std::size_t peak = 0;
+    std::optional<LogEvent> last_command;
+    while(auto event = reader.next()) {
+        peak = std::max(peak, reader.environments());
+        if(event->type == LogEvent::COMMAND) {
+            last_command = std::move(event);
+        }
+    }
+    EXPECT_TRUE(peak <= 3U);
+    ASSERT_TRUE(last_command.has_value());
+    EXPECT_EQ(last_command->id, 2000);
+    EXPECT_TRUE(last_command->cmd.env == EnvStore::materialize(cc_env));
+};
+
+TEST_CASE(cut_short_log_is_read_up_to_its_last_event) {
+    auto root = std::filesystem::temp_directory_path() / "catter-event-log-truncated";
+    TempFileManager manager(root);
+    std::filesystem::create_directories(root);
+    auto path = root / "build.log";
+
+    {
+        core::EventLogWriter writer(path, "/src", {"ninja"});
+        writer.command(1, 0, command_of({"ninja"}), nullptr);
+        writer.command(2, 1, command_of({"cc", "-c", "a.c"}), nullptr);
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 2);
+
+    core::EventLogReader reader(path);
+    auto first = reader.next();
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->id, 1);
+    EXPECT_FALSE(reader.next().has_value());
+};
+
+TEST_CASE(other_files_are_rejected) {
+    auto root = std::filesystem::temp_directory_path() / "catter-event-log-invalid";
+    TempFileManager manager(root);
+    std::error_code ec;
+    manager.create("build.log", ec, "not a log");
+    ASSERT_TRUE(!ec);
+
+    bool thrown = false;
+    try {
+        core::EventLogReader reader(root / "build.log");
+    } catch(const std::exception&) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+};
+};  // TEST_SUITE(event_log)
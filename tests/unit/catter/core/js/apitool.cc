@@ -0,0 +1,65 @@
+#include "js/apitool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <kota/zest/macro.h>
+#include <kota/zest/zest.h>
+
+#include "js/qjs.h"
+
+using namespace catter;
+
+namespace {
+
+int64_t counted_add_one(int64_t value) {
+    return value + 1;
+}
+
+int64_t counted_reject_negative(int64_t value) {
+    if(value < 0) {
+        throw std::invalid_argument("negative");
+    }
+    return value;
+}
+
+uint64_t calls_of(const std::string& name) {
+    auto stats = apitool::call_stats();
+    auto it = std::ranges::find(stats, name, &apitool::CallStatsSnapshot::name);
+    return it == stats.end() ? 0 : it->calls;
+}
+
+}  // namespace
+
+TEST_SUITE(apitool) {
+TEST_CASE(calls_are_counted_per_capi) {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    auto add_one = apitool::to_js_function<&counted_add_one>(ctx.js_context(), "add_one");
+
+    auto before = calls_of("counted_add_one");
+    EXPECT_EQ(add_one(1), 2);
+    EXPECT_EQ(add_one(2), 3);
+    EXPECT_EQ(calls_of("counted_add_one"), before + 2);
+};
+
+TEST_CASE(throwing_calls_are_counted) {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+    auto reject =
+        apitool::to_js_function<&counted_reject_negative>(ctx.js_context(), "reject_negative");
+
+    auto before = calls_of("counted_reject_negative");
+    EXPECT_EQ(reject(1), 1);
+    bool thrown = false;
+    try {
+        (void)reject(-1);
+    } catch(const std::exception&) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+    EXPECT_EQ(calls_of("counted_reject_negative"), before + 2);
+};
+};  // TEST_SUITE(apitool)
@@ -0,0 +1,111 @@
+#include "js/command_object.h"
+
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+#include <kota/zest/macro.h>
+#include <kota/zest/zest.h>
+
+#include "js/qjs.h"
+
+using namespace catter;
+
+namespace {
+
+constexpr int eval_flags = JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_STRICT;
+
+js::CommandData sample_command() {
+    return js::CommandData{
+        .cwd = "/tmp/build",
+        .exe = "/usr/bin/clang++",
+        .argv = {"clang++", "main.cc", "-c"},
+        .env = {"IGNORED=1"},
+        .runtime = {.supportActions = {js::ActionType::skip, js::ActionType::modify},
+                    .type = js::CatterRuntime::Type::inject,
+                    .supportParentId = true},
+        .parent = 7,
+    };
+}
+
+bool throws(const qjs::Context& ctx, const char* source) {
+    try {
+        (void)ctx.eval(source, "<eval>", eval_flags);
+    } catch(const std::exception&) {
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+TEST_SUITE(command_object) {
+TEST_CASE(fields_are_converted_on_first_read) {
+    auto f = [&]() {
+        auto runtime = qjs::Runtime::create();
+        auto ctx = runtime.context();
+        auto js_ctx = ctx.js_context();
+
+        int loaded = 0;
+        auto object = js::make_command_object(js_ctx, sample_command(), [&loaded]() {
+            ++loaded;
+            return std::vector<std::string>{"CC=clang"};
+        });
+        ctx.global_this().set_property("command", object);
+
+        EXPECT_TRUE(ctx.eval("Object.keys(command).join()", "<eval>", eval_flags)
+                        .as<std::string>() == "cwd,exe,argv,env,runtime,parent");
+        EXPECT_TRUE(ctx.eval("command.exe", "<eval>", eval_flags).as<std::string>() ==
+                    "/usr/bin/clang++");
+        EXPECT_TRUE(loaded == 0);
+
+        EXPECT_TRUE(ctx.eval("command.argv.join(' ')", "<eval>", eval_flags).as<std::string>() ==
+                    "clang++ main.cc -c");
+        EXPECT_TRUE(ctx.eval("command.argv === command.argv", "<eval>", eval_flags).as<bool>());
+        EXPECT_TRUE(ctx.eval("command.env.join()", "<eval>", eval_flags).as<std::string>() ==
+                    "CC=clang");
+        EXPECT_TRUE(ctx.eval("command.env.join()", "<eval>", eval_flags).as<std::string>() ==
+                    "CC=clang");
+        EXPECT_TRUE(loaded == 1);
+    };
+
+    EXPECT_NOTHROWS(f());
+};
+
+TEST_CASE(spread_and_writes_see_plain_values) {
+    auto f = [&]() {
+        auto runtime = qjs::Runtime::create();
+        auto ctx = runtime.context();
+        auto js_ctx = ctx.js_context();
+
+        auto expected = sample_command();
+        expected.env = {};
+        ctx.global_this().set_property(
+            "command",
+            js::make_command_object(js_ctx, expected, [] { return std::vector<std::string>{}; }));
+
+        expected.argv.push_back("-O2");
+        auto copy = ctx.eval("({ ...command, argv: [...command.argv, '-O2'] })",
+                             "<eval>",
+                             eval_flags);
+        EXPECT_TRUE(js::CommandData::make(copy.as<qjs::Object>()) == expected);
+
+        EXPECT_TRUE(ctx.eval("command.runtime = 1; command.runtime", "<eval>", eval_flags)
+                        .as<int64_t>() == 1);
+        EXPECT_TRUE(ctx.eval("command.argv.length", "<eval>", eval_flags).as<int64_t>() == 3);
+    };
+
+    EXPECT_NOTHROWS(f());
+};
+
+TEST_CASE(accessors_reject_other_objects) {
+    auto runtime = qjs::Runtime::create();
+    auto ctx = runtime.context();
+
+    ctx.global_this().set_property("command",
+                                   js::make_command_object(ctx.js_context(), sample_command()));
+    EXPECT_TRUE(throws(ctx, "Object.getPrototypeOf(command).argv"));
+    EXPECT_TRUE(throws(ctx, "Object.getOwnPropertyDescriptor(command, 'env').get.call({})"));
+    EXPECT_TRUE(ctx.eval("command.argv.length", "<eval>", eval_flags).as<int64_t>() == 3);
+};
+};  // TEST_SUITE(command_object)
@@ -59,9 +59,29 @@ TEST_CASE(command_data_and_action_conversion) {
 
         };
 
+        Action inherit_action = Tag<ActionType::skip>{.capture = js::CaptureMode::inherit};
+
+        Action fake_action = Tag<ActionType::fake>{};
+
+        Action unhooked_action = Tag<ActionType::skip>{.ignoreDescendants = true};
+
+        Action cached_action = Tag<ActionType::skip>{
+            .capture = js::CaptureMode::inherit,
+            .cache = js::CachedDecision{.state = "[[]]", .ignoreDescendants = true},
+        };
+
+        Action cached_drop = Tag<ActionType::drop>{
+            .cache = js::CachedDecision{.state = "[null]", .ignoreDescendants = false},
+        };
+
         EXPECT_TRUE(is_roundtrip_equal(ctx, command_data));
         EXPECT_TRUE(is_roundtrip_equal(ctx, modify_action));
         EXPECT_TRUE(is_roundtrip_equal(ctx, skip_action));
+        EXPECT_TRUE(is_roundtrip_equal(ctx, inherit_action));
+        EXPECT_TRUE(is_roundtrip_equal(ctx, fake_action));
+        EXPECT_TRUE(is_roundtrip_equal(ctx, unhooked_action));
+        EXPECT_TRUE(is_roundtrip_equal(ctx, cached_action));
+        EXPECT_TRUE(is_roundtrip_equal(ctx, cached_drop));
     };
 
     EXPECT_NOTHROWS(f());
@@ -78,6 +98,17 @@ TEST_CASE(process_result_and_config_conversion) {
             .stdErr = "warn",
         };
 
+        js::ProcessResult process_result_with_stats{
+            .code = 1,
+            .stats = js::ProcessStats{.pid = 4242,
+                                      .spawn = 1'700'000'000'000'000,
+                                      .exec = 1'700'000'000'000'150,
+                                      .exit = 1'700'000'000'250'000,
+                                      .userTime = 200'000,
+                                      .systemTime = 30'000,
+                                      .maxRss = 65'536},
+        };
+
         js::CatterConfig config{
             .scriptPath = "scripts/demo.js",
             .scriptArgs = {"--input", "compile_commands.json"},
@@ -86,11 +117,16 @@ TEST_CASE(process_result_and_config_conversion) {
             .runtime = {.supportActions = {js::ActionType::drop, js::ActionType::abort},
                            .type = js::CatterRuntime::Type::inject,
                            .supportParentId = false},
-            .options = {.log = true, .stdioMode = js::CatterOptions::StdioMode::inherit},
+            .options = {.log = true,
+                           .stdioMode = js::CatterOptions::StdioMode::inherit,
+                           .decisionCache = true,
+                           .decisionCacheEnv = std::vector<std::string>{"CFLAGS"},
+                           .observeOnly = true},
             .execute = true
         };
 
         EXPECT_TRUE(is_roundtrip_equal(ctx, process_result));
+        EXPECT_TRUE(is_roundtrip_equal(ctx, process_result_with_stats));
         EXPECT_TRUE(is_roundtrip_equal(ctx, config));
     };
 
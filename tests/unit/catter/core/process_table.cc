@@ -0,0 +1,107 @@
+#include "process_table.h"
+
+#include <vector>
+#include <kota/zest/macro.h>
+#include <kota/zest/zest.h>
+
+using namespace catter;
+using core::ProcessTable;
+
+TEST_SUITE(process_table) {
+TEST_CASE(reported_parent_is_kept_without_a_running_caller) {
+    ProcessTable table;
+    EXPECT_EQ(table.add(1, 0, {}), 0);
+    EXPECT_EQ(table.add(2, 1, {.pid = 500, .ppid = 400}), 1);
+
+    auto entry = table.find(2);
+    ASSERT_TRUE(entry != nullptr);
+    EXPECT_EQ(entry->parent, 1);
+    EXPECT_EQ(entry->origin.pid, 500);
+    EXPECT_TRUE(table.find(3) == nullptr);
+    EXPECT_EQ(table.size(), 2U);
+};
+
+TEST_CASE(command_is_linked_to_the_calling_command) {
+    ProcessTable table;
+    table.add(1, 0, {});
+    table.started(1, 100);
+    table.add(2, 1, {});
+    table.started(2, 200);
+
+    // `make` inherited the environment of 1, but 2 called it
+    EXPECT_EQ(table.add(3, 1, {.pid = 200, .ppid = 100}), 2);
+    EXPECT_EQ(table.find(3)->parent, 2);
+    EXPECT_EQ(table.running(200), 2);
+};
+
+TEST_CASE(command_is_linked_to_the_command_which_forked_the_caller) {
+    ProcessTable table;
+    table.add(1, 0, {});
+    table.started(1, 100);
+
+    // a subshell of 1 which was not hooked, as after `vfork`
+    EXPECT_EQ(table.add(2, 0, {.pid = 150, .ppid = 100}), 1);
+};
+
+TEST_CASE(exited_command_is_not_linked_anymore) {
+    ProcessTable table;
+    table.add(1, 0, {});
+    table.started(1, 100);
+    table.exited(1);
+
+    EXPECT_EQ(table.running(100), 0);
+    EXPECT_EQ(table.add(2, 0, {.pid = 100}), 0);
+};
+
+TEST_CASE(reused_pid_belongs_to_the_latest_command) {
+    ProcessTable table;
+    table.add(1, 0, {});
+    table.started(1, 100);
+    table.add(2, 0, {});
+    table.started(2, 100);
+
+    EXPECT_EQ(table.running(100), 2);
+    // the stale command leaving does not drop the new one
+    table.exited(1);
+    EXPECT_EQ(table.running(100), 2);
+    EXPECT_EQ(table.add(3, 0, {.pid = 100}), 2);
+};
+
+TEST_CASE(command_is_forgotten_after_its_linked_commands) {
+    ProcessTable table;
+    table.add(1, 0, {});
+    table.add(2, 1, {});
+    table.add(3, 2, {});
+
+    // 2 still has 3
+    EXPECT_TRUE(table.exited(2).empty());
+    EXPECT_TRUE(table.find(2) != nullptr);
+
+    std::vector<data::ipcid_t> forgotten = {3, 2};
+    EXPECT_TRUE(table.exited(3) == forgotten);
+    EXPECT_TRUE(table.find(2) == nullptr);
+    EXPECT_EQ(table.size(), 1U);
+
+    forgotten = {1};
+    EXPECT_TRUE(table.exited(1) == forgotten);
+    EXPECT_EQ(table.size(), 0U);
+    EXPECT_TRUE(table.exited(1).empty());
+};
+
+TEST_CASE(long_build_keeps_only_running_commands) {
+    ProcessTable table;
+    table.add(1, 0, {});
+    table.started(1, 100);
+    for(data::ipcid_t id = 2; id < 10000; ++id) {
+        table.add(id, 1, {.pid = 100 + id, .ppid = 100});
+        table.started(id, 100 + id);
+        // three run at once, as with `make -j3`
+        if(id >= 5) {
+            table.exited(id - 3);
+        }
+    }
+    EXPECT_EQ(table.size(), 4U);
+    EXPECT_TRUE(table.find(1) != nullptr);
+    EXPECT_TRUE(table.find(9996) == nullptr);
+};
+};  // TEST_SUITE(process_table)
@@ -290,6 +290,43 @@ TEST_CASE(object_property_apis_cover_reads_writes_and_exceptional_access) {
     JS_FreeValue(ctx.js_context(), JS_GetException(ctx.js_context()));
 };
 
+TEST_CASE(lazy_property_computes_once_and_can_be_overwritten) {
+    auto f = [&]() {
+        auto runtime = qjs::Runtime::create();
+        auto ctx = runtime.context();
+        auto js_ctx = ctx.js_context();
+
+        int computed = 0;
+        auto object = qjs::Object::empty_one(js_ctx);
+        object.define_lazy_property("lazy", [&computed, js_ctx]() {
+            ++computed;
+            return qjs::json::parse(R"({"value":7})", js_ctx).as<qjs::Object>();
+        });
+        ctx.global_this().set_property("holder", object);
+        EXPECT_TRUE(computed == 0);
+
+        EXPECT_TRUE(ctx.eval("Object.keys(holder).join()", "<eval>", eval_flags)
+                        .as<std::string>() == "lazy");
+        EXPECT_TRUE(computed == 0);
+
+        EXPECT_TRUE(ctx.eval("holder.lazy.value + holder.lazy.value", "<eval>", eval_flags)
+                        .as<int64_t>() == 14);
+        EXPECT_TRUE(computed == 1);
+
+        auto other = qjs::Object::empty_one(js_ctx);
+        other.define_lazy_property("lazy", [&computed, js_ctx]() {
+            ++computed;
+            return qjs::Object::empty_one(js_ctx);
+        });
+        ctx.global_this().set_property("other", other);
+        EXPECT_TRUE(ctx.eval("other.lazy = 5; other.lazy", "<eval>", eval_flags).as<int64_t>() ==
+                    5);
+        EXPECT_TRUE(computed == 1);
+    };
+
+    EXPECT_NOTHROWS(f());
+};
+
 TEST_CASE(array_conversions_cover_roundtrip_element_failures_and_push_errors) {
     auto f = [&]() {
         auto runtime = qjs::Runtime::create();
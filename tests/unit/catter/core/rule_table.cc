@@ -0,0 +1,93 @@
+#include "rule_table.h"
+
+#include <exception>
+#include <string>
+#include <vector>
+#include <kota/zest/macro.h>
+#include <kota/zest/zest.h>
+
+#include "util/exec_filter.h"
+
+using namespace catter;
+
+namespace {
+
+bool compile_fails(std::vector<js::CommandRule> rules) {
+    try {
+        (void)core::RuleTable::compile(rules);
+    } catch(const std::exception&) {
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+TEST_SUITE(rule_table) {
+TEST_CASE(glob) {
+    EXPECT_TRUE(util::glob_match("mkdir", "mkdir"));
+    EXPECT_TRUE(util::glob_match("*", ""));
+    EXPECT_TRUE(util::glob_match("python3*", "python3.12"));
+    EXPECT_TRUE(util::glob_match("*-gcc", "x86_64-linux-gnu-gcc"));
+    EXPECT_TRUE(util::glob_match("g?c", "gcc"));
+    EXPECT_TRUE(util::glob_match("a*b*c", "aXbYbZc"));
+    EXPECT_FALSE(util::glob_match("mkdir", "mkdirs"));
+    EXPECT_FALSE(util::glob_match("g?c", "gc"));
+    EXPECT_FALSE(util::glob_match("*-gcc", "gcc"));
+};
+
+TEST_CASE(first_matching_rule_decides) {
+    auto table = core::RuleTable::compile({
+        {.exe = "mkdir", .action = js::ActionType::skip},
+        {.exe = "cmake", .args = std::vector<std::string>{"-E"}, .action = js::ActionType::drop},
+        {.exePattern = "/opt/tools/", .action = js::ActionType::drop},
+    });
+    EXPECT_FALSE(table.empty());
+
+    std::vector<std::string> mkdir{"mkdir", "-p", "out"};
+    EXPECT_TRUE(table.match("/usr/bin/mkdir", mkdir) == js::ActionType::skip);
+
+    std::vector<std::string> cmake_e{"cmake", "-E", "copy", "a", "b"};
+    std::vector<std::string> cmake_build{"cmake", "--build", "."};
+    std::vector<std::string> cmake_bare{"cmake"};
+    EXPECT_TRUE(table.match("/usr/bin/cmake", cmake_e) == js::ActionType::drop);
+    EXPECT_FALSE(table.match("/usr/bin/cmake", cmake_build).has_value());
+    EXPECT_FALSE(table.match("/usr/bin/cmake", cmake_bare).has_value());
+
+    std::vector<std::string> tool{"tool"};
+    EXPECT_TRUE(table.match("/opt/tools/bin/tool", tool) == js::ActionType::drop);
+
+    std::vector<std::string> gcc{"gcc", "-c", "a.c"};
+    EXPECT_FALSE(table.match("/usr/bin/gcc", gcc).has_value());
+};
+
+TEST_CASE(exe_with_separator_matches_full_path) {
+    auto table = core::RuleTable::compile({
+        {.exe = "/usr/bin/*", .action = js::ActionType::skip},
+    });
+
+    std::vector<std::string> argv{"sed"};
+    EXPECT_TRUE(table.match("/usr/bin/sed", argv) == js::ActionType::skip);
+    EXPECT_FALSE(table.match("/usr/local/bin/sed", argv).has_value());
+};
+
+TEST_CASE(pass_through_stops_at_first_drop) {
+    auto table = core::RuleTable::compile({
+        {.exe = "sh", .action = js::ActionType::skip},
+        {.exe = "cmake", .args = std::vector<std::string>{"-E"}, .action = js::ActionType::skip},
+        {.exe = "sed", .exePattern = "/usr/", .action = js::ActionType::skip},
+        {.exe = "/usr/bin/*", .action = js::ActionType::skip},
+        {.exe = "cc1", .action = js::ActionType::drop},
+        {.exe = "mkdir", .action = js::ActionType::skip},
+    });
+    // `mkdir` may be dropped by an earlier rule, the hook can not tell
+    EXPECT_TRUE(table.pass_through() == std::vector<std::string>{"sh", "/usr/bin/*"});
+};
+
+TEST_CASE(invalid_rules_are_rejected) {
+    EXPECT_TRUE(compile_fails({{.exe = "gcc", .action = js::ActionType::modify}}));
+    EXPECT_TRUE(compile_fails({{.exe = "gcc", .action = js::ActionType::abort}}));
+    EXPECT_TRUE(compile_fails({{.exePattern = "(", .action = js::ActionType::skip}}));
+    EXPECT_TRUE(core::RuleTable::compile({}).empty());
+};
+};  // TEST_SUITE(rule_table)
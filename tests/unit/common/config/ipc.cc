@@ -0,0 +1,51 @@
+#include "config/ipc.h"
+
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <kota/zest/macro.h>
+#include <kota/zest/zest.h>
+
+#include "util/guard.h"
+
+using namespace catter;
+
+#ifndef CATTER_WINDOWS
+namespace {
+
+std::optional<std::string> get_env(const char* key) {
+    const char* value = std::getenv(key);
+    return value == nullptr ? std::nullopt : std::optional<std::string>(value);
+}
+
+void set_env(const char* key, const std::optional<std::string>& value) {
+    if(value.has_value()) {
+        setenv(key, value->c_str(), 1);
+    } else {
+        unsetenv(key);
+    }
+}
+
+}  // namespace
+
+TEST_SUITE(config_ipc) {
+TEST_CASE(socket_path_falls_back_when_home_is_too_deep) {
+    auto home = get_env("HOME");
+    auto runtime = get_env("XDG_RUNTIME_DIR");
+    auto restore = util::make_guard([&]() noexcept {
+        set_env("HOME", home);
+        set_env("XDG_RUNTIME_DIR", runtime);
+    });
+
+    set_env("HOME", "/home/user");
+    EXPECT_TRUE(config::ipc::socket_path("a.sock") == "/home/user/.catter/a.sock");
+
+    set_env("HOME", "/home/" + std::string(120, 'u'));
+    set_env("XDG_RUNTIME_DIR", "/run/user/1000");
+    EXPECT_TRUE(config::ipc::socket_path("a.sock") == "/run/user/1000/a.sock");
+
+    set_env("XDG_RUNTIME_DIR", std::nullopt);
+    EXPECT_TRUE(config::ipc::socket_path("a.sock") == "/tmp/a.sock");
+};
+};  // TEST_SUITE(config_ipc)
+#endif
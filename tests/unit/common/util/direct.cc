@@ -0,0 +1,89 @@
+#include "util/direct.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <kota/zest/macro.h>
+#include <kota/zest/zest.h>
+
+#include "util/bincode.h"
+
+using namespace catter;
+
+namespace {
+
+std::string_view body_of(const std::string& framed) {
+    return std::string_view(framed).substr(bincode::frame_header_size);
+}
+
+}  // namespace
+
+TEST_SUITE(direct) {
+TEST_CASE(frame_size_waits_for_complete_frame) {
+    auto framed = bincode::frame(std::string("body"));
+    ASSERT_TRUE(framed.has_value());
+    auto size = bincode::frame_size(*framed);
+    EXPECT_TRUE(size == framed->size());
+    EXPECT_FALSE(bincode::frame_size(std::string_view(*framed).substr(0, 2)).has_value());
+    EXPECT_FALSE(bincode::frame_size(std::string_view(*framed).substr(0, framed->size() - 1))
+                     .has_value());
+    EXPECT_TRUE(bincode::frame_size(*framed + "next") == framed->size());
+};
+
+TEST_CASE(messages_round_trip) {
+    direct::request req{
+        .parent_id = 3,
+        .cwd = "/src",
+        .executable = "/usr/bin/cc",
+        .args = {"cc", "-c", "main.c"},
+        .env_delta = true,
+        .env = {"PATH=/usr/bin"},
+        .env_unset = {"CC"},
+        .pid = 41,
+        .ppid = 40,
+        .tid = 42,
+    };
+    auto framed = direct::encode(req);
+    ASSERT_TRUE(framed.has_value());
+    auto decoded = direct::decode_request(body_of(*framed));
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_TRUE(decoded->parent_id == 3);
+    EXPECT_TRUE(decoded->cwd == req.cwd);
+    EXPECT_TRUE(decoded->executable == req.executable);
+    EXPECT_TRUE(decoded->args == req.args);
+    EXPECT_TRUE(decoded->env_delta);
+    EXPECT_TRUE(decoded->env == req.env);
+    EXPECT_TRUE(decoded->env_unset == req.env_unset);
+    EXPECT_EQ(decoded->pid, 41);
+    EXPECT_EQ(decoded->ppid, 40);
+    EXPECT_EQ(decoded->tid, 42);
+
+    direct::reply keep{.type = direct::reply::EXEC_ORIGINAL, .id = 9};
+    auto keep_framed = direct::encode(keep);
+    ASSERT_TRUE(keep_framed.has_value());
+    auto keep_decoded = direct::decode_reply(body_of(*keep_framed));
+    ASSERT_TRUE(keep_decoded.has_value());
+    EXPECT_TRUE(keep_decoded->type == direct::reply::EXEC_ORIGINAL);
+    EXPECT_TRUE(keep_decoded->id == 9);
+
+    direct::reply replaced{.type = direct::reply::EXEC, .id = 10, .args = {"cc", "-O2"}};
+    auto replaced_framed = direct::encode(replaced);
+    ASSERT_TRUE(replaced_framed.has_value());
+    auto replaced_decoded = direct::decode_reply(body_of(*replaced_framed));
+    ASSERT_TRUE(replaced_decoded.has_value());
+    EXPECT_TRUE(replaced_decoded->args == replaced.args);
+};
+
+TEST_CASE(request_rejects_other_versions) {
+    auto framed = direct::encode(direct::request{.version = direct::protocol_version + 1});
+    ASSERT_TRUE(framed.has_value());
+    EXPECT_FALSE(direct::decode_request(body_of(*framed)).has_value());
+};
+
+TEST_CASE(truncated_messages_are_rejected) {
+    auto framed = direct::encode(direct::request{.cwd = "/src", .args = {"cc"}});
+    ASSERT_TRUE(framed.has_value());
+    auto body = body_of(*framed);
+    EXPECT_FALSE(direct::decode_request(body.substr(0, body.size() - 1)).has_value());
+};
+};  // TEST_SUITE(direct)
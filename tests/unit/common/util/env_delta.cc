@@ -0,0 +1,48 @@
+#include "util/env_delta.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <kota/zest/macro.h>
+#include <kota/zest/zest.h>
+
+using namespace catter;
+
+TEST_SUITE(env_delta) {
+TEST_CASE(keys_round_trip) {
+    auto joined = env_delta::join_keys({"PATH", "CC", "A_B"});
+    EXPECT_TRUE(joined == "PATH=CC=A_B");
+    EXPECT_TRUE(env_delta::split_keys(joined) ==
+                std::vector<std::string_view>{"PATH", "CC", "A_B"});
+    EXPECT_TRUE(env_delta::split_keys("").empty());
+};
+
+TEST_CASE(apply_keeps_order_and_appends_new_keys) {
+    std::vector<std::string> env = {"PATH=/usr/bin", "LANG=C", "HOME=/root"};
+    env_delta::apply(env, {"LANG=en_US.UTF-8", "CC=clang"}, {"HOME"});
+    EXPECT_TRUE(env == std::vector<std::string>{"PATH=/usr/bin", "LANG=en_US.UTF-8", "CC=clang"});
+};
+
+TEST_CASE(diff_is_inverse_of_apply) {
+    std::vector<std::string> from = {"PATH=/usr/bin", "LANG=C", "HOME=/root"};
+    std::vector<std::string> to = {"PATH=/usr/bin", "LANG=en_US.UTF-8", "CC=clang"};
+
+    std::vector<std::string> changed;
+    std::vector<std::string> unset;
+    env_delta::diff(from, to, changed, unset);
+    EXPECT_TRUE(changed == std::vector<std::string>{"LANG=en_US.UTF-8", "CC=clang"});
+    EXPECT_TRUE(unset == std::vector<std::string>{"HOME"});
+
+    env_delta::apply(from, changed, unset);
+    EXPECT_TRUE(from == to);
+};
+
+TEST_CASE(select_picks_changed_keys) {
+    std::vector<std::string> env = {"PATH=/usr/bin", "LANG=C", "CC=clang"};
+    std::vector<std::string> changed;
+    std::vector<std::string> unset;
+    env_delta::select(env, "CC=HOME", changed, unset);
+    EXPECT_TRUE(changed == std::vector<std::string>{"CC=clang"});
+    EXPECT_TRUE(unset == std::vector<std::string>{"HOME"});
+};
+};  // TEST_SUITE(env_delta)
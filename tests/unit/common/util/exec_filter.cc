@@ -0,0 +1,49 @@
+#include "util/exec_filter.h"
+
+#include <string>
+#include <vector>
+#include <kota/zest/macro.h>
+#include <kota/zest/zest.h>
+
+using namespace catter;
+
+TEST_SUITE(exec_filter) {
+TEST_CASE(decoded_filter_matches_name_or_path) {
+    std::vector<std::string> globs{"sh", "python3*", "/usr/lib/gcc/*"};
+    auto content = util::ExecFilter::encode(globs);
+    auto filter = util::ExecFilter::decode(content);
+    ASSERT_TRUE(filter.has_value());
+    EXPECT_FALSE(filter->empty());
+
+    EXPECT_TRUE(filter->match("/bin/sh"));
+    EXPECT_TRUE(filter->match("sh"));
+    EXPECT_TRUE(filter->match("/usr/bin/python3.12"));
+    EXPECT_TRUE(filter->match("/usr/lib/gcc/x86_64-linux-gnu/13/cc1"));
+    EXPECT_FALSE(filter->match("/bin/bash"));
+    EXPECT_FALSE(filter->match("/opt/sh/gcc"));
+    // a glob with a separator is matched against the whole path only
+    EXPECT_FALSE(filter->match("/opt/usr/lib/gcc/cc1"));
+};
+
+TEST_CASE(empty_filter_matches_nothing) {
+    auto content = util::ExecFilter::encode(std::vector<std::string>{});
+    auto filter = util::ExecFilter::decode(content);
+    ASSERT_TRUE(filter.has_value());
+    EXPECT_TRUE(filter->empty());
+    EXPECT_FALSE(filter->match("/bin/sh"));
+};
+
+TEST_CASE(malformed_filter_is_rejected) {
+    auto content = util::ExecFilter::encode(std::vector<std::string>{"sh", "sed"});
+    EXPECT_FALSE(util::ExecFilter::decode(content.substr(0, content.size() - 1)).has_value());
+    EXPECT_FALSE(util::ExecFilter::decode(content + "x").has_value());
+    EXPECT_FALSE(util::ExecFilter::decode("").has_value());
+
+    // an empty pattern only comes from a broken file
+    EXPECT_FALSE(util::ExecFilter::decode(content + "\n").has_value());
+
+    // another version of the format
+    content[util::ExecFilter::magic.size() + 1] += 1;
+    EXPECT_FALSE(util::ExecFilter::decode(content).has_value());
+};
+};  // TEST_SUITE(exec_filter)
@@ -0,0 +1,195 @@
+#include "util/fake_compile.h"
+
+#include <exception>
+#include <filesystem>
+#include <initializer_list>
+#include <optional>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <kota/zest/macro.h>
+#include <kota/zest/zest.h>
+
+#include "temp_file_manager.h"
+
+using namespace catter;
+using fake_compile::output;
+
+namespace {
+
+std::optional<std::vector<output>> plan(std::initializer_list<std::string> argv) {
+    return fake_compile::plan(std::vector<std::string>(argv));
+}
+
+std::string read_file(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+}  // namespace
+
+TEST_SUITE(fake_compile) {
+TEST_CASE(compile_with_output_and_depfile) {
+    auto outputs =
+        plan({"/usr/bin/clang++", "-c", "src/main.cc", "-MD", "-o", "obj/main.o", "-Iinclude"});
+
+    ASSERT_TRUE(outputs.has_value());
+    ASSERT_EQ(outputs->size(), 2U);
+    EXPECT_TRUE((*outputs)[0].kind == output::DEPFILE);
+    EXPECT_EQ((*outputs)[0].path, "obj/main.d");
+    EXPECT_EQ((*outputs)[0].content, "obj/main.o: src/main.cc\n");
+    EXPECT_TRUE((*outputs)[1].kind == output::OBJECT);
+    EXPECT_EQ((*outputs)[1].path, "obj/main.o");
+};
+
+TEST_CASE(depfile_path_and_targets_are_taken_from_options) {
+    auto outputs = plan({"x86_64-linux-gnu-gcc-13",
+                         "-MMD",
+                         "-MF",
+                         "deps/a b.d",
+                         "-MT",
+                         "out/a.o",
+                         "-MQ",
+                         "a b.o",
+                         "-c",
+                         "a b.c"});
+
+    ASSERT_TRUE(outputs.has_value());
+    ASSERT_EQ(outputs->size(), 2U);
+    EXPECT_EQ((*outputs)[0].path, "deps/a b.d");
+    EXPECT_EQ((*outputs)[0].content, "out/a.o a\\ b.o: a\\ b.c\n");
+    EXPECT_EQ((*outputs)[1].path, "a b.o");
+};
+
+TEST_CASE(compile_several_sources_into_the_working_directory) {
+    auto outputs = plan({"gcc", "-c", "dir/one.c", "two.cpp", "extra.o", "-S"});
+
+    ASSERT_TRUE(outputs.has_value());
+    ASSERT_EQ(outputs->size(), 2U);
+    EXPECT_TRUE((*outputs)[0].kind == output::OTHER);
+    EXPECT_EQ((*outputs)[0].path, "one.s");
+    EXPECT_EQ((*outputs)[1].path, "two.s");
+};
+
+TEST_CASE(commands_whose_output_is_read_are_not_faked) {
+    EXPECT_FALSE(plan({"cc", "-E", "a.c"}).has_value());
+    EXPECT_FALSE(plan({"cc", "-M", "a.c"}).has_value());
+    EXPECT_FALSE(plan({"cc", "-c", "a.c", "-o", "-"}).has_value());
+    EXPECT_FALSE(plan({"cc", "@args.rsp"}).has_value());
+    EXPECT_FALSE(plan({"cc", "-c", "a.c", "-o"}).has_value());
+    EXPECT_FALSE(plan({"clang-tblgen", "-o", "x.inc"}).has_value());
+    EXPECT_FALSE(plan({}).has_value());
+
+    auto syntax = plan({"cc", "-fsyntax-only", "a.c"});
+    ASSERT_TRUE(syntax.has_value());
+    EXPECT_TRUE(syntax->empty());
+};
+
+TEST_CASE(link_writes_an_object_in_place_of_the_result) {
+    auto outputs = plan({"c++", "main.o", "util.o", "-lm", "-o", "bin/tool"});
+
+    ASSERT_TRUE(outputs.has_value());
+    ASSERT_EQ(outputs->size(), 1U);
+    EXPECT_TRUE((*outputs)[0].kind == output::OBJECT);
+    EXPECT_EQ((*outputs)[0].path, "bin/tool");
+};
+
+TEST_CASE(clang_cl_output_directory) {
+    auto outputs = plan({"clang-cl.exe", "/nologo", "/MD", "/c", "main.cc", "util.cc", "/Foobj\\"});
+
+    ASSERT_TRUE(outputs.has_value());
+    ASSERT_EQ(outputs->size(), 2U);
+    EXPECT_EQ((*outputs)[0].path, "obj\\main.obj");
+    EXPECT_EQ((*outputs)[1].path, "obj\\util.obj");
+};
+
+TEST_CASE(clang_cl_dll_with_import_library) {
+    auto outputs = plan({"cl", "/LD", "plugin.cc", "/Fe:bin/plugin.dll"});
+
+    ASSERT_TRUE(outputs.has_value());
+    ASSERT_EQ(outputs->size(), 2U);
+    EXPECT_TRUE((*outputs)[0].kind == output::ARCHIVE);
+    EXPECT_EQ((*outputs)[0].path, "bin/plugin.lib");
+    EXPECT_EQ((*outputs)[1].path, "bin/plugin.dll");
+};
+
+TEST_CASE(nvcc_compile_with_depfile) {
+    auto outputs =
+        plan({"nvcc", "-c", "kernel.cu", "-ofoo.o", "-MD", "-MF", "foo.d", "-arch=sm_80"});
+
+    ASSERT_TRUE(outputs.has_value());
+    ASSERT_EQ(outputs->size(), 2U);
+    EXPECT_EQ((*outputs)[0].path, "foo.d");
+    EXPECT_EQ((*outputs)[0].content, "foo.o: kernel.cu\n");
+    EXPECT_TRUE((*outputs)[1].kind == output::OBJECT);
+    EXPECT_EQ((*outputs)[1].path, "foo.o");
+
+    EXPECT_FALSE(plan({"nvcc", "-E", "kernel.cu"}).has_value());
+};
+
+TEST_CASE(archivers) {
+    auto ar = plan({"llvm-ar", "rcsT", "libx.a", "a.o"});
+    ASSERT_TRUE(ar.has_value());
+    ASSERT_EQ(ar->size(), 1U);
+    EXPECT_TRUE((*ar)[0].kind == output::THIN_ARCHIVE);
+    EXPECT_EQ((*ar)[0].path, "libx.a");
+
+    auto positional = plan({"ar", "-rb", "b.o", "liby.a", "a.o"});
+    ASSERT_TRUE(positional.has_value());
+    EXPECT_EQ((*positional)[0].path, "liby.a");
+
+    EXPECT_FALSE(plan({"ar", "t", "libx.a"}).has_value());
+
+    auto lib = plan({"lib.exe", "/out:z.lib", "a.obj"});
+    ASSERT_TRUE(lib.has_value());
+    ASSERT_EQ(lib->size(), 1U);
+    EXPECT_TRUE((*lib)[0].kind == output::ARCHIVE);
+    EXPECT_EQ((*lib)[0].path, "z.lib");
+};
+
+TEST_CASE(write_placeholders) {
+    auto root = std::filesystem::temp_directory_path() / "catter-fake-compile-test";
+    TempFileManager manager(root);
+    std::error_code ec;
+    std::filesystem::create_directories(root / "obj", ec);
+    ASSERT_TRUE(!ec);
+
+    const std::vector<output> outputs = {
+        {.kind = output::OBJECT, .path = "obj/main.o"},
+        {.kind = output::ARCHIVE, .path = (root / "libx.a").string()},
+        {.kind = output::DEPFILE, .path = "obj/main.d", .content = "x"},
+    };
+    fake_compile::write(outputs, root);
+
+    EXPECT_EQ(read_file(root / "obj/main.o"), fake_compile::empty_object());
+    EXPECT_EQ(read_file(root / "libx.a"), "!<arch>\n");
+    EXPECT_EQ(read_file(root / "obj/main.d"), "x");
+
+    // a missing directory is an error, as it is for the compiler
+    const std::vector<output> missing = {
+        {.kind = output::OTHER, .path = "missing/out.s"},
+    };
+    bool thrown = false;
+    try {
+        fake_compile::write(missing, root);
+    } catch(const std::exception&) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+};
+
+TEST_CASE(empty_object_has_the_host_format) {
+    auto object = fake_compile::empty_object();
+#if defined(CATTER_WINDOWS)
+    EXPECT_EQ(object.size(), 20U);
+#elif defined(CATTER_MAC)
+    EXPECT_EQ(object.size(), 32U);
+    EXPECT_TRUE(object.starts_with("\xcf\xfa\xed\xfe"));
+#elif defined(__x86_64__) || defined(__aarch64__)
+    EXPECT_EQ(object.size(), 208U);
+    EXPECT_TRUE(object.starts_with("\x7f" "ELF"));
+#endif
+};
+};  // TEST_SUITE(fake_compile)
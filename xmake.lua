@@ -239,6 +239,9 @@ target("catter-hook-unix")
 
     if is_mode("debug") then
         add_deps("common")
+    else
+        -- util/direct.h encodes with the bincode of kotatsu, --gc-sections drops the rest
+        add_packages("kotatsu")
     end
 
     add_cxxflags("-fvisibility=hidden")
@@ -247,6 +250,8 @@ target("catter-hook-unix")
 
     add_includedirs("src/catter-hook/")
     add_includedirs("src/catter-hook/unix/payload/")
+    -- header-only protocol definitions shared with catter, e.g. util/direct.h
+    add_includedirs("src/common/")
     add_files("src/catter-hook/unix/payload/**.cc")
 
     if is_plat("linux") then
@@ -376,6 +381,25 @@ target("it-catter-proxy")
     add_files("tests/integration/test/catter-proxy.cc")
     add_deps("common", "catter-core", "catter-proxy")
 
+if is_plat("linux", "macosx") then
+    target("bench")
+        set_default(false)
+        set_kind("binary")
+        add_files("tests/bench/exec.cc")
+        add_deps("common")
+        -- the setups run the driver under catter
+        add_deps("catter", "catter-proxy", "catter-hook-unix")
+        add_defines(format([[BENCH_NOOP_SCRIPT="%s"]], path.unix(path.join(os.projectdir(), "tests/bench/noop.js"))))
+end
+
+target("bench-qjs")
+    set_default(false)
+    set_kind("binary")
+    add_local_prefix_includedirs()
+    add_includedirs("tests/bench/base")
+    add_files("tests/bench/base/*.cc", "tests/bench/qjs.cc")
+    add_deps("catter-core", "common")
+
 rule("build.js")
     on_load(function (target)
         if target:kind() == "object" then